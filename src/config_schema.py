@@ -152,6 +152,14 @@ FOS_VMEM_RANGES = FCSchemaStruct([
         [0xA000_0000, 0xC000_0000]
     ).with_comment([
         "Where kernel and user thread stacks live."
+    ])),
+
+    ("PHYSMAP", FOS_RANGE32.with_default_any(
+        [0x4000_0000, 0x6000_0000]
+    ).with_comment([
+        "Kernel only window which maps the start of the physical BODY. (Only in the kernel pd)",
+        "Physical page p is visible at START + (p - BODY.START) when covered.",
+        "An empty range disables the physmap."
     ]))
 ]).with_extra_checks(no_overlap=fern_os_mem_ranges_no_overlap).with_comment([
     "How virtual memory is laid out in FernOS.",
@@ -245,6 +253,22 @@ FOS_CORE = FCSchemaStruct(
             "Guarnateed to be <= 256"
         ])),
 
+        ("PROC_FRAME_QUOTA", FOS_UINT32.with_default_any(0).with_comment([
+            "Default maximum number of resident physical pages per user process. (0 means no quota)",
+            "The root process is never given a quota. Other processes start with their parent's quota,",
+            "or this one when their parent has none."
+        ])),
+
+        ("SCHED_QUANTUM", fos_bound_int(1, 1024).with_default_any(4).with_comment([
+            "Number of timer ticks a thread may run before the next thread of equal priority gets a turn"
+        ])),
+
+        # Must stay below the number of thread priority levels. (THREAD_PRIO_LEVELS in shared_defs.h)
+        ("SCHED_WAKE_BOOST", fos_bound_int(0, 7).with_default_any(1).with_comment([
+            "How many priority levels a thread is boosted by when woken from a wait queue",
+            "The boost lasts until the thread uses up a full time slice (0 disables boosting)"
+        ])),
+
         # TODO: Add Plugin section to schema so that these gfx definitions don't need to
         # be here in "CORE".
         ("GFX_WIDTH", FCS_INT.const_any(1024)),
@@ -0,0 +1,28 @@
+
+#pragma once
+
+#include "s_util/err.h"
+#include "s_bridge/shared_defs.h"
+
+#include <stdint.h>
+
+/**
+ * Measure the TSC frequency against the PIT and start the monotonic clock. Right after this call,
+ * `clock_ns` returns ~0.
+ *
+ * This busy waits for ~50ms, it should be called once during startup before anything reads the
+ * clock.
+ *
+ * FOS_E_STATE_MISMATCH if the TSC doesn't seem to be counting.
+ */
+fernos_error_t init_clock(void);
+
+/**
+ * How TSC readings are converted into clock time. (Never changes after `init_clock`)
+ */
+const clock_info_t *clock_get_info(void);
+
+/**
+ * Nanoseconds since `init_clock` was called.
+ */
+uint64_t clock_ns(void);
@@ -7,6 +7,7 @@
 #pragma once
 
 typedef struct _thread_t thread_t;
+typedef struct _schedule_t schedule_t;
 typedef struct _process_t process_t;
 typedef struct _kernel_state_t kernel_state_t;
 
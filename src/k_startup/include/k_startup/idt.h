@@ -8,6 +8,11 @@
 
 #define NUM_IDT_ENTRIES 0x100
 
+/**
+ * The PIT reload value which gives one timer tick. (IRQ0 fires ~1193 times a second)
+ */
+#define TICK_PIT_RELOAD_VAL (1000U)
+
 extern uint8_t _idt_start[];
 extern uint8_t _idt_end[];
 
@@ -0,0 +1,145 @@
+
+#pragma once
+
+#include "k_sys/page.h"
+#include "k_startup/page_helpers.h"
+#include "s_bridge/app.h"
+#include "s_mem/allocator.h"
+#include "s_util/err.h"
+
+/*
+ * The image cache holds the read-only areas of recently executed user apps.
+ *
+ * Each cached image is identified by an opaque key. (For example, the node key of the file the
+ * app was loaded from) Every non-writeable area of a cached image is kept in a set of physical
+ * pages which is handed out to every process which executes the same image.
+ * These pages are reference counted exactly like COW pages. The cache holds one reference to
+ * each page, and every page table which maps the page holds one more.
+ * (See `new_user_app_pd_shared`)
+ *
+ * So, executing an image N times results in one copy of its text, not N.
+ *
+ * The cache has a fixed number of entries. When full, the least recently used entry is evicted.
+ * It is the responsibility of the user of the cache to evict an entry when the contents behind
+ * its key change!
+ */
+
+#define IMAGE_CACHE_CAP (8U)
+
+typedef struct _image_cache_t image_cache_t;
+typedef struct _image_cache_entry_t image_cache_entry_t;
+
+struct _image_cache_entry_t {
+    /**
+     * The key of this entry. NULL when this entry is not in use.
+     */
+    const void *key;
+
+    /**
+     * The value of the cache clock when this entry was last used.
+     */
+    uint32_t last_used;
+
+    /**
+     * For every area of the cached user app, the pages of said area, or NULL if the area is not
+     * cached. (i.e. the area is writeable or unoccupied)
+     *
+     * Area `i` has `ceil(area_sizes[i] / M_4K)` pages.
+     */
+    phys_addr_t *area_pages[FOS_MAX_APP_AREAS];
+
+    /**
+     * Where each cached area was loaded in the original user app.
+     */
+    const void *load_positions[FOS_MAX_APP_AREAS];
+
+    /**
+     * The size of each cached area in the original user app.
+     */
+    size_t area_sizes[FOS_MAX_APP_AREAS];
+};
+
+struct _image_cache_t {
+    allocator_t * const al;
+
+    /**
+     * Called right after a key is inserted into the cache.
+     *
+     * This is a chance to take a reference to whatever is behind the key.
+     */
+    void (* const on_insert)(void *ctx, const void *key);
+
+    /**
+     * Called right after a key is removed from the cache.
+     *
+     * After this call, the cache never touches `key` again.
+     */
+    void (* const on_evict)(void *ctx, const void *key);
+
+    void * const ctx;
+
+    /**
+     * Incremented on every cache access. Used for LRU eviction.
+     */
+    uint32_t clock;
+
+    image_cache_entry_t entries[IMAGE_CACHE_CAP];
+};
+
+/**
+ * Create a new empty image cache.
+ *
+ * `on_insert` and `on_evict` are both optional.
+ *
+ * Returns NULL on error.
+ */
+image_cache_t *new_image_cache(allocator_t *al, void (*on_insert)(void *ctx, const void *key),
+        void (*on_evict)(void *ctx, const void *key), void *ctx);
+
+/**
+ * Evicts all entries, then frees the cache.
+ *
+ * Pages which are still mapped by a process live on until said process lets them go.
+ */
+void delete_image_cache(image_cache_t *ic);
+
+/**
+ * Look for the image with key `key`.
+ *
+ * The found entry is only returned if its cached areas exactly match the non-writeable areas of
+ * `ua`. (Position and size) If they don't match, the stale entry is evicted.
+ * `ua` is only inspected for its layout, the `given` buffers are never read.
+ *
+ * Returns NULL if there is no such image.
+ */
+image_cache_entry_t *ic_get(image_cache_t *ic, const void *key, const user_app_t *ua);
+
+/**
+ * Build a new entry for `key` from the non-writeable areas of `ua`.
+ *
+ * If `reader` is given, area contents are read using `reader` rather than taken from the `given`
+ * buffers of `ua`. (See `ua_fill_area_page`)
+ *
+ * If an entry with `key` already exists, it is replaced. If the cache is full, the least recently
+ * used entry is evicted.
+ *
+ * FOS_E_BAD_ARGS if `key` or `ua` is NULL.
+ * FOS_E_EMPTY if `ua` has no non-writeable areas. (Nothing is cached)
+ * FOS_E_INVALID_RANGE/FOS_E_ALIGN_ERROR if a non-writeable area is malformed. (Nothing is cached)
+ * FOS_E_NO_MEM if we run out of memory. (Nothing is cached)
+ * Errors from `reader` are also returned. (Nothing is cached)
+ *
+ * On success, FOS_E_SUCCESS is returned and the new entry is written to `*out`.
+ */
+fernos_error_t ic_put(image_cache_t *ic, const void *key, const user_app_t *ua,
+        ua_area_reader_ft reader, void *reader_ctx, image_cache_entry_t **out);
+
+/**
+ * Evict the entry with key `key`. Does nothing if there is no such entry.
+ */
+void ic_evict(image_cache_t *ic, const void *key);
+
+/**
+ * Get a bit vector where bit `i` is set if area `i` is cached in `ice`.
+ */
+uint32_t ice_area_mask(const image_cache_entry_t *ice);
@@ -5,6 +5,8 @@
 
 #include "s_util/misc.h"
 #include "s_util/err.h"
+#include "s_bridge/shared_defs.h"
+#include "c_config.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -51,8 +53,9 @@ extern uint8_t _static_area_end[];
 
 /**
  * These values are used in the available bits of a page table entry. NOTE: They have
- * no meaning for entries in page directories. Other than the kernel page tables, 
- * all page tables will be placed in arbitrary pages! (Not shared or strictly identity)
+ * no meaning for entries in page directories which point to page tables. (Large entries are
+ * the exception, see below) Other than the kernel page tables, all page tables will be placed
+ * in arbitrary pages! (Not shared or strictly identity)
  *
  * An Identity Entry, is an entry which points to an identity page. This is a page
  * who's physical and virtual addresses are always equal. This page should NEVER be added
@@ -64,11 +67,33 @@ extern uint8_t _static_area_end[];
  * A shared entry points to a non-identity page which is referenced by many page tables.
  * These functions offer little support for shared entries. It is the job the kernel to manage
  * such pages correctly.
+ *
+ * A copy-on-write (COW) entry points to a page which was unique and writeable, but is now
+ * referenced by one or more page tables after a fork. COW entries are always marked read-only.
+ * Every COW page has a reference count (See `page_get_refs`) equal to the number of COW entries
+ * pointing to it. When a COW entry is freed, its page is only returned to the free list once
+ * its reference count hits 0. A write to a COW page faults, at which point the writer is given
+ * its own unique copy. (See `pd_resolve_cow_p`)
+ *
+ * A lazy entry is NOT present. It marks a page which has been reserved, but has no physical
+ * page behind it yet. The first access to a lazy page faults, at which point a zeroed unique 
+ * page is put in its place. (See `pd_resolve_lazy_p`) Lazy entries are treated as allocated by
+ * the allocation functions below, and are shallow copied like shared entries.
+ *
+ * A backed lazy entry is a lazy entry whose page is NOT zeroed when materialized. Instead, its
+ * contents are provided by the lazy page filler. (For example, read from a file, see
+ * `set_lazy_page_filler`) Backed lazy entries are told apart by their base, which is always
+ * `LAZY_BACKED_BASE`. Unlike plain lazy entries, a backed lazy entry may be read-only.
+ * Everywhere else, backed lazy entries are treated exactly like lazy entries.
  */
 
 #define IDENTITY_ENTRY (0)
 #define UNIQUE_ENTRY   (1)
 #define SHARED_ENTRY   (2)
+#define COW_ENTRY      (3)
+#define LAZY_ENTRY     (4)
+
+#define LAZY_BACKED_BASE (M_4K)
 
 static inline pt_entry_t fos_present_pt_entry(phys_addr_t base, bool user, bool writeable) {
     pt_entry_t pte = not_present_pt_entry();
@@ -108,6 +133,92 @@ static inline pt_entry_t fos_shared_pt_entry(phys_addr_t base, bool user, bool w
     return pte;
 }
 
+/**
+ * COW entries are never writeable, the page must be copied (or reclaimed) first.
+ */
+static inline pt_entry_t fos_cow_pt_entry(phys_addr_t base, bool user) {
+    pt_entry_t pte = fos_present_pt_entry(base, user, false);
+
+    pte_set_avail(&pte, COW_ENTRY);
+
+    return pte;
+}
+
+/**
+ * Lazy entries are always writeable once materialized.
+ */
+static inline pt_entry_t fos_lazy_pt_entry(bool user) {
+    pt_entry_t pte = not_present_pt_entry();
+
+    pte_set_user(&pte, user ? 1 : 0);
+    pte_set_writable(&pte, 1);
+    pte_set_avail(&pte, LAZY_ENTRY);
+
+    return pte;
+}
+
+/**
+ * A backed lazy entry keeps its writeable bit once materialized.
+ */
+static inline pt_entry_t fos_backed_lazy_pt_entry(bool user, bool writeable) {
+    pt_entry_t pte = fos_lazy_pt_entry(user);
+
+    pte_set_writable(&pte, writeable ? 1 : 0);
+    pte_set_base(&pte, LAZY_BACKED_BASE);
+
+    return pte;
+}
+
+/*
+ * Large entries.
+ *
+ * A large entry is a page directory entry with the page size bit set. It maps a 4MB aligned
+ * run of 1024 physical pages directly, no page table needed. The available bits of a large entry
+ * have the same meaning as in a page table entry. Only IDENTITY and UNIQUE large entries are
+ * ever created.
+ *
+ * Large identity entries are used for big identity mapped areas (like the epilogue which holds
+ * the framebuffer). Large unique entries are handed out by `pd_alloc_large_pages_p`.
+ *
+ * Anything which needs to work with a single 4K page within a large entry must first split it.
+ * (See `pde_split_large`) Splitting never changes what memory is mapped where.
+ */
+
+static inline pt_entry_t fos_large_identity_pd_entry(phys_addr_t base, bool user, bool writeable) {
+    pt_entry_t pde = fos_identity_pt_entry(base, user, writeable);
+
+    pte_set_ps(&pde, 1);
+
+    return pde;
+}
+
+static inline pt_entry_t fos_large_unique_pd_entry(phys_addr_t base, bool user, bool writeable) {
+    pt_entry_t pde = fos_unique_pt_entry(base, user, writeable);
+
+    pte_set_ps(&pde, 1);
+
+    return pde;
+}
+
+static inline bool fos_pde_is_large(pt_entry_t pde) {
+    return pte_get_present(pde) && pte_get_ps(pde);
+}
+
+static inline bool fos_pte_is_lazy(pt_entry_t pte) {
+    return !pte_get_present(pte) && pte_get_avail(pte) == LAZY_ENTRY;
+}
+
+static inline bool fos_pte_is_backed_lazy(pt_entry_t pte) {
+    return fos_pte_is_lazy(pte) && pte_get_base(pte) == LAZY_BACKED_BASE;
+}
+
+/**
+ * An entry is "in use" if it is present OR if it is lazy.
+ */
+static inline bool fos_pte_in_use(pt_entry_t pte) {
+    return pte_get_present(pte) || pte_get_avail(pte) == LAZY_ENTRY;
+}
+
 /*
  * NOTE: There will be a page directory stored in static memory which must always be loaded when
  * the kernel thread is running! 
@@ -153,23 +264,271 @@ extern uint8_t free_kernel_pages[NUM_FREE_KERNEL_PAGES][M_4K];
  */
 phys_addr_t assign_free_page(uint32_t slot, phys_addr_t p);
 
+/**
+ * Assign free kernel pages [0, n) to the pages in `ps` with a single TLB flush.
+ *
+ * Because the free kernel pages are contiguous, the `n` pages can then be accessed as one buffer
+ * starting at `free_kernel_pages[0]`.
+ *
+ * If `olds` is given, whatever was previously in each slot is written to `olds`.
+ * (Undo with `assign_free_pages(olds, n, NULL)`)
+ *
+ * `n` is capped at NUM_FREE_KERNEL_PAGES.
+ */
+void assign_free_pages(const phys_addr_t *ps, uint32_t n, phys_addr_t *olds);
+
+/*
+ * The physmap.
+ *
+ * When FC_CORE_VMEM_PHYSMAP is non-empty, the kernel page directory permanently maps the first
+ * `PHYSMAP_COVERED_SIZE` bytes of FC_CORE_PMEM_BODY into that window. (Supervisor only, using
+ * large entries when possible) A physical page covered by the physmap can be accessed by simple
+ * offset, no `assign_free_page` (and no TLB flush) required.
+ *
+ * The physmap only exists in the kernel page directory! (And copies of it) The kernel always runs
+ * in the kernel page directory, so this is rarely something to worry about.
+ *
+ * NOTE: Edits to page tables made through the physmap do NOT flush the TLB. If an existing entry
+ * of the current page directory is changed, the TLB must be flushed explicitly.
+ * (See `pd_flush_if_current`)
+ */
+
+#define PHYSMAP_COVERED_SIZE MIN(FC_CORE_VMEM_PHYSMAP_SIZE, FC_CORE_PMEM_BODY_SIZE)
+
+/**
+ * Set to true once paging is enabled (if the physmap is non-empty).
+ */
+extern bool physmap_enabled;
+
+/**
+ * Get a kernel pointer to the physical page `p` via the physmap.
+ *
+ * Returns NULL if the physmap is disabled or `p` isn't covered by it.
+ */
+static inline void *physmap_ptr(phys_addr_t p) {
+    if (!physmap_enabled || p < FC_CORE_PMEM_BODY_START || 
+            p - FC_CORE_PMEM_BODY_START >= PHYSMAP_COVERED_SIZE) {
+        return NULL;
+    }
+
+    return (uint8_t *)FC_CORE_VMEM_PHYSMAP_START + (p - FC_CORE_PMEM_BODY_START);
+}
+
+/**
+ * Returned by `map_page` when the given free kernel page slot was left untouched.
+ * (Never a valid page address as it isn't 4K aligned)
+ */
+#define PAGE_NOT_SLOTTED ((phys_addr_t)1)
+
+/**
+ * Get a kernel pointer to the physical page `p`.
+ *
+ * If `p` is covered by the physmap, that pointer is returned and `*old` is set to
+ * PAGE_NOT_SLOTTED. Otherwise, `p` is placed in free kernel page `slot` and `*old` is set to
+ * what was previously in said slot.
+ *
+ * Either way, `unmap_page(slot, *old)` undoes this.
+ */
+static inline void *map_page(uint32_t slot, phys_addr_t p, phys_addr_t *old) {
+    void *ptr = physmap_ptr(p);
+    if (ptr) {
+        *old = PAGE_NOT_SLOTTED;
+        return ptr;
+    }
+
+    *old = assign_free_page(slot, p);
+    return free_kernel_pages[slot];
+}
+
+static inline void unmap_page(uint32_t slot, phys_addr_t old) {
+    if (old != PAGE_NOT_SLOTTED) {
+        assign_free_page(slot, old);
+    }
+}
+
+/**
+ * Flush the TLB if `pd` is the page directory currently in use.
+ */
+static inline void pd_flush_if_current(phys_addr_t pd) {
+    if (get_page_directory() == pd) {
+        flush_page_cache();
+    }
+}
+
 /**
  * Number of free pages left. (Useful for testing)
+ *
+ * Pages in the pre-zeroed pool count as free. (See `refill_zeroed_pages`)
  */
 uint32_t get_num_free_pages(void);
 
 /**
  * If the given address is blatantly invalid, it will simply be ignored.
+ * (This includes addresses outside FC_CORE_PMEM_BODY and pages which are already free)
  */
 void push_free_page(phys_addr_t page_addr);
 
 /**
- * Attempt to pop a free page from the free page linked list.
+ * Attempt to pop a free page.
+ *
+ * The contents of the page are undefined. The pre-zeroed pool is only touched once every other
+ * free page is gone. (Same goes for `pop_free_page_batch`)
  *
  * NULL_PHYS_ADDR is returned if there are no pages to pop.
  */
 phys_addr_t pop_free_page(void);
 
+/**
+ * Attempt to pop `n` free pages. The pages popped need NOT be contiguous.
+ *
+ * Pages are written to `out`, which must have space for `n` addresses.
+ * Returns the number of pages actually popped. (Less than `n` only when free pages run out)
+ *
+ * This is cheaper than calling `pop_free_page` `n` times.
+ */
+uint32_t pop_free_page_batch(phys_addr_t *out, uint32_t n);
+
+/**
+ * Return `n` physically contiguous pages starting at `s`.
+ *
+ * Equivalent to calling `push_free_page` on each page.
+ */
+void push_free_pages(phys_addr_t s, uint32_t n);
+
+/**
+ * Attempt to pop `n` physically contiguous free pages.
+ *
+ * On success, the physical address of the first page is returned.
+ * NULL_PHYS_ADDR is returned if `n` is 0 or if no large enough run of free pages exists.
+ */
+phys_addr_t pop_free_pages(uint32_t n);
+
+/**
+ * Attempt to pop 1024 physically contiguous free pages which start on a 4MB boundary.
+ * (i.e. the pages behind a large entry)
+ *
+ * On success, the physical address of the first page is returned.
+ * NULL_PHYS_ADDR is returned if no such run exists.
+ *
+ * Return these pages with `push_free_pages(p, 1024)`.
+ */
+phys_addr_t pop_free_large_page(void);
+
+/**
+ * Maximum number of pages held in the pre-zeroed pool.
+ */
+#define ZEROED_POOL_CAP (256U)
+
+/**
+ * Pop a page which is all zeros.
+ *
+ * The page comes from the pre-zeroed pool when possible, otherwise a free page is zeroed on the
+ * spot.
+ *
+ * NULL_PHYS_ADDR is returned if there are no pages to pop.
+ */
+phys_addr_t pop_zeroed_page(void);
+
+/**
+ * Zero up to `n` free pages ahead of time and move them into the pre-zeroed pool.
+ * (The pool never holds more than ZEROED_POOL_CAP pages)
+ *
+ * This is meant to be called when the kernel has nothing better to do.
+ *
+ * Returns the number of pages added to the pool.
+ */
+uint32_t refill_zeroed_pages(uint32_t n);
+
+/**
+ * Number of pages in the pre-zeroed pool. (Useful for testing)
+ */
+uint32_t get_num_zeroed_pages(void);
+
+/**
+ * The zero page is a single read-only page of zeros shared by every memory space.
+ *
+ * A plain lazy page which is read before it is written is mapped to the zero page with a COW 
+ * entry. The first write then swaps in a page of its own. (See `pd_resolve_lazy_read_p`)
+ *
+ * The zero page is never freed and never reference counted. `page_get_refs` and `page_dec_refs`
+ * always give UINT32_MAX for it. Entries pointing to it are never charged to any 
+ * `proc_mem_stats_t`.
+ */
+phys_addr_t get_zero_page(void);
+
+/**
+ * Get the reference count of a page in FC_CORE_PMEM_BODY.
+ *
+ * Only COW pages are reference counted, all other pages should always have a count of 0.
+ * (Pages held by the image cache are also counted, see `k_startup/image_cache.h`)
+ * Returns 0 if `p` is invalid.
+ */
+uint32_t page_get_refs(phys_addr_t p);
+
+/**
+ * Increment the reference count of a page. Does nothing if `p` is invalid.
+ */
+void page_inc_refs(phys_addr_t p);
+
+/**
+ * Decrement the reference count of a page. Returns the new reference count.
+ *
+ * Does nothing and returns 0 if `p` is invalid or if its reference count is already 0.
+ */
+uint32_t page_dec_refs(phys_addr_t p);
+
+/*
+ * Page accounting.
+ *
+ * A page directory can be attached to a `proc_mem_stats_t`. From then on, every function in
+ * `k_startup/page.h` and `k_startup/page_helpers.h` which maps or unmaps user pages in said page
+ * directory keeps the counts up to date. (Page tables given directly, like in `pt_alloc_range`,
+ * are never accounted for)
+ *
+ * At most FC_CORE_MAX_PROCS page directories can be attached at once. (One per process)
+ *
+ * The functions which pop fresh pages for an attached page directory (Filling ranges and 
+ * resolving lazy pages) also respect `stats->quota`. They fail with FOS_E_NO_MEM once the quota
+ * is hit, exactly like when physical memory runs out.
+ */
+
+/**
+ * Attach `pd` to `stats`. The counters of `stats` are first set by counting the pages already in
+ * `pd`. (`stats->quota` is left as is)
+ *
+ * FOS_E_BAD_ARGS if `pd` is NULL_PHYS_ADDR or `stats` is NULL.
+ * FOS_E_ALREADY_ALLOCATED if `pd` is already attached.
+ * FOS_E_NO_SPACE if FC_CORE_MAX_PROCS page directories are already attached.
+ */
+fernos_error_t pd_acct_attach(phys_addr_t pd, proc_mem_stats_t *stats);
+
+/**
+ * Stop keeping the counts of `pd`. Does nothing if `pd` isn't attached.
+ *
+ * Deleting a page directory detaches it automatically.
+ */
+void pd_acct_detach(phys_addr_t pd);
+
+/**
+ * Get the stats `pd` is attached to. NULL if `pd` isn't attached.
+ */
+proc_mem_stats_t *pd_acct_find(phys_addr_t pd);
+
+/**
+ * Add (or remove when `add` is false) the page described by entry `pte` at page index `pi` to
+ * `stats`. When `pte` is a large entry, `pi` should be the index of its first page.
+ *
+ * Does nothing if `stats` is NULL or if the entry isn't a present, non-identity, user entry.
+ */
+void pd_acct_charge(proc_mem_stats_t *stats, uint32_t pi, pt_entry_t pte, bool large, bool add);
+
+/**
+ * How many more pages can be charged to `stats` before its quota is hit.
+ *
+ * UINT32_MAX if `stats` is NULL or has no quota.
+ */
+uint32_t pd_acct_room(const proc_mem_stats_t *stats);
+
 /**
  * Create a new page table. Returns NULL_PHYS_ADDR on error.
  */
@@ -179,6 +538,7 @@ phys_addr_t new_page_table(void);
  * Delete a page table.
  *
  * This returns all UNIQUE pages pointed to by the table to the free list.
+ * COW pages are returned when their last reference is deleted.
  *
  * Only returns SHARED pages if `return_shared` is true.
  */
@@ -216,15 +576,31 @@ fernos_error_t pt_alloc_range(phys_addr_t pt, bool user, bool shared, uint32_t s
 /**
  * Free a range within a page table.
  * Pages marked UNIQUE are ALWAYS returned to the free list.
+ * Pages marked COW have their reference count decremented, they are returned to the free list
+ * once the count reaches 0.
  *
  * If `return_shared` is `true`, pages marked `SHARED` are also returned to the free list.
  * This should only be done when the user can gauranteed these underlying pages aren't mapped
  * in any other page tables!
  *
+ * Lazy entries are simply cleared.
+ *
  * s and e follow the same rules as described in pt_alloc_range.
  */
 void pt_free_range(phys_addr_t pt, bool return_shared, uint32_t s, uint32_t e);
 
+/**
+ * Replace the large entry `*pde` with a page table holding 1024 entries which map the exact same
+ * pages with the exact same attributes.
+ *
+ * `pde` should point into a page directory which is currently mapped in a free kernel page.
+ * This uses free kernel page slot 2 to fill the new page table.
+ *
+ * Does nothing if `*pde` is not a large entry.
+ * Returns FOS_E_NO_MEM if the page table couldn't be allocated. (`*pde` is left as is)
+ */
+fernos_error_t pde_split_large(pt_entry_t *pde);
+
 /**
  * Create a new page directory. Returns NULL_PHYS_ADDR on error.
  *
@@ -261,23 +637,93 @@ fernos_error_t pd_alloc_pages_p(phys_addr_t pd, bool user, bool shared, uint32_t
  */
 fernos_error_t pd_alloc_pages(phys_addr_t pd, bool user, bool shared, void *s, const void *e, const void **true_e);
 
+/**
+ * Like `pd_alloc_pages_p` with `shared` false, except every 4MB aligned chunk which lies entirely
+ * within [pi_s, pi_e) and is entirely unmapped is given a single large entry. (When a 4MB aligned
+ * run of physical pages is available, otherwise regular pages are used)
+ *
+ * Follows the exact same error and `true_e` rules as `pd_alloc_pages_p`.
+ */
+fernos_error_t pd_alloc_large_pages_p(phys_addr_t pd, bool user, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e);
+
+/**
+ * Wrapper around `pd_alloc_large_pages_p`.
+ *
+ * FOS_E_ALIGN_ERROR if `pd`, `s`, or `e` aren't 4K aligned.
+ */
+fernos_error_t pd_alloc_large_pages(phys_addr_t pd, bool user, void *s, const void *e, const void **true_e);
+
+/**
+ * Reserve pages in a page directory without giving them any physical pages.
+ *
+ * Every entry in [pi_s, pi_e) is marked lazy. (Page tables are still allocated if necessary)
+ * Physical pages are only handed out as lazy pages are touched. (See `pd_resolve_lazy_p`)
+ *
+ * Follows the exact same error and `true_e` rules as `pd_alloc_pages_p`. 
+ * FOS_E_NO_MEM can only be returned if we fail to allocate a page table.
+ */
+fernos_error_t pd_reserve_pages_p(phys_addr_t pd, bool user, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e);
+
+/**
+ * Wrapper around `pd_reserve_pages_p`.
+ *
+ * FOS_E_ALIGN_ERROR if `pd`, `s`, or `e` aren't 4K aligned.
+ */
+fernos_error_t pd_reserve_pages(phys_addr_t pd, bool user, void *s, const void *e, const void **true_e);
+
+/**
+ * Like `pd_reserve_pages_p`, except every entry is marked as a backed lazy entry.
+ * When touched, each page is filled by the lazy page filler rather than zeroed, and is only
+ * writeable if `writeable` is true. (See `pd_resolve_lazy_p`)
+ */
+fernos_error_t pd_reserve_backed_pages_p(phys_addr_t pd, bool user, bool writeable, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e);
+
+/**
+ * Map already existing pages into a page directory as COW entries.
+ *
+ * Page `pi` in [pi_s, pi_e) is mapped to `pages[pi - pi_s]`. The reference count of every mapped
+ * page is incremented. This way, many page directories can share the same read-only pages,
+ * and a write still results in a private copy. (See `pd_resolve_cow_p`)
+ *
+ * NOTE: The caller must hold its own reference to each page for as long as it wants the page
+ * to stay around. Otherwise, the first page directory to write to or free the page takes it.
+ *
+ * FOS_E_BAD_ARGS if `pages` is NULL.
+ * Otherwise, follows the exact same error and `true_e` rules as `pd_alloc_pages_p`.
+ * FOS_E_NO_MEM can only be returned if we fail to allocate a page table.
+ */
+fernos_error_t pd_map_cow_pages_p(phys_addr_t pd, bool user, const phys_addr_t *pages, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e);
+
+/**
+ * Wrapper around `pd_map_cow_pages_p`.
+ *
+ * FOS_E_ALIGN_ERROR if `pd`, `s`, or `e` aren't 4K aligned.
+ */
+fernos_error_t pd_map_cow_pages(phys_addr_t pd, bool user, const phys_addr_t *pages, void *s, const void *e, const void **true_e);
+
 /**
  * Remove all pages from s to e in the given page directory.
  *
  * (Shared pages are returned if and only if `return_shared` is `true`)
  *
+ * Large entries which are only partially freed are split first. A unique large entry reuses one
+ * of its own freed pages as its new page table, so this never fails. Only when a large identity
+ * entry can't be split is FOS_E_NO_MEM returned. (Nothing in the range is freed in that case)
+ *
  * NOTE: `pi_e` will be rounded down to become valid!
  * (i.e. if pi_e == (1024 * 1024) + 100, it'll be rounded down to (1024 * 1024))
  * If pi_s >= (1024 * 1024), this does nothing!
  */
-void pd_free_pages_p(phys_addr_t pd, bool return_shared, uint32_t pi_s, uint32_t pi_e);
+fernos_error_t pd_free_pages_p(phys_addr_t pd, bool return_shared, uint32_t pi_s, uint32_t pi_e);
 
 /**
  * Remove all ble pages from s to e in the given page directory.
  *
  * Wrapper around `pd_free_pages_p`.
+ *
+ * FOS_E_ALIGN_ERROR if `pd`, `s`, or `e` aren't 4K aligned.
  */
-void pd_free_pages(phys_addr_t pd, bool return_shared, void *s, const void *e);
+fernos_error_t pd_free_pages(phys_addr_t pd, bool return_shared, void *s, const void *e);
 
 /**
  * Return *all* pages under `pd` to the free list.
@@ -30,6 +30,17 @@ phys_addr_t pd_get_underlying_p(phys_addr_t pd, uint32_t pi);
  */
 phys_addr_t pd_get_underlying(phys_addr_t pd, const void *ptr);
 
+/**
+ * Get the physical pages mapped at indeces [pi, pi + n) with a single page table walk.
+ * (The page directory and each page table are mapped once)
+ *
+ * Pages are written to `out` in order. The walk stops at the first page which isn't mapped,
+ * is lazy, or is COW when `write` is true. (i.e. pages which can't be accessed as is)
+ *
+ * Returns the number of pages written to `out`.
+ */
+uint32_t pd_get_underlying_run_p(phys_addr_t pd, uint32_t pi, uint32_t n, bool write, phys_addr_t *out);
+
 /**
  * Given the physical address of two page tables, copy page table entries with in range [s, e)
  * from `src_pt` to `dest_pt`. 
@@ -51,6 +62,22 @@ phys_addr_t pd_get_underlying(phys_addr_t pd, const void *ptr);
  */
 fernos_error_t pt_copy_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s, uint32_t e);
 
+/**
+ * Copy-on-write version of `pt_copy_range`.
+ *
+ * Writeable unique entries in `src_pt` are converted to COW entries, the same COW entry is then
+ * placed in `dest_pt`. (No page is copied) Existing COW entries are shared again. All other
+ * entries are handled exactly as in `pt_copy_range`. (i.e. read-only unique pages are still
+ * deep copied)
+ *
+ * NOTE: This modifies `src_pt`! If `src_pt` belongs to the currently loaded page directory,
+ * the TLB must be flushed before relying on the new read-only entries.
+ *
+ * Same errors as `pt_copy_range`. On failure, `dest_pt` is returned to its initial state,
+ * however entries in `src_pt` may remain COW. (Which is harmless)
+ */
+fernos_error_t pt_cow_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s, uint32_t e);
+
 /**
  * Create a deep copy of a page table.
  *
@@ -72,6 +99,11 @@ phys_addr_t copy_page_table(phys_addr_t pt);
  */
 fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t pi_s, uint32_t pi_e);
 
+/**
+ * Copy-on-write version of `pd_copy_range_p`. See `pt_cow_range`.
+ */
+fernos_error_t pd_cow_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t pi_s, uint32_t pi_e);
+
 /**
  * Wrapper around `pd_copy_range_p`.
  *
@@ -90,12 +122,122 @@ fernos_error_t pd_copy_range(phys_addr_t dest_pd, phys_addr_t src_pd, void *s, c
  */
 phys_addr_t copy_page_directory(phys_addr_t pd);
 
+/**
+ * Create a copy-on-write copy of a page directory. (Used when forking)
+ *
+ * Writeable unique pages become COW pages shared by both `pd` and the copy. Page tables
+ * themselves are never shared.
+ *
+ * Returns NULL_PHYS_ADDR if there is insufficient memory.
+ */
+phys_addr_t cow_page_directory(phys_addr_t pd);
+
+/**
+ * Give the page at index `pi` in `pd` back write access if it is a COW page.
+ *
+ * If the page still has other references, a copy is made and mapped in its place.
+ * If this is the only reference left, the page is simply remarked as unique.
+ * If the page is the zero page, a pre-zeroed page is mapped in its place. (See `get_zero_page`)
+ *
+ * FOS_E_BAD_ARGS if `pd` is NULL_PHYS_ADDR or `pi` is out of range.
+ * FOS_E_INVALID_INDEX if the page at `pi` is not a present COW page.
+ * FOS_E_NO_MEM if a copy was needed, but there are no free pages.
+ * FOS_E_SUCCESS if the page is now unique and writeable.
+ */
+fernos_error_t pd_resolve_cow_p(phys_addr_t pd, uint32_t pi);
+
+/**
+ * Wrapper around `pd_resolve_cow_p`. `ptr` can be any byte within the page.
+ */
+fernos_error_t pd_resolve_cow(phys_addr_t pd, const void *ptr);
+
+/**
+ * Clear the dirty bit of the page at index `pi` in `pd`.
+ *
+ * If the page is present and was dirty, its physical address is returned. Otherwise,
+ * NULL_PHYS_ADDR is returned. (Large entries are never reported)
+ *
+ * The dirty bit is set by the CPU for user writes and by `mem_cpy_to_user`/`mem_set_to_user`
+ * for kernel writes. It survives the page becoming COW and being made unique again.
+ */
+phys_addr_t pd_clean_page_p(phys_addr_t pd, uint32_t pi);
+
+/**
+ * Find the highest run of `n` unused pages within [pi_s, pi_e) of `pd`.
+ * (A page is unused if it is neither present nor lazy)
+ *
+ * On success, the index of the first page of the run is written to `*pi`.
+ *
+ * FOS_E_BAD_ARGS if `pd` is NULL_PHYS_ADDR, `pi` is NULL, or `n` is 0.
+ * FOS_E_INVALID_RANGE if [pi_s, pi_e) is an invalid range.
+ * FOS_E_NO_SPACE if there is no such run.
+ */
+fernos_error_t pd_find_free_run_p(phys_addr_t pd, uint32_t pi_s, uint32_t pi_e, uint32_t n, 
+        uint32_t *pi);
+
+/**
+ * Write the contents of page `pi` of the memory space described by `pd` to `dest`.
+ * (`dest` points to a full 4K page)
+ *
+ * Used to materialize backed lazy pages. (See `k_startup/page.h`)
+ */
+typedef fernos_error_t (*lazy_page_filler_ft)(void *ctx, phys_addr_t pd, uint32_t pi, void *dest);
+
+/**
+ * Set the function used to fill backed lazy pages. There is only one filler for the whole system.
+ *
+ * When no filler is set, backed lazy pages are zeroed just like plain lazy pages.
+ */
+void set_lazy_page_filler(lazy_page_filler_ft filler, void *ctx);
+
+/**
+ * Give the page at index `pi` in `pd` a physical page if it is a lazy page.
+ *
+ * A plain lazy page is given a zeroed page. (From the pre-zeroed pool when possible, see
+ * `pop_zeroed_page`) A backed lazy page is given a page filled by the lazy page filler. 
+ * (See `set_lazy_page_filler`)
+ *
+ * FOS_E_BAD_ARGS if `pd` is NULL_PHYS_ADDR or `pi` is out of range.
+ * FOS_E_INVALID_INDEX if the page at `pi` is not a lazy page.
+ * FOS_E_NO_MEM if there are no free pages.
+ * Errors from the lazy page filler are also returned. (The entry is left lazy)
+ * FOS_E_SUCCESS if the page is now unique and filled. (Writeable unless it was a read-only
+ * backed lazy page)
+ */
+fernos_error_t pd_resolve_lazy_p(phys_addr_t pd, uint32_t pi);
+
+/**
+ * Wrapper around `pd_resolve_lazy_p`. `ptr` can be any byte within the page.
+ */
+fernos_error_t pd_resolve_lazy(phys_addr_t pd, const void *ptr);
+
+/**
+ * Like `pd_resolve_lazy_p`, but for when the page is only being read.
+ *
+ * A plain lazy page is mapped to the zero page with a COW entry instead of being given a page
+ * of its own. (See `get_zero_page`) This never fails for lack of memory. A later write is resolved
+ * with `pd_resolve_cow_p` like any other COW page, except the new page is taken pre-zeroed
+ * rather than copied.
+ *
+ * A backed lazy page is resolved exactly like in `pd_resolve_lazy_p`.
+ *
+ * Same errors as `pd_resolve_lazy_p`.
+ */
+fernos_error_t pd_resolve_lazy_read_p(phys_addr_t pd, uint32_t pi);
+
+/**
+ * Wrapper around `pd_resolve_lazy_read_p`. `ptr` can be any byte within the page.
+ */
+fernos_error_t pd_resolve_lazy_read(phys_addr_t pd, const void *ptr);
+
 /**
  * Copy the contents from a buffer in a different memory space, to a buffer in this memory space.
  *
  * Returns an error if the user src buffer is not entirely mapped.
  * Returns an error if arguments are bad.
  *
+ * Lazy pages in the source are materialized before being read.
+ *
  * If `copied` is given, writes the number of successfully copied bytes to *copied.
  * On Success, *copied will always equal bytes.
  */
@@ -108,6 +250,9 @@ fernos_error_t mem_cpy_from_user(void *dest, phys_addr_t user_pd, const void *us
  * Returns an error if the user dest buffer is not entirely mapped.
  * Returns an error if args are bad.
  *
+ * Lazy pages in the destination are materialized, and COW pages in the destination are made
+ * unique before being written to.
+ *
  * If `copied` is given, writes the number of successfully copied bytes to *copied.
  * On Success, *copied will always equal bytes.
  */
@@ -158,6 +303,48 @@ fernos_error_t mem_set_to_user(phys_addr_t user_pd, void *user_dest, uint8_t val
 fernos_error_t new_user_app_pd(const user_app_t *ua, const void *abs_ab, size_t abs_ab_len,
         phys_addr_t *out);
 
+/**
+ * A function which reads `len` bytes of the given part of area `area_ind` into `dest`, starting
+ * at byte `offset` of said part.
+ *
+ * This lets areas of a user app be loaded from somewhere other than their `given` buffers.
+ * (For example, straight from an ELF file)
+ */
+typedef fernos_error_t (*ua_area_reader_ft)(void *ctx, size_t area_ind, size_t offset, void *dest,
+        size_t len);
+
+/**
+ * Write the contents of page `page_ind` of area `area_ind` of `ua` to `vpage`.
+ * (`vpage` must point to a full 4K page)
+ *
+ * The given bytes of the page come from `reader` when it is non-NULL, otherwise they come from
+ * the area's `given` buffer. Everything else in the page is zeroed.
+ *
+ * Only errors from `reader` are returned.
+ */
+fernos_error_t ua_fill_area_page(const user_app_t *ua, size_t area_ind, ua_area_reader_ft reader,
+        void *reader_ctx, uint32_t page_ind, void *vpage);
+
+/**
+ * Like `new_user_app_pd`, except areas can be loaded in different ways.
+ *
+ * `area_pages` is either NULL, or an array of `FOS_MAX_APP_AREAS` page arrays. When
+ * `area_pages[i]` is non-NULL, area `i` is NOT allocated or copied. Instead, the pages
+ * `area_pages[i][0...ceil(area_size / M_4K))` are mapped as COW entries in the new page directory.
+ * The caller is expected to hold its own reference to each of these pages.
+ * (See `pd_map_cow_pages_p` and `k_startup/image_cache.h`)
+ *
+ * When bit `i` of `backed_mask` is set (and area `i` is not given in `area_pages`), area `i` is
+ * NOT loaded at all. Its pages are reserved as backed lazy pages which are filled by the lazy
+ * page filler on first access. (See `pd_reserve_backed_pages_p` and `set_lazy_page_filler`)
+ *
+ * When `reader` is given, all other areas are filled using `reader` rather than their `given`
+ * buffers. (See `ua_fill_area_page`) An error from `reader` fails the whole call.
+ */
+fernos_error_t new_user_app_pd_shared(const user_app_t *ua, phys_addr_t * const *area_pages,
+        uint32_t backed_mask, ua_area_reader_ft reader, void *reader_ctx, const void *abs_ab, size_t abs_ab_len,
+        phys_addr_t *out);
+
 /**
  * Copy a user app which lives in a different memory space into this memory space.
  *
@@ -167,3 +354,12 @@ fernos_error_t new_user_app_pd(const user_app_t *ua, const void *abs_ab, size_t
  * Returns NULL on error.
  */
 user_app_t *ua_copy_from_user(allocator_t *al, phys_addr_t pd, const user_app_t *u_ua);
+
+/**
+ * Like `ua_copy_from_user`, except the given buffers of some areas are not copied.
+ *
+ * If bit `i` of `skip_mask` is set, area `i` of the copy will have a NULL `given` buffer and a
+ * `given_size` of 0. (All other fields of the area are still copied)
+ */
+user_app_t *ua_copy_from_user_partial(allocator_t *al, phys_addr_t pd, const user_app_t *u_ua,
+        uint32_t skip_mask);
@@ -44,6 +44,7 @@ typedef struct _plugin_impl_t {
     fernos_error_t (*plg_on_fork_proc)(plugin_t *plg, proc_id_t cpid);
     fernos_error_t (*plg_on_reset_proc)(plugin_t *plg, proc_id_t pid);
     fernos_error_t (*plg_on_reap_proc)(plugin_t *plg, proc_id_t rpid);
+    fernos_error_t (*plg_on_return_mem)(plugin_t *plg, proc_id_t pid, const void *s, const void *e);
 } plugin_impl_t;
 
 
@@ -185,3 +186,26 @@ static inline fernos_error_t plg_on_reap_proc(plugin_t *plg, proc_id_t rpid) {
  */
 fernos_error_t plgs_on_reap_proc(plugin_t **plgs, size_t plgs_len, proc_id_t rpid);
 
+/**
+ * When the kernel state's current thread returns the pages from `s` to `e` of its free area,
+ * this will be called BEFORE the pages are unmapped. (See `ks_return_mem`)
+ *
+ * `s` and `e` are 4K aligned and `s` < `e`.
+ *
+ * The addresses in this range can be handed out again right after, so any plugin state which
+ * refers to them must be dropped here.
+ */
+static inline fernos_error_t plg_on_return_mem(plugin_t *plg, proc_id_t pid, const void *s, 
+        const void *e) {
+    if (plg->impl->plg_on_return_mem) {
+        return plg->impl->plg_on_return_mem(plg, pid, s, e);
+    }
+    return FOS_E_SUCCESS;
+}
+
+/**
+ * Execute `plg_on_return_mem` on an array of plugins.
+ */
+fernos_error_t plgs_on_return_mem(plugin_t **plgs, size_t plgs_len, proc_id_t pid, 
+        const void *s, const void *e);
+
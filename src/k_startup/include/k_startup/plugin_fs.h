@@ -2,6 +2,7 @@
 #pragma once
 
 #include "k_startup/handle.h"
+#include "k_startup/image_cache.h"
 #include "k_startup/plugin.h"
 #include "k_startup/state.h"
 #include "s_block_device/file_sys.h"
@@ -9,9 +10,16 @@
 
 #define KS_FS_TX_MAX_LEN (2048U)
 
+/**
+ * When a file is executed, every area which has at least this many bytes in the file is demand
+ * paged. (Rather than read in full before the new process starts)
+ */
+#define KS_FS_DEMAND_PAGE_MIN_SIZE (0x10000U)
+
 typedef struct _plugin_fs_t plugin_fs_t;
 typedef struct _plugin_fs_handle_state_t plugin_fs_handle_state_t;
 typedef struct _plugin_fs_nk_map_entry_t plugin_fs_nk_map_entry_t;
+typedef struct _plugin_fs_region_t plugin_fs_region_t;
 
 /*
  * The file system plugin!
@@ -55,6 +63,61 @@ struct _plugin_fs_nk_map_entry_t {
     basic_wait_queue_t *bwq;
 };
 
+/**
+ * A range of a process's memory space whose contents come from a file.
+ *
+ * The pages of a region are mapped as backed lazy pages. Each page is read from the file the
+ * first time it is touched. (See `set_lazy_page_filler`)
+ *
+ * Regions are created when a file is executed (demand paged segments), or when a file is
+ * mapped with `PLG_FS_HCID_MMAP`.
+ *
+ * NOTE: A file cannot be removed while a region references it, but it can still be written to.
+ * Pages which have not been touched yet will see the new contents.
+ */
+struct _plugin_fs_region_t {
+    plugin_fs_region_t *next;
+
+    /**
+     * Start of the region. (4K Aligned)
+     */
+    const void *start;
+
+    /**
+     * Exclusive end of the region. (4K Aligned)
+     */
+    const void *end;
+
+    /**
+     * The file backing this region.
+     *
+     * Every region holds one reference to this key in the `nk_map`.
+     */
+    fs_node_key_t nk;
+
+    /**
+     * The offset into the file of the first byte of the region.
+     */
+    size_t offset;
+
+    /**
+     * How many bytes of the region come from the file. All bytes after are zero.
+     */
+    size_t file_len;
+
+    /**
+     * True if this region was created with `PLG_FS_HCID_MMAP`. (Only these can be unmapped)
+     */
+    bool mmapped;
+
+    /**
+     * When true, dirty pages of the region are written back to the file on flush, unmap,
+     * exec, and reap. Only the first `file_len` bytes are ever written back. (The file never
+     * grows)
+     */
+    bool write_back;
+};
+
 struct _plugin_fs_t {
     plugin_t super;
 
@@ -65,12 +128,33 @@ struct _plugin_fs_t {
      */
     map_t * const nk_map;
 
+    /**
+     * Read-only areas of recently executed files, keyed by node key.
+     *
+     * Every key in this cache holds one reference in the `nk_map`.
+     * An entry is evicted as soon as its file is written to or removed.
+     */
+    image_cache_t * const ic;
+
     /**
      * The current working directory of each process. 
      *
      * If a process exists, it will have a non-null value in this array!
      */
     fs_node_key_t cwds[FC_CORE_MAX_PROCS];
+
+    /**
+     * The file backed regions of each process. (NULL if a process has none)
+     */
+    plugin_fs_region_t *regions[FC_CORE_MAX_PROCS];
+
+    /**
+     * The regions of the process being created by an exec which is currently in progress.
+     *
+     * These are handed to the executing process when it is reset, if the exec fails, they are
+     * freed by the exec command itself.
+     */
+    plugin_fs_region_t *exec_regions;
 };
 
 /**
@@ -57,7 +57,7 @@ struct _window_gfx_base_t {
     /**
      * Woken threads are scheduled here.
      */
-    ring_t * const schedule;
+    schedule_t * const schedule;
 };
 
 /**
@@ -65,7 +65,7 @@ struct _window_gfx_base_t {
  *
  * References will be set as 1.
  */
-fernos_error_t init_window_gfx_base(window_gfx_base_t *win, gfx_manager_t *gm, const window_impl_t *impl, allocator_t *al, ring_t *sch);
+fernos_error_t init_window_gfx_base(window_gfx_base_t *win, gfx_manager_t *gm, const window_impl_t *impl, allocator_t *al, schedule_t *sch);
 
 /**
  * GFX Base windows are promised to be dynamically allocated.
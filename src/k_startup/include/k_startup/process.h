@@ -44,6 +44,14 @@ struct _process_t {
      */
     phys_addr_t pd;
 
+    /**
+     * How many physical pages this process's memory space uses.
+     *
+     * `pd` is always attached to these stats, so they are kept up to date by the paging
+     * functions. (See `pd_acct_attach`)
+     */
+    proc_mem_stats_t mem_stats;
+
     /**
      * A pointer to the parent process, NULL if the root process.
      */
@@ -77,6 +85,12 @@ struct _process_t {
      */
     vector_wait_queue_t *join_queue;
 
+    /**
+     * The summed scheduler statistics of all threads which have been deleted from this process.
+     * (See `proc_sched_stats`)
+     */
+    sched_stats_t exited_stats;
+
     /**
      * all processes have a main thread. When this thread exits, the process exits.
      *
@@ -142,7 +156,10 @@ struct _process_t {
  *
  * The main thread will start as NULL.
  *
- * If any allocation fails, NULL is returned.
+ * `pd` is attached to the new process's `mem_stats`. The new process's quota is `parent`'s quota,
+ * or FC_CORE_PROC_FRAME_QUOTA if `parent` has none. (When `parent` is NULL, there is no quota)
+ *
+ * If any allocation fails (or `pd` can't be attached), NULL is returned.
  */
 process_t *new_process(allocator_t *al, proc_id_t pid, phys_addr_t pd, process_t *parent);
 
@@ -170,6 +187,25 @@ static inline process_t *new_da_process(proc_id_t pid, phys_addr_t pd, process_t
  */
 fernos_error_t new_process_fork(process_t *proc, thread_t *thr, proc_id_t cpid, process_t **out);
 
+/**
+ * Given a process, create a new child process which runs in the fresh memory space `new_pd`.
+ *
+ * This is what you'd get by forking `proc` and then having the child call `proc_exec`, except
+ * `proc`'s memory space is never copied.
+ *
+ * The child will have pid `cpid` and parent `proc`. Its single main thread starts detached
+ * at `entry` with the given args. Only `proc`'s default IO handles are copied over.
+ * (Just like `new_process_fork`, `proc` is not edited in ANY WAY)
+ *
+ * `new_pd` is always consumed by this call. On error, it is deleted.
+ *
+ * Returns FOS_E_ABORT_SYSTEM if some catastrophic error occurs.
+ *
+ * Uses the same allocator as the given process.
+ */
+fernos_error_t new_process_spawn(process_t *proc, proc_id_t cpid, phys_addr_t new_pd,
+        uintptr_t entry, uint32_t arg0, uint32_t arg1, uint32_t arg2, process_t **out);
+
 /**
  * Process destructor!
  *
@@ -193,7 +229,8 @@ fernos_error_t delete_process(process_t *proc);
  * the user stacks, we rely on the PF handler to do that!
  * 
  * `pid` is preserved.
- * `pd` is switched with `new_pd`. (then `pd` is deleted)
+ * `pd` is switched with `new_pd`. (then `pd` is deleted, `mem_stats` are recounted for `new_pd`,
+ *  the quota is preserved)
  * `parent` is preserved.
  * `children` is preserved.
  * `zombie_children` is preserved.
@@ -213,6 +250,18 @@ fernos_error_t delete_process(process_t *proc);
 fernos_error_t proc_exec(process_t *proc, phys_addr_t new_pd, uintptr_t entry, uint32_t arg0,
         uint32_t arg1, uint32_t arg2);
 
+/**
+ * Return the user pages of `proc`'s memory space to the free list. (The app area, the app
+ * arguments area, the free area and all thread stacks) Shared entries are left alone.
+ *
+ * This is for processes which will never run again, but can't be deleted just yet. (i.e. zombies)
+ * Pages tracked by plugins (like file mappings and shared memory) should be let go of through 
+ * the plugins first. (See `plgs_on_reset_proc`)
+ *
+ * `proc` itself is still deleted with `delete_process`.
+ */
+void proc_release_memory(process_t *proc);
+
 /**
  * Create a thread within a process with the given entry point and argument!
  * The created thread will start in a detached state.
@@ -235,3 +284,9 @@ thread_t *proc_new_thread(process_t *proc, uintptr_t entry, uint32_t arg0, uint3
  * If you'd like the thread's stack pages to be returned, set `return_stack` to true.
  */
 void proc_delete_thread(process_t *proc, thread_t *thr, bool return_stack);
+
+/**
+ * Write the scheduler statistics of the process as a whole to `*stats`. (The sum over all threads
+ * ever run by `proc`, including deleted ones)
+ */
+void proc_sched_stats(process_t *proc, sched_stats_t *stats);
@@ -11,7 +11,8 @@
 #include "s_bridge/ctx.h"
 #include "s_data/map.h"
 #include "s_bridge/app.h"
-#include "s_data/ring.h"
+#include "k_startup/thread.h"
+#include "k_startup/image_cache.h"
 
 #include "s_block_device/file_sys.h"
 
@@ -57,8 +58,9 @@
  *
  * Now, threads and process are given hooks for doing the modifications they need in certain
  * situations. For example, a function in `thread.c` should never access kernel state schedule
- * directly. However, threads now inherit from `ring_element`, which give them the ability 
- * to remove themselves from any "ring/schedule" without knowledge of where said schedule lives.
+ * directly. However, threads now inherit from `ring_element` (and remember their `schedule`), which
+ * give them the ability to remove themselves from any schedule without knowledge of where said
+ * schedule lives.
  * The same concept applies to the thread `wq` field, and a process's handle states!
  *
  * Addition (9/1/2025) NOTE that many of these functions are designed specifically to correspond
@@ -88,9 +90,17 @@ struct _kernel_state_t {
     allocator_t * const al;
 
     /**
-     * The schedule!
+     * Optional allocator for short lived scratch memory. (NULL if not set)
+     *
+     * Everything allocated here MUST be freed before the system call which allocated it returns.
+     * Use `ks_scratch_al` to get this allocator, it falls back to `al` when this is NULL.
+     */
+    allocator_t *scratch_al;
+
+    /**
+     * The schedule! `schedule.head` is the current thread.
      */
-    ring_t schedule;
+    schedule_t schedule;
 
     /**
      * Every process will have a globally unique ID!
@@ -104,12 +114,28 @@ struct _kernel_state_t {
 
     /**
      * This counter is initialized as 0 and incremented every time the
-     * timer interrupt handler is entered.
+     * timer interrupt handler is entered. (While idle, it is incremented by however many ticks
+     * the kernel was idle for, see `ks_idle`)
      */
     uint32_t curr_tick;
 
     /**
-     * Threads that call the sleep system call will be placed in this queue.
+     * When non-zero, the kernel is idle and the PIT is in one-shot mode, set to interrupt
+     * this many PIT cycles after the kernel went idle.
+     */
+    uint32_t idle_counts;
+
+    /**
+     * Idle periods don't always last a whole number of ticks. The PIT cycles left over after 
+     * crediting `curr_tick` are kept here. (Always less than `TICK_PIT_RELOAD_VAL`)
+     */
+    uint32_t idle_rem_counts;
+
+    /**
+     * Threads that call the sleep system calls will be placed in this queue.
+     *
+     * Its times are in units of 2^KS_SLEEP_UNIT_SHIFT nanoseconds of the monotonic clock. 
+     * (See `clock_ns`)
      */
     timed_wait_queue_t * const sleep_q;
 
@@ -136,6 +162,13 @@ static inline kernel_state_t *new_da_kernel_state(void) {
     return new_kernel_state(get_default_allocator());
 }
 
+/**
+ * Get the allocator to use for scratch memory within a system call.
+ */
+static inline allocator_t *ks_scratch_al(kernel_state_t *ks) {
+    return ks->scratch_al ? ks->scratch_al : ks->al;
+}
+
 /**
  * Place the given plugin pointer in the plugins table at slot `plg_id`.
  *
@@ -159,7 +192,8 @@ fernos_error_t ks_kernel_cmd(kernel_state_t *ks, plugin_id_t plg_id, plugin_kern
         uint32_t arg1, uint32_t arg2, uint32_t arg3);
 
 /**
- * This function saves the given context into the current thread.
+ * This function saves the given context into the current thread. (And charges it for the CPU time
+ * it used, see `thread_charge`)
  *
  * Does nothing if there is no current thread.
  */
@@ -176,6 +210,58 @@ void ks_save_ctx(kernel_state_t *ks, user_ctx_t *ctx);
  */
 fernos_error_t ks_expand_stack(kernel_state_t *ks, void *new_base);
 
+/**
+ * Attempts to give the current thread's process write access to the page containing `addr`.
+ *
+ * This is meant to be called when a page fault occurs on a copy-on-write page.
+ *
+ * FOS_E_STATE_MISMATCH if there is no current thread.
+ * FOS_E_INVALID_INDEX if `addr` is not in a COW page. (i.e. the fault was for some other reason)
+ * FOS_E_NO_MEM if the page needed to be copied, but there are no free pages.
+ */
+fernos_error_t ks_resolve_cow(kernel_state_t *ks, void *addr);
+
+/**
+ * Attempts to give the page containing `addr` a physical page if it was reserved lazily 
+ * in the current thread's process.
+ *
+ * This is meant to be called when a page fault occurs on a lazy page.
+ * Backed lazy pages are filled by the lazy page filler. (See `pd_resolve_lazy_p`)
+ *
+ * If the fault was not a `write`, plain lazy pages are just mapped to the zero page.
+ * (See `pd_resolve_lazy_read_p`)
+ *
+ * FOS_E_STATE_MISMATCH if there is no current thread.
+ * FOS_E_INVALID_INDEX if `addr` is not in a lazy page. (i.e. the fault was for some other reason)
+ * FOS_E_NO_MEM if there are no free pages.
+ * Errors from the lazy page filler are also returned.
+ */
+fernos_error_t ks_resolve_lazy(kernel_state_t *ks, void *addr, bool write);
+
+/**
+ * Called when the current thread's process could not be given a page it needs. (i.e. a page
+ * fault could not be resolved with FOS_E_NO_MEM)
+ *
+ * NOTE: Only page faults call this. Syscalls which run out of memory (`ks_request_mem`, 
+ * `ks_fork_proc`, etc.) just return FOS_E_NO_MEM to the calling thread and never kill anyone.
+ *
+ * The living non-root process with the most private resident pages is killed with exit status
+ * PROC_ES_OOM. Its memory is given back right away instead of when it is reaped. (See 
+ * `proc_release_memory`) The parent is notified like with any other exit.
+ *
+ * Processes whose exit would end the current thread's process are never picked. (An exit can
+ * be forwarded up through parents which don't allow FSIG_CHLD, See `ks_signal`)
+ *
+ * This never kills the current thread's process, instead FOS_E_NO_MEM is returned when it is the
+ * process which should go. (i.e. it is the heaviest process, there is no other process to 
+ * pick, or it has hit its own quota)
+ *
+ * FOS_E_SUCCESS if some other process was killed, the failed allocation can be retried.
+ * FOS_E_STATE_MISMATCH if there is no current thread.
+ * Any other error is catastrophic.
+ */
+fernos_error_t ks_oom_kill(kernel_state_t *ks);
+
 /**
  * This "Shuts down" the system.
  *
@@ -190,14 +276,58 @@ fernos_error_t ks_expand_stack(kernel_state_t *ks, void *new_base);
 void ks_shutdown(kernel_state_t *ks);
 
 /**
- * This function advances the kernel's tick counter.
+ * Plugin tick handlers are run once every this many ticks.
+ */
+#define KS_PLG_TICK_PERIOD (16U)
+
+/**
+ * One sleep queue time unit is 2^KS_SLEEP_UNIT_SHIFT nanoseconds. (~1us)
+ */
+#define KS_SLEEP_UNIT_SHIFT (10U)
+
+/**
+ * The longest a thread can sleep in one go. (~36 minutes) Longer sleeps are cut down to this.
+ *
+ * (The sleep queue works with wrapping 32-bit times, so deadlines must stay well within 2^32 units)
+ */
+#define KS_MAX_SLEEP_NS ((uint64_t)(UINT32_MAX >> 1) << KS_SLEEP_UNIT_SHIFT)
+
+/**
+ * This function advances the kernel's tick counter. (By more than one tick if the kernel was idle)
  *
  * (This also updates the sleep queue and schedule automatically)
  *
+ * The current thread is only switched out when its time slice is used up, or when a more urgent
+ * thread is scheduled. (See `schedule_tick`)
+ *
  * Returns an error if there is some issue dealing with the sleep queue.
  */
 fernos_error_t ks_tick(kernel_state_t *ks);
 
+/**
+ * Call this when there is no thread to run, right before halting.
+ *
+ * The PIT is put in one-shot mode so that the next timer interrupt happens exactly when something
+ * is due. (The next sleeping thread's deadline, or the next plugin tick) This way the halted CPU 
+ * isn't woken up every tick for nothing, and sleeping threads are woken up between ticks.
+ *
+ * Does nothing if there is a current thread, or if the kernel is already idle.
+ */
+void ks_idle(kernel_state_t *ks);
+
+/**
+ * Call this when an interrupt other than the timer arrives. 
+ *
+ * If the kernel was idle, the ticks which have passed are added to the tick counter, and the
+ * PIT goes back to interrupting every tick.
+ *
+ * If the one-shot countdown already finished, nothing is done. The pending timer interrupt will
+ * end the idle period. (See `ks_tick`)
+ *
+ * Does nothing if the kernel isn't idle.
+ */
+void ks_exit_idle(kernel_state_t *ks);
+
 /*
  * Many of the below functions assume that the current thread is the one invoking the requested
  * behavior. Thus erors will be returned here in kernel space, and also to the calling thread
@@ -296,6 +426,65 @@ KS_SYSCALL fernos_error_t ks_reap_proc(kernel_state_t *ks, proc_id_t cpid, proc_
 KS_SYSCALL fernos_error_t ks_exec(kernel_state_t *ks, user_app_t *u_ua, const void *u_abs_ab,
         size_t u_abs_ab_len);
 
+/**
+ * Same as `ks_exec`, except the read-only areas of the app are taken from/placed in the image
+ * cache `ic` under key `key`.
+ *
+ * On a cache hit, the given buffers of the cached areas are never copied out of userspace, and
+ * the new process maps the cached pages rather than getting its own copies.
+ * On a miss, the cache is filled from `u_ua`. Failing to fill the cache is NOT an error, the app
+ * is just loaded the normal way.
+ *
+ * NOTE: It is the responsibility of the caller to ensure `u_ua` really describes the image
+ * behind `key`! Never pass a cache which other execs trust with an app that only userspace
+ * vouches for, a crafted `u_ua` would poison the cache for every later exec of `key`.
+ *
+ * If `ic` is NULL, this is equivalent to `ks_exec`.
+ */
+KS_SYSCALL fernos_error_t ks_exec_cached(kernel_state_t *ks, user_app_t *u_ua, const void *u_abs_ab,
+        size_t u_abs_ab_len, image_cache_t *ic, const void *key);
+
+/**
+ * Same as `ks_exec_cached`, except the user app already lives in kernel space, and the contents
+ * of its areas are read using `reader` rather than taken from `given` buffers.
+ * (See `ua_fill_area_page`)
+ *
+ * This lets the kernel load an app straight into the frames of the new page directory without
+ * ever staging it anywhere. `u_abs_ab` is still expected to be in userspace.
+ *
+ * Areas with their bit set in `backed_mask` are not read at all during this call. They are
+ * mapped as backed lazy pages, it is up to the caller to make sure the lazy page filler can fill
+ * them later. (See `new_user_app_pd_shared`)
+ *
+ * `ua` and `reader` are required. If `reader` fails, the exec fails and the calling process is
+ * left intact.
+ */
+KS_SYSCALL fernos_error_t ks_exec_loaded(kernel_state_t *ks, const user_app_t *ua,
+        uint32_t backed_mask, ua_area_reader_ft reader, void *reader_ctx, const void *u_abs_ab, size_t u_abs_ab_len,
+        image_cache_t *ic, const void *key);
+
+/**
+ * Create a new child process of the current process which runs the given user application.
+ *
+ * This behaves like a fork followed by an exec in the child, except the current process's
+ * memory space is never copied. The child is built directly from `u_ua` and `u_abs_ab`. 
+ * (Which follow the same rules as in `ks_exec`)
+ *
+ * The child inherits the calling process's default IO handles, and whatever plugins copy over
+ * on fork and keep on reset. (e.g. the working directory) Nothing else is inherited.
+ * Its main thread is scheduled right away.
+ *
+ * On success, FOS_E_SUCCESS is returned to the caller, and the child's pid is written to
+ * *u_cpid. On error, FC_CORE_MAX_PROCS is written to *u_cpid.
+ *
+ * User error if `u_ua` is NULL, if the app can't be loaded, or if there are insufficient
+ * resources. 
+ *
+ * NOTE: u_cpid is optional and a userspace pointer.
+ */
+KS_SYSCALL fernos_error_t ks_spawn(kernel_state_t *ks, user_app_t *u_ua, const void *u_abs_ab,
+        size_t u_abs_ab_len, proc_id_t *u_cpid);
+
 /** 
  * Send a signal to a process with pid `pid`.
  *
@@ -365,19 +554,73 @@ KS_SYSCALL fernos_error_t ks_signal_clear(kernel_state_t *ks, sig_vector_t sv);
  */
 KS_SYSCALL fernos_error_t ks_request_mem(kernel_state_t *ks, void *s, const void *e, const void **u_true_e);
 
+/**
+ * Reserve memory in a process's free area.
+ *
+ * Exact same semantics as `ks_request_mem`, except no physical pages are allocated. The pages
+ * in the range are marked lazy, and only receive (zeroed) physical pages when first touched.
+ *
+ * The end of the last reserved page is written to `*u_true_e`. FOS_E_NO_MEM is only returned 
+ * if there wasn't enough memory for the page tables themselves. If we run out of memory
+ * when a lazy page is touched, the process exits as if it page faulted.
+ */
+KS_SYSCALL fernos_error_t ks_reserve_mem(kernel_state_t *ks, void *s, const void *e, const void **u_true_e);
+
 /**
  * Returns memory in the proccess's free area.
  *
  * Does nothing if `s` or `e` aren't 4K aligned, `e` < `s`, or `s` or `e` are outside
  * the process free area.
  *
+ * Plugins are told before anything is unmapped. (See `plg_on_return_mem`) For example, file 
+ * mappings which overlap the range are written back and removed in full.
+ *
  * Returns nothing to the user thread.
  */
 KS_SYSCALL fernos_error_t ks_return_mem(kernel_state_t *ks, void *s, const void *e);
 
+/**
+ * Copy the statistics of the kernel heap (`ks->al`) to `*u_stats` in userspace.
+ *
+ * FOS_E_BAD_ARGS if `u_stats` is NULL.
+ * FOS_E_NOT_IMPLEMENTED if the kernel heap doesn't keep statistics.
+ */
+KS_SYSCALL fernos_error_t ks_kernel_heap_stats(kernel_state_t *ks, heap_stats_t *u_stats);
+
+/**
+ * Copy the page usage of process `pid` to `*u_stats` in userspace. (See `proc_mem_stats_t`)
+ *
+ * If `pid` is FC_CORE_MAX_PROCS, the calling process's usage is copied.
+ *
+ * FOS_E_BAD_ARGS if `u_stats` is NULL.
+ * FOS_E_INVALID_INDEX if there is no process with id `pid`.
+ */
+KS_SYSCALL fernos_error_t ks_proc_mem_stats(kernel_state_t *ks, proc_id_t pid, proc_mem_stats_t *u_stats);
+
+/**
+ * Set the page quota of process `pid` to `quota`. (See `proc_mem_stats_t`) 0 means no quota.
+ *
+ * If `pid` is FC_CORE_MAX_PROCS, the calling process's quota is set. Otherwise, `pid` must be a 
+ * living child of the calling process.
+ *
+ * A process with a quota can't hand out more than it has itself. The new quota must be non-zero
+ * and at most the calling process's own quota. (So a process can only ever lower its own quota)
+ *
+ * If the process is already above its new quota, nothing is taken from it, it just won't be given
+ * any new pages.
+ *
+ * FOS_E_INVALID_INDEX if there is no process with id `pid`.
+ * FOS_E_NOT_PERMITTED if `pid` isn't a living child, or `quota` is above the caller's own quota.
+ */
+KS_SYSCALL fernos_error_t ks_proc_mem_set_quota(kernel_state_t *ks, proc_id_t pid, uint32_t quota);
+
 /**
  * Take the current thread, deschedule it, and add it it to the sleep wait queue.
  *
+ * It sleeps for at least `ticks` tick periods. (See `ks_sleep_thread_until`)
+ * Unlike `ks_sleep_thread_until`, the thread is always descheduled, even when `ticks` is 0. It
+ * then just sleeps until the next tick. (i.e. it yields)
+ *
  * Kernel error if there is no current thread.
  *
  * User error if there are insufficient resources. In this case the thread will 
@@ -385,6 +628,42 @@ KS_SYSCALL fernos_error_t ks_return_mem(kernel_state_t *ks, void *s, const void
  */
 KS_SYSCALL fernos_error_t ks_sleep_thread(kernel_state_t *ks, uint32_t ticks);
 
+/**
+ * Like `ks_sleep_thread`, except the current thread sleeps until the monotonic clock reaches
+ * `deadline` nanoseconds. (See `clock_ns`)
+ *
+ * Deadlines don't need to line up with ticks. When the kernel is idle, the timer is set to go off
+ * right at the deadline. Otherwise, the thread is woken up by the first tick after the deadline.
+ *
+ * If `deadline` has already passed, the thread doesn't sleep at all.
+ * Deadlines further than `KS_MAX_SLEEP_NS` away are brought in to `KS_MAX_SLEEP_NS`.
+ */
+KS_SYSCALL fernos_error_t ks_sleep_thread_until(kernel_state_t *ks, uint64_t deadline);
+
+/**
+ * Copy how the monotonic clock is read to `*u_info` in userspace. (See `clock_info_t`)
+ *
+ * FOS_E_BAD_ARGS if `u_info` is NULL.
+ */
+KS_SYSCALL fernos_error_t ks_clock_info(kernel_state_t *ks, clock_info_t *u_info);
+
+/**
+ * Copy the scheduler statistics of thread `tid` in process `pid` to `*u_stats` in userspace.
+ * (See `sched_stats_t`)
+ *
+ * If `pid` is FC_CORE_MAX_PROCS, the calling process is used.
+ * If `tid` is FC_CORE_MAX_THREADS_PER_PROC, the statistics of the whole process are copied.
+ * (See `proc_sched_stats`)
+ *
+ * The calling thread's statistics only include CPU time up to its most recent entry into the
+ * kernel.
+ *
+ * FOS_E_BAD_ARGS if `u_stats` is NULL.
+ * FOS_E_INVALID_INDEX if there is no process with id `pid`, or it has no thread with id `tid`.
+ */
+KS_SYSCALL fernos_error_t ks_sched_stats(kernel_state_t *ks, proc_id_t pid, thread_id_t tid,
+        sched_stats_t *u_stats);
+
 /**
  * Spawn new thread in the current process using entry and arg.
  *
@@ -436,6 +715,23 @@ KS_SYSCALL fernos_error_t ks_exit_thread(kernel_state_t *ks, void *ret_val);
 KS_SYSCALL fernos_error_t ks_join_local_thread(kernel_state_t *ks, join_vector_t jv, 
         thread_join_ret_t *u_join_ret);
 
+/**
+ * Set the base priority of thread `tid` in the current process. 
+ * If `tid` is the null thread id, the current thread's priority is set.
+ *
+ * A change in priority takes effect the next time the schedule is advanced. (i.e. The current
+ * thread is never preempted by this call)
+ *
+ * Only the root process may give a thread a priority more urgent than both THREAD_PRIO_DEFAULT
+ * and the thread's current priority.
+ *
+ * User error FOS_E_BAD_ARGS if `prio` is not less than THREAD_PRIO_LEVELS.
+ * User error FOS_E_INVALID_INDEX if there is no living thread with id `tid`.
+ * User error FOS_E_NOT_PERMITTED if a non-root process tries to raise a thread above
+ * THREAD_PRIO_DEFAULT.
+ */
+KS_SYSCALL fernos_error_t ks_set_thread_prio(kernel_state_t *ks, thread_id_t tid, thread_prio_t prio);
+
 /**
  * Set the default input handle of the calling process. If the given input handle is invalid,
  * this will set the defualt Input handle to the NULL_HANDLE.
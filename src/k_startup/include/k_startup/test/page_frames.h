@@ -0,0 +1,6 @@
+
+#pragma once
+
+#include <stdbool.h>
+
+bool test_page_frames(void);
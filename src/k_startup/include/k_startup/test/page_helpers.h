@@ -4,3 +4,9 @@
 #include <stdbool.h>
 
 bool test_page_helpers(void);
+
+/**
+ * Time `mem_cpy_to_user`/`mem_cpy_from_user` for 4K, 64K and 1M copies.
+ * (Results are printed with `gfx_direct_put_fmt_s_rr`)
+ */
+void bench_mem_cpy_user(void);
@@ -32,17 +32,106 @@ typedef uint32_t thread_state_t;
  */
 #define THREAD_STATE_EXITED    (3)
 
+/**
+ * A schedule holds one round robin ring of threads per priority level.
+ *
+ * The thread at the head of the most urgent non-empty level is the one picked to run next.
+ */
+struct _schedule_t {
+    /**
+     * The current thread. NULL if no threads are scheduled.
+     *
+     * Scheduling a thread never preempts the current thread directly. `head` only changes when
+     * the current thread leaves the schedule, or when the schedule is advanced.
+     *
+     * This field is designed to be read directly, never write to it!
+     */
+    ring_element_t *head;
+
+    /**
+     * Bit `i` is set iff `levels[i]` is non-empty.
+     */
+    uint32_t level_map;
+
+    /**
+     * The run queue of each priority level.
+     */
+    ring_t levels[THREAD_PRIO_LEVELS];
+};
+
+/**
+ * Initialize an empty schedule.
+ */
+void init_schedule(schedule_t *s);
+
+/**
+ * Rotate the current thread to the back of its level, then pick the thread at the head of the
+ * most urgent non-empty level as the new current thread.
+ *
+ * The current thread is considered to have used up its time slice, so its boost is cleared and
+ * it is given a fresh slice.
+ *
+ * Does nothing if `s` is empty.
+ */
+void schedule_advance(schedule_t *s);
+
+/**
+ * Charge the current thread for one timer tick.
+ *
+ * If this uses up the current thread's time slice, the schedule is advanced. (See 
+ * `schedule_advance`) Otherwise, the current thread keeps running, unless a more urgent thread
+ * was scheduled. In that case, the more urgent thread takes over, and the current thread keeps
+ * its place (and the rest of its slice) in its level.
+ *
+ * Does nothing if `s` is empty.
+ */
+void schedule_tick(schedule_t *s);
+
+/**
+ * Make the thread at the head of the most urgent non-empty level the current thread.
+ * (Without moving any threads)
+ *
+ * Useful after scheduling threads into a schedule which had no current thread.
+ */
+void schedule_refresh(schedule_t *s);
+
 struct _thread_t {
     /**
-     * A thread will also be a ring element. (The ring being a schedule)
+     * A thread will also be a ring element. (The ring being one level of a schedule)
      */
     ring_element_t super;
 
+    /**
+     * The schedule this thread is in. NULL when this thread is not scheduled.
+     */
+    schedule_t *schedule;
+
     /**
      * The state of this thread.
      */
     thread_state_t state;
 
+    /**
+     * The base priority of this thread. (See `THREAD_PRIO_LEVELS`)
+     */
+    thread_prio_t prio;
+
+    /**
+     * How many levels this thread's priority is currently raised above `prio`.
+     *
+     * This is set when the thread is woken from a wait queue, and cleared once the thread uses up
+     * a full time slice. (See `thread_wake`)
+     */
+    thread_prio_t boost;
+
+    /**
+     * How many more ticks this thread may run before its time slice is used up.
+     *
+     * A thread starts with a full slice of `FC_CORE_SCHED_QUANTUM` ticks, and gets a new one when
+     * its slice is used up or when it is woken from a wait queue. (See `schedule_tick`)
+     */
+    uint32_t slice;
+
     /**
      * The process local id of this thread.
      */
@@ -77,6 +166,35 @@ struct _thread_t {
      */
     uint32_t wait_ctx[6];
 
+    /**
+     * What this thread is waiting on, `WAIT_KINDS` when it isn't waiting. (See `thread_wait`)
+     *
+     * NOTE: Wake ups often reset `wq` and `state` by hand before scheduling the thread, so this
+     * stays set until the thread is actually scheduled or detached. That is when the waiting time
+     * is added to `stats`.
+     */
+    wait_kind_t wait_kind;
+
+    /**
+     * When this thread started waiting.
+     */
+    uint64_t wait_start;
+
+    /**
+     * When this thread was last woken up, 0 once it has run since. (See `thread_dispatch`)
+     */
+    uint64_t wake_time;
+
+    /**
+     * When this thread was last dispatched, 0 if it isn't running right now.
+     */
+    uint64_t run_start;
+
+    /**
+     * This thread's scheduler statistics. These start at 0, even for copied threads.
+     */
+    sched_stats_t stats;
+
     /**
      * The context to use when switching back to this thread.
      */
@@ -123,7 +241,7 @@ void thread_reset(thread_t *thr, uintptr_t entry, uint32_t arg0, uint32_t arg1,
  * Copy a given thread.
  *
  * The created thread is always in a detached stated! The only data which is actually copied
- * is the given thread's TID and context!
+ * is the given thread's TID, base priority and context!
  *
  * new_proc will be the process of this copied thread! cr3 in the new thread's context
  * will be replaced with the page directory of the given process.
@@ -145,10 +263,57 @@ thread_t *new_thread_copy(thread_t *thr, process_t *new_proc);
 void thread_detach(thread_t *thr);
 
 /**
- * Add a thread to schedule `r`. 
- * If `thr` is not detached, `thread_detach` will be called before `thr` is added to `r`.
+ * Add a thread to the back of its level in schedule `s`.
+ * If `thr` is not detached, `thread_detach` will be called before `thr` is added to `s`.
+ *
+ * If `thr` was woken up from waiting, the time it spent waiting is added to its statistics.
+ *
+ * If `s` had no current thread, `thr` becomes the current thread.
+ */
+void thread_schedule(thread_t *thr, schedule_t *s);
+
+/**
+ * Detach `thr` and mark it as waiting in `wq`. `thr` should already be enqueued in `wq`.
+ *
+ * `kind` is what `thr` is waiting on, it's only used for statistics.
+ */
+void thread_wait(thread_t *thr, wait_queue_t *wq, wait_kind_t kind);
+
+/**
+ * Schedule a thread which was just woken up from a wait queue.
+ *
+ * This is `thread_schedule`, except `thr` is given a fresh time slice and is boosted
+ * `FC_CORE_SCHED_WAKE_BOOST` levels until it next uses up a full time slice. This way interactive
+ * threads (waiting on the keyboard, pipes, etc.) get to respond before CPU bound threads of the
+ * same priority.
+ */
+void thread_wake(thread_t *thr, schedule_t *s);
+
+/**
+ * Call right before switching into `thr`'s context.
+ *
+ * This starts timing `thr`'s CPU time. If `thr` was woken up since it last ran, its run queue
+ * latency is recorded.
+ */
+void thread_dispatch(thread_t *thr);
+
+/**
+ * Call when the kernel is entered from `thr`'s context.
+ *
+ * This adds the time since `thr` was dispatched to its CPU time. Does nothing if `thr` wasn't 
+ * dispatched.
+ */
+void thread_charge(thread_t *thr);
+
+/**
+ * Set the base priority of a thread.
+ *
+ * If `thr` is scheduled, it is moved to the back of its new level. If `thr` is the current thread
+ * of its schedule, it stays the current thread until the schedule is advanced.
+ *
+ * FOS_E_BAD_ARGS if `prio` is not less than `THREAD_PRIO_LEVELS`.
  */
-void thread_schedule(thread_t *thr, ring_t *r);
+fernos_error_t thread_set_prio(thread_t *thr, thread_prio_t prio);
 
 /**
  * Delete a thread.
@@ -165,8 +330,8 @@ void delete_thread(thread_t *thr);
  * This function pops all pointers off the given basic wait queue.
  * It then assumes said pointers are thread pointers.
  * Each thread is reset to a detached state and given `eax` value of `wake_status`.
- * Finally each thread is added to the given schedule.
+ * Finally each thread is woken into the given schedule. (See `thread_wake`)
  *
  * FOS_E_SUCCESS is returned on success.
  */
-fernos_error_t bwq_wake_all_threads(basic_wait_queue_t *bwq, ring_t *schedule, fernos_error_t wake_status);
+fernos_error_t bwq_wake_all_threads(basic_wait_queue_t *bwq, schedule_t *schedule, fernos_error_t wake_status);
@@ -33,11 +33,23 @@
  */
 void return_to_halt_context(void);
 
+/**
+ * How many pages are pre-zeroed each time the halt context is entered.
+ */
+#define HALT_ZERO_BATCH (16U)
+
 /**
  * This function remains in kernel mode, but enables interrupts and resets the kernel stack!
  * Should be used when there are no threads to schedule!
  */
 void _return_to_halt_context(void) {
+    // Nothing else to do, so zero some pages ahead of time. (Page faults can then skip zeroing)
+    // Interrupts are still disabled here, so only a small batch is done each time we go idle.
+    refill_zeroed_pages(HALT_ZERO_BATCH);
+
+    // If nothing is due for a while, don't have the timer wake us up every tick.
+    ks_idle(kernel);
+
     user_ctx_t halt_ctx = (user_ctx_t) {
         .ds = KERNEL_DATA_SELECTOR,
         .cr3 = get_kernel_pd(),
@@ -63,6 +75,7 @@ void _return_to_halt_context(void) {
 static void return_to_curr_thread(void) {
     thread_t *thr = (thread_t *)(kernel->schedule.head);
     if (thr) {
+        thread_dispatch(thr);
         return_to_ctx(&(thr->ctx));
     }
 
@@ -85,6 +98,27 @@ void fos_gpf_action(user_ctx_t *ctx) {
     return_to_curr_thread();
 }
 
+/**
+ * Try to make the page at `new_base` accessible to the current thread.
+ *
+ * `write` should be true if the fault was caused by a write.
+ */
+static fernos_error_t resolve_pf(void *new_base, bool write) {
+    // First, see if this was a write to a copy-on-write page, or an access to a lazy page.
+    // (Which may be backed by a file, in which case the page is read in here)
+    // If not, the thread may just be growing its stack.
+    fernos_error_t err = ks_resolve_cow(kernel, new_base);
+    if (err == FOS_E_INVALID_INDEX) {
+        err = ks_resolve_lazy(kernel, new_base, write);
+    }
+
+    if (err == FOS_E_INVALID_INDEX) {
+        err = ks_expand_stack(kernel, new_base);
+    }
+
+    return err;
+}
+
 void fos_pf_action(user_ctx_t *ctx) {
     // NOTE: I believe right now if you blow the kernel stack, the system just straight up
     // crashes. So don't do that. Maybe in the future I could set up some cool double fault 
@@ -99,8 +133,26 @@ void fos_pf_action(user_ctx_t *ctx) {
     uint32_t cr2 = read_cr2();
     void *new_base = (void *)ALIGN(cr2, M_4K);
 
-    fernos_error_t err = ks_expand_stack(kernel, new_base);
-    if (err != FOS_E_SUCCESS) {
+    // Bit 1 of the error code is set for writes.
+    const bool write = (ctx->err & (1 << 1)) != 0;
+
+    fernos_error_t err = resolve_pf(new_base, write);
+
+    // Out of pages, make some room by killing off the heaviest process, then try again.
+    if (err == FOS_E_NO_MEM) {
+        err = ks_oom_kill(kernel);
+
+        if (err == FOS_E_SUCCESS) {
+            err = resolve_pf(new_base, write);
+        } else if (err != FOS_E_NO_MEM) {
+            gfx_direct_put_fmt_s_rr("[OOM Error 0x%X]", err);
+            ks_shutdown(kernel);
+        }
+    }
+
+    if (err == FOS_E_NO_MEM) {
+        ks_exit_proc(kernel, PROC_ES_OOM);
+    } else if (err != FOS_E_SUCCESS) {
         ks_exit_proc(kernel, PROC_ES_PF);
     }
 
@@ -143,6 +195,11 @@ void fos_syscall_action(user_ctx_t *ctx, uint32_t id, uint32_t arg0, uint32_t ar
         err = ks_exec(kernel, (user_app_t *)arg0, (const void *)arg1, (size_t)arg2);
         break;
 
+    case SCID_PROC_SPAWN:
+        err = ks_spawn(kernel, (user_app_t *)arg0, (const void *)arg1, (size_t)arg2, 
+                (proc_id_t *)arg3);
+        break;
+
     case SCID_SIGNAL:
         err = ks_signal(kernel, (proc_id_t)arg0, (sig_id_t)arg1);
         break;
@@ -167,6 +224,30 @@ void fos_syscall_action(user_ctx_t *ctx, uint32_t id, uint32_t arg0, uint32_t ar
         err = ks_return_mem(kernel, (void *)arg0, (const void *)arg1);
         break;
 
+    case SCID_MEM_RESERVE:
+        err = ks_reserve_mem(kernel, (void *)arg0, (const void *)arg1, (const void **)arg2);
+        break;
+
+    case SCID_MEM_KERNEL_STATS:
+        err = ks_kernel_heap_stats(kernel, (heap_stats_t *)arg0);
+        break;
+
+    case SCID_MEM_PROC_STATS:
+        err = ks_proc_mem_stats(kernel, (proc_id_t)arg0, (proc_mem_stats_t *)arg1);
+        break;
+
+    case SCID_MEM_PROC_SET_QUOTA:
+        err = ks_proc_mem_set_quota(kernel, (proc_id_t)arg0, arg1);
+        break;
+
+    case SCID_CLOCK_INFO:
+        err = ks_clock_info(kernel, (clock_info_t *)arg0);
+        break;
+
+    case SCID_SCHED_STATS:
+        err = ks_sched_stats(kernel, (proc_id_t)arg0, (thread_id_t)arg1, (sched_stats_t *)arg2);
+        break;
+
     case SCID_THREAD_EXIT:
         err = ks_exit_thread(kernel, (void *)arg0);
         break;
@@ -184,6 +265,14 @@ void fos_syscall_action(user_ctx_t *ctx, uint32_t id, uint32_t arg0, uint32_t ar
         err = ks_join_local_thread(kernel, arg0, (thread_join_ret_t *)arg1);
         break;
 
+    case SCID_THREAD_SET_PRIO:
+        err = ks_set_thread_prio(kernel, (thread_id_t)arg0, (thread_prio_t)arg1);
+        break;
+
+    case SCID_THREAD_SLEEP_UNTIL:
+        err = ks_sleep_thread_until(kernel, ((uint64_t)arg1 << 32) | arg0);
+        break;
+
     case SCID_SET_IN_HANDLE:
         err = ks_set_in_handle(kernel, (handle_t)arg0);
         break;
@@ -298,6 +387,7 @@ void fos_syscall_action(user_ctx_t *ctx, uint32_t id, uint32_t arg0, uint32_t ar
 
 void fos_irq1_action(user_ctx_t *ctx) {
     ks_save_ctx(kernel, ctx);
+    ks_exit_idle(kernel);
 
     // Kinda interesting point here, but during keyboard init
     // the interrupt will be triggered due to the intial PS/2 commands
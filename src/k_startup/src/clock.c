@@ -0,0 +1,43 @@
+
+#include "k_startup/clock.h"
+#include "k_sys/intr.h"
+#include "s_util/misc.h"
+
+/**
+ * How many PIT cycles the TSC is measured over. (~50ms)
+ */
+#define CLOCK_CALIBRATION_PIT_COUNTS (PIT_BASE_FREQ_HZ / 20)
+
+#define NS_PER_SEC (1000000000ULL)
+
+static clock_info_t clock_info = { 0 };
+
+fernos_error_t init_clock(void) {
+    const uint64_t cycles = pit_measure_tsc(CLOCK_CALIBRATION_PIT_COUNTS);
+    const uint64_t tsc_hz = (cycles * PIT_BASE_FREQ_HZ) / CLOCK_CALIBRATION_PIT_COUNTS;
+
+    if (tsc_hz == 0) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    // Use the largest shift which still lets `mult` fit in 32 bits. (Most precision)
+    uint32_t shift = 32;
+    uint64_t mult;
+    while ((mult = (NS_PER_SEC << shift) / tsc_hz) > UINT32_MAX) {
+        shift--;
+    }
+
+    clock_info.mult = (uint32_t)mult;
+    clock_info.shift = shift;
+    clock_info.tsc_start = read_tsc();
+
+    return FOS_E_SUCCESS;
+}
+
+const clock_info_t *clock_get_info(void) {
+    return &clock_info;
+}
+
+uint64_t clock_ns(void) {
+    return clock_info_ns(&clock_info, read_tsc());
+}
@@ -133,7 +133,7 @@ fernos_error_t init_idt(void) {
     // 1 M / 1000 = 1000 times per second. 
     // It is definitely a lot slower though, maybe just because
     // we are in QEMU?
-    init_pit(1000);
+    init_pit(TICK_PIT_RELOAD_VAL);
     
     return FOS_E_SUCCESS;
 }
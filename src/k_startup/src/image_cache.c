@@ -0,0 +1,304 @@
+
+#include "k_startup/image_cache.h"
+#include "k_startup/page.h"
+#include "k_startup/page_helpers.h"
+
+#include "s_util/misc.h"
+#include "s_util/str.h"
+#include "c_config.h"
+
+image_cache_t *new_image_cache(allocator_t *al, void (*on_insert)(void *ctx, const void *key),
+        void (*on_evict)(void *ctx, const void *key), void *ctx) {
+    if (!al) {
+        return NULL;
+    }
+
+    image_cache_t *ic = al_malloc(al, sizeof(image_cache_t));
+    if (!ic) {
+        return NULL;
+    }
+
+    mem_set(ic, 0, sizeof(image_cache_t));
+
+    *(allocator_t **)&(ic->al) = al;
+    *(void (**)(void *, const void *))&(ic->on_insert) = on_insert;
+    *(void (**)(void *, const void *))&(ic->on_evict) = on_evict;
+    *(void **)&(ic->ctx) = ctx;
+
+    return ic;
+}
+
+void delete_image_cache(image_cache_t *ic) {
+    if (!ic) {
+        return;
+    }
+
+    for (size_t i = 0; i < IMAGE_CACHE_CAP; i++) {
+        if (ic->entries[i].key) {
+            ic_evict(ic, ic->entries[i].key);
+        }
+    }
+
+    al_free(ic->al, ic);
+}
+
+static inline uint32_t area_num_pages(size_t area_size) {
+    return (uint32_t)(ALIGN_UP(area_size, M_4K) / M_4K);
+}
+
+/**
+ * Drop the cache's reference to the first `n` pages of `pages`, then free `pages`.
+ *
+ * Pages which are no longer mapped anywhere are returned to the free list.
+ */
+static void ic_release_pages(image_cache_t *ic, phys_addr_t *pages, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (page_dec_refs(pages[i]) == 0) {
+            push_free_page(pages[i]);
+        }
+    }
+
+    al_free(ic->al, pages);
+}
+
+/**
+ * Release all areas held by `ice` and mark it unused. The evict callback is NOT called here.
+ */
+static void ic_clear_entry(image_cache_t *ic, image_cache_entry_t *ice) {
+    for (size_t i = 0; i < FOS_MAX_APP_AREAS; i++) {
+        if (ice->area_pages[i]) {
+            ic_release_pages(ic, ice->area_pages[i], area_num_pages(ice->area_sizes[i]));
+        }
+    }
+
+    mem_set(ice, 0, sizeof(image_cache_entry_t));
+}
+
+static void ic_evict_entry(image_cache_t *ic, image_cache_entry_t *ice) {
+    const void *key = ice->key;
+
+    ic_clear_entry(ic, ice);
+
+    if (ic->on_evict) {
+        ic->on_evict(ic->ctx, key);
+    }
+}
+
+static image_cache_entry_t *ic_find(image_cache_t *ic, const void *key) {
+    for (size_t i = 0; i < IMAGE_CACHE_CAP; i++) {
+        if (ic->entries[i].key == key) {
+            return ic->entries + i;
+        }
+    }
+
+    return NULL;
+}
+
+static inline bool ua_area_is_cacheable(const user_app_area_entry_t *uaa) {
+    return uaa->occupied && !(uaa->writeable);
+}
+
+image_cache_entry_t *ic_get(image_cache_t *ic, const void *key, const user_app_t *ua) {
+    if (!ic || !key || !ua) {
+        return NULL;
+    }
+
+    image_cache_entry_t *ice = ic_find(ic, key);
+    if (!ice) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < FOS_MAX_APP_AREAS; i++) {
+        const user_app_area_entry_t *uaa = ua->areas + i;
+
+        bool match;
+        if (ua_area_is_cacheable(uaa)) {
+            match = ice->area_pages[i] && ice->load_positions[i] == uaa->load_position &&
+                ice->area_sizes[i] == uaa->area_size;
+        } else {
+            match = !(ice->area_pages[i]);
+        }
+
+        if (!match) {
+            // The app no longer looks like what we cached, this entry is useless.
+            ic_evict_entry(ic, ice);
+            return NULL;
+        }
+    }
+
+    ice->last_used = ++(ic->clock);
+
+    return ice;
+}
+
+/**
+ * Load area `area_ind` of `ua` into freshly popped pages.
+ *
+ * On success, the cache holds a reference to every page and the new page array is written
+ * to `*out`.
+ */
+static fernos_error_t ic_load_area(image_cache_t *ic, const user_app_t *ua, size_t area_ind,
+        ua_area_reader_ft reader, void *reader_ctx, phys_addr_t **out) {
+    fernos_error_t err;
+
+    const uint32_t num_pages = area_num_pages(ua->areas[area_ind].area_size);
+
+    phys_addr_t *pages = al_malloc(ic->al, num_pages * sizeof(phys_addr_t));
+    if (!pages) {
+        return FOS_E_NO_MEM;
+    }
+
+    err = FOS_E_SUCCESS;
+
+    uint32_t i;
+    for (i = 0; i < num_pages && err == FOS_E_SUCCESS; i++) {
+        const phys_addr_t p = pop_free_page();
+        if (p == NULL_PHYS_ADDR) {
+            err = FOS_E_NO_MEM;
+            break;
+        }
+
+        page_inc_refs(p);
+        pages[i] = p;
+
+        phys_addr_t old;
+        void *vp = map_page(0, p, &old);
+        err = ua_fill_area_page(ua, area_ind, reader, reader_ctx, i, vp);
+        unmap_page(0, old);
+    }
+
+    if (err != FOS_E_SUCCESS) {
+        ic_release_pages(ic, pages, i);
+        return err;
+    }
+
+    *out = pages;
+
+    return FOS_E_SUCCESS;
+}
+
+fernos_error_t ic_put(image_cache_t *ic, const void *key, const user_app_t *ua,
+        ua_area_reader_ft reader, void *reader_ctx, image_cache_entry_t **out) {
+    fernos_error_t err;
+
+    if (!ic || !key || !ua || !out) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    // First make sure what we are about to cache is sane.
+
+    bool any_cacheable = false;
+
+    for (size_t i = 0; i < FOS_MAX_APP_AREAS; i++) {
+        const user_app_area_entry_t *uaa = ua->areas + i;
+
+        if (!ua_area_is_cacheable(uaa)) {
+            continue;
+        }
+
+        const void *start = uaa->load_position;
+        const void *end = (const uint8_t *)start + uaa->area_size;
+
+        if (!IS_ALIGNED(start, M_4K)) {
+            return FOS_E_ALIGN_ERROR;
+        }
+
+        if (uaa->area_size == 0 || end < start || uaa->given_size > uaa->area_size) {
+            return FOS_E_INVALID_RANGE;
+        }
+
+        if (start < (void *)FC_CORE_VMEM_APP_START || (void *)FC_CORE_VMEM_APP_END < end) {
+            return FOS_E_INVALID_RANGE;
+        }
+
+        if (!reader && uaa->given_size > 0 && !(uaa->given)) {
+            return FOS_E_BAD_ARGS;
+        }
+
+        any_cacheable = true;
+    }
+
+    if (!any_cacheable) {
+        return FOS_E_EMPTY;
+    }
+
+    // Now pick a spot. An old version of this key goes first, then an unused entry, then the
+    // least recently used entry.
+
+    image_cache_entry_t *ice = ic_find(ic, key);
+
+    if (!ice) {
+        for (size_t i = 0; i < IMAGE_CACHE_CAP; i++) {
+            image_cache_entry_t *cand = ic->entries + i;
+
+            if (!(cand->key)) {
+                ice = cand;
+                break;
+            }
+
+            if (!ice || cand->last_used < ice->last_used) {
+                ice = cand;
+            }
+        }
+    }
+
+    if (ice->key) {
+        ic_evict_entry(ic, ice);
+    }
+
+    // `ice` is now a clean unused entry.
+
+    err = FOS_E_SUCCESS;
+
+    for (size_t i = 0; i < FOS_MAX_APP_AREAS && err == FOS_E_SUCCESS; i++) {
+        const user_app_area_entry_t *uaa = ua->areas + i;
+
+        if (ua_area_is_cacheable(uaa)) {
+            err = ic_load_area(ic, ua, i, reader, reader_ctx, ice->area_pages + i);
+
+            if (err == FOS_E_SUCCESS) {
+                ice->load_positions[i] = uaa->load_position;
+                ice->area_sizes[i] = uaa->area_size;
+            }
+        }
+    }
+
+    if (err != FOS_E_SUCCESS) {
+        ic_clear_entry(ic, ice);
+        return err;
+    }
+
+    ice->key = key;
+    ice->last_used = ++(ic->clock);
+
+    if (ic->on_insert) {
+        ic->on_insert(ic->ctx, key);
+    }
+
+    *out = ice;
+
+    return FOS_E_SUCCESS;
+}
+
+void ic_evict(image_cache_t *ic, const void *key) {
+    if (!ic || !key) {
+        return;
+    }
+
+    image_cache_entry_t *ice = ic_find(ic, key);
+    if (ice) {
+        ic_evict_entry(ic, ice);
+    }
+}
+
+uint32_t ice_area_mask(const image_cache_entry_t *ice) {
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < FOS_MAX_APP_AREAS; i++) {
+        if (ice->area_pages[i]) {
+            mask |= (1U << i);
+        }
+    }
+
+    return mask;
+}
@@ -6,10 +6,13 @@
 #include "k_startup/state.h"
 #include "k_startup/process.h"
 #include "k_startup/tss.h"
+#include "k_startup/clock.h"
 #include "k_startup/action.h"
 #include "k_sys/page.h"
 #include "u_startup/main.h"
 #include "s_mem/simple_heap.h"
+#include "s_mem/slab.h"
+#include "s_mem/arena.h"
 #include "s_bridge/ctx.h"
 #include "c_config.h"
 #include "k_startup/ata_block_device.h"
@@ -43,20 +46,42 @@ static inline void try_setup_step(fernos_error_t err, const char *msg) {
     }
 }
 
+/**
+ * The first part of the kernel's free area is used for slab pages. (Small objects)
+ * Then comes the scratch arena. (See `kernel_state_t.scratch_al`)
+ * The rest is used by the simple heap for everything else.
+ */
+#define KERNEL_SLAB_REGION_SIZE    (16 * M_1M)
+#define KERNEL_SCRATCH_REGION_SIZE (4 * M_1M)
+
+#define KERNEL_SCRATCH_START (FC_CORE_VMEM_FREE_START + KERNEL_SLAB_REGION_SIZE)
+#define KERNEL_SCRATCH_END   (KERNEL_SCRATCH_START + KERNEL_SCRATCH_REGION_SIZE)
+
 static fernos_error_t init_kernel_heap(void) {
-    simple_heap_attrs_t shal_attrs = {
+    const mem_manage_pair_t k_mmp = {
+        .request_mem = alloc_pages,
+        .return_mem = free_pages
+    };
+
+    slab_attrs_t slab_attrs = {
         .start = (void *)FC_CORE_VMEM_FREE_START,
-        .end =   (void *)FC_CORE_VMEM_FREE_END,
-        .mmp = (mem_manage_pair_t) {
-            .request_mem = alloc_pages,
-            .return_mem = free_pages
-        },
-
-        .small_fl_cutoff = 0x100,
-        .small_fl_search_amt = 0x10,
-        .large_fl_search_amt = 0x10
+        .end =   (void *)(FC_CORE_VMEM_FREE_START + KERNEL_SLAB_REGION_SIZE),
+        .mmp = k_mmp,
+
+        .large_attrs = {
+            .start = (void *)KERNEL_SCRATCH_END,
+            .end =   (void *)FC_CORE_VMEM_FREE_END,
+            .mmp = k_mmp,
+
+            .small_fl_cutoff = 0x100,
+            .small_fl_search_amt = 0x10,
+            .large_fl_search_amt = 0x10,
+
+            .segregated = true,
+            .trim_threshold = M_1M
+        }
     };
-    allocator_t *k_al = new_simple_heap_allocator(shal_attrs);
+    allocator_t *k_al = new_slab_allocator(slab_attrs);
 
     if (!k_al) {
         return FOS_E_NO_MEM;
@@ -108,6 +133,25 @@ static void init_kernel_state(void) {
     thread_schedule(thr, &(kernel->schedule));
 }
 
+static void init_kernel_scratch(void) {
+    allocator_t *scratch_al = new_arena_allocator(
+        (arena_attrs_t) {
+            .start = (void *)KERNEL_SCRATCH_START,
+            .end = (void *)KERNEL_SCRATCH_END,
+            .mmp = (mem_manage_pair_t) {
+                .request_mem = alloc_pages,
+                .return_mem = free_pages
+            }
+        }
+    );
+
+    if (!scratch_al) {
+        gfx_direct_fatal("Failed to create kernel scratch arena");
+    }
+
+    kernel->scratch_al = scratch_al;
+}
+
 static void init_kernel_plugins(void) {
     fernos_error_t err;
 
@@ -197,6 +241,7 @@ void start_kernel(uint32_t m2_magic, const m2_info_start_t *m2_info) {
     try_setup_step(init_gdt(), "Failed to initialize GDT");
     try_setup_step(init_idt(), "Failed to initialize IDT");
     try_setup_step(init_global_tss(), "Failed to initialize TSS");
+    try_setup_step(init_clock(), "Failed to calibrate clock");
 
     // Put these in place so we can catch errors in the following setup steps.
     set_gpf_action(fos_lock_up_action);
@@ -208,6 +253,7 @@ void start_kernel(uint32_t m2_magic, const m2_info_start_t *m2_info) {
     try_setup_step(init_kb(), "Failed to init keyboard");
     
     init_kernel_state();
+    init_kernel_scratch();
     init_kernel_plugins();
 
     // Now put in the real actions.
@@ -219,5 +265,6 @@ void start_kernel(uint32_t m2_magic, const m2_info_start_t *m2_info) {
     set_irq1_action(fos_irq1_action);
 
     thread_t *first_thread = (thread_t *)(kernel->schedule.head);
+    thread_dispatch(first_thread);
     return_to_ctx(&(first_thread->ctx));
 }
@@ -51,6 +51,8 @@ uint8_t free_kernel_pages[NUM_FREE_KERNEL_PAGES][M_4K] __attribute__((aligned(NU
 static pt_entry_t free_kernel_page_pt[1024] __attribute__((aligned(M_4K)));
 static pt_entry_t *free_kernel_page_ptes[NUM_FREE_KERNEL_PAGES];
 
+bool physmap_enabled = false;
+
 /*
  * If you look in c_config.h, you'll see many areas prefixed with "VMEM". These outline
  * what memory will look like when virtual memory is enabled.
@@ -69,17 +71,106 @@ static pt_entry_t *free_kernel_page_ptes[NUM_FREE_KERNEL_PAGES];
  *
  * The pages all live within the range FC_CORE_PMEM_BODY.
  * So, all physical pages within FC_CORE_PMEM_BODY which are NOT part of the above two ranges,
- * will be added to the free list!
+ * will be marked free!
  *
  * NOTE: The logic for this used to be much simpler as the _static_area was always the very 
  * beginning of the BODY, and the kernel stack was always very end.
  * Now though with config.json files, these two ranges can appear anywhere within the body!
  */
 
-static phys_addr_t free_list_head = NULL_PHYS_ADDR;
-static uint32_t free_list_len = 0;
+/*
+ * Physical pages within FC_CORE_PMEM_BODY are tracked with a bitmap which lives in kernel
+ * static memory. A set bit means the corresponding page is free.
+ *
+ * This used to be a linked list threaded through the free pages themselves. The problem with that
+ * was every push or pop required mapping the page into a free kernel page just to read/write a
+ * single link. (2 `assign_free_page` calls, each flushing the TLB)
+ *
+ * Because the bitmap is always mapped (identity in the static area), the same functions work
+ * before AND after paging is enabled, and allocating a page never touches the page itself.
+ *
+ * The summary bitmap has one bit per word of the frame bitmap. A summary bit is set if and
+ * only if its corresponding frame bitmap word contains at least one free page. This lets us
+ * skip over 1024 used pages at a time while searching.
+ */
+
+#define NUM_FRAMES          (FC_CORE_PMEM_BODY_SIZE / M_4K)
+#define FRAME_BM_WORDS      ((NUM_FRAMES + 31) / 32)
+#define FRAME_SUMMARY_WORDS ((FRAME_BM_WORDS + 31) / 32)
+
+static uint32_t frame_bm[FRAME_BM_WORDS];
+static uint32_t frame_summary[FRAME_SUMMARY_WORDS];
+
+/**
+ * No word in `frame_summary` below this index is non-zero.
+ *
+ * This is what makes single page allocation amortized O(1). The hint only moves backwards when
+ * a page below it is pushed.
+ */
+static uint32_t frame_summary_hint = FRAME_SUMMARY_WORDS;
+
+static uint32_t num_free_frames = 0;
+
+/**
+ * Free pages which have already been zeroed. (See `refill_zeroed_pages`)
+ *
+ * These pages are NOT marked free in the bitmap, but are still counted by `get_num_free_pages`.
+ */
+static phys_addr_t zeroed_pool[ZEROED_POOL_CAP];
+static uint32_t zeroed_pool_len = 0;
+
+/**
+ * See `get_zero_page`. Set once paging is enabled.
+ */
+static phys_addr_t zero_page = NULL_PHYS_ADDR;
+
+/**
+ * Reference counts for COW pages. (Indexed by frame, just like the bitmap)
+ *
+ * A single page can be referenced at most once per process, so 16-bits is plenty.
+ */
+static uint16_t frame_refs[NUM_FRAMES];
+
+static inline bool frame_is_free(uint32_t fi) {
+    return (frame_bm[fi / 32] & (1UL << (fi % 32))) != 0;
+}
+
+/**
+ * Mark the frame at index `fi` as free. Does nothing if it is already free.
+ */
+static void free_frame(uint32_t fi) {
+    const uint32_t wi = fi / 32;
+    const uint32_t si = wi / 32;
+
+    if (frame_is_free(fi)) {
+        return;
+    }
+
+    frame_bm[wi] |= (1UL << (fi % 32));
+    frame_summary[si] |= (1UL << (wi % 32));
+
+    if (si < frame_summary_hint) {
+        frame_summary_hint = si;
+    }
+
+    num_free_frames++;
+}
 
-static fernos_error_t _init_free_list(void) {
+/**
+ * Mark the frame at index `fi` as used. The frame MUST currently be free.
+ */
+static void use_frame(uint32_t fi) {
+    const uint32_t wi = fi / 32;
+
+    frame_bm[wi] &= ~(1UL << (fi % 32));
+    if (frame_bm[wi] == 0) {
+        frame_summary[wi / 32] &= ~(1UL << (wi % 32));
+    }
+
+    num_free_frames--;
+}
+
+static fernos_error_t _init_free_frames(void) {
     // These checks are redundant, but whatever.
     CHECK_ALIGN((phys_addr_t)_static_area_start, M_4K);
     CHECK_ALIGN((phys_addr_t)_static_area_end, M_4K);
@@ -118,41 +209,14 @@ static fernos_error_t _init_free_list(void) {
     for (size_t i = 0; i < num_free_areas; i++) {
         page_range_t free_area = free_areas[i];
 
-        if (free_area.start == free_area.end) {
-            continue; // skip empty ranges!
-        }
-
-        for (phys_addr_t p = free_area.start; p < free_area.end - M_4K; p += M_4K) {
-            *(phys_addr_t *)p = p + M_4K;
+        for (phys_addr_t p = free_area.start; p < free_area.end; p += M_4K) {
+            free_frame((p - FC_CORE_PMEM_BODY_START) / M_4K);
         }
-        
-        // The final page in the area will point to the current free list head.
-        *(phys_addr_t *)(free_area.end - M_4K) = free_list_head;
-        free_list_head = free_area.start;
-        free_list_len += (free_area.end - free_area.start) / M_4K;
     }
 
     return FOS_E_SUCCESS;
 }
 
-/**
- * Must be called after _init_free_list.
- *
- * Pops a free page from the free list before paging is enabled.
- */
-static phys_addr_t _pop_free_page(void) {
-    if (free_list_head == NULL_PHYS_ADDR) {
-        return NULL_PHYS_ADDR;
-    }
-
-    phys_addr_t popped = free_list_head;
-
-    free_list_head = *(phys_addr_t *)free_list_head;
-    free_list_len--;
-
-    return popped;
-}
-
 /*
  * The below flags are used for `_place_range` ONLY!
  */
@@ -187,6 +251,10 @@ static phys_addr_t _pop_free_page(void) {
 /**
  * Make a certain range available within a page table.
  *
+ * Identity ranges which cover an entire 4MB chunk outside of FC_CORE_PMEM_BODY are mapped with
+ * a single large entry. (i.e. the epilogue, which holds the framebuffer) Pages in the body are
+ * always mapped individually as they may be edited one by one later.
+ *
  * e is exclusive.
  */
 static fernos_error_t _place_range(pt_entry_t *pd, uint8_t *s, const uint8_t *e, uint8_t flags) {
@@ -221,13 +289,34 @@ static fernos_error_t _place_range(pt_entry_t *pd, uint8_t *s, const uint8_t *e,
 
         uint32_t pdi = pi / 1024;
 
+        if (fos_pde_is_large(pd[pdi])) {
+            return FOS_E_ALREADY_ALLOCATED;
+        }
+
+        const bool large = (flags & _R_IDENTITY) && IS_ALIGNED(i, M_4M) && 
+            (uint32_t)(e - i) >= M_4M && !pte_get_present(pd[pdi]) &&
+            ((uint32_t)i >= FC_CORE_PMEM_BODY_END || (uint32_t)i + M_4M <= FC_CORE_PMEM_BODY_START);
+
+        if (large) {
+            pt_entry_t pde = fos_large_identity_pd_entry((phys_addr_t)i, user, writeable);
+            if (flags & _R_DONT_CACHE) {
+                pte_set_pcd(&pde, 1);
+            }
+            pd[pdi] = pde;
+
+            // The increment in the loop header takes care of the final 4K.
+            i += M_4M - M_4K; 
+
+            continue;
+        }
+
         // Must we access a different entry in the given page directory?
         if (pdi != curr_pdi) {
             pt_entry_t *pde = &(pd[pdi]);
 
             // Must we allocate a new page table?
             if (!pte_get_present(*pde)) {
-                phys_addr_t new_page = _pop_free_page();
+                phys_addr_t new_page = pop_free_page();
                 if (new_page == NULL_PHYS_ADDR) {
                     return FOS_E_NO_MEM;
                 }
@@ -262,7 +351,7 @@ static fernos_error_t _place_range(pt_entry_t *pd, uint8_t *s, const uint8_t *e,
         phys_addr_t page_addr = (phys_addr_t)i;
         if (flags & _R_ALLOCATE) {
             // If allocate is marked, we map the virtual address i to a different page.
-            page_addr = _pop_free_page();
+            page_addr = pop_free_page();
             if (page_addr == NULL_PHYS_ADDR) {
                 return FOS_E_NO_MEM;
             }
@@ -285,14 +374,72 @@ static fernos_error_t _place_range(pt_entry_t *pd, uint8_t *s, const uint8_t *e,
     return FOS_E_SUCCESS;
 }
 
+/**
+ * Map the first `PHYSMAP_COVERED_SIZE` bytes of the body into FC_CORE_VMEM_PHYSMAP.
+ *
+ * Large entries are used wherever both the virtual and physical chunks are 4MB aligned.
+ * Entries are marked identity so that they are never returned. (The pages behind them are owned
+ * by whoever popped them)
+ */
+static fernos_error_t _place_physmap(pt_entry_t *pd) {
+    CHECK_ALIGN(FC_CORE_VMEM_PHYSMAP_START, M_4K);
+
+    const uint32_t size = PHYSMAP_COVERED_SIZE;
+
+    uint32_t off = 0;
+    while (off < size) {
+        const uint32_t va = FC_CORE_VMEM_PHYSMAP_START + off;
+        const phys_addr_t pa = FC_CORE_PMEM_BODY_START + off;
+
+        pt_entry_t *pde = &(pd[va / M_4M]);
+
+        if (IS_ALIGNED(va, M_4M) && IS_ALIGNED(pa, M_4M) && size - off >= M_4M) {
+            if (pte_get_present(*pde)) {
+                return FOS_E_ALREADY_ALLOCATED;
+            }
+
+            *pde = fos_large_identity_pd_entry(pa, false, true);
+            off += M_4M;
+
+            continue;
+        }
+
+        if (fos_pde_is_large(*pde)) {
+            return FOS_E_ALREADY_ALLOCATED;
+        }
+
+        if (!pte_get_present(*pde)) {
+            phys_addr_t new_page = pop_free_page();
+            if (new_page == NULL_PHYS_ADDR) {
+                return FOS_E_NO_MEM;
+            }
+
+            clear_page_table((pt_entry_t *)new_page);
+            *pde = fos_unique_pt_entry(new_page, true, true);
+        }
+
+        pt_entry_t *pt = (pt_entry_t *)pte_get_base(*pde);
+        pt_entry_t *pte = &(pt[(va / M_4K) % 1024]);
+
+        if (pte_get_present(*pte)) {
+            return FOS_E_ALREADY_ALLOCATED;
+        }
+
+        *pte = fos_identity_pt_entry(pa, false, true);
+        off += M_4K;
+    }
+
+    return FOS_E_SUCCESS;
+}
+
 /**
  * Initialize kernel page directory.
  *
- * _init_free_list must be called before this function!
+ * _init_free_frames must be called before this function!
  * Obviously this should be run before paging is enabled.
  */
 static fernos_error_t _init_kernel_pd(void) {
-    phys_addr_t kpd = _pop_free_page();
+    phys_addr_t kpd = pop_free_page();
     if (kpd == NULL_PHYS_ADDR) {
         return FOS_E_NO_MEM;
     }
@@ -346,6 +493,9 @@ static fernos_error_t _init_kernel_pd(void) {
     PROP_ERR(_place_range(pd, (uint8_t *)FC_CORE_PMEM_EPILOGUE_START, (const uint8_t *)FC_CORE_PMEM_EPILOGUE_END,
                 _R_WRITEABLE | _R_IDENTITY | _R_DONT_CACHE));
 
+    // The physmap is only ever placed in the kernel page directory.
+    PROP_ERR(_place_physmap(pd));
+
     // Now setup up the free kernel pages!
     // THIS IS VERY CONFUSING SADLY!
     phys_addr_t fkp = (phys_addr_t)free_kernel_pages;
@@ -433,7 +583,7 @@ static fernos_error_t _copy_range(pt_entry_t *dest_pd, const pt_entry_t *src_pd,
  * _init_kernel_pd must be called before calling this function!
  */
 static fernos_error_t _init_first_user_pd(void) {
-    phys_addr_t upd = _pop_free_page();
+    phys_addr_t upd = pop_free_page();
     if (upd == NULL_PHYS_ADDR) {
         return FOS_E_NO_MEM;
     }
@@ -492,13 +642,23 @@ fernos_error_t init_paging(void) {
         return FOS_E_NO_MEM;
     }
 
-    PROP_ERR(_init_free_list());
+    PROP_ERR(_init_free_frames());
     PROP_ERR(_init_kernel_pd());
     PROP_ERR(_init_first_user_pd()); 
 
+    // Large entries are placed in `_place_range`, so PSE must be on before paging.
+    enable_pse();
+
     set_page_directory(kernel_pd);
     enable_paging();
 
+    physmap_enabled = PHYSMAP_COVERED_SIZE > 0;
+
+    zero_page = pop_zeroed_page();
+    if (zero_page == NULL_PHYS_ADDR) {
+        return FOS_E_NO_MEM;
+    }
+
     return FOS_E_SUCCESS;
 }
 
@@ -529,47 +689,431 @@ phys_addr_t assign_free_page(uint32_t slot, phys_addr_t p) {
     return ret;
 }
 
+void assign_free_pages(const phys_addr_t *ps, uint32_t n, phys_addr_t *olds) {
+    n = MIN(n, NUM_FREE_KERNEL_PAGES);
+
+    for (uint32_t slot = 0; slot < n; slot++) {
+        pt_entry_t *free_kernel_page_pte = free_kernel_page_ptes[slot];
+
+        if (olds) {
+            olds[slot] = pte_get_present(*free_kernel_page_pte) 
+                ? pte_get_base(*free_kernel_page_pte) : NULL_PHYS_ADDR;
+        }
+
+        *free_kernel_page_pte = ps[slot] == NULL_PHYS_ADDR 
+            ? not_present_pt_entry() : fos_unique_pt_entry(ps[slot], false, true);
+    }
+
+    flush_page_cache();
+}
+
 uint32_t get_num_free_pages(void) {
-    return free_list_len;
+    return num_free_frames + zeroed_pool_len;
 }
 
 void push_free_page(phys_addr_t page_addr) {
     if (!(IS_ALIGNED(page_addr, M_4K))) {
         return;
     }
-    
-    phys_addr_t old = assign_free_page(0, page_addr);
-    *(phys_addr_t *)(free_kernel_pages[0]) = free_list_head;
-    assign_free_page(0, old);
 
-    free_list_head = page_addr;
-    free_list_len++; 
+    if (page_addr < FC_CORE_PMEM_BODY_START || page_addr >= FC_CORE_PMEM_BODY_END) {
+        return;
+    }
+
+    free_frame((page_addr - FC_CORE_PMEM_BODY_START) / M_4K);
+}
+
+uint32_t pop_free_page_batch(phys_addr_t *out, uint32_t n) {
+    uint32_t popped = 0;
+
+    while (popped < n) {
+        uint32_t si = frame_summary_hint;
+        while (si < FRAME_SUMMARY_WORDS && frame_summary[si] == 0) {
+            si++;
+        }
+
+        frame_summary_hint = si;
+
+        if (si == FRAME_SUMMARY_WORDS) {
+            break; // No free pages left at all.
+        }
+
+        // Consume as much of the lowest non-empty bitmap word as we can in one go.
+
+        const uint32_t wi = (si * 32) + __builtin_ctz(frame_summary[si]);
+        uint32_t word = frame_bm[wi];
+
+        while (word != 0 && popped < n) {
+            const uint32_t fi = (wi * 32) + __builtin_ctz(word);
+            word &= word - 1;
+
+            out[popped++] = FC_CORE_PMEM_BODY_START + (fi * M_4K);
+            num_free_frames--;
+        }
+
+        frame_bm[wi] = word;
+        if (word == 0) {
+            frame_summary[si] &= ~(1UL << (wi % 32));
+        }
+    }
+
+    // Pre-zeroed pages are a last resort.
+    while (popped < n && zeroed_pool_len > 0) {
+        out[popped++] = zeroed_pool[--zeroed_pool_len];
+    }
+
+    return popped;
 }
 
 phys_addr_t pop_free_page(void) {
-    if (free_list_head == NULL_PHYS_ADDR) {
-        return NULL_PHYS_ADDR; 
+    phys_addr_t p;
+    return pop_free_page_batch(&p, 1) == 1 ? p : NULL_PHYS_ADDR;
+}
+
+void push_free_pages(phys_addr_t s, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        push_free_page(s + (i * M_4K));
+    }
+}
+
+phys_addr_t pop_free_pages(uint32_t n) {
+    if (n == 0 || n > num_free_frames) {
+        return NULL_PHYS_ADDR;
+    }
+
+    if (n == 1) {
+        return pop_free_page();
+    }
+
+    // First fit search for a run of `n` free frames.
+    // Whole summary words and whole bitmap words are skipped/consumed when possible.
+
+    uint32_t run_s = 0;
+    uint32_t run_len = 0;
+
+    uint32_t fi = frame_summary_hint * 32 * 32;
+    while (fi < NUM_FRAMES && run_len < n) {
+        const uint32_t wi = fi / 32;
+
+        if (fi % (32 * 32) == 0 && frame_summary[wi / 32] == 0) {
+            run_len = 0;
+            fi += 32 * 32;
+        } else if (fi % 32 == 0 && frame_bm[wi] == 0) {
+            run_len = 0;
+            fi += 32;
+        } else if (fi % 32 == 0 && frame_bm[wi] == 0xFFFFFFFF) {
+            // NOTE: Bits past NUM_FRAMES are never set, so a full word is always in bounds.
+            if (run_len == 0) {
+                run_s = fi;
+            }
+            run_len += 32;
+            fi += 32;
+        } else {
+            if (frame_is_free(fi)) {
+                if (run_len == 0) {
+                    run_s = fi;
+                }
+                run_len++;
+            } else {
+                run_len = 0;
+            }
+            fi++;
+        }
     }
 
-    phys_addr_t old = assign_free_page(0, free_list_head);
-    phys_addr_t next = *(phys_addr_t *)(free_kernel_pages[0]);
-    assign_free_page(0, old);
+    if (run_len < n) {
+        return NULL_PHYS_ADDR;
+    }
 
-    phys_addr_t ret = free_list_head;
+    for (uint32_t i = run_s; i < run_s + n; i++) {
+        use_frame(i);
+    }
 
-    free_list_head = next;
-    free_list_len--;
+    return FC_CORE_PMEM_BODY_START + (run_s * M_4K);
+}
 
-    return ret;
+phys_addr_t pop_zeroed_page(void) {
+    if (zeroed_pool_len > 0) {
+        return zeroed_pool[--zeroed_pool_len];
+    }
+
+    const phys_addr_t p = pop_free_page();
+
+    if (p != NULL_PHYS_ADDR) {
+        phys_addr_t old;
+        mem_set(map_page(1, p, &old), 0, M_4K);
+        unmap_page(1, old);
+    }
+
+    return p;
+}
+
+uint32_t refill_zeroed_pages(uint32_t n) {
+    n = MIN(n, ZEROED_POOL_CAP - zeroed_pool_len);
+
+    // Only pages from the bitmap, popping from the pool itself would be pointless.
+    phys_addr_t batch[32];
+    uint32_t added = 0;
+
+    while (added < n && num_free_frames > 0) {
+        const uint32_t want = MIN(MIN(n - added, num_free_frames), 
+                sizeof(batch) / sizeof(batch[0]));
+        const uint32_t popped = pop_free_page_batch(batch, want);
+
+        for (uint32_t i = 0; i < popped; i++) {
+            phys_addr_t old;
+            mem_set(map_page(0, batch[i], &old), 0, M_4K);
+            unmap_page(0, old);
+
+            zeroed_pool[zeroed_pool_len++] = batch[i];
+        }
+
+        added += popped;
+    }
+
+    return added;
+}
+
+uint32_t get_num_zeroed_pages(void) {
+    return zeroed_pool_len;
+}
+
+phys_addr_t get_zero_page(void) {
+    return zero_page;
+}
+
+/**
+ * Are all frames in [fi, fi + 1024) free? `fi` MUST be a multiple of 32.
+ */
+static bool frame_run_is_free(uint32_t fi) {
+    if (fi + 1024 > NUM_FRAMES) {
+        return false;
+    }
+
+    for (uint32_t wi = fi / 32; wi < (fi + 1024) / 32; wi++) {
+        if (frame_bm[wi] != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+phys_addr_t pop_free_large_page(void) {
+    if (num_free_frames < 1024) {
+        return NULL_PHYS_ADDR;
+    }
+
+    // The body itself is only guaranteed to be 4K aligned. The frame index of the first
+    // physically 4MB aligned page is not necessarily 0.
+    const uint32_t first_fi = (ALIGN_UP(FC_CORE_PMEM_BODY_START, M_4M) - FC_CORE_PMEM_BODY_START) / M_4K;
+
+    if (!IS_ALIGNED(first_fi, 32)) {
+        return NULL_PHYS_ADDR; // Only possible with a very strange body start.
+    }
+
+    for (uint32_t fi = first_fi; fi + 1024 <= NUM_FRAMES; fi += 1024) {
+        if (frame_run_is_free(fi)) {
+            for (uint32_t i = fi; i < fi + 1024; i++) {
+                use_frame(i);
+            }
+
+            return FC_CORE_PMEM_BODY_START + (fi * M_4K);
+        }
+    }
+
+    return NULL_PHYS_ADDR;
+}
+
+/**
+ * Get the frame index of `p`. Returns NUM_FRAMES if `p` is not a valid page in the body.
+ */
+static uint32_t frame_index(phys_addr_t p) {
+    if (!IS_ALIGNED(p, M_4K) || p < FC_CORE_PMEM_BODY_START || p >= FC_CORE_PMEM_BODY_END) {
+        return NUM_FRAMES;
+    }
+
+    return (p - FC_CORE_PMEM_BODY_START) / M_4K;
+}
+
+uint32_t page_get_refs(phys_addr_t p) {
+    if (p == zero_page) {
+        return UINT32_MAX;
+    }
+
+    const uint32_t fi = frame_index(p);
+    return fi < NUM_FRAMES ? frame_refs[fi] : 0;
+}
+
+void page_inc_refs(phys_addr_t p) {
+    if (p == zero_page) {
+        return;
+    }
+
+    const uint32_t fi = frame_index(p);
+    if (fi < NUM_FRAMES) {
+        frame_refs[fi]++;
+    }
+}
+
+uint32_t page_dec_refs(phys_addr_t p) {
+    if (p == zero_page) {
+        return UINT32_MAX;
+    }
+
+    const uint32_t fi = frame_index(p);
+    if (fi >= NUM_FRAMES || frame_refs[fi] == 0) {
+        return 0;
+    }
+
+    return --frame_refs[fi];
+}
+
+typedef struct _pd_acct_entry_t {
+    phys_addr_t pd;
+    proc_mem_stats_t *stats;
+} pd_acct_entry_t;
+
+/**
+ * Every attached page directory. Unused entries have a NULL_PHYS_ADDR `pd`.
+ */
+static pd_acct_entry_t pd_accts[FC_CORE_MAX_PROCS];
+
+/**
+ * Index of the last entry found. Lookups for the same page directory tend to come in bursts.
+ */
+static uint32_t pd_acct_hint = 0;
+
+void pd_acct_charge(proc_mem_stats_t *stats, uint32_t pi, pt_entry_t pte, bool large, bool add) {
+    if (!stats || !pte_get_present(pte) || !pte_get_user(pte) || 
+            pte_get_avail(pte) == IDENTITY_ENTRY) {
+        return;
+    }
+
+    // The zero page belongs to no one.
+    if (!large && pte_get_base(pte) == zero_page) {
+        return;
+    }
+
+    // Unsigned wrap around takes care of subtraction.
+    const uint32_t delta = add ? (large ? 1024 : 1) : (large ? -1024U : -1U);
+
+    stats->resident += delta;
+
+    const uint8_t type = pte_get_avail(pte);
+    if (type == SHARED_ENTRY || type == COW_ENTRY) {
+        stats->shared += delta;
+    }
+
+    const uint32_t addr = pi * M_4K;
+
+    if (FC_CORE_VMEM_STACK_START <= addr && addr < FC_CORE_VMEM_STACK_END) {
+        stats->stack += delta;
+    } else if (FC_CORE_VMEM_FREE_START <= addr && addr < FC_CORE_VMEM_FREE_END) {
+        stats->heap += delta;
+    }
+}
+
+uint32_t pd_acct_room(const proc_mem_stats_t *stats) {
+    if (!stats || stats->quota == 0) {
+        return UINT32_MAX;
+    }
+
+    return stats->resident < stats->quota ? stats->quota - stats->resident : 0;
+}
+
+proc_mem_stats_t *pd_acct_find(phys_addr_t pd) {
+    if (pd == NULL_PHYS_ADDR) {
+        return NULL;
+    }
+
+    if (pd_accts[pd_acct_hint].pd == pd) {
+        return pd_accts[pd_acct_hint].stats;
+    }
+
+    for (uint32_t i = 0; i < FC_CORE_MAX_PROCS; i++) {
+        if (pd_accts[i].pd == pd) {
+            pd_acct_hint = i;
+            return pd_accts[i].stats;
+        }
+    }
+
+    return NULL;
+}
+
+fernos_error_t pd_acct_attach(phys_addr_t pd, proc_mem_stats_t *stats) {
+    if (pd == NULL_PHYS_ADDR || !stats) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    if (pd_acct_find(pd)) {
+        return FOS_E_ALREADY_ALLOCATED;
+    }
+
+    uint32_t slot;
+    for (slot = 0; slot < FC_CORE_MAX_PROCS; slot++) {
+        if (pd_accts[slot].pd == NULL_PHYS_ADDR) {
+            break;
+        }
+    }
+
+    if (slot == FC_CORE_MAX_PROCS) {
+        return FOS_E_NO_SPACE;
+    }
+
+    const uint32_t quota = stats->quota;
+    mem_set(stats, 0, sizeof(proc_mem_stats_t));
+    stats->quota = quota;
+
+    phys_addr_t old0;
+    const pt_entry_t *pdes = (pt_entry_t *)map_page(0, pd, &old0);
+
+    for (uint32_t pdi = 0; pdi < 1024; pdi++) {
+        const pt_entry_t pde = pdes[pdi];
+
+        if (fos_pde_is_large(pde)) {
+            pd_acct_charge(stats, pdi * 1024, pde, true, true);
+        } else if (pte_get_present(pde)) {
+            phys_addr_t old1;
+            const pt_entry_t *ptes = (pt_entry_t *)map_page(1, pte_get_base(pde), &old1);
+
+            for (uint32_t pti = 0; pti < 1024; pti++) {
+                pd_acct_charge(stats, (pdi * 1024) + pti, ptes[pti], false, true);
+            }
+
+            unmap_page(1, old1);
+        }
+    }
+
+    unmap_page(0, old0);
+
+    pd_accts[slot].pd = pd;
+    pd_accts[slot].stats = stats;
+
+    return FOS_E_SUCCESS;
+}
+
+void pd_acct_detach(phys_addr_t pd) {
+    if (pd == NULL_PHYS_ADDR) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < FC_CORE_MAX_PROCS; i++) {
+        if (pd_accts[i].pd == pd) {
+            pd_accts[i].pd = NULL_PHYS_ADDR;
+            pd_accts[i].stats = NULL;
+            return;
+        }
+    }
 }
 
 phys_addr_t new_page_table(void) {
     phys_addr_t pt = pop_free_page();
 
     if (pt != NULL_PHYS_ADDR) {
-        phys_addr_t old = assign_free_page(0, pt);
-        clear_page_table((pt_entry_t *)(free_kernel_pages[0]));
-        assign_free_page(0, old);
+        phys_addr_t old;
+        clear_page_table((pt_entry_t *)map_page(0, pt, &old));
+        unmap_page(0, old);
     }
 
     return pt;
@@ -587,45 +1131,100 @@ void delete_page_table(phys_addr_t pt) {
 }
 
 
-fernos_error_t pt_alloc_range(phys_addr_t pt, bool user, bool shared, uint32_t s, uint32_t e, uint32_t *true_e) {
-    CHECK_ALIGN(pt, M_4K);
-
-    if (s >= 1024 || e > 1024 || e < s) {
-        return FOS_E_INVALID_RANGE;
-    }
-
-    if (s == e) {
-        *true_e = e;
-        return FOS_E_SUCCESS;
+/**
+ * Fill entries [s, e) of a page table which is already mapped at `ptes` with new pages.
+ *
+ * Pages are popped in batches, and the table is never remapped while filling.
+ * If `lazy` is a lazy entry (i.e. non-zero), no pages are popped, all entries are just set to
+ * `lazy`. (`shared` is ignored)
+ * If `cow` is given, no pages are popped, entry `i` becomes a COW entry pointing to `cow[i - s]`.
+ * (The reference count of said page is incremented)
+ *
+ * Follows the same error and `true_e` rules as `pt_alloc_range`. (Except `true_e` is required)
+ *
+ * Every page mapped is charged to `stats` (when given), `pi_base` is the page index of entry 0.
+ * Fresh pages are only popped while `stats` has room. (See `pd_acct_room`)
+ */
+static fernos_error_t pt_fill_range(pt_entry_t *ptes, bool user, bool shared, pt_entry_t lazy, const phys_addr_t *cow, uint32_t s, uint32_t e, uint32_t *true_e,
+        proc_mem_stats_t *stats, uint32_t pi_base) {
+    // How far can we go before hitting an allocated entry?
+    uint32_t avail_e = s;
+    while (avail_e < e && !fos_pte_in_use(ptes[avail_e])) {
+        avail_e++;
     }
 
-    fernos_error_t err = FOS_E_SUCCESS;
-    uint32_t i;
+    phys_addr_t batch[32];
 
-    phys_addr_t old = assign_free_page(0, pt);
+    uint32_t i = s;
 
-    pt_entry_t *ptes = (pt_entry_t *)(free_kernel_pages[0]);
+    if (lazy) {
+        for (; i < avail_e; i++) {
+            ptes[i] = lazy;
+        }
+    }
 
-    for (i = s; i < e; i++) {
-        pt_entry_t *pte = &(ptes[i]);
+    if (cow) {
+        for (; i < avail_e; i++) {
+            page_inc_refs(cow[i - s]);
+            ptes[i] = fos_cow_pt_entry(cow[i - s], user);
+            pd_acct_charge(stats, pi_base + i, ptes[i], false, true);
+        }
+    }
 
-        if (pte_get_present(*pte)) {
-            err = FOS_E_ALREADY_ALLOCATED;
+    while (i < avail_e) {
+        const uint32_t room = pd_acct_room(stats);
+        if (room == 0) {
             break;
         }
 
-        phys_addr_t new_page = pop_free_page();
-        if (new_page == NULL_PHYS_ADDR) {
-            err = FOS_E_NO_MEM;
+        const uint32_t want = MIN(avail_e - i, sizeof(batch) / sizeof(batch[0]));
+        const uint32_t popped = pop_free_page_batch(batch, MIN(want, room));
+        if (popped == 0) {
             break;
         }
 
-        *pte = shared 
-            ? fos_shared_pt_entry(new_page, user, true) 
-            : fos_unique_pt_entry(new_page, user, true);
+        for (uint32_t bi = 0; bi < popped; bi++, i++) {
+            ptes[i] = shared 
+                ? fos_shared_pt_entry(batch[bi], user, true) 
+                : fos_unique_pt_entry(batch[bi], user, true);
+            pd_acct_charge(stats, pi_base + i, ptes[i], false, true);
+        }
+    }
+
+    *true_e = i;
+
+    if (i < avail_e) {
+        return FOS_E_NO_MEM;
+    }
+
+    if (avail_e < e) {
+        return FOS_E_ALREADY_ALLOCATED;
+    }
+
+    return FOS_E_SUCCESS;
+}
+
+fernos_error_t pt_alloc_range(phys_addr_t pt, bool user, bool shared, uint32_t s, uint32_t e, uint32_t *true_e) {
+    CHECK_ALIGN(pt, M_4K);
+
+    if (s >= 1024 || e > 1024 || e < s) {
+        return FOS_E_INVALID_RANGE;
+    }
+
+    if (s == e) {
+        if (true_e) {
+            *true_e = e;
+        }
+        return FOS_E_SUCCESS;
     }
 
-    assign_free_page(0, old);
+    phys_addr_t old;
+    pt_entry_t *ptes = (pt_entry_t *)map_page(0, pt, &old);
+
+    uint32_t i;
+    fernos_error_t err = pt_fill_range(ptes, user, shared, false, NULL, s, e, &i, NULL, 0);
+
+    unmap_page(0, old);
 
     if (true_e) {
         *true_e = i;
@@ -634,7 +1233,12 @@ fernos_error_t pt_alloc_range(phys_addr_t pt, bool user, bool shared, uint32_t s
     return err;
 }
 
-void pt_free_range(phys_addr_t pt, bool return_shared, uint32_t s, uint32_t e) {
+/**
+ * `pt_free_range`, except every page unmapped is removed from `stats` (when given).
+ * `pi_base` is the page index of entry 0.
+ */
+static void pt_free_range_acct(phys_addr_t pt, bool return_shared, uint32_t s, uint32_t e,
+        proc_mem_stats_t *stats, uint32_t pi_base) {
     if (!IS_ALIGNED(pt, M_4K)) {
         return;
     }
@@ -647,9 +1251,8 @@ void pt_free_range(phys_addr_t pt, bool return_shared, uint32_t s, uint32_t e) {
         return;
     }
 
-    phys_addr_t old = assign_free_page(0, pt);
-
-    pt_entry_t *ptes = (pt_entry_t *)(free_kernel_pages[0]);
+    phys_addr_t old;
+    pt_entry_t *ptes = (pt_entry_t *)map_page(0, pt, &old);
 
     for (uint32_t i = s; i < e; i++) {
         pt_entry_t *pte = &(ptes[i]);
@@ -658,30 +1261,104 @@ void pt_free_range(phys_addr_t pt, bool return_shared, uint32_t s, uint32_t e) {
         const uint8_t type = pte_get_avail(*pte);
         const phys_addr_t base = pte_get_base(*pte);
 
+        pd_acct_charge(stats, pi_base + i, *pte, false, false);
+
         // Always return unique, only return shared when `return_shared` is true.
         if (present && (type == UNIQUE_ENTRY || (type == SHARED_ENTRY && return_shared))) {
             push_free_page(base);
         }
 
+        // COW pages are only returned by whoever holds the final reference.
+        if (present && type == COW_ENTRY && page_dec_refs(base) == 0) {
+            push_free_page(base);
+        }
+
         *pte = not_present_pt_entry();
     }
 
-    assign_free_page(0, old);
+    unmap_page(0, old);
+}
+
+void pt_free_range(phys_addr_t pt, bool return_shared, uint32_t s, uint32_t e) {
+    pt_free_range_acct(pt, return_shared, s, e, NULL, 0);
 }
 
 phys_addr_t new_page_directory(void) {
     return new_page_table();
 }
 
-fernos_error_t pd_alloc_pages_p(phys_addr_t pd, bool user, bool shared, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e) {
+/**
+ * Replace the large entry `*pde` with the page table `pt`. Entry `hole` of the new page table is
+ * left not present, all others map the same pages as the large entry did.
+ * (Pass 1024 for `hole` to have no hole at all)
+ *
+ * `pt` is allowed to be one of the pages mapped by the large entry, as long as `hole` is the
+ * entry which mapped it.
+ */
+static void pde_split_large_into(pt_entry_t *pde, phys_addr_t pt, uint32_t hole) {
+    const pt_entry_t large = *pde;
+    const phys_addr_t base = pte_get_base(large);
+
+    phys_addr_t old2;
+    pt_entry_t *ptes = (pt_entry_t *)map_page(2, pt, &old2);
+
+    for (uint32_t pti = 0; pti < 1024; pti++) {
+        pt_entry_t pte = large;
+        pte_set_ps(&pte, 0);
+        pte_set_base(&pte, base + (pti * M_4K));
+
+        ptes[pti] = pti == hole ? not_present_pt_entry() : pte;
+    }
+
+    unmap_page(2, old2);
+
+    *pde = fos_unique_pt_entry(pt, true, true);
+
+    // The large entry might be cached with the old page size.
+    flush_page_cache();
+}
+
+fernos_error_t pde_split_large(pt_entry_t *pde) {
+    if (!fos_pde_is_large(*pde)) {
+        return FOS_E_SUCCESS;
+    }
+
+    const phys_addr_t pt = pop_free_page();
+    if (pt == NULL_PHYS_ADDR) {
+        return FOS_E_NO_MEM;
+    }
+
+    pde_split_large_into(pde, pt, 1024);
+
+    return FOS_E_SUCCESS;
+}
+
+/**
+ * Shared implementation of `pd_alloc_pages_p`, `pd_alloc_large_pages_p`, `pd_reserve_pages_p`,
+ * `pd_reserve_backed_pages_p` and `pd_map_cow_pages_p`.
+ *
+ * When `large` is true, unmapped 4MB chunks which are entirely within the range are given large
+ * entries when possible. (`shared` must be false, `lazy` must be 0, `cow` must be NULL)
+ *
+ * When `cow` is given, page `pi` is mapped as a COW entry to `cow[pi - pi_s]`.
+ */
+static fernos_error_t pd_fill_pages_p(phys_addr_t pd, bool user, bool shared, pt_entry_t lazy, bool large, const phys_addr_t *cow, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e) {
     fernos_error_t err;
 
     if (pi_e < pi_s || pi_s >= (1024 * 1024) || pi_e > (1024 * 1024)) {
         return FOS_E_INVALID_RANGE;
     }
 
-    phys_addr_t old = assign_free_page(0, pd);
-    pt_entry_t *pdes = (pt_entry_t *)(free_kernel_pages[0]);
+    proc_mem_stats_t *stats = pd_acct_find(pd);
+
+    phys_addr_t old0;
+    pt_entry_t *pdes = (pt_entry_t *)map_page(0, pd, &old0);
+
+    // Each page table touched is mapped exactly once, new or not.
+    // (Rather than once to clear it, and again to fill it)
+    // Slot 1 is only restored at the very end, and only if it was ever used.
+    phys_addr_t old1 = NULL_PHYS_ADDR;
+    bool slot1_taken = false;
 
     uint32_t pi;
     err = FOS_E_SUCCESS;
@@ -694,24 +1371,56 @@ fernos_error_t pd_alloc_pages_p(phys_addr_t pd, bool user, bool shared, uint32_t
         const uint32_t pti_e = nb_pi > pi_e ? pi_e % 1024 : 1024;
 
         pt_entry_t *pde = pdes + pdi;
-        if (!pte_get_present(*pde)) {
-            phys_addr_t new_pt = new_page_table();
-            if (new_pt == NULL_PHYS_ADDR) {
-                err = FOS_E_NO_MEM;
-                break;
+
+        if (fos_pde_is_large(*pde)) {
+            err = FOS_E_ALREADY_ALLOCATED;
+            break;
+        }
+
+        if (large && pti_s == 0 && pti_e == 1024 && !pte_get_present(*pde) && 
+                pd_acct_room(stats) >= 1024) {
+            const phys_addr_t lp = pop_free_large_page();
+            if (lp != NULL_PHYS_ADDR) {
+                *pde = fos_large_unique_pd_entry(lp, user, true);
+                pd_acct_charge(stats, pi, *pde, true, true);
+                pi += 1024;
+
+                continue;
             }
 
-            *pde = fos_unique_pt_entry(new_pt, true, true);
+            // Otherwise, fall back to regular pages.
+        }
+
+        const bool pt_is_new = !pte_get_present(*pde);
+        const phys_addr_t pt = pt_is_new ? pop_free_page() : pte_get_base(*pde);
+        if (pt == NULL_PHYS_ADDR) {
+            err = FOS_E_NO_MEM;
+            break;
+        }
+
+        phys_addr_t prev;
+        pt_entry_t *ptes = (pt_entry_t *)map_page(1, pt, &prev);
+        if (!slot1_taken && prev != PAGE_NOT_SLOTTED) {
+            old1 = prev;
+            slot1_taken = true;
         }
 
-        phys_addr_t pt = pte_get_base(*pde);
+        if (pt_is_new) {
+            clear_page_table(ptes);
+            *pde = fos_unique_pt_entry(pt, true, true);
+        }
 
         uint32_t true_pti_e;
-        err = pt_alloc_range(pt, user, shared, pti_s, pti_e, &true_pti_e);
+        err = pt_fill_range(ptes, user, shared, lazy, cow ? cow + (pi - pi_s) : NULL,
+                pti_s, pti_e, &true_pti_e, stats, pdi * 1024);
         pi += (true_pti_e - pti_s);
     }
 
-    assign_free_page(0, old);
+    if (slot1_taken) {
+        assign_free_page(1, old1);
+    }
+
+    unmap_page(0, old0);
 
     if (true_e) {
         *true_e = pi;
@@ -720,6 +1429,10 @@ fernos_error_t pd_alloc_pages_p(phys_addr_t pd, bool user, bool shared, uint32_t
     return err;
 }
 
+fernos_error_t pd_alloc_pages_p(phys_addr_t pd, bool user, bool shared, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e) {
+    return pd_fill_pages_p(pd, user, shared, 0, false, NULL, pi_s, pi_e, true_e);
+}
+
 fernos_error_t pd_alloc_pages(phys_addr_t pd, bool user, bool shared, void *s, const void *e, const void **true_e) {
     fernos_error_t err;
 
@@ -737,9 +1450,80 @@ fernos_error_t pd_alloc_pages(phys_addr_t pd, bool user, bool shared, void *s, c
     return err;
 }
 
-void pd_free_pages_p(phys_addr_t pd, bool return_shared, uint32_t pi_s, uint32_t pi_e) {
+fernos_error_t pd_alloc_large_pages_p(phys_addr_t pd, bool user, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e) {
+    return pd_fill_pages_p(pd, user, false, 0, true, NULL, pi_s, pi_e, true_e);
+}
+
+fernos_error_t pd_alloc_large_pages(phys_addr_t pd, bool user, void *s, const void *e, const void **true_e) {
+    fernos_error_t err;
+
+    CHECK_ALIGN(pd, M_4K);
+    CHECK_ALIGN(s, M_4K);
+    CHECK_ALIGN(e, M_4K);
+
+    uint32_t pi_true_e;
+    err = pd_alloc_large_pages_p(pd, user, (uint32_t)s / M_4K, (uint32_t)e / M_4K, &pi_true_e);
+
+    if (true_e) {
+        *true_e = (void *)(pi_true_e * M_4K);
+    }
+
+    return err;
+}
+
+fernos_error_t pd_reserve_pages_p(phys_addr_t pd, bool user, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e) {
+    return pd_fill_pages_p(pd, user, false, fos_lazy_pt_entry(user), false, NULL, pi_s, pi_e, true_e);
+}
+
+fernos_error_t pd_reserve_pages(phys_addr_t pd, bool user, void *s, const void *e, const void **true_e) {
+    fernos_error_t err;
+
+    CHECK_ALIGN(pd, M_4K);
+    CHECK_ALIGN(s, M_4K);
+    CHECK_ALIGN(e, M_4K);
+
+    uint32_t pi_true_e;
+    err = pd_reserve_pages_p(pd, user, (uint32_t)s / M_4K, (uint32_t)e / M_4K, &pi_true_e);
+
+    if (true_e) {
+        *true_e = (void *)(pi_true_e * M_4K);
+    }
+
+    return err;
+}
+
+fernos_error_t pd_reserve_backed_pages_p(phys_addr_t pd, bool user, bool writeable, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e) {
+    return pd_fill_pages_p(pd, user, false, fos_backed_lazy_pt_entry(user, writeable), false, NULL, pi_s, pi_e, true_e);
+}
+
+fernos_error_t pd_map_cow_pages_p(phys_addr_t pd, bool user, const phys_addr_t *pages, uint32_t pi_s, uint32_t pi_e, uint32_t *true_e) {
+    if (!pages) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    return pd_fill_pages_p(pd, user, false, 0, false, pages, pi_s, pi_e, true_e);
+}
+
+fernos_error_t pd_map_cow_pages(phys_addr_t pd, bool user, const phys_addr_t *pages, void *s, const void *e, const void **true_e) {
+    fernos_error_t err;
+
+    CHECK_ALIGN(pd, M_4K);
+    CHECK_ALIGN(s, M_4K);
+    CHECK_ALIGN(e, M_4K);
+
+    uint32_t pi_true_e;
+    err = pd_map_cow_pages_p(pd, user, pages, (uint32_t)s / M_4K, (uint32_t)e / M_4K, &pi_true_e);
+
+    if (true_e) {
+        *true_e = (void *)(pi_true_e * M_4K);
+    }
+
+    return err;
+}
+
+fernos_error_t pd_free_pages_p(phys_addr_t pd, bool return_shared, uint32_t pi_s, uint32_t pi_e) {
     if (pd == NULL_PHYS_ADDR) {
-        return;
+        return FOS_E_SUCCESS;
     }
 
     if (pi_e > (1024 * 1024)) { // make pi_e valid.
@@ -747,11 +1531,40 @@ void pd_free_pages_p(phys_addr_t pd, bool return_shared, uint32_t pi_s, uint32_t
     }
 
     if (pi_e <= pi_s) { // invalid or empty range => do nothing.
-        return;
+        return FOS_E_SUCCESS;
     }
 
-    phys_addr_t old = assign_free_page(0, pd);
-    pt_entry_t *pdes = (pt_entry_t *)(free_kernel_pages[0]);
+    proc_mem_stats_t *stats = pd_acct_find(pd);
+
+    phys_addr_t old;
+    pt_entry_t *pdes = (pt_entry_t *)map_page(0, pd, &old);
+
+    // Large entries which are only partially freed must become regular page tables. Only the first
+    // and last entries of the range can be partial, so they are split before anything is freed.
+    const uint32_t edge_pis[2] = {pi_s, pi_e - 1};
+    for (uint32_t i = 0; i < 2; i++) {
+        const uint32_t pdi = edge_pis[i] / 1024;
+        const bool partial = pi_s > pdi * 1024 || pi_e < (pdi + 1) * 1024;
+
+        pt_entry_t *pde = pdes + pdi;
+
+        if (!partial || !fos_pde_is_large(*pde)) {
+            continue;
+        }
+
+        if (pte_get_avail(*pde) == UNIQUE_ENTRY) {
+            // The first page being freed from a unique entry becomes its page table. This way,
+            // freeing user memory never needs memory, and can't fail.
+            const uint32_t hole = pi_s > pdi * 1024 ? pi_s % 1024 : 0;
+
+            pd_acct_charge(stats, (pdi * 1024) + hole, *pde, false, false);
+            pde_split_large_into(pde, pte_get_base(*pde) + (hole * M_4K), hole);
+        } else if (pde_split_large(pde) != FOS_E_SUCCESS) {
+            // Identity entries own none of their pages, so a new page table is needed.
+            unmap_page(0, old);
+            return FOS_E_NO_MEM;
+        }
+    }
 
     uint32_t pi, next_pi;
 
@@ -765,9 +1578,23 @@ void pd_free_pages_p(phys_addr_t pd, bool return_shared, uint32_t pi_s, uint32_t
         next_pi = pi + (pti_e - pti_s);
 
         pt_entry_t *pde = pdes + pdi;
+
+        // Partial large entries were split above, so any large entry left is freed entirely.
+        if (fos_pde_is_large(*pde)) {
+            pd_acct_charge(stats, pdi * 1024, *pde, true, false);
+
+            // Large entries are only ever IDENTITY or UNIQUE.
+            if (pte_get_avail(*pde) == UNIQUE_ENTRY) {
+                push_free_pages(pte_get_base(*pde), 1024);
+            }
+
+            *pde = not_present_pt_entry();
+            continue;
+        }
+
         if (pte_get_present(*pde)) {
             phys_addr_t pt = pte_get_base(*pde);
-            pt_free_range(pt, return_shared, pti_s, pti_e);
+            pt_free_range_acct(pt, return_shared, pti_s, pti_e, stats, pdi * 1024);
 
             /*
              * NOTE: When we all entries in the page table, we know we can push the page table back
@@ -791,19 +1618,25 @@ void pd_free_pages_p(phys_addr_t pd, bool return_shared, uint32_t pi_s, uint32_t
         }
     }
 
-    assign_free_page(0, old);
+    unmap_page(0, old);
+
+    // Stale translations of the pages we just returned must not outlive this call.
+    pd_flush_if_current(pd);
+
+    return FOS_E_SUCCESS;
 }
 
-void pd_free_pages(phys_addr_t pd, bool return_shared, void *s, const void *e) {
-    if (!IS_ALIGNED(pd, M_4K) || !IS_ALIGNED(s, M_4K) || !IS_ALIGNED(e, M_4K)) {
-        return;
-    }
+fernos_error_t pd_free_pages(phys_addr_t pd, bool return_shared, void *s, const void *e) {
+    CHECK_ALIGN(pd, M_4K);
+    CHECK_ALIGN(s, M_4K);
+    CHECK_ALIGN(e, M_4K);
 
-    pd_free_pages_p(pd, return_shared, (uint32_t)s / M_4K, (uint32_t)e / M_4K);
+    return pd_free_pages_p(pd, return_shared, (uint32_t)s / M_4K, (uint32_t)e / M_4K);
 }
 
 void delete_page_directory_force(phys_addr_t pd, bool return_shared) {
     if (pd != NULL_PHYS_ADDR) {
+        pd_acct_detach(pd);
         pd_free_pages_p(pd, return_shared, 0, (1024 * 1024));
         push_free_page(pd);
     }
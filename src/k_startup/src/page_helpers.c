@@ -5,42 +5,46 @@
 #include "c_config.h"
 
 void page_copy(phys_addr_t dest, phys_addr_t src) {
-    phys_addr_t old0 = assign_free_page(0, dest);
-    phys_addr_t old1 = assign_free_page(1, src);
+    phys_addr_t old0;
+    phys_addr_t old1;
 
-    void *vdest = free_kernel_pages[0];
-    void *vsrc = free_kernel_pages[1];
+    void *vdest = map_page(0, dest, &old0);
+    void *vsrc = map_page(1, src, &old1);
 
     mem_cpy(vdest, vsrc, M_4K);
 
-    assign_free_page(0, old0);
-    assign_free_page(1, old1);
+    unmap_page(0, old0);
+    unmap_page(1, old1);
 }
 
 phys_addr_t pd_get_underlying_p(phys_addr_t pd, uint32_t pi) {
-    phys_addr_t old0 = assign_free_page(0, pd);
+    phys_addr_t old0;
+    pt_entry_t *pdir = (pt_entry_t *)map_page(0, pd, &old0);
 
     uint32_t pdi = pi / 1024;
     uint32_t pti = pi % 1024;
 
-    pt_entry_t *pdir = (pt_entry_t *)(free_kernel_pages[0]);
     pt_entry_t *pde = pdir + pdi;
 
     phys_addr_t ret = NULL_PHYS_ADDR;
     
-    if (pte_get_present(*pde)) {
+    if (fos_pde_is_large(*pde)) {
+        ret = pte_get_base(*pde) + (pti * M_4K);
+    } else if (pte_get_present(*pde)) {
         phys_addr_t phys_pt = pte_get_base(*pde);
-        assign_free_page(0, phys_pt);
 
-        pt_entry_t *ptab = (pt_entry_t *)(free_kernel_pages[0]);
+        phys_addr_t old_pt;
+        pt_entry_t *ptab = (pt_entry_t *)map_page(0, phys_pt, &old_pt);
         pt_entry_t *pte = ptab + pti;
 
         if (pte_get_present(*pte)) {
             ret = pte_get_base(*pte);
         }
+
+        unmap_page(0, old_pt);
     }
 
-    assign_free_page(0, old0);
+    unmap_page(0, old0);
 
     return ret;
 }
@@ -49,7 +53,76 @@ phys_addr_t pd_get_underlying(phys_addr_t pd, const void *ptr) {
     return pd_get_underlying_p(pd, (uint32_t)ptr / M_4K);
 }
 
-fernos_error_t pt_copy_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s, uint32_t e) {
+uint32_t pd_get_underlying_run_p(phys_addr_t pd, uint32_t pi, uint32_t n, bool write, phys_addr_t *out) {
+    if (pd == NULL_PHYS_ADDR || !out || pi >= (1024 * 1024)) {
+        return 0;
+    }
+
+    if (n > (1024 * 1024) - pi) {
+        n = (1024 * 1024) - pi;
+    }
+
+    phys_addr_t old0;
+    const pt_entry_t *pdir = (pt_entry_t *)map_page(0, pd, &old0);
+
+    uint32_t got = 0;
+    bool stop = false;
+
+    while (!stop && got < n) {
+        const uint32_t cpi = pi + got;
+
+        const uint32_t pti_s = cpi % 1024;
+        const uint32_t pti_e = MIN(1024, pti_s + (n - got));
+
+        const pt_entry_t pde = pdir[cpi / 1024];
+
+        if (fos_pde_is_large(pde)) {
+            for (uint32_t pti = pti_s; pti < pti_e; pti++) {
+                out[got++] = pte_get_base(pde) + (pti * M_4K);
+            }
+        } else if (pte_get_present(pde)) {
+            phys_addr_t old1;
+            pt_entry_t *ptab = (pt_entry_t *)map_page(1, pte_get_base(pde), &old1);
+
+            for (uint32_t pti = pti_s; pti < pti_e; pti++) {
+                const pt_entry_t pte = ptab[pti];
+
+                // NOTE: Lazy entries are never present.
+                if (!pte_get_present(pte) || (write && pte_get_avail(pte) == COW_ENTRY)) {
+                    stop = true;
+                    break;
+                }
+
+                // The CPU only sets the dirty bit for writes it sees.
+                if (write) {
+                    pte_set_dirty(ptab + pti, 1);
+                }
+
+                out[got++] = pte_get_base(pte);
+            }
+
+            unmap_page(1, old1);
+        } else {
+            stop = true;
+        }
+    }
+
+    unmap_page(0, old0);
+
+    return got;
+}
+
+/**
+ * Shared implementation of `pt_copy_range` and `pt_cow_range`.
+ *
+ * When `cow` is true, writeable unique pages in `src_pt` are converted to COW entries and
+ * shared with `dest_pt` rather than copied.
+ *
+ * Changes to either table are charged to `dest_stats`/`src_stats` when given. `pi_base` is the
+ * page index of entry 0 of both tables. (`dest_pt` is only charged on success)
+ */
+static fernos_error_t pt_copy_range_internal(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s, uint32_t e, bool cow,
+        proc_mem_stats_t *dest_stats, proc_mem_stats_t *src_stats, uint32_t pi_base) {
     fernos_error_t err;
 
     CHECK_ALIGN(dest_pt, M_4K);
@@ -63,11 +136,11 @@ fernos_error_t pt_copy_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s
         return FOS_E_INVALID_RANGE;
     }
 
-    phys_addr_t old0 = assign_free_page(0, dest_pt);
-    pt_entry_t *dest_ptv = (pt_entry_t *)(free_kernel_pages[0]);
+    phys_addr_t old0;
+    pt_entry_t *dest_ptv = (pt_entry_t *)map_page(0, dest_pt, &old0);
 
-    phys_addr_t old1 = assign_free_page(1, src_pt);
-    pt_entry_t *src_ptv = (pt_entry_t *)(free_kernel_pages[1]);
+    phys_addr_t old1;
+    pt_entry_t *src_ptv = (pt_entry_t *)map_page(1, src_pt, &old1);
 
     err = FOS_E_SUCCESS;
     uint32_t i;
@@ -76,20 +149,42 @@ fernos_error_t pt_copy_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s
     // this range will need to be freed in error case.
     for (i = s; i < e; i++) {
         pt_entry_t *dest_pte = dest_ptv + i;
-        if (pte_get_present(*dest_pte)) {
+        if (fos_pte_in_use(*dest_pte)) {
             err = FOS_E_ALREADY_ALLOCATED;
             break;
         }
 
         pt_entry_t src_pte = src_ptv[i];
+        if (fos_pte_is_lazy(src_pte)) {
+            *dest_pte = src_pte; // Nothing to copy yet, the reservation is just carried over.
+            continue;
+        }
+
         if (!pte_get_present(src_pte)) {
             continue; // We know the destination pte isn't present, so this
                       // continue is safe!
         }
 
         uint8_t avail = pte_get_avail(src_pte);
-        if (avail == UNIQUE_ENTRY) {
-            phys_addr_t src_base  = pte_get_base(src_pte);
+        phys_addr_t src_base  = pte_get_base(src_pte);
+
+        if (cow && avail == UNIQUE_ENTRY && pte_get_writable(src_pte)) {
+            // The source loses write access too! One reference for each table.
+            // The dirty bit is kept. (Mapped files rely on it for write back)
+            src_ptv[i] = fos_cow_pt_entry(src_base, pte_get_user(src_pte));
+            pte_set_dirty(src_ptv + i, pte_get_dirty(src_pte));
+            pd_acct_charge(src_stats, pi_base + i, src_pte, false, false);
+            pd_acct_charge(src_stats, pi_base + i, src_ptv[i], false, true);
+            page_inc_refs(src_base);
+            page_inc_refs(src_base);
+
+            *dest_pte = src_ptv[i];
+        } else if ((cow || src_base == get_zero_page()) && avail == COW_ENTRY) {
+            // NOTE: The zero page is never copied. (And never reference counted)
+            page_inc_refs(src_base);
+
+            *dest_pte = src_pte;
+        } else if (avail == UNIQUE_ENTRY || avail == COW_ENTRY) {
             phys_addr_t dest_base =  pop_free_page();
 
             if (dest_base == NULL_PHYS_ADDR) {
@@ -99,16 +194,24 @@ fernos_error_t pt_copy_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s
 
             page_copy(dest_base, src_base); 
 
+            // A COW page was always writeable before it was shared.
             *dest_pte = fos_unique_pt_entry(dest_base, 
                     pte_get_user(src_pte),
-                    pte_get_writable(src_pte));
+                    avail == COW_ENTRY || pte_get_writable(src_pte));
+            pte_set_dirty(dest_pte, pte_get_dirty(src_pte));
         } else {
             *dest_pte = src_pte; // shallow copy for SHARED or IDENTITY
         }
     }
 
-    assign_free_page(1, old1);
-    assign_free_page(0, old0);
+    if (err == FOS_E_SUCCESS) {
+        for (i = s; i < e; i++) {
+            pd_acct_charge(dest_stats, pi_base + i, dest_ptv[i], false, true);
+        }
+    }
+
+    unmap_page(1, old1);
+    unmap_page(0, old0);
 
     if (err != FOS_E_SUCCESS) { // cleanup on error case!
         pt_free_range(dest_pt, false, s, i);
@@ -118,6 +221,14 @@ fernos_error_t pt_copy_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s
     return FOS_E_SUCCESS;
 }
 
+fernos_error_t pt_copy_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s, uint32_t e) {
+    return pt_copy_range_internal(dest_pt, src_pt, s, e, false, NULL, NULL, 0);
+}
+
+fernos_error_t pt_cow_range(phys_addr_t dest_pt, phys_addr_t src_pt, uint32_t s, uint32_t e) {
+    return pt_copy_range_internal(dest_pt, src_pt, s, e, true, NULL, NULL, 0);
+}
+
 phys_addr_t copy_page_table(phys_addr_t pt) {
     fernos_error_t err;
 
@@ -140,7 +251,10 @@ phys_addr_t copy_page_table(phys_addr_t pt) {
     return pt_copy;
 }
 
-fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t pi_s, uint32_t pi_e) {
+/**
+ * Shared implementation of `pd_copy_range_p` and `pd_cow_range_p`.
+ */
+static fernos_error_t pd_copy_range_internal(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t pi_s, uint32_t pi_e, bool cow) {
     fernos_error_t err;
 
     // This is kinda like the pd_alloc implementation which is a little annoying IMO.
@@ -156,11 +270,14 @@ fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t
         return FOS_E_INVALID_RANGE;
     }
 
-    phys_addr_t old0 = assign_free_page(0, dest_pd);
-    pt_entry_t *dest_pdv = (pt_entry_t *)(free_kernel_pages[0]);
+    proc_mem_stats_t *dest_stats = pd_acct_find(dest_pd);
+    proc_mem_stats_t *src_stats = pd_acct_find(src_pd);
+
+    phys_addr_t old0;
+    pt_entry_t *dest_pdv = (pt_entry_t *)map_page(0, dest_pd, &old0);
 
-    phys_addr_t old1 = assign_free_page(1, src_pd);
-    pt_entry_t *src_pdv = (pt_entry_t *)(free_kernel_pages[1]);
+    phys_addr_t old1;
+    pt_entry_t *src_pdv = (pt_entry_t *)map_page(1, src_pd, &old1);
 
     uint32_t pi;
     uint32_t next_pi;
@@ -189,6 +306,45 @@ fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t
 
         next_pi = pi + (e_pti - s_pti);
 
+        if (fos_pde_is_large(*dest_pde)) {
+            err = FOS_E_ALREADY_ALLOCATED;
+            break;
+        }
+
+        if (fos_pde_is_large(src_pde)) {
+            const bool full = s_pti == 0 && e_pti == 1024 && !pte_get_present(*dest_pde);
+
+            if (full && pte_get_avail(src_pde) == IDENTITY_ENTRY) {
+                *dest_pde = src_pde;
+                continue;
+            }
+
+            if (full && !cow) {
+                const phys_addr_t src_base = pte_get_base(src_pde);
+                const phys_addr_t dest_base = pop_free_large_page();
+
+                if (dest_base != NULL_PHYS_ADDR) {
+                    for (uint32_t i = 0; i < 1024; i++) {
+                        page_copy(dest_base + (i * M_4K), src_base + (i * M_4K));
+                    }
+
+                    *dest_pde = fos_large_unique_pd_entry(dest_base, 
+                            pte_get_user(src_pde), pte_get_writable(src_pde));
+                    pd_acct_charge(dest_stats, pi, *dest_pde, true, true);
+                    continue;
+                }
+            }
+
+            // Otherwise the source is split and copied page by page below.
+            // (COW entries can only live in regular page tables)
+            err = pde_split_large(src_pdv + pdi);
+            if (err != FOS_E_SUCCESS) {
+                break;
+            }
+
+            src_pde = src_pdv[pdi];
+        }
+
         if (pte_get_present(src_pde)) {
             // With a present source entry, we must copy from source into dest!
             phys_addr_t dest_pt;
@@ -208,21 +364,22 @@ fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t
                 // Note, that if this fails, `[s_pti, e_pti)` will be left untouched in `dest_pt`.
                 // So, we don't need to worry about freeing those pages below in the final error case
                 // of this funciton.
-                err = pt_copy_range(dest_pt, pte_get_base(src_pde), s_pti, e_pti);
+                err = pt_copy_range_internal(dest_pt, pte_get_base(src_pde), s_pti, e_pti, cow,
+                        dest_stats, src_stats, pdi * 1024);
             }
         } else if (pte_get_present(*dest_pde)) {
             // In this situaion:
             // the source page directory is not mapped here, but the dest page directory has
             // a page table! This is only ok, if the ENTIRE page table is empty!
 
-            phys_addr_t tmp = assign_free_page(0, pte_get_base(*dest_pde));
-            pt_entry_t *dest_ptv = (pt_entry_t *)(free_kernel_pages[0]);
+            phys_addr_t tmp;
+            pt_entry_t *dest_ptv = (pt_entry_t *)map_page(0, pte_get_base(*dest_pde), &tmp);
             for (uint32_t i = 0; err == FOS_E_SUCCESS && i < 1024; i++) {
                 if (pte_get_present(dest_ptv[i])) {
                     err = FOS_E_ALREADY_ALLOCATED;
                 }
             }
-            assign_free_page(0, tmp);
+            unmap_page(0, tmp);
         } // NOTE: if both dest_pde and src_pde are not present, no big deal!
 
         // It's important that this is not in the loop condition because, on
@@ -232,8 +389,13 @@ fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t
         }
     }
 
-    assign_free_page(1, old1);
-    assign_free_page(0, old0);
+    unmap_page(1, old1);
+    unmap_page(0, old0);
+
+    // A COW copy takes write access away from existing entries of the source.
+    if (cow) {
+        pd_flush_if_current(src_pd);
+    }
 
     if (err != FOS_E_SUCCESS) {
         // Only free what we copied! (NOT RETURNING SHARED!)
@@ -244,6 +406,14 @@ fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t
     return FOS_E_SUCCESS;
 }
 
+fernos_error_t pd_copy_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t pi_s, uint32_t pi_e) {
+    return pd_copy_range_internal(dest_pd, src_pd, pi_s, pi_e, false);
+}
+
+fernos_error_t pd_cow_range_p(phys_addr_t dest_pd, phys_addr_t src_pd, uint32_t pi_s, uint32_t pi_e) {
+    return pd_copy_range_internal(dest_pd, src_pd, pi_s, pi_e, true);
+}
+
 fernos_error_t pd_copy_range(phys_addr_t dest_pd, phys_addr_t src_pd, void *s, const void *e) {
     CHECK_ALIGN(s, M_4K);
     CHECK_ALIGN(e, M_4K);
@@ -275,11 +445,375 @@ phys_addr_t copy_page_directory(phys_addr_t pd) {
     return pd_copy;
 }
 
+phys_addr_t cow_page_directory(phys_addr_t pd) {
+    fernos_error_t err;
+
+    CHECK_ALIGN(pd, M_4K);
+
+    if (pd == NULL_PHYS_ADDR) {
+        return NULL_PHYS_ADDR;
+    }
+
+    phys_addr_t pd_copy = new_page_directory();
+
+    if (pd_copy == NULL_PHYS_ADDR) {
+        return NULL_PHYS_ADDR;
+    }
+
+    err = pd_cow_range_p(pd_copy, pd, 0, 1024 * 1024);
+    if (err != FOS_E_SUCCESS) {
+        delete_page_directory(pd_copy);
+        return NULL_PHYS_ADDR;
+    }
+
+    return pd_copy;
+}
+
+fernos_error_t pd_resolve_cow_p(phys_addr_t pd, uint32_t pi) {
+    if (pd == NULL_PHYS_ADDR || pi >= (1024 * 1024)) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    const uint32_t pdi = pi / 1024;
+    const uint32_t pti = pi % 1024;
+
+    fernos_error_t err = FOS_E_INVALID_INDEX;
+
+    phys_addr_t old0;
+    const pt_entry_t pde = ((pt_entry_t *)map_page(0, pd, &old0))[pdi];
+    unmap_page(0, old0);
+
+    // Large entries never hold COW pages.
+    if (pte_get_present(pde) && !pte_get_ps(pde)) {
+        pt_entry_t *pte = (pt_entry_t *)map_page(0, pte_get_base(pde), &old0) + pti;
+
+        if (pte_get_present(*pte) && pte_get_avail(*pte) == COW_ENTRY) {
+            const pt_entry_t cow_pte = *pte;
+            const phys_addr_t base = pte_get_base(*pte);
+            const bool user = pte_get_user(*pte);
+            const uint8_t dirty = pte_get_dirty(*pte);
+
+            if (base == get_zero_page()) {
+                // Nothing to copy, and the new page counts against the quota for the first time.
+                phys_addr_t page = pd_acct_room(pd_acct_find(pd)) > 0 
+                    ? pop_zeroed_page() : NULL_PHYS_ADDR;
+                if (page == NULL_PHYS_ADDR) {
+                    err = FOS_E_NO_MEM;
+                } else {
+                    *pte = fos_unique_pt_entry(page, user, true);
+                    pte_set_dirty(pte, dirty);
+                    err = FOS_E_SUCCESS;
+                }
+            } else if (page_get_refs(base) <= 1) {
+                // We hold the last reference, no copy needed, just take the page back.
+                page_dec_refs(base);
+                *pte = fos_unique_pt_entry(base, user, true);
+                pte_set_dirty(pte, dirty);
+                err = FOS_E_SUCCESS;
+            } else {
+                phys_addr_t copy = pop_free_page();
+                if (copy == NULL_PHYS_ADDR) {
+                    err = FOS_E_NO_MEM;
+                } else {
+                    // NOTE: `page_copy` restores slot 0 (our page table) when done.
+                    page_copy(copy, base);
+                    page_dec_refs(base);
+                    *pte = fos_unique_pt_entry(copy, user, true);
+                    pte_set_dirty(pte, dirty);
+                    err = FOS_E_SUCCESS;
+                }
+            }
+
+            if (err == FOS_E_SUCCESS) {
+                proc_mem_stats_t *stats = pd_acct_find(pd);
+                pd_acct_charge(stats, pi, cow_pte, false, false);
+                pd_acct_charge(stats, pi, *pte, false, true);
+            }
+        }
+
+        unmap_page(0, old0);
+    }
+
+    // The entry went from read-only to writeable.
+    if (err == FOS_E_SUCCESS) {
+        pd_flush_if_current(pd);
+    }
+
+    return err;
+}
+
+fernos_error_t pd_resolve_cow(phys_addr_t pd, const void *ptr) {
+    return pd_resolve_cow_p(pd, (uint32_t)ptr / M_4K);
+}
+
+phys_addr_t pd_clean_page_p(phys_addr_t pd, uint32_t pi) {
+    if (pd == NULL_PHYS_ADDR || pi >= (1024 * 1024)) {
+        return NULL_PHYS_ADDR;
+    }
+
+    phys_addr_t old0;
+    const pt_entry_t pde = ((pt_entry_t *)map_page(0, pd, &old0))[pi / 1024];
+    unmap_page(0, old0);
+
+    if (!pte_get_present(pde) || pte_get_ps(pde)) {
+        return NULL_PHYS_ADDR;
+    }
+
+    phys_addr_t page = NULL_PHYS_ADDR;
+
+    pt_entry_t *pte = (pt_entry_t *)map_page(0, pte_get_base(pde), &old0) + (pi % 1024);
+    if (pte_get_present(*pte) && pte_get_dirty(*pte)) {
+        pte_set_dirty(pte, 0);
+        page = pte_get_base(*pte);
+    }
+    unmap_page(0, old0);
+
+    // Otherwise, a cached entry would let the next write go by without setting the bit again.
+    if (page != NULL_PHYS_ADDR) {
+        pd_flush_if_current(pd);
+    }
+
+    return page;
+}
+
+fernos_error_t pd_find_free_run_p(phys_addr_t pd, uint32_t pi_s, uint32_t pi_e, uint32_t n, 
+        uint32_t *pi) {
+    if (pd == NULL_PHYS_ADDR || !pi || n == 0) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    if (pi_e > (1024 * 1024) || pi_s > pi_e) {
+        return FOS_E_INVALID_RANGE;
+    }
+
+    phys_addr_t old0;
+    const pt_entry_t *pdir = (pt_entry_t *)map_page(0, pd, &old0);
+
+    fernos_error_t err = FOS_E_NO_SPACE;
+
+    // The exclusive end of the free run currently being measured.
+    uint32_t top = pi_e;
+
+    // We walk one page table at a time from the end of the range down to its start.
+    uint32_t cpi = pi_e;
+    while (err == FOS_E_NO_SPACE && cpi > pi_s) {
+        const uint32_t pdi = (cpi - 1) / 1024;
+        const uint32_t base = pdi * 1024;
+        const uint32_t low = base < pi_s ? pi_s : base;
+
+        const pt_entry_t pde = pdir[pdi];
+
+        if (!pte_get_present(pde)) {
+            if (top - low >= n) {
+                err = FOS_E_SUCCESS;
+            }
+        } else if (pte_get_ps(pde)) {
+            top = low;
+        } else {
+            phys_addr_t old1;
+            const pt_entry_t *ptab = (pt_entry_t *)map_page(1, pte_get_base(pde), &old1);
+
+            for (uint32_t i = cpi; i > low; i--) {
+                if (fos_pte_in_use(ptab[(i - 1) % 1024])) {
+                    top = i - 1;
+                } else if (top - (i - 1) >= n) {
+                    err = FOS_E_SUCCESS;
+                    break;
+                }
+            }
+
+            unmap_page(1, old1);
+        }
+
+        cpi = low;
+    }
+
+    unmap_page(0, old0);
+
+    if (err == FOS_E_SUCCESS) {
+        *pi = top - n;
+    }
+
+    return err;
+}
+
+static lazy_page_filler_ft lazy_page_filler = NULL;
+static void *lazy_page_filler_ctx = NULL;
+
+void set_lazy_page_filler(lazy_page_filler_ft filler, void *ctx) {
+    lazy_page_filler = filler;
+    lazy_page_filler_ctx = ctx;
+}
+
+fernos_error_t pd_resolve_lazy_p(phys_addr_t pd, uint32_t pi) {
+    fernos_error_t err;
+
+    if (pd == NULL_PHYS_ADDR || pi >= (1024 * 1024)) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    const uint32_t pdi = pi / 1024;
+    const uint32_t pti = pi % 1024;
+
+    phys_addr_t old0;
+    const pt_entry_t pde = ((pt_entry_t *)map_page(0, pd, &old0))[pdi];
+    unmap_page(0, old0);
+
+    // Large entries never hold lazy pages.
+    if (!pte_get_present(pde) || pte_get_ps(pde)) {
+        return FOS_E_INVALID_INDEX;
+    }
+
+    const phys_addr_t pt = pte_get_base(pde);
+
+    const pt_entry_t pte = ((pt_entry_t *)map_page(0, pt, &old0))[pti];
+    unmap_page(0, old0);
+
+    if (!fos_pte_is_lazy(pte)) {
+        return FOS_E_INVALID_INDEX;
+    }
+
+    proc_mem_stats_t *stats = pd_acct_find(pd);
+    if (pd_acct_room(stats) == 0) {
+        return FOS_E_NO_MEM;
+    }
+
+    const bool fill = fos_pte_is_backed_lazy(pte) && lazy_page_filler;
+
+    // Pages which aren't filled come pre-zeroed.
+    phys_addr_t page = fill ? pop_free_page() : pop_zeroed_page();
+    if (page == NULL_PHYS_ADDR) {
+        return FOS_E_NO_MEM;
+    }
+
+    if (fill) {
+        // The page is filled while no page table is mapped. A filler may end up doing a lot of
+        // work. (Like reading from disk)
+
+        phys_addr_t old1;
+        err = lazy_page_filler(lazy_page_filler_ctx, pd, pi, map_page(1, page, &old1));
+        unmap_page(1, old1);
+
+        if (err != FOS_E_SUCCESS) {
+            push_free_page(page);
+            return err;
+        }
+    }
+
+    const pt_entry_t new_pte = fos_unique_pt_entry(page, pte_get_user(pte), pte_get_writable(pte));
+
+    ((pt_entry_t *)map_page(0, pt, &old0))[pti] = new_pte;
+    unmap_page(0, old0);
+
+    pd_acct_charge(stats, pi, new_pte, false, true);
+
+    return FOS_E_SUCCESS;
+}
+
+fernos_error_t pd_resolve_lazy(phys_addr_t pd, const void *ptr) {
+    return pd_resolve_lazy_p(pd, (uint32_t)ptr / M_4K);
+}
+
+fernos_error_t pd_resolve_lazy_read_p(phys_addr_t pd, uint32_t pi) {
+    if (pd == NULL_PHYS_ADDR || pi >= (1024 * 1024)) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    const uint32_t pdi = pi / 1024;
+    const uint32_t pti = pi % 1024;
+
+    phys_addr_t old0;
+    const pt_entry_t pde = ((pt_entry_t *)map_page(0, pd, &old0))[pdi];
+    unmap_page(0, old0);
+
+    if (!pte_get_present(pde) || pte_get_ps(pde)) {
+        return FOS_E_INVALID_INDEX;
+    }
+
+    pt_entry_t *pte = (pt_entry_t *)map_page(0, pte_get_base(pde), &old0) + pti;
+    const pt_entry_t lazy_pte = *pte;
+
+    if (fos_pte_is_lazy(lazy_pte) && !fos_pte_is_backed_lazy(lazy_pte)) {
+        // Not present to present, no flush needed.
+        *pte = fos_cow_pt_entry(get_zero_page(), pte_get_user(lazy_pte));
+    }
+
+    unmap_page(0, old0);
+
+    if (!fos_pte_is_lazy(lazy_pte)) {
+        return FOS_E_INVALID_INDEX;
+    }
+
+    // Backed pages have real contents, there is no getting around reading them in.
+    if (fos_pte_is_backed_lazy(lazy_pte)) {
+        return pd_resolve_lazy_p(pd, pi);
+    }
+
+    return FOS_E_SUCCESS;
+}
+
+fernos_error_t pd_resolve_lazy_read(phys_addr_t pd, const void *ptr) {
+    return pd_resolve_lazy_read_p(pd, (uint32_t)ptr / M_4K);
+}
+
+/**
+ * Like `pd_get_underlying`, but if `ptr` lands in a lazy page, the page is materialized first.
+ * (A plain lazy page just gets the zero page, see `pd_resolve_lazy_read_p`)
+ *
+ * Returns NULL_PHYS_ADDR if `ptr` is not mapped or if there is no page to give to the lazy entry.
+ */
+static phys_addr_t pd_get_underlying_for_read(phys_addr_t pd, const void *ptr) {
+    if (pd_resolve_lazy_read(pd, ptr) == FOS_E_NO_MEM) {
+        return NULL_PHYS_ADDR;
+    }
+
+    return pd_get_underlying(pd, ptr);
+}
+
+/**
+ * Like `pd_get_underlying_for_read`, but if `ptr` lands in a COW page, the page is made 
+ * unique first.
+ *
+ * The kernel writes to user pages through their physical addresses, so it would otherwise
+ * bypass the read-only bit of the COW entry and write into every process sharing the page.
+ *
+ * Returns NULL_PHYS_ADDR if `ptr` is not mapped or if the COW copy fails.
+ */
+static phys_addr_t pd_get_underlying_for_write(phys_addr_t pd, const void *ptr) {
+    if (pd_resolve_lazy(pd, ptr) == FOS_E_NO_MEM) {
+        return NULL_PHYS_ADDR;
+    }
+
+    if (pd_resolve_cow(pd, ptr) == FOS_E_NO_MEM) {
+        return NULL_PHYS_ADDR;
+    }
+
+    // The run walk also marks the page dirty.
+    phys_addr_t page;
+    if (pd_get_underlying_run_p(pd, (uint32_t)ptr / M_4K, 1, true, &page) == 0) {
+        return NULL_PHYS_ADDR;
+    }
+
+    return page;
+}
+
+/**
+ * The most pages `mem_cpy_user` resolves with a single page table walk.
+ */
+#define MEM_CPY_USER_RUN (16U)
+
 /**
  * Copy bytes to or from another memory space.
  *
  * When direction is true, copy to the memory space.
  * When false, copy from the memory space.
+ *
+ * Pages are resolved `MEM_CPY_USER_RUN` at a time. Each run is then copied in as few chunks as
+ * possible. Physically contiguous pages in the physmap are one chunk, other pages are mapped into
+ * the free kernel pages `NUM_FREE_KERNEL_PAGES` at a time. (With a single TLB flush)
+ *
+ * Only pages which need attention first (lazy, or COW when writing) go through the one page at
+ * a time path.
  */
 static fernos_error_t mem_cpy_user(void *kbuf, phys_addr_t user_pd, void *ubuf, 
         uint32_t bytes, uint32_t *copied, bool direction) {
@@ -291,37 +825,75 @@ static fernos_error_t mem_cpy_user(void *kbuf, phys_addr_t user_pd, void *ubuf,
         return FOS_E_BAD_ARGS;
     }
 
-    const uint8_t *limit = (uint8_t *)ubuf + bytes;
+    phys_addr_t run[MEM_CPY_USER_RUN];
 
     uint32_t bytes_copied = 0;
 
     while (bytes_copied < bytes) {
         const uint8_t *tbuf = (uint8_t *)ubuf + bytes_copied;
-        phys_addr_t upage = pd_get_underlying(user_pd, tbuf);
-        if (upage == NULL_PHYS_ADDR) {
-            break;
-        }
 
-        const uint8_t *nb = (uint8_t *)ALIGN(tbuf + M_4K, M_4K);
-        if (nb > limit) {
-            nb = limit;
+        const uint32_t pi = (uint32_t)tbuf / M_4K;
+        const uint32_t last_pi = ((uint32_t)tbuf + (bytes - bytes_copied - 1)) / M_4K;
+
+        uint32_t run_len = pd_get_underlying_run_p(user_pd, pi, 
+                MIN(last_pi - pi + 1, MEM_CPY_USER_RUN), direction, run);
+
+        if (run_len == 0) {
+            run[0] = direction 
+                ? pd_get_underlying_for_write(user_pd, tbuf) 
+                : pd_get_underlying_for_read(user_pd, tbuf);
+            if (run[0] == NULL_PHYS_ADDR) {
+                break;
+            }
+
+            run_len = 1;
         }
 
-        uint32_t bytes_to_copy = (uint32_t)nb - (uint32_t)tbuf;
+        uint32_t i = 0;
+        while (i < run_len) {
+            const uint32_t cbuf = (uint32_t)ubuf + bytes_copied;
 
-        phys_addr_t old0 = assign_free_page(0, upage);
+            uint8_t *chunk = physmap_ptr(run[i]);
+            const bool slotted = !chunk;
+            phys_addr_t olds[NUM_FREE_KERNEL_PAGES];
 
-        uint32_t offset = (uint32_t)tbuf % M_4K;
+            uint32_t j = i + 1;
 
-        if (direction) {
-            mem_cpy(free_kernel_pages[0] + offset, (uint8_t *)kbuf + bytes_copied, bytes_to_copy); 
-        } else {
-            mem_cpy((uint8_t *)kbuf + bytes_copied, free_kernel_pages[0] + offset, bytes_to_copy);
-        }
+            if (!slotted) {
+                while (j < run_len && run[j] == run[j - 1] + M_4K && physmap_ptr(run[j])) {
+                    j++;
+                }
+            } else {
+                while (j < run_len && j - i < NUM_FREE_KERNEL_PAGES && !physmap_ptr(run[j])) {
+                    j++;
+                }
+
+                assign_free_pages(run + i, j - i, olds);
+                chunk = free_kernel_pages[0];
+            }
+
+            // NOTE: This is computed modulo 2^32 on purpose, the chunk may end at the very end
+            // of the address space.
+            uint32_t bytes_to_copy = ((pi + j) * M_4K) - cbuf;
+            if (bytes_to_copy > bytes - bytes_copied) {
+                bytes_to_copy = bytes - bytes_copied;
+            }
+
+            uint8_t *chunk_pos = chunk + (cbuf - ((pi + i) * M_4K));
 
-        bytes_copied += bytes_to_copy;
+            if (direction) {
+                mem_cpy(chunk_pos, (uint8_t *)kbuf + bytes_copied, bytes_to_copy); 
+            } else {
+                mem_cpy((uint8_t *)kbuf + bytes_copied, chunk_pos, bytes_to_copy);
+            }
 
-        assign_free_page(0, old0);
+            if (slotted) {
+                assign_free_pages(olds, j - i, NULL);
+            }
+
+            bytes_copied += bytes_to_copy;
+            i = j;
+        }
     }
 
     if (copied) {
@@ -353,13 +925,14 @@ fernos_error_t mem_set_to_user(phys_addr_t user_pd, void *user_dest, uint8_t val
     uint32_t bytes_left = bytes;
 
     while (bytes_left > 0) {
-        phys_addr_t underlying = pd_get_underlying(user_pd, iter);
+        phys_addr_t underlying = pd_get_underlying_for_write(user_pd, iter);
         if (underlying == NULL_PHYS_ADDR) {
             err = FOS_E_NO_MEM;
             break;
         }
 
-        phys_addr_t old = assign_free_page(0, underlying);
+        phys_addr_t old;
+        uint8_t *underlyingv = map_page(0, underlying, &old);
         
         const uint32_t offset = (uint32_t)iter % M_4K;
         uint32_t amt_to_set = M_4K - offset;
@@ -367,9 +940,9 @@ fernos_error_t mem_set_to_user(phys_addr_t user_pd, void *user_dest, uint8_t val
             amt_to_set = bytes_left;
         }
 
-        mem_set(free_kernel_pages[0] + offset, val, amt_to_set);
+        mem_set(underlyingv + offset, val, amt_to_set);
 
-        assign_free_page(0, old);
+        unmap_page(0, old);
 
         iter += amt_to_set;
         bytes_left -= amt_to_set;
@@ -384,6 +957,38 @@ fernos_error_t mem_set_to_user(phys_addr_t user_pd, void *user_dest, uint8_t val
 
 fernos_error_t new_user_app_pd(const user_app_t *ua, const void *abs_ab, size_t abs_ab_len,
         phys_addr_t *out) {
+    return new_user_app_pd_shared(ua, NULL, 0, NULL, NULL, abs_ab, abs_ab_len, out);
+}
+
+fernos_error_t ua_fill_area_page(const user_app_t *ua, size_t area_ind, ua_area_reader_ft reader,
+        void *reader_ctx, uint32_t page_ind, void *vpage) {
+    const user_app_area_entry_t *uaa = ua->areas + area_ind;
+
+    const size_t page_offset = page_ind * M_4K;
+
+    size_t to_give = 0;
+    if (page_offset < uaa->given_size) {
+        to_give = MIN(uaa->given_size - page_offset, M_4K);
+    }
+
+    if (to_give > 0) {
+        if (reader) {
+            PROP_ERR(reader(reader_ctx, area_ind, page_offset, vpage, to_give));
+        } else {
+            mem_cpy(vpage, (const uint8_t *)(uaa->given) + page_offset, to_give);
+        }
+    }
+
+    if (to_give < M_4K) {
+        mem_set((uint8_t *)vpage + to_give, 0, M_4K - to_give);
+    }
+
+    return FOS_E_SUCCESS;
+}
+
+fernos_error_t new_user_app_pd_shared(const user_app_t *ua, phys_addr_t * const *area_pages,
+        uint32_t backed_mask, ua_area_reader_ft reader, void *reader_ctx, const void *abs_ab, size_t abs_ab_len,
+        phys_addr_t *out) {
     fernos_error_t err;
 
     if (!ua || !out) {
@@ -504,9 +1109,42 @@ fernos_error_t new_user_app_pd(const user_app_t *ua, const void *abs_ab, size_t
         }
         
         const void *true_e;
+
+        if (area_pages && area_pages[i]) {
+            // The contents of this area already exist, no copying needed!
+            err = pd_map_cow_pages(new_pd, true, area_pages[i], uaa->load_position,
+                    (uint8_t *)(uaa->load_position) + area_size, &true_e);
+            continue;
+        }
+
+        if (backed_mask & (1U << i)) {
+            // Nothing is loaded now, pages are filled in as they are touched.
+            // (Writeable just like every other loaded area)
+            uint32_t pi_true_e;
+            err = pd_reserve_backed_pages_p(new_pd, true, true,
+                    (uint32_t)(uaa->load_position) / M_4K,
+                    ((uint32_t)(uaa->load_position) + area_size) / M_4K, &pi_true_e);
+            continue;
+        }
+
         err = pd_alloc_pages(new_pd, true, false, uaa->load_position, 
                 (uint8_t *)(uaa->load_position) + area_size, &true_e);
 
+        if (reader) {
+            // Read each page straight into its frame, no staging buffers.
+            const uint32_t pi_s = (uint32_t)(uaa->load_position) / M_4K;
+            const uint32_t num_pages = area_size / M_4K;
+
+            for (uint32_t pg = 0; err == FOS_E_SUCCESS && pg < num_pages; pg++) {
+                phys_addr_t old0;
+                void *vpage = map_page(0, pd_get_underlying_p(new_pd, pi_s + pg), &old0);
+                err = ua_fill_area_page(ua, i, reader, reader_ctx, pg, vpage);
+                unmap_page(0, old0);
+            }
+
+            continue;
+        }
+
         if (err == FOS_E_SUCCESS && uaa->given_size > 0) {
             err = mem_cpy_to_user(new_pd, uaa->load_position, uaa->given, uaa->given_size, NULL);
         }
@@ -531,6 +1169,11 @@ fernos_error_t new_user_app_pd(const user_app_t *ua, const void *abs_ab, size_t
 }
 
 user_app_t *ua_copy_from_user(allocator_t *al, phys_addr_t pd, const user_app_t *u_ua) {
+    return ua_copy_from_user_partial(al, pd, u_ua, 0);
+}
+
+user_app_t *ua_copy_from_user_partial(allocator_t *al, phys_addr_t pd, const user_app_t *u_ua,
+        uint32_t skip_mask) {
     fernos_error_t err;
 
     if (!al || pd == NULL_PHYS_ADDR || !u_ua) {
@@ -550,6 +1193,13 @@ user_app_t *ua_copy_from_user(allocator_t *al, phys_addr_t pd, const user_app_t
 
     ua->al = al; // Essential we overwrite the userspace allocator!
 
+    for (size_t i = 0; i < FOS_MAX_APP_AREAS; i++) {
+        if (skip_mask & (1U << i)) {
+            ua->areas[i].given = NULL;
+            ua->areas[i].given_size = 0;
+        }
+    }
+
     // Ok, now to do a deep copy of all the given regions!
 
     err = FOS_E_SUCCESS;
@@ -68,3 +68,21 @@ fernos_error_t plgs_on_reap_proc(plugin_t **plgs, size_t plgs_len, proc_id_t rpi
 
     return FOS_E_SUCCESS;
 }
+
+fernos_error_t plgs_on_return_mem(plugin_t **plgs, size_t plgs_len, proc_id_t pid, 
+        const void *s, const void *e) {
+    fernos_error_t err;
+    for (size_t i = 0; i < plgs_len; i++) {
+        plugin_t *plg = plgs[i];
+
+        if (plg) {
+            err = plg_on_return_mem(plg, pid, s, e);
+
+            if (err != FOS_E_SUCCESS) {
+                return err;
+            }
+        }
+    }
+
+    return FOS_E_SUCCESS;
+}
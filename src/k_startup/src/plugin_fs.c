@@ -4,11 +4,14 @@
 #include "s_bridge/shared_defs.h"
 #include "k_startup/thread.h"
 #include "k_startup/page_helpers.h"
+#include "s_util/elf.h"
 
 static void plg_fs_on_shutdown(plugin_t *plg);
 static fernos_error_t plg_fs_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 static fernos_error_t plg_fs_on_fork_proc(plugin_t *plg, proc_id_t cpid);
+static fernos_error_t plg_fs_on_reset_proc(plugin_t *plg, proc_id_t pid);
 static fernos_error_t plg_fs_on_reap_proc(plugin_t *plg, proc_id_t rpid);
+static fernos_error_t plg_fs_on_return_mem(plugin_t *plg, proc_id_t pid, const void *s, const void *e);
 
 static const plugin_impl_t PLUGIN_FS_IMPL = {
     .plg_on_shutdown = plg_fs_on_shutdown,
@@ -16,10 +19,16 @@ static const plugin_impl_t PLUGIN_FS_IMPL = {
     .plg_cmd = plg_fs_cmd,
     .plg_tick = NULL,
     .plg_on_fork_proc = plg_fs_on_fork_proc,
-    .plg_on_reset_proc = NULL,
-    .plg_on_reap_proc = plg_fs_on_reap_proc
+    .plg_on_reset_proc = plg_fs_on_reset_proc,
+    .plg_on_reap_proc = plg_fs_on_reap_proc,
+    .plg_on_return_mem = plg_fs_on_return_mem
 };
 
+static fernos_error_t plg_fs_deregister_nk(plugin_fs_t *plg_fs, fs_node_key_t nk);
+static void plg_fs_ic_on_insert(void *ctx, const void *key);
+static void plg_fs_ic_on_evict(void *ctx, const void *key);
+static fernos_error_t plg_fs_fill_page(void *ctx, phys_addr_t pd, uint32_t pi, void *dest);
+
 static fernos_error_t copy_fs_handle_state(handle_state_t *hs, process_t *proc, handle_state_t **out);
 static fernos_error_t delete_fs_handle_state(handle_state_t *hs);
 static fernos_error_t fs_hs_wait_write_ready(handle_state_t *hs);
@@ -53,13 +62,15 @@ plugin_t *new_plugin_fs(kernel_state_t *ks, file_sys_t *fs) {
 
     plugin_fs_nk_map_entry_t *nk_entry = al_malloc(ks->al, sizeof(plugin_fs_nk_map_entry_t));
     basic_wait_queue_t *bwq = new_basic_wait_queue(ks->al);
+    image_cache_t *ic = new_image_cache(ks->al, plg_fs_ic_on_insert, plg_fs_ic_on_evict, plg_fs);
 
     fernos_error_t put_err = FOS_E_UNKNWON_ERROR;
     if (nk_map && new_key_err == FOS_E_SUCCESS) {
         put_err = mp_put(nk_map, (void *)&root_nk, (const void *)&nk_entry);
     }
 
-    if (!plg_fs || !nk_map || new_key_err != FOS_E_SUCCESS || !nk_entry || !bwq || put_err != FOS_E_SUCCESS) {
+    if (!plg_fs || !nk_map || new_key_err != FOS_E_SUCCESS || !nk_entry || !bwq || !ic || put_err != FOS_E_SUCCESS) {
+        delete_image_cache(ic);
         delete_wait_queue((wait_queue_t *)bwq);
         al_free(ks->al, nk_entry);
         fs_delete_key(fs, root_nk);
@@ -73,6 +84,8 @@ plugin_t *new_plugin_fs(kernel_state_t *ks, file_sys_t *fs) {
 
     size_t root_nk_references = 0;
     for (size_t i = 0; i < FC_CORE_MAX_PROCS; i++) {
+        plg_fs->regions[i] = NULL;
+
         if (idtb_get(ks->proc_table, i)) {
             root_nk_references++;
             plg_fs->cwds[i] = root_nk;
@@ -98,6 +111,11 @@ plugin_t *new_plugin_fs(kernel_state_t *ks, file_sys_t *fs) {
     init_base_plugin((plugin_t *)plg_fs, &PLUGIN_FS_IMPL, ks);
     *(file_sys_t **)&(plg_fs->fs) = fs;
     *(map_t **)&(plg_fs->nk_map) = nk_map;
+    *(image_cache_t **)&(plg_fs->ic) = ic;
+    plg_fs->exec_regions = NULL;
+
+    // This plugin is the only source of backed lazy pages.
+    set_lazy_page_filler(plg_fs_fill_page, plg_fs);
 
     return (plugin_t *)plg_fs;
 }
@@ -198,7 +216,7 @@ static fernos_error_t plg_fs_deregister_nk(plugin_fs_t *plg_fs, fs_node_key_t nk
             mem_set(&(woken_thread->wait_ctx), 0, sizeof(woken_thread->wait_ctx));
             woken_thread->ctx.eax = FOS_E_STATE_MISMATCH; 
 
-            thread_schedule(woken_thread, &(plg_fs->super.ks->schedule));
+            thread_wake(woken_thread, &(plg_fs->super.ks->schedule));
         }
 
         if (err != FOS_E_EMPTY) {
@@ -214,6 +232,296 @@ static fernos_error_t plg_fs_deregister_nk(plugin_fs_t *plg_fs, fs_node_key_t nk
     return FOS_E_SUCCESS;
 }
 
+/**
+ * Free every region in the list `regions`, dropping each region's node key reference.
+ */
+static fernos_error_t plg_fs_free_regions(plugin_fs_t *plg_fs, plugin_fs_region_t *regions) {
+    while (regions) {
+        plugin_fs_region_t *next = regions->next;
+
+        fernos_error_t err = plg_fs_deregister_nk(plg_fs, regions->nk);
+        al_free(plg_fs->super.ks->al, regions);
+
+        if (err != FOS_E_SUCCESS) {
+            return err;
+        }
+
+        regions = next;
+    }
+
+    return FOS_E_SUCCESS;
+}
+
+/**
+ * Push a copy of `src` onto the front of `*regions`. (`src->next` is ignored)
+ *
+ * `src->nk` must already be registered, the new region takes one more reference.
+ */
+static fernos_error_t plg_fs_push_region(plugin_fs_t *plg_fs, plugin_fs_region_t **regions,
+        const plugin_fs_region_t *src) {
+    plugin_fs_region_t *region = al_malloc(plg_fs->super.ks->al, sizeof(plugin_fs_region_t));
+    if (!region) {
+        return FOS_E_NO_MEM;
+    }
+
+    fernos_error_t err = plg_fs_register_nk(plg_fs, src->nk, NULL);
+    if (err != FOS_E_SUCCESS) {
+        al_free(plg_fs->super.ks->al, region);
+        return err;
+    }
+
+    *region = *src;
+    region->next = *regions;
+
+    *regions = region;
+
+    return FOS_E_SUCCESS;
+}
+
+/**
+ * Write the dirty pages of `region` within the memory space `pd` back to the region's file.
+ *
+ * Does nothing if the region isn't a write back region.
+ *
+ * Bytes which now lie past the end of the file are not written. Errors from the file system are
+ * returned, in which case some pages may not have been written back.
+ */
+static fernos_error_t plg_fs_write_back_region(plugin_fs_t *plg_fs, phys_addr_t pd, 
+        const plugin_fs_region_t *region) {
+    if (!(region->write_back)) {
+        return FOS_E_SUCCESS;
+    }
+
+    fs_node_info_t info;
+    PROP_ERR(fs_get_node_info(plg_fs->fs, region->nk, &info));
+
+    if (info.is_dir || info.len <= region->offset) {
+        return FOS_E_SUCCESS;
+    }
+
+    const size_t file_len = MIN(region->file_len, info.len - region->offset);
+
+    const uint32_t pi_s = (uint32_t)(region->start) / M_4K;
+    const uint32_t pi_e = pi_s + (ALIGN_UP(file_len, M_4K) / M_4K);
+
+    bool evicted = false;
+
+    for (uint32_t pi = pi_s; pi < pi_e; pi++) {
+        const phys_addr_t page = pd_clean_page_p(pd, pi);
+        if (page == NULL_PHYS_ADDR) {
+            continue;
+        }
+
+        if (!evicted) {
+            // Any cached image of this file is about to go stale.
+            ic_evict(plg_fs->ic, region->nk);
+            evicted = true;
+        }
+
+        const size_t region_offset = (pi - pi_s) * M_4K;
+
+        phys_addr_t old;
+        const void *vpage = map_page(1, page, &old);
+        fernos_error_t err = fs_write(plg_fs->fs, region->nk, region->offset + region_offset,
+                MIN(file_len - region_offset, M_4K), vpage);
+        unmap_page(1, old);
+
+        PROP_ERR(err);
+    }
+
+    return FOS_E_SUCCESS;
+}
+
+/**
+ * Write back every region of `pid`. If `nk` is given, only regions backed by `nk` are
+ * written back.
+ *
+ * Every region is attempted, the first error encountered is returned.
+ */
+static fernos_error_t plg_fs_write_back_regions(plugin_fs_t *plg_fs, proc_id_t pid, 
+        fs_node_key_t nk) {
+    process_t *proc = idtb_get(plg_fs->super.ks->proc_table, pid);
+    if (!proc) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    fernos_error_t first_err = FOS_E_SUCCESS;
+
+    for (plugin_fs_region_t *region = plg_fs->regions[pid]; region; region = region->next) {
+        if (nk && region->nk != nk) {
+            continue;
+        }
+
+        fernos_error_t err = plg_fs_write_back_region(plg_fs, proc->pd, region);
+        if (first_err == FOS_E_SUCCESS) {
+            first_err = err;
+        }
+    }
+
+    return first_err;
+}
+
+/**
+ * Unmap the region `*region_p` from the memory space `pd` and unlink it from its list.
+ *
+ * NOTE: No write back is done here!
+ *
+ * An error is only returned if the region's node key couldn't be deregistered. (Catastrophic)
+ */
+static fernos_error_t plg_fs_remove_region(plugin_fs_t *plg_fs, phys_addr_t pd, 
+        plugin_fs_region_t **region_p) {
+    plugin_fs_region_t *region = *region_p;
+
+    pd_free_pages(pd, false, (void *)(region->start), region->end);
+
+    *region_p = region->next;
+    region->next = NULL;
+
+    return plg_fs_free_regions(plg_fs, region);
+}
+
+/**
+ * The lazy page filler. Reads page `pi` of whichever process owns `pd` out of the file backing it.
+ *
+ * FOS_E_INVALID_INDEX if no region covers the page.
+ */
+static fernos_error_t plg_fs_fill_page(void *ctx, phys_addr_t pd, uint32_t pi, void *dest) {
+    plugin_fs_t *plg_fs = (plugin_fs_t *)ctx;
+
+    const uint8_t *addr = (const uint8_t *)(pi * M_4K);
+
+    for (size_t pid = 0; pid < FC_CORE_MAX_PROCS; pid++) {
+        if (!(plg_fs->regions[pid])) {
+            continue;
+        }
+
+        process_t *proc = idtb_get(plg_fs->super.ks->proc_table, pid);
+        if (!proc || proc->pd != pd) {
+            continue;
+        }
+
+        for (plugin_fs_region_t *region = plg_fs->regions[pid]; region; region = region->next) {
+            if (addr < (const uint8_t *)(region->start) || (const uint8_t *)(region->end) <= addr) {
+                continue;
+            }
+
+            const size_t region_offset = addr - (const uint8_t *)(region->start);
+
+            size_t to_read = 0;
+            if (region_offset < region->file_len) {
+                to_read = MIN(region->file_len - region_offset, M_4K);
+            }
+
+            if (to_read > 0) {
+                PROP_ERR(fs_read(plg_fs->fs, region->nk, region->offset + region_offset,
+                            to_read, dest));
+            }
+
+            if (to_read < M_4K) {
+                mem_set((uint8_t *)dest + to_read, 0, M_4K - to_read);
+            }
+
+            return FOS_E_SUCCESS;
+        }
+
+        break; // Only one process can own `pd`.
+    }
+
+    return FOS_E_INVALID_INDEX;
+}
+
+/**
+ * Everything needed to read the loadable segments of an ELF file straight out of the file system.
+ */
+typedef struct _plugin_fs_elf_reader_t {
+    file_sys_t *fs;
+    fs_node_key_t nk;
+
+    /**
+     * File offset of the given part of each user app area.
+     */
+    uint32_t offsets[FOS_MAX_APP_AREAS];
+} plugin_fs_elf_reader_t;
+
+/**
+ * A `ua_area_reader_ft` over an ELF file.
+ */
+static fernos_error_t plg_fs_elf_read(void *ctx, size_t area_ind, size_t offset, void *dest, size_t len) {
+    plugin_fs_elf_reader_t *reader = (plugin_fs_elf_reader_t *)ctx;
+    return fs_read(reader->fs, reader->nk, reader->offsets[area_ind] + offset, len, dest);
+}
+
+/**
+ * Parse the ELF file behind `reader->nk` into `ua` without reading any segment contents.
+ *
+ * `ua` is expected to be zero'd. Every area is given a NULL `given` buffer, the file offset of
+ * what would've been the given buffer is written to `reader->offsets`.
+ *
+ * This mirrors the userspace parser. (See `sc_fs_parse_elf32`)
+ */
+static fernos_error_t plg_fs_parse_elf32(plugin_fs_elf_reader_t *reader, size_t file_len, user_app_t *ua) {
+    if (file_len < sizeof(elf32_header_t)) {
+        return FOS_E_EMPTY;
+    }
+
+    elf32_header_t elf32_header;
+    PROP_ERR(fs_read(reader->fs, reader->nk, 0, sizeof(elf32_header_t), &elf32_header));
+
+    // Must be 32-bit little-endian targeting x86 with an entry point!
+    if (elf32_header.header_magic != ELF_HEADER_MAGIC || 
+            elf32_header.cls != 1 || elf32_header.endian != 1 ||
+            elf32_header.machine != 0x03 || 
+            elf32_header.this_header_size != sizeof(elf32_header_t) ||
+            elf32_header.program_header_size != sizeof(elf32_program_header_t) ||
+            elf32_header.section_header_size != sizeof(elf32_section_header_t)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    const size_t num_pg_headers = elf32_header.num_program_headers;
+    const size_t pg_headers_size = num_pg_headers * sizeof(elf32_program_header_t);
+    if (file_len < pg_headers_size ||
+            file_len - pg_headers_size < elf32_header.program_header_table) {
+        return FOS_E_EMPTY; // File doesn't contain expected program header table.
+    }
+
+    ua->entry = elf32_header.entry;
+
+    size_t area_ind = 0;
+    for (size_t i = 0; i < num_pg_headers; i++) {
+        elf32_program_header_t pg_header;
+        PROP_ERR(fs_read(reader->fs, reader->nk,
+                    elf32_header.program_header_table + (i * sizeof(elf32_program_header_t)),
+                    sizeof(elf32_program_header_t), &pg_header));
+
+        // We only care about loadable segments for now!
+        if (pg_header.type != ELF32_SEG_TYPE_LOADABLE) {
+            continue;
+        }
+
+        if (area_ind >= FOS_MAX_APP_AREAS) {
+            return FOS_E_NO_SPACE;
+        }
+
+        if (pg_header.size_in_file > 0 && (file_len < pg_header.size_in_file ||
+                    file_len - pg_header.size_in_file < pg_header.offset)) {
+            return FOS_E_EMPTY; // This elf file doesn't hold the program segment it says it does!
+        }
+
+        reader->offsets[area_ind] = pg_header.offset;
+
+        user_app_area_entry_t *area_entry = ua->areas + (area_ind++);
+
+        area_entry->occupied = true;
+        area_entry->given = NULL;
+        area_entry->given_size = pg_header.size_in_file;
+        area_entry->area_size = pg_header.size_in_mem;
+        area_entry->load_position = pg_header.vaddr;
+        area_entry->writeable = (pg_header.flags & ELF32_SEG_FLAG_WRITEABLE) == ELF32_SEG_FLAG_WRITEABLE;
+    }
+
+    return FOS_E_SUCCESS;
+}
+
 static fernos_error_t plg_fs_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
     fernos_error_t err;
 
@@ -231,8 +539,43 @@ static fernos_error_t plg_fs_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t ar
     // Flush all is kinda special because it does not take a string as the first argument.
     // So, we'll just deal with it first than move on.
     if (cmd == PLG_FS_PCID_FLUSH) {
+        // Only the calling process's mappings are written back.
+        fernos_error_t wb_err = plg_fs_write_back_regions(plg_fs, pid, NULL);
+
         err = fs_flush(plg_fs->fs, NULL);
-        DUAL_RET(thr, err, FOS_E_SUCCESS);
+        DUAL_RET(thr, wb_err != FOS_E_SUCCESS ? wb_err : err, FOS_E_SUCCESS);
+    }
+
+    /*
+     * Unmap a mapping created with `PLG_FS_HCID_MMAP`.
+     *
+     * `arg0` is the address of the mapping. (As given by `PLG_FS_HCID_MMAP`)
+     *
+     * Dirty pages are written back before the mapping is removed. The mapping is removed even
+     * if the write back fails, in which case the write back error is returned.
+     *
+     * returns FOS_E_INVALID_INDEX if there is no mapping at the given address.
+     */
+    if (cmd == PLG_FS_PCID_MUNMAP) {
+        const void *addr = (const void *)arg0;
+
+        plugin_fs_region_t **region_p = plg_fs->regions + pid;
+        while (*region_p && !((*region_p)->mmapped && (*region_p)->start == addr)) {
+            region_p = &((*region_p)->next);
+        }
+
+        if (!*region_p) {
+            DUAL_RET(thr, FOS_E_INVALID_INDEX, FOS_E_SUCCESS);
+        }
+
+        fernos_error_t wb_err = plg_fs_write_back_region(plg_fs, proc->pd, *region_p);
+
+        err = plg_fs_remove_region(plg_fs, proc->pd, region_p);
+        if (err != FOS_E_SUCCESS) {
+            return FOS_E_ABORT_SYSTEM;
+        }
+
+        DUAL_RET(thr, wb_err, FOS_E_SUCCESS);
     }
 
     const char *u_path = (const char *)arg0;
@@ -336,6 +679,13 @@ static fernos_error_t plg_fs_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t ar
         err =  fs_new_key(plg_fs->fs, cwd, path, &nk);
         DUAL_RET_FOS_ERR(err, thr);
 
+        // Being in the image cache alone shouldn't stop a file from being removed.
+        const fs_node_key_t *kernel_nk_p;
+        plugin_fs_nk_map_entry_t **nk_entry_p;
+        if (mp_get_kvp(plg_fs->nk_map, &nk, (const void **)&kernel_nk_p, (void **)&nk_entry_p) == FOS_E_SUCCESS) {
+            ic_evict(plg_fs->ic, *kernel_nk_p);
+        }
+
         if (mp_get(plg_fs->nk_map, &nk)) {
             // This key is referenced by another process!
             fs_delete_key(plg_fs->fs, nk);
@@ -510,12 +860,136 @@ static fernos_error_t plg_fs_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t ar
         DUAL_RET(thr, FOS_E_SUCCESS, FOS_E_SUCCESS);
     }
 
+    /*
+     * Execute the ELF file at the given path.
+     *
+     * `arg2` and `arg3` are the absolute args block and its length. (Just like `ks_exec`)
+     *
+     * The file is parsed here in the kernel, and each loadable segment is read straight into the
+     * frames of the new process. Read-only segments are shared with all other processes running
+     * the same file. (See the image cache)
+     *
+     * Segments with at least `KS_FS_DEMAND_PAGE_MIN_SIZE` bytes in the file are not read at all
+     * up front. They become file backed regions which are paged in as they are touched.
+     * Apps with such segments bypass the image cache.
+     *
+     * returns FOS_E_INVALID_INDEX if the given path does not exist.
+     * returns FOS_E_STATE_MISMATCH if the given path is a directory or not a 32-bit x86 ELF file.
+     * On success, this does not return to the calling process.
+     */
+    case PLG_FS_PCID_EXEC: {
+        fs_node_key_t nk;
+
+        err = fs_new_key(plg_fs->fs, cwd, path, &nk);
+        DUAL_RET_FOS_ERR(err, thr);
+
+        fs_node_info_t info;
+        err = fs_get_node_info(plg_fs->fs, nk, &info);
+        if (err != FOS_E_SUCCESS || info.is_dir) {
+            fs_delete_key(plg_fs->fs, nk);
+            err = info.is_dir ? FOS_E_STATE_MISMATCH : err;
+            DUAL_RET(thr, err, FOS_E_SUCCESS);
+        }
+
+        // We use the registered key so that it can be used as an image cache key.
+        fs_node_key_t kernel_nk = NULL;
+        err = plg_fs_register_nk(plg_fs, nk, &kernel_nk);
+        fs_delete_key(plg_fs->fs, nk); // Do this regardless.
+        
+        if (err != FOS_E_SUCCESS) {
+            return err; // Treat a register failure as catastrophic.
+        }
+
+        plugin_fs_elf_reader_t reader = {
+            .fs = plg_fs->fs,
+            .nk = kernel_nk
+        };
+
+        user_app_t ua;
+        mem_set(&ua, 0, sizeof(user_app_t));
+
+        fernos_error_t parse_err = plg_fs_parse_elf32(&reader, info.len, &ua);
+
+        // Large segments are demand paged.
+        uint32_t backed_mask = 0;
+        plugin_fs_region_t *regions = NULL;
+
+        for (size_t i = 0; parse_err == FOS_E_SUCCESS && i < FOS_MAX_APP_AREAS; i++) {
+            const user_app_area_entry_t *uaa = ua.areas + i;
+
+            if (uaa->occupied && uaa->given_size >= KS_FS_DEMAND_PAGE_MIN_SIZE) {
+                const void *end = (const uint8_t *)(uaa->load_position) +
+                    ALIGN_UP(uaa->area_size, M_4K);
+
+                const plugin_fs_region_t region = {
+                    .start = uaa->load_position,
+                    .end = end,
+                    .nk = kernel_nk,
+                    .offset = reader.offsets[i],
+                    .file_len = uaa->given_size,
+                    .mmapped = false,
+                    .write_back = false
+                };
+
+                parse_err = plg_fs_push_region(plg_fs, &regions, &region);
+                backed_mask |= (1U << i);
+            }
+        }
+
+        if (parse_err == FOS_E_SUCCESS) {
+            // The regions are handed over on reset. (See `plg_fs_on_reset_proc`)
+            plg_fs->exec_regions = regions;
+
+            // NOTE: On success, `thr` may no longer exist after this call.
+            err = ks_exec_loaded(plg->ks, &ua, backed_mask, plg_fs_elf_read, &reader,
+                    (const void *)arg2, (size_t)arg3, backed_mask ? NULL : plg_fs->ic, kernel_nk);
+
+            regions = plg_fs->exec_regions; // Still here only if the exec failed.
+            plg_fs->exec_regions = NULL;
+        } else {
+            thr->ctx.eax = parse_err;
+            err = FOS_E_SUCCESS;
+        }
+
+        if (plg_fs_free_regions(plg_fs, regions) != FOS_E_SUCCESS) {
+            return FOS_E_ABORT_SYSTEM;
+        }
+
+        // The image cache takes its own reference if it needs one.
+        if (plg_fs_deregister_nk(plg_fs, kernel_nk) != FOS_E_SUCCESS) {
+            return FOS_E_ABORT_SYSTEM;
+        }
+
+        return err;
+    }
+
     default: { // This will never run.
         return FOS_E_STATE_MISMATCH;
     }
     }
 }
 
+/**
+ * A key placed in the image cache is always a key which is already in the node key map.
+ * (The key of the handle which was executed)
+ */
+static void plg_fs_ic_on_insert(void *ctx, const void *key) {
+    plugin_fs_t *plg_fs = (plugin_fs_t *)ctx;
+    fs_node_key_t nk = (fs_node_key_t)key;
+
+    plugin_fs_nk_map_entry_t **nk_entry = mp_get(plg_fs->nk_map, &nk);
+    if (nk_entry && *nk_entry) {
+        (*nk_entry)->references++;
+    }
+}
+
+static void plg_fs_ic_on_evict(void *ctx, const void *key) {
+    plugin_fs_t *plg_fs = (plugin_fs_t *)ctx;
+
+    // This can only fail if the node key map is already broken.
+    plg_fs_deregister_nk(plg_fs, (fs_node_key_t)key);
+}
+
 static fernos_error_t plg_fs_on_fork_proc(plugin_t *plg, proc_id_t cpid) {
     plugin_fs_t *plg_fs = (plugin_fs_t *)plg;
 
@@ -539,12 +1013,42 @@ static fernos_error_t plg_fs_on_fork_proc(plugin_t *plg, proc_id_t cpid) {
     }
     (*nk_entry)->references++;
 
+    // The child's memory space is a copy of the parent's, so it needs the same regions.
+    // NOTE: The list is copied in reverse, order doesn't matter.
+    plg_fs->regions[child->pid] = NULL;
+
+    for (plugin_fs_region_t *region = plg_fs->regions[parent->pid]; region; region = region->next) {
+        fernos_error_t err = plg_fs_push_region(plg_fs, plg_fs->regions + child->pid, region);
+
+        // Without its regions, the child will fault on its first touch of an unloaded page.
+        // It'll be killed, but the system lives on.
+        if (err != FOS_E_SUCCESS) {
+            break;
+        }
+    }
+
     // The copy function inside each handle should handle increasing the reference count for
-    // each copied handle. We only need to deal with copying over the cwd here.
+    // each copied handle. We only need to deal with copying over the cwd and regions here.
 
     return FOS_E_SUCCESS;    
 }
 
+static fernos_error_t plg_fs_on_reset_proc(plugin_t *plg, proc_id_t pid) {
+    plugin_fs_t *plg_fs = (plugin_fs_t *)plg;
+
+    // The old memory space is about to go away, and with it, all of its regions.
+    // Write back errors have no one to be reported to.
+    plg_fs_write_back_regions(plg_fs, pid, NULL);
+
+    fernos_error_t err = plg_fs_free_regions(plg_fs, plg_fs->regions[pid]);
+
+    // If this reset is due to an exec of a file, the new memory space has its own regions.
+    plg_fs->regions[pid] = plg_fs->exec_regions;
+    plg_fs->exec_regions = NULL;
+
+    return err;
+}
+
 static fernos_error_t plg_fs_on_reap_proc(plugin_t *plg, proc_id_t rpid) {
     plugin_fs_t *plg_fs = (plugin_fs_t *)plg;
 
@@ -558,6 +1062,47 @@ static fernos_error_t plg_fs_on_reap_proc(plugin_t *plg, proc_id_t rpid) {
         return err;
     }
 
+    // The reaped process's memory space is still around at this point.
+    plg_fs_write_back_regions(plg_fs, rpid, NULL);
+
+    err = plg_fs_free_regions(plg_fs, plg_fs->regions[rpid]);
+    plg_fs->regions[rpid] = NULL;
+
+    if (err != FOS_E_SUCCESS) {
+        return err;
+    }
+
+    return FOS_E_SUCCESS;
+}
+
+static fernos_error_t plg_fs_on_return_mem(plugin_t *plg, proc_id_t pid, const void *s, const void *e) {
+    plugin_fs_t *plg_fs = (plugin_fs_t *)plg;
+
+    process_t *proc = idtb_get(plg->ks->proc_table, pid);
+    if (!proc) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    // A mapping which is even partially returned is unmapped in full, just like with
+    // `PLG_FS_PCID_MUNMAP`. Otherwise, whatever is mapped at its addresses next would be written
+    // into the file.
+    plugin_fs_region_t **region_p = plg_fs->regions + pid;
+    while (*region_p) {
+        plugin_fs_region_t *region = *region_p;
+
+        if ((const uint8_t *)e <= (const uint8_t *)(region->start) || 
+                (const uint8_t *)(region->end) <= (const uint8_t *)s) {
+            region_p = &(region->next);
+            continue;
+        }
+
+        // There's no one to tell if this fails, the pages are going away regardless.
+        plg_fs_write_back_region(plg_fs, proc->pd, region);
+
+        // This also moves `*region_p` onto the next region.
+        PROP_ERR(plg_fs_remove_region(plg_fs, proc->pd, region_p));
+    }
+
     return FOS_E_SUCCESS;
 }
 
@@ -703,6 +1248,9 @@ static fernos_error_t fs_hs_write(handle_state_t *hs, const void *u_src, size_t
 
     const size_t bytes_left = old_len - fs_hs->pos;
 
+    // Any cached image of this file is about to go stale.
+    ic_evict(plg_fs->ic, fs_hs->nk);
+
     // First off, do we need to expand our file?
     if (bytes_left < bytes_to_write) { // expansion is needed.
         err = fs_resize(plg_fs->fs, fs_hs->nk, fs_hs->pos + bytes_to_write);
@@ -757,7 +1305,7 @@ static fernos_error_t fs_hs_write(handle_state_t *hs, const void *u_src, size_t
 
             woken_thr->ctx.eax = FOS_E_SUCCESS;
 
-            thread_schedule(woken_thr, &(plg_fs->super.ks->schedule));
+            thread_wake(woken_thr, &(plg_fs->super.ks->schedule));
         }
     }
 
@@ -800,11 +1348,8 @@ static fernos_error_t fs_hs_wait_read_ready(handle_state_t *hs) {
         err = bwq_enqueue(bwq, thr);
         DUAL_RET_COND(err != FOS_E_SUCCESS, thr, FOS_E_UNKNWON_ERROR, FOS_E_SUCCESS);
 
-        thread_detach(thr);
-
-        thr->wq = (wait_queue_t *)bwq;
+        thread_wait(thr, (wait_queue_t *)bwq, WAIT_KIND_IO);
         thr->wait_ctx[0] = (uint32_t)fs_hs;
-        thr->state = THREAD_STATE_WAITING;
 
         // Current thread is now waiting, just return one code to kernel space.
         return FOS_E_SUCCESS;
@@ -890,10 +1435,6 @@ static fernos_error_t fs_hs_read(handle_state_t *hs, void *u_dst, size_t len, si
 static fernos_error_t fs_hs_cmd(handle_state_t *hs, handle_cmd_id_t cmd, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
     fernos_error_t err;
 
-    (void)arg1;
-    (void)arg2;
-    (void)arg3;
-
     plugin_fs_handle_state_t *fs_hs = (plugin_fs_handle_state_t *)hs;
     plugin_fs_t *plg_fs = fs_hs->plg_fs;
 
@@ -929,9 +1470,123 @@ static fernos_error_t fs_hs_cmd(handle_state_t *hs, handle_cmd_id_t cmd, uint32_
         DUAL_RET(thr, FOS_E_SUCCESS, FOS_E_SUCCESS);
     }
 
+    /*
+     * Flush the file behind this handle.
+     *
+     * Dirty pages of the calling process's mappings of this file are written back first.
+     */
     case PLG_FS_HCID_FLUSH: {
+        fernos_error_t wb_err = plg_fs_write_back_regions(plg_fs, thr->proc->pid, fs_hs->nk);
+
         err = fs_flush(plg_fs->fs, fs_hs->nk);
-        DUAL_RET(thr, err, FOS_E_SUCCESS);
+        DUAL_RET(thr, wb_err != FOS_E_SUCCESS ? wb_err : err, FOS_E_SUCCESS);
+    }
+
+    /*
+     * Execute the file behind this handle.
+     *
+     * Exactly like `ks_exec` with (`arg0`, `arg1`, `arg2`) = (`u_ua`, `u_abs_ab`, `u_abs_ab_len`).
+     *
+     * The image cache is NOT used here. `u_ua` comes from userspace, so nothing guarantees it
+     * really was parsed from this file. Filling the cache from it would let any process with a
+     * handle on a file change what every later exec of that file maps. (Only images parsed by
+     * the kernel are cached, see `PLG_FS_PCID_EXEC`)
+     */
+    case PLG_FS_HCID_EXEC: {
+        // NOTE: On success, this handle is deleted by the exec! `fs_hs` can't be used after.
+        return ks_exec(hs->ks, (user_app_t *)arg0, (const void *)arg1, (size_t)arg2);
+    }
+
+    /*
+     * Map part of the file behind this handle into the calling process's free area.
+     *
+     * `arg0` is the file offset of the first mapped byte. (Must be 4K aligned)
+     * `arg1` is the length of the mapping in bytes. Mapped bytes past the end of the file are 
+     * zero and are never written back.
+     * `arg2` holds the mapping flags. (See `PLG_FS_MMAP_FLAG_*`)
+     * `arg3` is where the address of the mapping is written in userspace.
+     *
+     * Mappings are placed as high in the free area as possible, away from the heap.
+     * No pages are read up front, each page is read from the file the first time it is touched.
+     * (Just like demand paged segments)
+     *
+     * returns FOS_E_BAD_ARGS if `arg3` is NULL or `arg1` is 0.
+     * returns FOS_E_ALIGN_ERROR if the offset isn't 4K aligned.
+     * returns FOS_E_INVALID_RANGE if the offset is past the end of the file.
+     * returns FOS_E_NO_SPACE if the free area has no room for the mapping.
+     */
+    case PLG_FS_HCID_MMAP: {
+        const size_t offset = (size_t)arg0;
+        const size_t len = (size_t)arg1;
+        const uint32_t flags = arg2;
+        const void **u_addr = (const void **)arg3;
+
+        if (!u_addr || len == 0) {
+            DUAL_RET(thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+        }
+
+        if (!IS_ALIGNED(offset, M_4K)) {
+            DUAL_RET(thr, FOS_E_ALIGN_ERROR, FOS_E_SUCCESS);
+        }
+
+        if (len > FC_CORE_VMEM_FREE_SIZE) {
+            DUAL_RET(thr, FOS_E_NO_SPACE, FOS_E_SUCCESS);
+        }
+
+        fs_node_info_t info;
+        err = fs_get_node_info(plg_fs->fs, fs_hs->nk, &info);
+        DUAL_RET_FOS_ERR(err, thr);
+
+        if (info.is_dir) {
+            return FOS_E_STATE_MISMATCH; // Sanity check.
+        }
+
+        if (offset > info.len) {
+            DUAL_RET(thr, FOS_E_INVALID_RANGE, FOS_E_SUCCESS);
+        }
+
+        const phys_addr_t pd = thr->proc->pd;
+        const uint32_t num_pages = ALIGN_UP(len, M_4K) / M_4K;
+
+        uint32_t pi;
+        err = pd_find_free_run_p(pd, FC_CORE_VMEM_FREE_START / M_4K, FC_CORE_VMEM_FREE_END / M_4K,
+                num_pages, &pi);
+        DUAL_RET_FOS_ERR(err, thr);
+
+        const bool writeable = (flags & PLG_FS_MMAP_FLAG_WRITE) == PLG_FS_MMAP_FLAG_WRITE;
+
+        const plugin_fs_region_t region = {
+            .start = (const void *)(pi * M_4K),
+            .end = (const void *)((pi + num_pages) * M_4K),
+            .nk = fs_hs->nk,
+            .offset = offset,
+            .file_len = MIN(len, info.len - offset),
+            .mmapped = true,
+            .write_back = writeable && !(flags & PLG_FS_MMAP_FLAG_PRIVATE)
+        };
+
+        plugin_fs_region_t **regions = plg_fs->regions + thr->proc->pid;
+
+        err = plg_fs_push_region(plg_fs, regions, &region);
+        DUAL_RET_FOS_ERR(err, thr);
+
+        // A fresh mapping has no dirty pages, so there's nothing to write back if we fail from
+        // here on out.
+
+        err = pd_reserve_backed_pages_p(pd, true, writeable, pi, pi + num_pages, NULL);
+        if (err == FOS_E_SUCCESS) {
+            err = mem_cpy_to_user(pd, u_addr, &(region.start), sizeof(const void *), NULL);
+        }
+
+        if (err != FOS_E_SUCCESS) {
+            if (plg_fs_remove_region(plg_fs, pd, regions) != FOS_E_SUCCESS) {
+                return FOS_E_ABORT_SYSTEM;
+            }
+
+            DUAL_RET(thr, err, FOS_E_SUCCESS);
+        }
+
+        DUAL_RET(thr, FOS_E_SUCCESS, FOS_E_SUCCESS);
     }
 
     default: {
@@ -27,7 +27,8 @@ static const plugin_impl_t PLUGIN_FUT_IMPL = {
     .plg_tick = NULL,
     .plg_on_fork_proc = plg_fut_on_fork_proc,
     .plg_on_reset_proc = plg_fut_on_reset_proc,
-    .plg_on_reap_proc =plg_fut_on_reap_proc 
+    .plg_on_reap_proc =plg_fut_on_reap_proc,
+    .plg_on_return_mem = NULL
 };
 
 plugin_t *new_plugin_fut(kernel_state_t *ks) {
@@ -172,7 +173,7 @@ static fernos_error_t plg_fut_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t a
             woken_thread->ctx.eax = FOS_E_STATE_MISMATCH;
             woken_thread->state = THREAD_STATE_DETATCHED;
 
-            thread_schedule(woken_thread, &(ks->schedule));
+            thread_wake(woken_thread, &(ks->schedule));
         }
 
         // Some sort of error with the popping.
@@ -234,9 +235,7 @@ static fernos_error_t plg_fut_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t a
         err = bwq_enqueue(bwq, curr_thr);
         DUAL_RET_FOS_ERR(err, curr_thr); // An error to enqueue is actually recoverable!
 
-        thread_detach(curr_thr);
-        curr_thr->wq = (wait_queue_t *)bwq;
-        curr_thr->state = THREAD_STATE_WAITING;
+        thread_wait(curr_thr, (wait_queue_t *)bwq, WAIT_KIND_SYNC);
 
         return FOS_E_SUCCESS;
 	}
@@ -280,7 +279,7 @@ static fernos_error_t plg_fut_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t a
             woken_thread->ctx.eax = FOS_E_SUCCESS;
             woken_thread->state = THREAD_STATE_DETATCHED;
 
-            thread_schedule(woken_thread, &(ks->schedule));
+            thread_wake(woken_thread, &(ks->schedule));
         }
 
         if (err != FOS_E_EMPTY) {
@@ -9,7 +9,7 @@
 #include "s_util/ansi.h"
 
 
-fernos_error_t init_window_gfx_base(window_gfx_base_t *win, gfx_manager_t *gm, const window_impl_t *impl, allocator_t *al, ring_t *sch) {
+fernos_error_t init_window_gfx_base(window_gfx_base_t *win, gfx_manager_t *gm, const window_impl_t *impl, allocator_t *al, schedule_t *sch) {
     if (!win || !gm || !impl || !al || !sch) {
         return FOS_E_BAD_ARGS;
     }
@@ -36,7 +36,7 @@ fernos_error_t init_window_gfx_base(window_gfx_base_t *win, gfx_manager_t *gm, c
     win->references = 1;
     *(fixed_queue_t **)&(win->eq) = eq;
     *(basic_wait_queue_t **)&(win->bwq) = bwq;
-    *(ring_t **)&(win->schedule) = sch;
+    *(schedule_t **)&(win->schedule) = sch;
 
     return FOS_E_SUCCESS;
 }
@@ -77,9 +77,7 @@ static fernos_error_t window_gfx_base_wait_events(window_gfx_base_t *win, thread
     }
 
     // Enqueue succeeded, we are in the clear!
-    thread_detach(thr);
-    thr->wq = (wait_queue_t *)(win->bwq);
-    thr->state = THREAD_STATE_WAITING;
+    thread_wait(thr, (wait_queue_t *)(win->bwq), WAIT_KIND_IO);
 
     return FOS_E_SUCCESS;
 }
@@ -141,7 +139,7 @@ static fernos_error_t window_gfx_base_read_events(window_gfx_base_t *win, thread
 }
 
 static window_terminal_t *new_window_terminal(allocator_t *al, uint16_t rows, uint16_t cols, 
-        const gfx_term_buffer_attrs_t *attrs, ring_t *sch);
+        const gfx_term_buffer_attrs_t *attrs, schedule_t *sch);
 static void delete_terminal_window(window_t *w);
 static void tw_render(window_t *w);
 static fernos_error_t tw_on_event(window_t *w, window_event_t ev);
@@ -157,7 +155,7 @@ static const window_impl_t TERMINAL_WINDOW_IMPL = {
 };
 
 static window_terminal_t *new_window_terminal(allocator_t *al, uint16_t rows, uint16_t cols, 
-        const gfx_term_buffer_attrs_t *attrs, ring_t *sch) {
+        const gfx_term_buffer_attrs_t *attrs, schedule_t *sch) {
     if (!al || !attrs || !sch) {
         return NULL;
     }
@@ -878,6 +876,7 @@ static const plugin_impl_t PLUGIN_GFX_IMPL = {
     .plg_on_fork_proc = NULL,
     .plg_on_reset_proc = NULL,
     .plg_on_reap_proc = NULL,
+    .plg_on_return_mem = NULL
 };
 
 plugin_t *new_plugin_gfx(kernel_state_t *ks, window_t *root_window) {
@@ -156,11 +156,8 @@ static fernos_error_t kb_hs_wait_read_ready(handle_state_t *hs) {
         err = bwq_enqueue(bwq, thr);
         DUAL_RET_COND(err != FOS_E_SUCCESS, thr, FOS_E_UNKNWON_ERROR, FOS_E_SUCCESS);
 
-        thread_detach(thr);
-
-        thr->wq = (wait_queue_t *)bwq;
+        thread_wait(thr, (wait_queue_t *)bwq, WAIT_KIND_IO);
         thr->wait_ctx[0] = (uint32_t)plg_kb_hs;
-        thr->state = THREAD_STATE_WAITING;
 
         // Current thread is now waiting, just return one code to kernel space.
         return FOS_E_SUCCESS;
@@ -219,6 +216,7 @@ static const plugin_impl_t PLUGIN_KB_IMPL = {
     .plg_on_fork_proc = NULL,
     .plg_on_reset_proc = NULL,
     .plg_on_reap_proc = NULL,
+    .plg_on_return_mem = NULL
 };
 
 plugin_t *new_plugin_kb(kernel_state_t *ks) {
@@ -303,7 +301,7 @@ static fernos_error_t plg_kb_kernel_cmd(plugin_t *plg, plugin_kernel_cmd_id_t kc
             
             woken_thr->ctx.eax = FOS_E_SUCCESS;
 
-            thread_schedule(woken_thr, &(plg->ks->schedule));
+            thread_wake(woken_thr, &(plg->ks->schedule));
         }
 
         if (err != FOS_E_EMPTY) {
@@ -176,9 +176,7 @@ static fernos_error_t pipe_hs_wait_write_ready(handle_state_t *hs) {
         err = bwq_enqueue(pipe->w_wq, thr);
         DUAL_RET_FOS_ERR(err, thr); // Failing to enqueue here is recoverable!
 
-        thread_detach(thr);
-        thr->wq = (wait_queue_t *)(pipe->w_wq);
-        thr->state = THREAD_STATE_WAITING;
+        thread_wait(thr, (wait_queue_t *)(pipe->w_wq), WAIT_KIND_IO);
 
         return FOS_E_SUCCESS;
     }
@@ -294,9 +292,7 @@ static fernos_error_t pipe_hs_wait_read_ready(handle_state_t *hs) {
         err = bwq_enqueue(pipe->r_wq, thr);
         DUAL_RET_FOS_ERR(err, thr); // Failing to enqueue here is recoverable!
 
-        thread_detach(thr);
-        thr->wq = (wait_queue_t *)(pipe->r_wq);
-        thr->state = THREAD_STATE_WAITING;
+        thread_wait(thr, (wait_queue_t *)(pipe->r_wq), WAIT_KIND_IO);
 
         return FOS_E_SUCCESS;
     }
@@ -392,6 +388,7 @@ static const plugin_impl_t PLUGIN_PIPE_IMPL = {
     .plg_on_fork_proc = NULL,
     .plg_on_reset_proc = NULL,
     .plg_on_reap_proc = NULL,
+    .plg_on_return_mem = NULL
 };
 
 plugin_t *new_plugin_pipe(kernel_state_t *ks) {
@@ -72,7 +72,8 @@ static const plugin_impl_t PLUGIN_SHM_IMPL = {
     .plg_tick = NULL,
     .plg_on_fork_proc = plg_shm_on_fork_proc,
     .plg_on_reset_proc = plg_shm_on_reset_proc,
-    .plg_on_reap_proc =plg_shm_on_reap_proc 
+    .plg_on_reap_proc =plg_shm_on_reap_proc,
+    .plg_on_return_mem = NULL
 };
 
 plugin_t *new_plugin_shm(kernel_state_t *ks) {
@@ -493,9 +494,7 @@ static fernos_error_t plg_shm_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t a
             DUAL_RET(curr_thr, FOS_E_NO_MEM, FOS_E_SUCCESS);
         }
 
-        thread_detach(curr_thr);
-        curr_thr->state = THREAD_STATE_WAITING;
-        curr_thr->wq = (wait_queue_t *)(sem->bwq);
+        thread_wait(curr_thr, (wait_queue_t *)(sem->bwq), WAIT_KIND_SYNC);
 
         return FOS_E_SUCCESS;
     }
@@ -552,7 +551,7 @@ static fernos_error_t plg_shm_cmd(plugin_t *plg, plugin_cmd_id_t cmd, uint32_t a
                 mem_set(woken_thr->wait_ctx, 0, sizeof(woken_thr->wait_ctx)); // Not really necessary, but whatever.
                 woken_thr->ctx.eax = FOS_E_SUCCESS;
 
-                thread_schedule(woken_thr, &(ks->schedule));
+                thread_wake(woken_thr, &(ks->schedule));
             }
 
             if (err != FOS_E_EMPTY) {
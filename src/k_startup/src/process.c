@@ -19,8 +19,16 @@ process_t *new_process(allocator_t *al, proc_id_t pid, phys_addr_t pd, process_t
     vector_wait_queue_t *signal_queue = new_vector_wait_queue(al);
     id_table_t *handle_table = new_id_table(al, FC_CORE_MAX_HANDLES_PER_PROC);
 
+    if (proc) {
+        // Must be set before attaching. The root process never has a quota, everyone else starts
+        // with their parent's. (Or the default when their parent has none)
+        proc->mem_stats.quota = !parent ? 0 
+            : parent->mem_stats.quota ? parent->mem_stats.quota : FC_CORE_PROC_FRAME_QUOTA;
+    }
+
     if (!proc || !children || !zchildren || !thread_table || !join_queue || 
-            !signal_queue || !handle_table) {
+            !signal_queue || !handle_table || 
+            pd_acct_attach(pd, &(proc->mem_stats)) != FOS_E_SUCCESS) {
         al_free(al, proc);
         delete_list(children);
         delete_list(zchildren);
@@ -44,6 +52,7 @@ process_t *new_process(allocator_t *al, proc_id_t pid, phys_addr_t pd, process_t
 
     proc->thread_table = thread_table;
     proc->join_queue = join_queue;
+    proc->exited_stats = (sched_stats_t) { 0 };
 
     proc->main_thread = NULL;
 
@@ -60,6 +69,49 @@ process_t *new_process(allocator_t *al, proc_id_t pid, phys_addr_t pd, process_t
     return proc;
 }
 
+/**
+ * Copy the handle state at `hid` in `proc` (if there is one) into the same slot of `child`.
+ *
+ * On error, `child` is deleted! (FOS_E_ABORT_SYSTEM is returned if this deletion fails, or if
+ * the copy itself was catastrophic)
+ */
+static fernos_error_t proc_copy_handle(process_t *proc, process_t *child, handle_t hid) {
+    fernos_error_t err;
+
+    handle_state_t *hs = idtb_get(proc->handle_table, hid);
+    if (!hs) {
+        return FOS_E_SUCCESS;
+    }
+
+    handle_state_t *hs_copy;
+
+    err = idtb_request_id(child->handle_table, hid);
+    if (err == FOS_E_SUCCESS) {
+        // Same idea as what is done with the thread table in `new_process_fork`!
+        idtb_set(child->handle_table, hid, NULL);
+        err = copy_handle_state(hs, child, &hs_copy);
+    }
+
+    if (err != FOS_E_SUCCESS) {
+        if (err == FOS_E_ABORT_SYSTEM) {
+            // In case of catastrophic error, don't worry about clean up.
+            return FOS_E_ABORT_SYSTEM;
+        }
+
+        // In case of other error, attempt cleanup.
+        if (delete_process(child) != FOS_E_SUCCESS) {
+            return FOS_E_ABORT_SYSTEM;
+        }
+
+        return err;
+    }
+
+    // Success case! Place in table!
+    idtb_set(child->handle_table, hid, hs_copy);
+
+    return FOS_E_SUCCESS;
+}
+
 fernos_error_t new_process_fork(process_t *proc, thread_t *thr, proc_id_t cpid, process_t **out) {
     fernos_error_t err;
 
@@ -71,7 +123,8 @@ fernos_error_t new_process_fork(process_t *proc, thread_t *thr, proc_id_t cpid,
         return FOS_E_BAD_ARGS;
     }
 
-    phys_addr_t new_pd = copy_page_directory(proc->pd);
+    // Writeable unique pages are shared copy-on-write rather than copied up front.
+    phys_addr_t new_pd = cow_page_directory(proc->pd);
     if (new_pd == NULL_PHYS_ADDR) {
         return FOS_E_NO_MEM;
     }
@@ -144,34 +197,57 @@ fernos_error_t new_process_fork(process_t *proc, thread_t *thr, proc_id_t cpid,
     // Ok, now actual handle copying will happen here too!
 
     for (id_t hid = 0; hid < FC_CORE_MAX_HANDLES_PER_PROC; hid++) {
-        handle_state_t *hs = idtb_get(proc->handle_table, hid);
-        if (hs) {
-            handle_state_t *hs_copy;
-
-            err = idtb_request_id(child->handle_table, hid);
-            if (err == FOS_E_SUCCESS) {
-                // Same idea as what I said above about the thread table!
-                idtb_set(child->handle_table, hid, NULL);
-                err = copy_handle_state(hs, child, &hs_copy);
-            }
+        err = proc_copy_handle(proc, child, hid);
+        if (err != FOS_E_SUCCESS) {
+            return err;
+        }
+    }
 
-            if (err != FOS_E_SUCCESS) {
-                if (err == FOS_E_ABORT_SYSTEM) {
-                    // In case of catastrophic error, don't worry about clean up.
-                    return FOS_E_ABORT_SYSTEM;
-                }
+    *out = child;
+
+    return FOS_E_SUCCESS;
+}
 
-                // In case of other error, attempt cleanup.
-                if (delete_process(child) != FOS_E_SUCCESS) {
-                    return FOS_E_ABORT_SYSTEM;
-                }
+fernos_error_t new_process_spawn(process_t *proc, proc_id_t cpid, phys_addr_t new_pd, 
+        uintptr_t entry, uint32_t arg0, uint32_t arg1, uint32_t arg2, process_t **out) {
+    fernos_error_t err;
 
-                return err;
-            }
+    if (!proc || new_pd == NULL_PHYS_ADDR || !entry || !out) {
+        delete_page_directory(new_pd);
+        return FOS_E_BAD_ARGS;
+    }
 
-            // Success case! Place in table!
-            idtb_set(child->handle_table, hid, hs_copy);
+    process_t *child = new_process(proc->al, cpid, new_pd, proc);
+
+    if (!child) {
+        delete_page_directory(new_pd);
+        return FOS_E_NO_MEM;
+    }
+
+    // From this point on, `child` owns `new_pd`.
+
+    // The new page directory has no stacks allocated, the main thread's stack is paged in
+    // by the PF handler as usual.
+    if (!proc_new_thread(child, entry, arg0, arg1, arg2)) {
+        if (delete_process(child) != FOS_E_SUCCESS) {
+            return FOS_E_ABORT_SYSTEM;
         }
+
+        return FOS_E_NO_MEM;
+    }
+
+    // Just like an exec, only the default IO handles survive.
+
+    child->in_handle = proc->in_handle;
+    child->out_handle = proc->out_handle;
+
+    err = proc_copy_handle(proc, child, proc->in_handle);
+    if (err == FOS_E_SUCCESS && proc->out_handle != proc->in_handle) {
+        err = proc_copy_handle(proc, child, proc->out_handle);
+    }
+
+    if (err != FOS_E_SUCCESS) {
+        return err; // `child` was deleted by `proc_copy_handle`.
     }
 
     *out = child;
@@ -245,12 +321,17 @@ fernos_error_t proc_exec(process_t *proc, phys_addr_t new_pd, uintptr_t entry, u
     delete_page_directory(proc->pd);
     proc->pd = new_pd; // New pd should have no thread stacks allocated!
 
+    // This can't fail, deleting the old page directory freed up its accounting slot.
+    pd_acct_attach(new_pd, &(proc->mem_stats));
+
     // Now delete all non-main threads!
 
     for (thread_id_t tid = 0; tid < FC_CORE_MAX_THREADS_PER_PROC; tid++) {
         thread_t *thr = (thread_t *)idtb_get(proc->thread_table, tid);
         if (thr && thr != main_thr) {
-            delete_thread(thr); // This will deschedule/unwait as necessary!
+            thread_detach(thr);
+            sched_stats_add(&(proc->exited_stats), &(thr->stats));
+            delete_thread(thr);
 
             // No need to delete `thr`'s stack.
             // This was already done by just deleting the whole page directory!
@@ -286,6 +367,31 @@ fernos_error_t proc_exec(process_t *proc, phys_addr_t new_pd, uintptr_t entry, u
     return FOS_E_SUCCESS;
 }
 
+void proc_release_memory(process_t *proc) {
+    if (!proc) {
+        return;
+    }
+
+    pd_free_pages(proc->pd, false, (void *)FC_CORE_VMEM_APP_START, 
+            (const void *)FC_CORE_VMEM_APP_END);
+    pd_free_pages(proc->pd, false, (void *)FC_CORE_VMEM_APP_ARGS_START, 
+            (const void *)FC_CORE_VMEM_APP_ARGS_END);
+    pd_free_pages(proc->pd, false, (void *)FC_CORE_VMEM_FREE_START, 
+            (const void *)FC_CORE_VMEM_FREE_END);
+
+    for (thread_id_t tid = 0; tid < FC_CORE_MAX_THREADS_PER_PROC; tid++) {
+        thread_t *thr = idtb_get(proc->thread_table, tid);
+        if (thr) {
+            const void *tstack_end = (const void *)FC_CORE_TSTACK_END(tid);
+
+            pd_free_pages(proc->pd, false, thr->stack_base, tstack_end);
+
+            // The stack is now empty.
+            thr->stack_base = (void *)tstack_end;
+        }
+    }
+}
+
 thread_t *proc_new_thread(process_t *proc, uintptr_t entry, uint32_t arg0, uint32_t arg1,
         uint32_t arg2) {
     if (!proc || !entry) {
@@ -334,10 +440,24 @@ void proc_delete_thread(process_t *proc, thread_t *thr, bool return_stack) {
         pd_free_pages(proc->pd, false, tstack_start, tstack_end);
     }
 
-    // detaches.
+    // Detach first, so everything up to the thread's deletion is counted.
+    thread_detach(thr);
+    sched_stats_add(&(proc->exited_stats), &(thr->stats));
+
     delete_thread(thr);
 
     // Return the thread id so it can be used by later threads!
     idtb_push_id(proc->thread_table, tid);
 }
 
+void proc_sched_stats(process_t *proc, sched_stats_t *stats) {
+    *stats = proc->exited_stats;
+
+    for (thread_id_t tid = 0; tid < FC_CORE_MAX_THREADS_PER_PROC; tid++) {
+        thread_t *thr = (thread_t *)idtb_get(proc->thread_table, tid);
+        if (thr) {
+            sched_stats_add(stats, &(thr->stats));
+        }
+    }
+}
+
@@ -10,6 +10,9 @@
 
 #include "s_util/str.h"
 #include "k_startup/gfx.h"
+#include "k_startup/idt.h"
+#include "k_startup/clock.h"
+#include "k_sys/intr.h"
 
 /**
  * Creates a new kernel state with basically no fleshed out details.
@@ -27,11 +30,14 @@ kernel_state_t *new_kernel_state(allocator_t *al) {
     }
 
     *(allocator_t **)&(ks->al) = al;
-    init_ring(&(ks->schedule));
+    ks->scratch_al = NULL;
+    init_schedule(&(ks->schedule));
     *(id_table_t **)&(ks->proc_table) = pt;
     ks->root_proc = NULL;
 
     ks->curr_tick = 0;
+    ks->idle_counts = 0;
+    ks->idle_rem_counts = 0;
     *(timed_wait_queue_t **)&(ks->sleep_q) = twq;
 
     for (size_t i = 0; i < FC_CORE_MAX_PLUGINS; i++) {
@@ -79,7 +85,10 @@ fernos_error_t ks_kernel_cmd(kernel_state_t *ks, plugin_id_t plg_id, plugin_kern
 
 void ks_save_ctx(kernel_state_t *ks, user_ctx_t *ctx) {
     if (ks->schedule.head) {
-        ((thread_t *)(ks->schedule.head))->ctx = *ctx;
+        thread_t *thr = (thread_t *)(ks->schedule.head);
+
+        thr->ctx = *ctx;
+        thread_charge(thr);
     }
 }
 
@@ -121,6 +130,28 @@ fernos_error_t ks_expand_stack(kernel_state_t *ks, void *new_base) {
     return FOS_E_SUCCESS;
 }
 
+fernos_error_t ks_resolve_cow(kernel_state_t *ks, void *addr) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+
+    return pd_resolve_cow(thr->proc->pd, addr);
+}
+
+fernos_error_t ks_resolve_lazy(kernel_state_t *ks, void *addr, bool write) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+
+    return write 
+        ? pd_resolve_lazy(thr->proc->pd, addr) 
+        : pd_resolve_lazy_read(thr->proc->pd, addr);
+}
+
 void ks_shutdown(kernel_state_t *ks) {
     for (size_t i = 0; i < FC_CORE_MAX_PLUGINS; i++) {
         if (ks->plugins[i]) {
@@ -131,14 +162,105 @@ void ks_shutdown(kernel_state_t *ks) {
     lock_up();
 }
 
+#define NS_PER_SEC (1000000000ULL)
+
+/**
+ * The length of one tick in nanoseconds.
+ */
+#define KS_TICK_NS (((uint64_t)TICK_PIT_RELOAD_VAL * NS_PER_SEC) / PIT_BASE_FREQ_HZ)
+
+/**
+ * The current time in sleep queue units.
+ */
+static uint32_t ks_sleep_now(void) {
+    return (uint32_t)(clock_ns() >> KS_SLEEP_UNIT_SHIFT);
+}
+
+/**
+ * Add `counts` PIT cycles worth of ticks to the tick counter. Partial ticks are carried over
+ * in `idle_rem_counts`.
+ */
+static void ks_credit_pit_counts(kernel_state_t *ks, uint32_t counts) {
+    counts += ks->idle_rem_counts;
+
+    ks->curr_tick += counts / TICK_PIT_RELOAD_VAL;
+    ks->idle_rem_counts = counts % TICK_PIT_RELOAD_VAL;
+}
+
+void ks_idle(kernel_state_t *ks) {
+    if (ks->schedule.head || ks->idle_counts) {
+        return;
+    }
+
+    uint64_t counts = ((KS_PLG_TICK_PERIOD - (ks->curr_tick % KS_PLG_TICK_PERIOD)) 
+            * TICK_PIT_RELOAD_VAL) - ks->idle_rem_counts;
+
+    // The sleep queue was last notified at the last tick, bring it up to now so the time until 
+    // the next deadline is measured from here.
+    twq_notify(ks->sleep_q, ks_sleep_now());
+
+    uint32_t sleep_units;
+    if (twq_time_until_next(ks->sleep_q, &sleep_units) == FOS_E_SUCCESS) {
+        // Round up, so we never wake up before the deadline.
+        const uint64_t sleep_counts = ((((uint64_t)sleep_units << KS_SLEEP_UNIT_SHIFT) 
+                    * PIT_BASE_FREQ_HZ) + NS_PER_SEC - 1) / NS_PER_SEC;
+
+        if (sleep_counts < counts) {
+            counts = sleep_counts;
+        }
+    }
+
+    if (counts > UINT16_MAX) {
+        counts = UINT16_MAX;
+    }
+
+    // A sleeping thread is already due, interrupt right away.
+    if (counts == 0) {
+        counts = 1;
+    }
+
+    pit_one_shot((uint16_t)counts);
+    ks->idle_counts = (uint32_t)counts;
+}
+
+void ks_exit_idle(kernel_state_t *ks) {
+    if (!(ks->idle_counts)) {
+        return;
+    }
+
+    // Read the count BEFORE checking if the countdown finished. Once the countdown finishes, the
+    // count wraps around and is meaningless.
+    const uint32_t count = pit_get_count();
+
+    if (pit_one_shot_done()) {
+        // IRQ0 is still pending, the timer handler will end the idle period once it runs.
+        return;
+    }
+
+    // (The count may not be loaded yet if the countdown only just started)
+    ks_credit_pit_counts(ks, count <= ks->idle_counts ? ks->idle_counts - count : 0);
+    ks->idle_counts = 0;
+
+    init_pit(TICK_PIT_RELOAD_VAL);
+}
+
 fernos_error_t ks_tick(kernel_state_t *ks) {
     fernos_error_t err;
 
     bool not_halted = ks->schedule.head != NULL;
 
-    ks->curr_tick++;
+    const uint32_t prev_tick = ks->curr_tick;
 
-    twq_notify(ks->sleep_q, ks->curr_tick);
+    if (ks->idle_counts) {
+        // The one-shot interrupt we were waiting for, back to the periodic timer.
+        ks_credit_pit_counts(ks, ks->idle_counts);
+        ks->idle_counts = 0;
+        init_pit(TICK_PIT_RELOAD_VAL);
+    } else {
+        ks->curr_tick++;
+    }
+
+    twq_notify(ks->sleep_q, ks_sleep_now());
 
     thread_t *woken_thread;
     while ((err = twq_pop(ks->sleep_q, (void **)&woken_thread)) == FOS_E_SUCCESS) {
@@ -148,7 +270,7 @@ fernos_error_t ks_tick(kernel_state_t *ks) {
 
         // Schedule woken thread. 
         
-        thread_schedule(woken_thread, &(ks->schedule));
+        thread_wake(woken_thread, &(ks->schedule));
     }
 
     if (err != FOS_E_EMPTY) {
@@ -160,13 +282,19 @@ fernos_error_t ks_tick(kernel_state_t *ks) {
      *
      * Otherwise, the order threads are woken up doesn't always match when they execute.
      * (This doesn't really matter that much, but makes execution behavior more predictable)
+     *
+     * When we were halted, the first woken thread became the current thread, but a more urgent
+     * thread may have been woken after it.
      */
     if (not_halted) {
-        ring_advance(&(ks->schedule));
+        ((thread_t *)(ks->schedule.head))->stats.cpu_ticks++;
+        schedule_tick(&(ks->schedule));
+    } else {
+        schedule_refresh(&(ks->schedule));
     }
 
-    // trigger plugin on tick handlers every 16th tick.
-    if ((ks->curr_tick & 0xF) == 0) {
+    // trigger plugin on tick handlers every 16th tick. (Idle periods never skip past one)
+    if ((prev_tick / KS_PLG_TICK_PERIOD) != (ks->curr_tick / KS_PLG_TICK_PERIOD)) {
         err = plgs_tick(ks->plugins, FC_CORE_MAX_PLUGINS);
         if (err != FOS_E_SUCCESS) {
             return err;
@@ -423,6 +551,86 @@ KS_SYSCALL fernos_error_t ks_exit_proc(kernel_state_t *ks, proc_exit_status_t st
     return ks_exit_proc_p(ks, thr->proc, status);
 }
 
+/**
+ * Force exit `proc` with PROC_ES_OOM, and release its memory right away.
+ */
+static fernos_error_t ks_oom_kill_p(kernel_state_t *ks, process_t *proc) {
+    PROP_ERR(ks_exit_proc_p(ks, proc, PROC_ES_OOM));
+
+    // Plugins let go of their pages first. This way file mappings are still written back.
+    PROP_ERR(plgs_on_reset_proc(ks->plugins, FC_CORE_MAX_PLUGINS, proc->pid));
+
+    proc_release_memory(proc);
+
+    return FOS_E_SUCCESS;
+}
+
+/**
+ * Whether force exiting `victim` would also end `proc`.
+ *
+ * An exit sends FSIG_CHLD to the parent, which exits as well if it doesn't allow FSIG_CHLD, and so
+ * on up the tree. (See `ks_signal_p`)
+ */
+static bool ks_exit_ends_proc(process_t *victim, process_t *proc) {
+    const sig_vector_t chld = 1UL << FSIG_CHLD;
+
+    for (process_t *iter = victim; iter != proc; iter = iter->parent) {
+        process_t *parent = iter->parent;
+
+        // A pending FSIG_CHLD is never sent again, an allowed one is just queued.
+        if (!parent || (parent->sig_vec & chld) || (parent->sig_allow & chld)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+fernos_error_t ks_oom_kill(kernel_state_t *ks) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+    process_t *proc = thr->proc;
+
+    // A process which hit its own quota has no one else to blame.
+    if (pd_acct_room(&(proc->mem_stats)) == 0) {
+        return FOS_E_NO_MEM;
+    }
+
+    process_t *victim = NULL;
+    uint32_t victim_pages = 0;
+
+    for (proc_id_t pid = 0; pid < FC_CORE_MAX_PROCS; pid++) {
+        process_t *iter = idtb_get(ks->proc_table, pid);
+        if (!iter || iter->exited || iter == ks->root_proc) {
+            continue;
+        }
+
+        // Killing a process which would take us down with it doesn't help the allocation.
+        if (iter != proc && ks_exit_ends_proc(iter, proc)) {
+            continue;
+        }
+
+        // Shared pages don't come back when a process is killed.
+        const uint32_t pages = iter->mem_stats.resident - iter->mem_stats.shared;
+
+        if (!victim || pages > victim_pages) {
+            victim = iter;
+            victim_pages = pages;
+        }
+    }
+
+    if (!victim || victim == proc) {
+        return FOS_E_NO_MEM;
+    }
+
+    PROP_ERR(ks_oom_kill_p(ks, victim));
+
+    return FOS_E_SUCCESS;
+}
+
 KS_SYSCALL fernos_error_t ks_reap_proc(kernel_state_t *ks, proc_id_t cpid, 
         proc_id_t *u_rcpid, proc_exit_status_t *u_rces) {
     fernos_error_t err;
@@ -526,42 +734,44 @@ KS_SYSCALL fernos_error_t ks_reap_proc(kernel_state_t *ks, proc_id_t cpid,
 
 KS_SYSCALL fernos_error_t ks_exec(kernel_state_t *ks, user_app_t *u_ua, const void *u_abs_ab,
         size_t u_abs_ab_len) {
-    fernos_error_t err;
-
-    if (!(ks->schedule.head)) {
-        return FOS_E_STATE_MISMATCH;
-    }
-
-    thread_t *thr = (thread_t *)(ks->schedule.head);
-    process_t *proc = thr->proc;
+    return ks_exec_cached(ks, u_ua, u_abs_ab, u_abs_ab_len, NULL, NULL);
+}
 
-    // Quick args check.
-    if (!u_ua) {
-        DUAL_RET(thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
-    }
+/**
+ * Build the page directory of a new app for `proc`. (Shared by exec and spawn)
+ *
+ * `ua` lives in kernel space. Areas which are not found in `ice` or `backed_mask` are loaded
+ * using `reader` if given, otherwise from their `given` buffers. If `ic` is given and `ice` is NULL, an attempt is
+ * made to cache `ua` under `key`.
+ *
+ * `u_abs_ab` is copied out of `proc`'s memory space. On success, the new page directory is
+ * written to `*new_pd` and the number of arguments found in the args block is written to
+ * `*num_args`.
+ *
+ * All errors returned are meant for the user, nothing is modified on error.
+ * `ua` is NOT deleted by this function.
+ */
+static fernos_error_t ks_load_app_p(kernel_state_t *ks, process_t *proc, const user_app_t *ua, 
+        uint32_t backed_mask, ua_area_reader_ft reader, void *reader_ctx, image_cache_entry_t *ice, 
+        const void *u_abs_ab, size_t u_abs_ab_len, image_cache_t *ic, const void *key,
+        phys_addr_t *new_pd, uint32_t *num_args) {
+    fernos_error_t err;
 
     if (u_abs_ab_len > 0 && !u_abs_ab) {
-        DUAL_RET(thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
-    }
-
-    // 1) Attempt to copy user app from userspace here into kernel space.
-
-    user_app_t *ua = ua_copy_from_user(ks->al, proc->pd, u_ua);
-    if (!ua) {
-        DUAL_RET(thr, FOS_E_UNKNWON_ERROR, FOS_E_SUCCESS);
+        return FOS_E_BAD_ARGS;
     }
 
-    // Save for later.
-    const uint32_t entry = (uint32_t)(ua->entry);
+    // 1) Copy in abs args block.
 
-    // 2) Copy in abs args block.
+    // The args block only lives until the end of this call.
+    allocator_t *scratch_al = ks_scratch_al(ks);
 
     void *abs_ab = NULL;
-    uint32_t num_args = 0;
+    *num_args = 0;
 
     if (u_abs_ab_len > 0) {
         err = FOS_E_SUCCESS;
-        abs_ab = al_malloc(ks->al, u_abs_ab_len);
+        abs_ab = al_malloc(scratch_al, u_abs_ab_len);
 
         if (abs_ab) {
             err = mem_cpy_from_user(abs_ab, proc->pd, u_abs_ab, u_abs_ab_len, NULL);
@@ -569,10 +779,9 @@ KS_SYSCALL fernos_error_t ks_exec(kernel_state_t *ks, user_app_t *u_ua, const vo
 
         // Copy error!
         if (!abs_ab || err != FOS_E_SUCCESS) {
-            al_free(ks->al, abs_ab);
-            delete_user_app(ua);
+            al_free(scratch_al, abs_ab);
 
-            DUAL_RET(thr, FOS_E_UNKNWON_ERROR, FOS_E_SUCCESS);
+            return FOS_E_UNKNWON_ERROR;
         }
 
         // Success, let's count the number of arguments actually in the 
@@ -582,32 +791,66 @@ KS_SYSCALL fernos_error_t ks_exec(kernel_state_t *ks, user_app_t *u_ua, const vo
         uint32_t *abs_ab_prefix = (uint32_t *)abs_ab;
 
         // Loop until we hit the end of the args block OR we hit a 0.
-        for (; num_args < max_num_args && abs_ab_prefix[num_args]; num_args++);
+        for (; *num_args < max_num_args && abs_ab_prefix[*num_args]; (*num_args)++);
     }
 
-    // 3) Create new page directory from abs args block and user app object.
+    // 2) Create new page directory from abs args block and user app object.
 
-    phys_addr_t new_pd;
-    err = new_user_app_pd(ua, abs_ab, u_abs_ab_len, &new_pd);
+    if (ic && key && !ice) {
+        // A failure here just means this app won't be cached.
+        if (ic_put(ic, key, ua, reader, reader_ctx, &ice) != FOS_E_SUCCESS) {
+            ice = NULL;
+        }
+    }
 
-    // Regardless of success or error, we can delete the user app and args block now.
-    al_free(ks->al, abs_ab);
-    delete_user_app(ua);
+    err = new_user_app_pd_shared(ua, ice ? ice->area_pages : NULL, backed_mask,
+            reader, reader_ctx, abs_ab, u_abs_ab_len, new_pd);
+
+    // Regardless of success or error, we can delete the args block now.
+    al_free(scratch_al, abs_ab);
 
     if (err != FOS_E_SUCCESS) {
-        DUAL_RET(thr, FOS_E_UNKNWON_ERROR, FOS_E_SUCCESS);
+        return FOS_E_UNKNWON_ERROR;
     }
 
+    return FOS_E_SUCCESS;
+}
+
+/**
+ * The shared second half of all exec calls.
+ *
+ * See `ks_load_app_p` for how `ua` is loaded.
+ *
+ * `ua` is NOT deleted by this function.
+ */
+static fernos_error_t ks_exec_p(kernel_state_t *ks, const user_app_t *ua, uint32_t backed_mask,
+        ua_area_reader_ft reader, void *reader_ctx, image_cache_entry_t *ice, const void *u_abs_ab, size_t u_abs_ab_len,
+        image_cache_t *ic, const void *key) {
+    fernos_error_t err;
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+    process_t *proc = thr->proc;
+
+    // Save for later.
+    const uint32_t entry = (uint32_t)(ua->entry);
+
+    phys_addr_t new_pd;
+    uint32_t num_args;
+
+    err = ks_load_app_p(ks, proc, ua, backed_mask, reader, reader_ctx, ice, u_abs_ab, u_abs_ab_len,
+            ic, key, &new_pd, &num_args);
+    DUAL_RET_FOS_ERR(err, thr);
+
     // THE POINT OF NO RETURN.
     // Errors after this point will crash the system. (may change this later)
 
-    // 4) Tell all plugins that a reset is about to occur.
+    // 3) Tell all plugins that a reset is about to occur.
     PROP_ERR(plgs_on_reset_proc(ks->plugins, FC_CORE_MAX_PLUGINS, proc->pid));
 
-    // 5) Give all children to the root process.
+    // 4) Give all children to the root process.
     PROP_ERR(ks_abandon_children(ks, proc));
 
-    // 6) Exec and schedule!
+    // 5) Exec and schedule!
     PROP_ERR(proc_exec(proc, new_pd, entry, (uint32_t)FC_CORE_VMEM_APP_ARGS_START, num_args, 0));
 
     thr = NULL; // `proc` has been reset, thus the calling thread may not even exist anymore!
@@ -619,6 +862,174 @@ KS_SYSCALL fernos_error_t ks_exec(kernel_state_t *ks, user_app_t *u_ua, const vo
     return FOS_E_SUCCESS;
 }
 
+KS_SYSCALL fernos_error_t ks_exec_cached(kernel_state_t *ks, user_app_t *u_ua, const void *u_abs_ab,
+        size_t u_abs_ab_len, image_cache_t *ic, const void *key) {
+    fernos_error_t err;
+
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+    process_t *proc = thr->proc;
+
+    // Quick args check.
+    if (!u_ua) {
+        DUAL_RET(thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+    }
+
+    // Attempt to copy user app from userspace here into kernel space.
+
+    // If the image is already cached, there is no need to copy in its read-only areas.
+    image_cache_entry_t *ice = NULL;
+
+    if (ic && key) {
+        user_app_t ua_layout;
+        err = mem_cpy_from_user(&ua_layout, proc->pd, u_ua, sizeof(user_app_t), NULL);
+        DUAL_RET_FOS_ERR(err, thr);
+
+        ice = ic_get(ic, key, &ua_layout);
+    }
+
+    // The user app only lives until the end of this call.
+    user_app_t *ua = ua_copy_from_user_partial(ks_scratch_al(ks), proc->pd, u_ua,
+            ice ? ice_area_mask(ice) : 0);
+    if (!ua) {
+        DUAL_RET(thr, FOS_E_UNKNWON_ERROR, FOS_E_SUCCESS);
+    }
+
+    err = ks_exec_p(ks, ua, 0, NULL, NULL, ice, u_abs_ab, u_abs_ab_len, ic, key);
+
+    delete_user_app(ua);
+
+    return err;
+}
+
+KS_SYSCALL fernos_error_t ks_exec_loaded(kernel_state_t *ks, const user_app_t *ua,
+        uint32_t backed_mask, ua_area_reader_ft reader, void *reader_ctx, const void *u_abs_ab, size_t u_abs_ab_len,
+        image_cache_t *ic, const void *key) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+
+    if (!ua || !reader) {
+        DUAL_RET(thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+    }
+
+    image_cache_entry_t *ice = NULL;
+    if (ic && key) {
+        ice = ic_get(ic, key, ua);
+    }
+
+    return ks_exec_p(ks, ua, backed_mask, reader, reader_ctx, ice, u_abs_ab, u_abs_ab_len, ic, key);
+}
+
+KS_SYSCALL fernos_error_t ks_spawn(kernel_state_t *ks, user_app_t *u_ua, const void *u_abs_ab,
+        size_t u_abs_ab_len, proc_id_t *u_cpid) {
+    fernos_error_t err;
+
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+    process_t *proc = thr->proc;
+
+    const proc_id_t NULL_PID = idtb_null_id(ks->proc_table);
+
+    proc_id_t cpid = NULL_PID;
+    user_app_t *ua = NULL;
+    process_t *child = NULL;
+
+    fernos_error_t user_err = FOS_E_SUCCESS;
+
+    // 1) Copy in the user app. (It only lives until the end of this call)
+
+    if (!u_ua) {
+        user_err = FOS_E_BAD_ARGS;
+    } else {
+        ua = ua_copy_from_user(ks_scratch_al(ks), proc->pd, u_ua);
+        if (!ua) {
+            user_err = FOS_E_UNKNWON_ERROR;
+        }
+    }
+
+    // 2) Reserve the child's ID and load the app into a new page directory. 
+    // The parent's memory is never copied.
+
+    phys_addr_t new_pd = NULL_PHYS_ADDR;
+    uint32_t num_args = 0;
+
+    if (user_err == FOS_E_SUCCESS) {
+        cpid = idtb_pop_id(ks->proc_table);
+        if (cpid == NULL_PID) {
+            user_err = FOS_E_NO_MEM;
+        }
+    }
+
+    if (user_err == FOS_E_SUCCESS) {
+        user_err = ks_load_app_p(ks, proc, ua, 0, NULL, NULL, NULL, u_abs_ab, u_abs_ab_len,
+                NULL, NULL, &new_pd, &num_args);
+    }
+
+    // 3) Create the child process around it.
+
+    if (user_err == FOS_E_SUCCESS) {
+        // `new_pd` is consumed here regardless of success.
+        user_err = new_process_spawn(proc, cpid, new_pd, (uintptr_t)(ua->entry), 
+                (uint32_t)FC_CORE_VMEM_APP_ARGS_START, num_args, 0, &child);
+        if (user_err == FOS_E_ABORT_SYSTEM) {
+            return FOS_E_ABORT_SYSTEM;
+        }
+
+        if (user_err == FOS_E_SUCCESS) {
+            user_err = l_push_back(proc->children, &child);
+        }
+    }
+
+    delete_user_app(ua);
+
+    if (user_err != FOS_E_SUCCESS) {
+        idtb_push_id(ks->proc_table, cpid);
+
+        if (delete_process(child) != FOS_E_SUCCESS) {
+            return FOS_E_ABORT_SYSTEM;
+        }
+
+        if (u_cpid) {
+            cpid = FC_CORE_MAX_PROCS;
+            mem_cpy_to_user(proc->pd, u_cpid, &cpid, sizeof(proc_id_t), NULL);
+        }
+
+        DUAL_RET(thr, user_err, FOS_E_SUCCESS);
+    }
+
+    idtb_set(ks->proc_table, cpid, child);
+    thread_schedule(child->main_thread, &(ks->schedule));
+
+    // 4) To the plugins, a spawn looks exactly like a fork followed by an exec in the child.
+    // This way the child inherits things like the working directory, but nothing tied to the 
+    // parent's memory space.
+
+    err = plgs_on_fork_proc(ks->plugins, FC_CORE_MAX_PLUGINS, cpid);
+    if (err != FOS_E_SUCCESS) {
+        return err;
+    }
+
+    err = plgs_on_reset_proc(ks->plugins, FC_CORE_MAX_PLUGINS, cpid);
+    if (err != FOS_E_SUCCESS) {
+        return err;
+    }
+
+    if (u_cpid) {
+        mem_cpy_to_user(proc->pd, u_cpid, &cpid, sizeof(proc_id_t), NULL);
+    }
+
+    DUAL_RET(thr, FOS_E_SUCCESS, FOS_E_SUCCESS);
+}
+
 static fernos_error_t ks_signal_p(kernel_state_t *ks, process_t *proc, sig_id_t sid) {
     fernos_error_t err;
 
@@ -673,7 +1084,7 @@ static fernos_error_t ks_signal_p(kernel_state_t *ks, process_t *proc, sig_id_t
         woken_thread->state = THREAD_STATE_DETATCHED;
 
         // Schedule thread and return correct values!
-        thread_schedule(woken_thread, &(ks->schedule));
+        thread_wake(woken_thread, &(ks->schedule));
 
         if (u_sid) {
             mem_cpy_to_user(woken_thread->proc->pd, u_sid, &sid, 
@@ -802,9 +1213,7 @@ KS_SYSCALL fernos_error_t ks_wait_signal(kernel_state_t *ks, sig_vector_t sv, si
     }
 
     // This is safe because we know `thr->state` is THREAD_SCHEDULED!
-    thread_detach(thr); 
-    thr->wq = (wait_queue_t *)(proc->signal_queue);
-    thr->state = THREAD_STATE_WAITING;
+    thread_wait(thr, (wait_queue_t *)(proc->signal_queue), WAIT_KIND_SIGNAL);
     thr->wait_ctx[0] = (uint32_t)u_sid;
 
     return FOS_E_SUCCESS;
@@ -822,7 +1231,12 @@ KS_SYSCALL fernos_error_t ks_signal_clear(kernel_state_t *ks, sig_vector_t sv) {
     return FOS_E_SUCCESS;
 }
 
-KS_SYSCALL fernos_error_t ks_request_mem(kernel_state_t *ks, void *s, const void *e, const void **u_true_e) {
+/**
+ * Shared implementation of `ks_request_mem` and `ks_reserve_mem`.
+ *
+ * When `lazy` is true, pages are only reserved, not allocated.
+ */
+static fernos_error_t ks_request_mem_internal(kernel_state_t *ks, void *s, const void *e, const void **u_true_e, bool lazy) {
     fernos_error_t err;
 
     if (!(ks->schedule.head)) {
@@ -844,10 +1258,15 @@ KS_SYSCALL fernos_error_t ks_request_mem(kernel_state_t *ks, void *s, const void
         DUAL_RET(thr, FOS_E_INVALID_RANGE, FOS_E_SUCCESS);
     }
     
-    // All other errors should be handled in `pd_alloc_pages`.
+    // All other errors should be handled in `pd_alloc_large_pages`/`pd_reserve_pages`.
+    //
+    // Eager requests which cover whole aligned 4MB chunks get large pages when possible.
+    // This is invisible to the user, everything is still allocated/returned at 4K granularity.
 
     const void *true_e = NULL;
-    err = pd_alloc_pages(pd, true, false, s, e, &true_e);
+    err = lazy 
+        ? pd_reserve_pages(pd, true, s, e, &true_e)
+        : pd_alloc_large_pages(pd, true, s, e, &true_e);
 
     // Sadly we are not going to error check here, but this should really always succeed
     // unless the user gives a bad address, in which case it doesn't matter anyway.
@@ -856,6 +1275,14 @@ KS_SYSCALL fernos_error_t ks_request_mem(kernel_state_t *ks, void *s, const void
     DUAL_RET(thr, err, FOS_E_SUCCESS);
 }
 
+KS_SYSCALL fernos_error_t ks_request_mem(kernel_state_t *ks, void *s, const void *e, const void **u_true_e) {
+    return ks_request_mem_internal(ks, s, e, u_true_e, false);
+}
+
+KS_SYSCALL fernos_error_t ks_reserve_mem(kernel_state_t *ks, void *s, const void *e, const void **u_true_e) {
+    return ks_request_mem_internal(ks, s, e, u_true_e, true);
+}
+
 KS_SYSCALL fernos_error_t ks_return_mem(kernel_state_t *ks, void *s, const void *e) {
     if (!(ks->schedule.head)) {
         return FOS_E_STATE_MISMATCH;
@@ -872,13 +1299,20 @@ KS_SYSCALL fernos_error_t ks_return_mem(kernel_state_t *ks, void *s, const void
         return FOS_E_SUCCESS;
     }
 
-    // All other error cases are checked inside `pd_free_pages`.
+    if (!IS_ALIGNED(s, M_4K) || !IS_ALIGNED(e, M_4K) || e <= s) {
+        return FOS_E_SUCCESS;
+    }
+
+    // Plugins let go of the range first. This way file mappings in it are still written back.
+    PROP_ERR(plgs_on_return_mem(ks->plugins, FC_CORE_MAX_PLUGINS, thr->proc->pid, s, e));
+
+    // (The free area never holds identity entries, so this can't run out of memory)
     pd_free_pages(pd, false, s, e);
 
     return FOS_E_SUCCESS;
 }
 
-KS_SYSCALL fernos_error_t ks_sleep_thread(kernel_state_t *ks, uint32_t ticks) {
+KS_SYSCALL fernos_error_t ks_kernel_heap_stats(kernel_state_t *ks, heap_stats_t *u_stats) {
     fernos_error_t err;
 
     if (!(ks->schedule.head)) {
@@ -887,21 +1321,184 @@ KS_SYSCALL fernos_error_t ks_sleep_thread(kernel_state_t *ks, uint32_t ticks) {
 
     thread_t *thr = (thread_t *)(ks->schedule.head);
 
-    err = twq_enqueue(ks->sleep_q, (void *)thr, 
-            ks->curr_tick + ticks);
+    DUAL_RET_COND(!u_stats, thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+
+    allocator_stats_t al_s;
+    err = al_stats(ks->al, &al_s);
+    DUAL_RET_FOS_ERR(err, thr);
+
+    heap_stats_t stats = {
+        .bytes_in_use = al_s.bytes_in_use,
+        .peak_bytes_in_use = al_s.peak_bytes_in_use,
+        .bytes_mapped = al_s.bytes_mapped,
+
+        .num_user_blocks = al_s.num_user_blocks,
+        .num_free_blocks = al_s.num_free_blocks,
+        .bytes_free = al_s.bytes_free,
+
+        .num_mallocs = al_s.num_mallocs,
+        .num_failed_mallocs = al_s.num_failed_mallocs,
+        .num_reallocs = al_s.num_reallocs,
+        .num_frees = al_s.num_frees,
+
+        .num_blocks_searched = al_s.num_blocks_searched
+    };
+
+    for (uint32_t i = 0; i < HEAP_STATS_NUM_CLASSES && i < AL_STATS_NUM_CLASSES; i++) {
+        stats.mallocs_per_class[i] = al_s.mallocs_per_class[i];
+    }
+
+    err = mem_cpy_to_user(thr->proc->pd, u_stats, &stats, sizeof(heap_stats_t), NULL);
+    DUAL_RET(thr, err, FOS_E_SUCCESS);
+}
+
+KS_SYSCALL fernos_error_t ks_proc_mem_stats(kernel_state_t *ks, proc_id_t pid, proc_mem_stats_t *u_stats) {
+    fernos_error_t err;
+
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+
+    DUAL_RET_COND(!u_stats, thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+
+    process_t *proc = pid == FC_CORE_MAX_PROCS 
+        ? thr->proc 
+        : (process_t *)idtb_get(ks->proc_table, pid);
+
+    DUAL_RET_COND(!proc, thr, FOS_E_INVALID_INDEX, FOS_E_SUCCESS);
+
+    err = mem_cpy_to_user(thr->proc->pd, u_stats, &(proc->mem_stats), sizeof(proc_mem_stats_t), NULL);
+    DUAL_RET(thr, err, FOS_E_SUCCESS);
+}
+
+KS_SYSCALL fernos_error_t ks_proc_mem_set_quota(kernel_state_t *ks, proc_id_t pid, uint32_t quota) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+    process_t *proc = thr->proc;
+
+    process_t *target = pid == FC_CORE_MAX_PROCS 
+        ? proc
+        : (process_t *)idtb_get(ks->proc_table, pid);
+
+    DUAL_RET_COND(!target, thr, FOS_E_INVALID_INDEX, FOS_E_SUCCESS);
+    DUAL_RET_COND(target != proc && (target->parent != proc || target->exited), 
+            thr, FOS_E_NOT_PERMITTED, FOS_E_SUCCESS);
+
+    const uint32_t own_quota = proc->mem_stats.quota;
+    DUAL_RET_COND(own_quota != 0 && (quota == 0 || quota > own_quota), 
+            thr, FOS_E_NOT_PERMITTED, FOS_E_SUCCESS);
+
+    target->mem_stats.quota = quota;
+
+    DUAL_RET(thr, FOS_E_SUCCESS, FOS_E_SUCCESS);
+}
+
+/**
+ * Put the current thread `thr` in the sleep queue until `deadline`. (`now` being the current time)
+ *
+ * The thread is always queued, even if `deadline` has already passed. In that case, it is woken
+ * up by the next tick.
+ */
+static fernos_error_t ks_sleep_thread_p(kernel_state_t *ks, thread_t *thr, uint64_t now, 
+        uint64_t deadline) {
+    fernos_error_t err;
+
+    if (deadline > now && deadline - now > KS_MAX_SLEEP_NS) {
+        deadline = now + KS_MAX_SLEEP_NS;
+    }
+
+    // Round up, a thread should never wake up before its deadline.
+    const uint32_t wake_time = (uint32_t)((deadline + (1ULL << KS_SLEEP_UNIT_SHIFT) - 1) 
+            >> KS_SLEEP_UNIT_SHIFT);
+
+    err = twq_enqueue(ks->sleep_q, (void *)thr, wake_time);
     if (err != FOS_E_SUCCESS) {
         return err;
     }
 
     // Only deschedule one we know our thread was added successfully to the wait queue!
-    thread_detach(thr);
-
-    thr->wq = (wait_queue_t *)(ks->sleep_q);
-    thr->state = THREAD_STATE_WAITING;
+    thread_wait(thr, (wait_queue_t *)(ks->sleep_q), WAIT_KIND_SLEEP);
 
     return FOS_E_SUCCESS;
 }
 
+KS_SYSCALL fernos_error_t ks_sleep_thread(kernel_state_t *ks, uint32_t ticks) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    // Even a 0 tick sleep gives up the CPU until the next tick. (Userspace uses it to yield)
+    const uint64_t now = clock_ns();
+    return ks_sleep_thread_p(ks, (thread_t *)(ks->schedule.head), now, now + (ticks * KS_TICK_NS));
+}
+
+KS_SYSCALL fernos_error_t ks_sleep_thread_until(kernel_state_t *ks, uint64_t deadline) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    const uint64_t now = clock_ns();
+
+    if (deadline <= now) {
+        return FOS_E_SUCCESS;
+    }
+
+    return ks_sleep_thread_p(ks, (thread_t *)(ks->schedule.head), now, deadline);
+}
+
+KS_SYSCALL fernos_error_t ks_clock_info(kernel_state_t *ks, clock_info_t *u_info) {
+    fernos_error_t err;
+
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+
+    DUAL_RET_COND(!u_info, thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+
+    err = mem_cpy_to_user(thr->proc->pd, u_info, clock_get_info(), sizeof(clock_info_t), NULL);
+    DUAL_RET(thr, err, FOS_E_SUCCESS);
+}
+
+KS_SYSCALL fernos_error_t ks_sched_stats(kernel_state_t *ks, proc_id_t pid, thread_id_t tid,
+        sched_stats_t *u_stats) {
+    fernos_error_t err;
+
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+
+    DUAL_RET_COND(!u_stats, thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+
+    process_t *proc = pid == FC_CORE_MAX_PROCS 
+        ? thr->proc 
+        : (process_t *)idtb_get(ks->proc_table, pid);
+
+    DUAL_RET_COND(!proc, thr, FOS_E_INVALID_INDEX, FOS_E_SUCCESS);
+
+    sched_stats_t stats;
+
+    if (tid == FC_CORE_MAX_THREADS_PER_PROC) {
+        proc_sched_stats(proc, &stats);
+    } else {
+        thread_t *target = (thread_t *)idtb_get(proc->thread_table, tid);
+        DUAL_RET_COND(!target, thr, FOS_E_INVALID_INDEX, FOS_E_SUCCESS);
+
+        stats = target->stats;
+    }
+
+    err = mem_cpy_to_user(thr->proc->pd, u_stats, &stats, sizeof(sched_stats_t), NULL);
+    DUAL_RET(thr, err, FOS_E_SUCCESS);
+}
+
 KS_SYSCALL fernos_error_t ks_spawn_local_thread(kernel_state_t *ks, thread_id_t *u_tid, 
         thread_entry_t entry, void *arg) {
     if (!(ks->schedule.head)) {
@@ -1003,7 +1600,7 @@ KS_SYSCALL fernos_error_t ks_exit_thread(kernel_state_t *ks, void *ret_val) {
     }
     joining_thread->ctx.eax = FOS_E_SUCCESS;
 
-    thread_schedule(joining_thread, &(ks->schedule));
+    thread_wake(joining_thread, &(ks->schedule));
 
     // Ok finally, since our exited thread is no longer needed
     proc_delete_thread(proc, thr, true);
@@ -1067,14 +1664,38 @@ KS_SYSCALL fernos_error_t ks_join_local_thread(kernel_state_t *ks, join_vector_t
     // Here we successfully queued our thread!
     // Now we can safely deschedule it!
 
-    thread_detach(thr);
-    thr->wq = (wait_queue_t *)(proc->join_queue);
+    thread_wait(thr, (wait_queue_t *)(proc->join_queue), WAIT_KIND_JOIN);
     thr->wait_ctx[0] = (uint32_t)u_join_ret; // Save where we will eventually return to!
-    thr->state = THREAD_STATE_WAITING;
 
     return FOS_E_SUCCESS;
 }
 
+KS_SYSCALL fernos_error_t ks_set_thread_prio(kernel_state_t *ks, thread_id_t tid, thread_prio_t prio) {
+    if (!(ks->schedule.head)) {
+        return FOS_E_STATE_MISMATCH;
+    }
+
+    thread_t *thr = (thread_t *)(ks->schedule.head);
+    process_t *proc = thr->proc;
+
+    DUAL_RET_COND(prio >= THREAD_PRIO_LEVELS, thr, FOS_E_BAD_ARGS, FOS_E_SUCCESS);
+
+    thread_t *target = thr;
+    if (tid != idtb_null_id(proc->thread_table)) {
+        target = idtb_get(proc->thread_table, tid);
+    }
+
+    DUAL_RET_COND(!target || target->state == THREAD_STATE_EXITED, thr, 
+            FOS_E_INVALID_INDEX, FOS_E_SUCCESS);
+
+    // A busy thread above the default level starves every level below it, so only the root
+    // process may raise a thread there. Other processes can still move such a thread down.
+    DUAL_RET_COND(proc != ks->root_proc && prio < THREAD_PRIO_DEFAULT && prio < target->prio, 
+            thr, FOS_E_NOT_PERMITTED, FOS_E_SUCCESS);
+
+    DUAL_RET(thr, thread_set_prio(target, prio), FOS_E_SUCCESS);
+}
+
 KS_SYSCALL fernos_error_t ks_set_in_handle(kernel_state_t *ks, handle_t in) {
     if (!(ks->schedule.head)) {
         return FOS_E_STATE_MISMATCH;
@@ -8,6 +8,18 @@
 #include "u_startup/main.h"
 #include "s_util/str.h"
 #include "k_startup/stacks.h"
+#include "k_startup/clock.h"
+
+/**
+ * Reset the scheduler statistics of a new thread.
+ */
+static void thread_init_stats(thread_t *thr) {
+    thr->wait_kind = WAIT_KINDS;
+    thr->wait_start = 0;
+    thr->wake_time = 0;
+    thr->run_start = 0;
+    mem_set(&(thr->stats), 0, sizeof(sched_stats_t));
+}
 
 /**
  * private version of `thread_reset`, this just requires `thr` to have a parent process
@@ -70,8 +82,13 @@ thread_t *new_thread(process_t *proc, thread_id_t tid, uintptr_t entry,
     // NOTE: we used to allocate stack pages here... NOT ANYMORE!
 
     init_ring_element(&(thr->super));
+    thr->schedule = NULL;
 
     thr->state = THREAD_STATE_DETATCHED;
+    thr->prio = THREAD_PRIO_DEFAULT;
+    thr->boost = 0;
+    thr->slice = FC_CORE_SCHED_QUANTUM;
+    thread_init_stats(thr);
 
     thr->tid = tid;
     thr->stack_base = tstack_end; // New change here! hopefully this works!
@@ -99,7 +116,12 @@ thread_t *new_thread_copy(thread_t *thr, process_t *new_proc) {
     }
 
     init_ring_element(&(copy->super));
+    copy->schedule = NULL;
     copy->state = THREAD_STATE_DETATCHED;
+    copy->prio = thr->prio;
+    copy->boost = 0;
+    copy->slice = FC_CORE_SCHED_QUANTUM;
+    thread_init_stats(copy);
     copy->tid = thr->tid;
     copy->stack_base = thr->stack_base;
 
@@ -115,29 +137,208 @@ thread_t *new_thread_copy(thread_t *thr, process_t *new_proc) {
     return copy;
 }
 
+/**
+ * The level `thr` is placed in when scheduled. (Its base priority minus its boost)
+ */
+static thread_prio_t thread_level(const thread_t *thr) {
+    return thr->boost < thr->prio ? thr->prio - thr->boost : 0;
+}
+
+/**
+ * Add `thr` to the back of its level in `s`.
+ *
+ * `thr` must not currently be in any schedule.
+ */
+static void schedule_insert(schedule_t *s, thread_t *thr) {
+    const thread_prio_t level = thread_level(thr);
+
+    ring_element_attach((ring_element_t *)thr, &(s->levels[level]));
+    s->level_map |= (1UL << level);
+    thr->schedule = s;
+
+    if (!(s->head)) {
+        s->head = (ring_element_t *)thr;
+    }
+}
+
+/**
+ * Remove `thr` from its schedule.
+ *
+ * If `thr` was the current thread, the head of the most urgent non-empty level takes its place.
+ */
+static void schedule_remove(thread_t *thr) {
+    schedule_t *s = thr->schedule;
+    ring_t *level = thr->super.r;
+
+    ring_element_detach((ring_element_t *)thr);
+    thr->schedule = NULL;
+
+    if (level->len == 0) {
+        s->level_map &= ~(1UL << (level - s->levels));
+    }
+
+    if (s->head == (ring_element_t *)thr) {
+        schedule_refresh(s);
+    }
+}
+
+void init_schedule(schedule_t *s) {
+    s->head = NULL;
+    s->level_map = 0;
+
+    for (thread_prio_t i = 0; i < THREAD_PRIO_LEVELS; i++) {
+        init_ring(&(s->levels[i]));
+    }
+}
+
+void schedule_refresh(schedule_t *s) {
+    s->head = s->level_map ? s->levels[__builtin_ctz(s->level_map)].head : NULL;
+}
+
+void schedule_advance(schedule_t *s) {
+    thread_t *curr = (thread_t *)(s->head);
+
+    if (!curr) {
+        return;
+    }
+
+    // Removing and reinserting places `curr` at the back of its (possibly unboosted) level.
+    schedule_remove(curr);
+    curr->boost = 0;
+    curr->slice = FC_CORE_SCHED_QUANTUM;
+    schedule_insert(s, curr);
+
+    schedule_refresh(s);
+}
+
+void schedule_tick(schedule_t *s) {
+    thread_t *curr = (thread_t *)(s->head);
+
+    if (!curr) {
+        return;
+    }
+
+    if (curr->slice > 1) {
+        curr->slice--;
+
+        if ((thread_prio_t)__builtin_ctz(s->level_map) < thread_level(curr)) {
+            schedule_refresh(s);
+        }
+    } else {
+        schedule_advance(s);
+    }
+
+    if (s->head != (ring_element_t *)curr) {
+        curr->stats.invol_switches++;
+    }
+}
+
+/**
+ * Add the time `thr` spent waiting to its statistics.
+ */
+static void thread_end_wait(thread_t *thr) {
+    if (thr->wait_kind < WAIT_KINDS) {
+        thr->stats.wait_ns[thr->wait_kind] += clock_ns() - thr->wait_start;
+        thr->wait_kind = WAIT_KINDS;
+    }
+}
+
 void thread_detach(thread_t *thr) {
     if (thr->state == THREAD_STATE_WAITING) {
         wq_remove(thr->wq, thr);
         thr->wq = NULL;
         mem_set(thr->wait_ctx, 0, sizeof(thr->wait_ctx));
+        thread_end_wait(thr);
 
         thr->state = THREAD_STATE_DETATCHED;
     } else if (thr->state == THREAD_STATE_SCHEDULED) {
-        ring_element_detach((ring_element_t *)thr);
+        if (thr->schedule->head == (ring_element_t *)thr) {
+            thr->stats.vol_switches++;
+        }
+
+        schedule_remove(thr);
         thr->state = THREAD_STATE_DETATCHED;
     }
 }
 
-void thread_schedule(thread_t *thr, ring_t *r) {
+void thread_schedule(thread_t *thr, schedule_t *s) {
     if (thr->state != THREAD_STATE_DETATCHED) {
         thread_detach(thr);
     }
 
-    ring_element_attach((ring_element_t *)thr, r);
+    // For threads woken up by hand. (Their wait queue and state are already reset)
+    thread_end_wait(thr);
+
+    schedule_insert(s, thr);
 
     thr->state = THREAD_STATE_SCHEDULED;
 }
 
+void thread_wait(thread_t *thr, wait_queue_t *wq, wait_kind_t kind) {
+    thread_detach(thr);
+
+    thr->wq = wq;
+    thr->state = THREAD_STATE_WAITING;
+
+    thr->wait_kind = kind;
+    thr->wait_start = clock_ns();
+}
+
+void thread_wake(thread_t *thr, schedule_t *s) {
+    thr->boost = FC_CORE_SCHED_WAKE_BOOST;
+    thr->slice = FC_CORE_SCHED_QUANTUM;
+    thread_schedule(thr, s);
+
+    thr->wake_time = clock_ns();
+}
+
+void thread_dispatch(thread_t *thr) {
+    const uint64_t now = clock_ns();
+
+    if (thr->wake_time) {
+        const uint64_t latency = now - thr->wake_time;
+
+        thr->stats.wakeups++;
+        thr->stats.runq_latency_ns += latency;
+        if (latency > thr->stats.max_runq_latency_ns) {
+            thr->stats.max_runq_latency_ns = latency;
+        }
+
+        thr->wake_time = 0;
+    }
+
+    thr->run_start = now;
+}
+
+void thread_charge(thread_t *thr) {
+    if (thr->run_start) {
+        thr->stats.cpu_ns += clock_ns() - thr->run_start;
+        thr->run_start = 0;
+    }
+}
+
+fernos_error_t thread_set_prio(thread_t *thr, thread_prio_t prio) {
+    if (prio >= THREAD_PRIO_LEVELS) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    thr->prio = prio;
+
+    if (thr->state == THREAD_STATE_SCHEDULED) {
+        schedule_t *s = thr->schedule;
+        const bool curr = s->head == (ring_element_t *)thr;
+
+        schedule_remove(thr);
+        schedule_insert(s, thr);
+
+        if (curr) {
+            s->head = (ring_element_t *)thr;
+        }
+    }
+
+    return FOS_E_SUCCESS;
+}
+
 void delete_thread(thread_t *thr) {
     if (!thr) {
         return;
@@ -148,7 +349,7 @@ void delete_thread(thread_t *thr) {
     al_free(thr->proc->al, thr);
 }
 
-fernos_error_t bwq_wake_all_threads(basic_wait_queue_t *bwq, ring_t *schedule, fernos_error_t wake_status) {
+fernos_error_t bwq_wake_all_threads(basic_wait_queue_t *bwq, schedule_t *schedule, fernos_error_t wake_status) {
     fernos_error_t err;
 
     if (!bwq || !schedule) {
@@ -164,7 +365,7 @@ fernos_error_t bwq_wake_all_threads(basic_wait_queue_t *bwq, ring_t *schedule, f
         mem_set(woken_thread->wait_ctx, 0, sizeof(woken_thread->wait_ctx));
         woken_thread->ctx.eax = wake_status;
 
-        thread_schedule(woken_thread, schedule); 
+        thread_wake(woken_thread, schedule);
     }
 
     if (err != FOS_E_EMPTY) {
@@ -1,6 +1,7 @@
 
 #include "k_startup/test/page.h"
 #include "k_startup/page.h"
+#include "k_startup/page_helpers.h"
 #include "k_sys/page.h"
 
 #include "k_sys/debug.h"
@@ -456,6 +457,285 @@ static bool test_pd_alloc_entries(void) {
     TEST_SUCCEED();
 }
 
+static bool test_pd_alloc_accounting(void) {
+    enable_loss_check();
+
+    // A range spanning 3 page tables should use exactly one free page per entry plus
+    // one per page table.
+
+    const uint32_t pi_s = 1024 + 1000;
+    const uint32_t pi_e = (1024 * 3) + 24;
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    const uint32_t before = get_num_free_pages();
+
+    uint32_t true_e;
+    TEST_SUCCESS(pd_alloc_pages_p(pd, true, false, pi_s, pi_e, &true_e));
+    TEST_EQUAL_UINT(pi_e, true_e);
+    TEST_EQUAL_UINT(before - ((pi_e - pi_s) + 3), get_num_free_pages());
+
+    // Every entry should point to a different page.
+    phys_addr_t old0 = assign_free_page(0, pd);
+    const pt_entry_t *pdv = (pt_entry_t *)(free_kernel_pages[0]);
+
+    phys_addr_t prev_base = NULL_PHYS_ADDR;
+    for (uint32_t pdi = 1; pdi <= 3; pdi++) {
+        TEST_TRUE(pte_get_present(pdv[pdi]));
+
+        phys_addr_t old1 = assign_free_page(1, pte_get_base(pdv[pdi]));
+        const pt_entry_t *ptv = (pt_entry_t *)(free_kernel_pages[1]);
+
+        for (uint32_t pti = 0; pti < 1024; pti++) {
+            const uint32_t pi = (pdi * 1024) + pti;
+            const bool expect_present = pi_s <= pi && pi < pi_e;
+
+            TEST_EQUAL_UINT(expect_present, pte_get_present(ptv[pti]));
+            if (expect_present) {
+                TEST_TRUE(pte_get_base(ptv[pti]) != prev_base);
+                prev_base = pte_get_base(ptv[pti]);
+            }
+        }
+
+        assign_free_page(1, old1);
+    }
+
+    assign_free_page(0, old0);
+
+    // Allocating over the same range again should fail immediately and use no pages.
+    TEST_EQUAL_HEX(FOS_E_ALREADY_ALLOCATED, pd_alloc_pages_p(pd, true, false, pi_s, pi_e, &true_e));
+    TEST_EQUAL_UINT(pi_s, true_e);
+    TEST_EQUAL_UINT(before - ((pi_e - pi_s) + 3), get_num_free_pages());
+
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_acct_quota(void) {
+    enable_loss_check();
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    proc_mem_stats_t stats;
+    stats.quota = 8;
+
+    TEST_SUCCESS(pd_acct_attach(pd, &stats));
+    TEST_EQUAL_HEX(FOS_E_ALREADY_ALLOCATED, pd_acct_attach(pd, &stats));
+    TEST_TRUE(pd_acct_find(pd) == &stats);
+
+    // Attaching only resets the counters.
+    TEST_EQUAL_UINT(0, stats.resident);
+    TEST_EQUAL_UINT(8, stats.quota);
+    TEST_EQUAL_UINT(8, pd_acct_room(&stats));
+
+    const uint32_t pi_s = FC_CORE_VMEM_FREE_START / M_4K;
+
+    uint32_t true_e;
+    TEST_SUCCESS(pd_alloc_pages_p(pd, true, false, pi_s, pi_s + 4, &true_e));
+    TEST_EQUAL_UINT(4, stats.resident);
+    TEST_EQUAL_UINT(4, stats.heap);
+
+    // Only 4 more pages fit.
+    TEST_EQUAL_HEX(FOS_E_NO_MEM, pd_alloc_pages_p(pd, true, false, pi_s + 4, pi_s + 16, &true_e));
+    TEST_EQUAL_UINT(pi_s + 8, true_e);
+    TEST_EQUAL_UINT(8, stats.resident);
+    TEST_EQUAL_UINT(0, pd_acct_room(&stats));
+
+    // Reserving costs nothing, but materializing does.
+    TEST_SUCCESS(pd_reserve_pages_p(pd, true, pi_s + 8, pi_s + 9, &true_e));
+    TEST_EQUAL_UINT(8, stats.resident);
+    TEST_EQUAL_HEX(FOS_E_NO_MEM, pd_resolve_lazy_p(pd, pi_s + 8));
+
+    pd_free_pages_p(pd, false, pi_s, pi_s + 2);
+    TEST_EQUAL_UINT(6, stats.resident);
+
+    TEST_SUCCESS(pd_resolve_lazy_p(pd, pi_s + 8));
+    TEST_EQUAL_UINT(7, stats.resident);
+    TEST_EQUAL_UINT(7, stats.heap);
+
+    stats.quota = 0;
+    TEST_EQUAL_UINT(UINT32_MAX, pd_acct_room(&stats));
+
+    // Deleting the page directory detaches it.
+    delete_page_directory(pd);
+    TEST_TRUE(pd_acct_find(pd) == NULL);
+
+    TEST_SUCCEED();
+}
+
+static bool test_zeroed_pool(void) {
+    enable_loss_check();
+
+    const uint32_t free_before = get_num_free_pages();
+    const uint32_t pool_before = get_num_zeroed_pages();
+
+    // Dirty some free pages first, the pool should still only hold zeros.
+    phys_addr_t dirty[8];
+    TEST_EQUAL_UINT(8, pop_free_page_batch(dirty, 8));
+    for (uint32_t i = 0; i < 8; i++) {
+        phys_addr_t old0 = assign_free_page(0, dirty[i]);
+        mem_set(free_kernel_pages[0], 0xAB, M_4K);
+        assign_free_page(0, old0);
+        push_free_page(dirty[i]);
+    }
+
+    const uint32_t added = refill_zeroed_pages(8);
+    TEST_TRUE(added <= 8);
+    TEST_EQUAL_UINT(pool_before + added, get_num_zeroed_pages());
+
+    // Pooled pages still count as free.
+    TEST_EQUAL_UINT(free_before, get_num_free_pages());
+
+    for (uint32_t i = 0; i < 8; i++) {
+        const phys_addr_t p = pop_zeroed_page();
+        TEST_TRUE(p != NULL_PHYS_ADDR);
+
+        phys_addr_t old0 = assign_free_page(0, p);
+        TEST_TRUE(mem_chk(free_kernel_pages[0], 0, M_4K));
+        mem_set(free_kernel_pages[0], 0xAB, M_4K);
+        assign_free_page(0, old0);
+
+        push_free_page(p);
+    }
+
+    // The pool never grows past its capacity.
+    refill_zeroed_pages(ZEROED_POOL_CAP + 1);
+    TEST_EQUAL_UINT(ZEROED_POOL_CAP, get_num_zeroed_pages());
+    TEST_EQUAL_UINT(0, refill_zeroed_pages(1));
+    TEST_EQUAL_UINT(free_before, get_num_free_pages());
+
+    TEST_SUCCEED();
+}
+
+static bool test_physmap(void) {
+    enable_loss_check();
+
+    if (!physmap_enabled) {
+        TEST_SUCCEED(); // Nothing to test.
+    }
+
+    // Pages are given out lowest first, so this page should always be covered.
+    phys_addr_t p = pop_free_page();
+    TEST_TRUE(p != NULL_PHYS_ADDR);
+
+    uint8_t *pv = physmap_ptr(p);
+    TEST_TRUE(pv != NULL);
+
+    // Writes through a free kernel page should be visible through the physmap and vice versa.
+    phys_addr_t old0 = assign_free_page(0, p);
+    mem_set(free_kernel_pages[0], 0x5A, M_4K);
+    TEST_TRUE(mem_chk(pv, 0x5A, M_4K));
+
+    mem_set(pv, 0xA5, M_4K);
+    TEST_TRUE(mem_chk(free_kernel_pages[0], 0xA5, M_4K));
+    assign_free_page(0, old0);
+
+    // `map_page` should leave the slot alone when the physmap can be used.
+    phys_addr_t old1;
+    TEST_EQUAL_HEX(pv, map_page(1, p, &old1));
+    TEST_EQUAL_HEX(PAGE_NOT_SLOTTED, old1);
+    unmap_page(1, old1);
+
+    TEST_EQUAL_HEX(NULL, physmap_ptr(FC_CORE_PMEM_BODY_START - M_4K));
+    TEST_EQUAL_HEX(NULL, physmap_ptr(FC_CORE_PMEM_BODY_START + PHYSMAP_COVERED_SIZE));
+
+    push_free_page(p);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_alloc_large(void) {
+    enable_loss_check();
+
+    // Chunk 2 is only partially covered, chunks 3 and 4 are entirely covered.
+    const uint32_t pi_s = (1024 * 2) + 5;
+    const uint32_t pi_e = 1024 * 5;
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    const uint32_t before = get_num_free_pages();
+
+    uint32_t true_e;
+    TEST_SUCCESS(pd_alloc_large_pages_p(pd, true, pi_s, pi_e, &true_e));
+    TEST_EQUAL_UINT(pi_e, true_e);
+
+    // Only the partial chunk needs a page table.
+    TEST_EQUAL_UINT(before - ((pi_e - pi_s) + 1), get_num_free_pages());
+
+    phys_addr_t old0 = assign_free_page(0, pd);
+    const pt_entry_t *pdv = (pt_entry_t *)(free_kernel_pages[0]);
+
+    TEST_TRUE(pte_get_present(pdv[2]));
+    TEST_FALSE(fos_pde_is_large(pdv[2]));
+
+    for (uint32_t pdi = 3; pdi < 5; pdi++) {
+        TEST_TRUE(fos_pde_is_large(pdv[pdi]));
+        TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(pdv[pdi]));
+        TEST_TRUE(pte_get_user(pdv[pdi]));
+        TEST_TRUE(IS_ALIGNED(pte_get_base(pdv[pdi]), M_4M));
+    }
+
+    const phys_addr_t base3 = pte_get_base(pdv[3]);
+
+    assign_free_page(0, old0);
+
+    for (uint32_t pti = 0; pti < 1024; pti += 31) {
+        TEST_EQUAL_HEX(base3 + (pti * M_4K), pd_get_underlying_p(pd, (1024 * 3) + pti));
+    }
+
+    // Allocating within a large entry should fail.
+    TEST_EQUAL_HEX(FOS_E_ALREADY_ALLOCATED, pd_alloc_pages_p(pd, true, false, (1024 * 3) + 10, (1024 * 3) + 11, NULL));
+
+    // Freeing part of a large entry should split it, the rest should be left untouched.
+    // One of the freed pages becomes the new page table, so only 9 pages are given back.
+    const uint32_t before_free = get_num_free_pages();
+    TEST_SUCCESS(pd_free_pages_p(pd, false, (1024 * 3) + 10, (1024 * 3) + 20));
+    TEST_EQUAL_UINT(before_free + 9, get_num_free_pages());
+
+    old0 = assign_free_page(0, pd);
+    TEST_TRUE(pte_get_present(pdv[3]));
+    TEST_FALSE(fos_pde_is_large(pdv[3]));
+    assign_free_page(0, old0);
+
+    for (uint32_t pti = 0; pti < 1024; pti++) {
+        const phys_addr_t expected = (10 <= pti && pti < 20) ? NULL_PHYS_ADDR : base3 + (pti * M_4K);
+        TEST_EQUAL_HEX(expected, pd_get_underlying_p(pd, (1024 * 3) + pti));
+    }
+
+    // The freed part can be allocated again with regular pages.
+    TEST_SUCCESS(pd_alloc_large_pages_p(pd, true, (1024 * 3) + 10, (1024 * 3) + 20, NULL));
+
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_kernel_pd_large_identity(void) {
+    // Whole 4MB chunks of the epilogue should be mapped with large identity entries.
+
+    const uint32_t s = ALIGN_UP(FC_CORE_PMEM_EPILOGUE_START, M_4M);
+    if (s < FC_CORE_PMEM_EPILOGUE_START || s + M_4M > FC_CORE_PMEM_EPILOGUE_END || s + M_4M < s) {
+        TEST_SUCCEED(); // No full chunk, nothing to check.
+    }
+
+    phys_addr_t old0 = assign_free_page(0, get_kernel_pd());
+    const pt_entry_t pde = ((pt_entry_t *)(free_kernel_pages[0]))[s / M_4M];
+    assign_free_page(0, old0);
+
+    TEST_TRUE(fos_pde_is_large(pde));
+    TEST_EQUAL_UINT(IDENTITY_ENTRY, pte_get_avail(pde));
+    TEST_EQUAL_HEX(s, pte_get_base(pde));
+    TEST_TRUE(pte_get_pcd(pde));
+
+    TEST_EQUAL_HEX(s + (7 * M_4K), pd_get_underlying_p(get_kernel_pd(), (s / M_4K) + 7));
+
+    TEST_SUCCEED();
+}
+
 static bool test_kernel_pd_alloc(void) {
     uint8_t * const S = (uint8_t *)FC_CORE_VMEM_FREE_START;
     // Here we will test that mapping stuff into the kernel free area actually works!
@@ -513,6 +793,12 @@ bool test_page(void) {
     RUN_TEST(test_pt_alloc_and_free);
     RUN_TEST(test_pd_alloc_and_free_p);
     RUN_TEST(test_pd_alloc_entries);
+    RUN_TEST(test_pd_alloc_accounting);
+    RUN_TEST(test_pd_acct_quota);
+    RUN_TEST(test_zeroed_pool);
+    RUN_TEST(test_physmap);
+    RUN_TEST(test_pd_alloc_large);
+    RUN_TEST(test_kernel_pd_large_identity);
     RUN_TEST(test_kernel_pd_alloc);
 
     // Remember this halts the cpu.
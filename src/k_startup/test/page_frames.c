@@ -0,0 +1,318 @@
+#include "k_startup/test/page_frames.h"
+#include "k_startup/page.h"
+#include "k_sys/page.h"
+
+#include "k_sys/debug.h"
+#include "s_util/err.h"
+
+#include "s_util/str.h"
+#include <stdint.h>
+#include "k_startup/gfx.h"
+#include "c_config.h"
+
+static bool pretest(void);
+static bool posttest(void);
+
+#define PRETEST() pretest()
+#define POSTTEST() posttest()
+
+#define LOGF_METHOD(...) gfx_direct_put_fmt_s_rr(__VA_ARGS__)
+#define FAILURE_ACTION() lock_up()
+
+#include "s_util/test.h"
+
+/*
+ * Tests for the physical page allocator. (push/pop free page(s))
+ *
+ * These tests assume there are at least a few thousand free pages available.
+ */
+
+/**
+ * When true, the test will confirm the number of free pages before and after the test are equal.
+ */
+static bool expect_no_loss;
+static uint32_t initial_num_free_pages;
+
+static void enable_loss_check(void) {
+    expect_no_loss = true;
+}
+
+static bool pretest(void) {
+    expect_no_loss = false;
+    initial_num_free_pages = get_num_free_pages();
+
+    TEST_SUCCEED();
+}
+
+static bool posttest(void) {
+    uint32_t actual_num_free_pages = get_num_free_pages();
+
+    if (expect_no_loss) {
+        TEST_EQUAL_HEX(initial_num_free_pages, actual_num_free_pages);
+    }
+
+    TEST_SUCCEED();
+}
+
+static bool in_body(phys_addr_t p) {
+    return FC_CORE_PMEM_BODY_START <= p && p < FC_CORE_PMEM_BODY_END;
+}
+
+static bool test_pop_and_push_single(void) {
+    enable_loss_check();
+
+    phys_addr_t p = pop_free_page();
+    TEST_TRUE(p != NULL_PHYS_ADDR);
+    TEST_TRUE(IS_ALIGNED(p, M_4K));
+    TEST_TRUE(in_body(p));
+    TEST_EQUAL_UINT(initial_num_free_pages - 1, get_num_free_pages());
+
+    push_free_page(p);
+    TEST_EQUAL_UINT(initial_num_free_pages, get_num_free_pages());
+
+    // The lowest free page is always given out first, so we should get the same page back.
+    phys_addr_t p1 = pop_free_page();
+    TEST_EQUAL_HEX(p, p1);
+    push_free_page(p1);
+
+    TEST_SUCCEED();
+}
+
+static bool test_push_invalid(void) {
+    enable_loss_check();
+
+    phys_addr_t p = pop_free_page();
+    TEST_TRUE(p != NULL_PHYS_ADDR);
+
+    // Unaligned and out of range addresses should be ignored.
+    push_free_page(p + 1);
+    push_free_page(FC_CORE_PMEM_BODY_START - M_4K);
+    push_free_page(FC_CORE_PMEM_EPILOGUE_START);
+    TEST_EQUAL_UINT(initial_num_free_pages - 1, get_num_free_pages());
+
+    push_free_page(p);
+
+    // Double free should also be ignored.
+    push_free_page(p);
+    TEST_EQUAL_UINT(initial_num_free_pages, get_num_free_pages());
+
+    TEST_SUCCEED();
+}
+
+static bool test_pop_many_distinct(void) {
+    enable_loss_check();
+
+    const uint32_t num_pages = 256;
+    phys_addr_t pages[num_pages];
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        pages[i] = pop_free_page();
+        TEST_TRUE(pages[i] != NULL_PHYS_ADDR);
+
+        for (uint32_t j = 0; j < i; j++) {
+            TEST_TRUE(pages[i] != pages[j]);
+        }
+    }
+
+    TEST_EQUAL_UINT(initial_num_free_pages - num_pages, get_num_free_pages());
+
+    // Push back in a different order than popped.
+    for (uint32_t i = 0; i < num_pages; i += 2) {
+        push_free_page(pages[i]);
+    }
+
+    for (uint32_t i = 1; i < num_pages; i += 2) {
+        push_free_page(pages[i]);
+    }
+
+    TEST_SUCCEED();
+}
+
+static bool test_pop_batch(void) {
+    enable_loss_check();
+
+    const uint32_t num_pages = 100;
+    phys_addr_t pages[num_pages];
+
+    TEST_EQUAL_UINT(0, pop_free_page_batch(pages, 0));
+
+    TEST_EQUAL_UINT(num_pages, pop_free_page_batch(pages, num_pages));
+    TEST_EQUAL_UINT(initial_num_free_pages - num_pages, get_num_free_pages());
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        TEST_TRUE(IS_ALIGNED(pages[i], M_4K));
+        TEST_TRUE(in_body(pages[i]));
+
+        for (uint32_t j = 0; j < i; j++) {
+            TEST_TRUE(pages[i] != pages[j]);
+        }
+    }
+
+    for (uint32_t i = 0; i < num_pages; i++) {
+        push_free_page(pages[i]);
+    }
+
+    TEST_SUCCEED();
+}
+
+static bool test_pop_contiguous(void) {
+    enable_loss_check();
+
+    TEST_EQUAL_HEX(NULL_PHYS_ADDR, pop_free_pages(0));
+    TEST_EQUAL_HEX(NULL_PHYS_ADDR, pop_free_pages(get_num_free_pages() + 1));
+
+    const uint32_t run_sizes[] = {
+        1, 2, 31, 32, 33, 1024, 1500
+    };
+    const uint32_t num_runs = sizeof(run_sizes) / sizeof(run_sizes[0]);
+
+    phys_addr_t runs[num_runs];
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < num_runs; i++) {
+        runs[i] = pop_free_pages(run_sizes[i]);
+        TEST_TRUE(runs[i] != NULL_PHYS_ADDR);
+        TEST_TRUE(IS_ALIGNED(runs[i], M_4K));
+        TEST_TRUE(in_body(runs[i]));
+        TEST_TRUE(in_body(runs[i] + ((run_sizes[i] - 1) * M_4K)));
+
+        total += run_sizes[i];
+        TEST_EQUAL_UINT(initial_num_free_pages - total, get_num_free_pages());
+    }
+
+    // No two runs should overlap.
+    for (uint32_t i = 0; i < num_runs; i++) {
+        for (uint32_t j = i + 1; j < num_runs; j++) {
+            const phys_addr_t i_e = runs[i] + (run_sizes[i] * M_4K);
+            const phys_addr_t j_e = runs[j] + (run_sizes[j] * M_4K);
+
+            TEST_TRUE(i_e <= runs[j] || j_e <= runs[i]);
+        }
+    }
+
+    // Single pages popped now should never land inside a run.
+    for (uint32_t k = 0; k < 64; k++) {
+        phys_addr_t p = pop_free_page();
+        TEST_TRUE(p != NULL_PHYS_ADDR);
+
+        for (uint32_t i = 0; i < num_runs; i++) {
+            TEST_FALSE(runs[i] <= p && p < runs[i] + (run_sizes[i] * M_4K));
+        }
+
+        push_free_page(p);
+    }
+
+    for (uint32_t i = 0; i < num_runs; i++) {
+        push_free_pages(runs[i], run_sizes[i]);
+    }
+
+    TEST_SUCCEED();
+}
+
+static bool test_pop_contiguous_fragmented(void) {
+    enable_loss_check();
+
+    // Pop a run, then free every other page within it. (Keeping the first and last pages)
+    // A contiguous request for 2 pages should never be served from within the holes.
+
+    const uint32_t run_size = 64;
+    phys_addr_t run = pop_free_pages(run_size);
+    TEST_TRUE(run != NULL_PHYS_ADDR);
+
+    for (uint32_t i = 1; i < run_size - 1; i += 2) {
+        push_free_page(run + (i * M_4K));
+    }
+
+    phys_addr_t pair = pop_free_pages(2);
+    TEST_TRUE(pair != NULL_PHYS_ADDR);
+    TEST_TRUE(pair + (2 * M_4K) <= run || run + (run_size * M_4K) <= pair);
+
+    push_free_pages(pair, 2);
+
+    for (uint32_t i = 0; i < run_size; i += 2) {
+        push_free_page(run + (i * M_4K));
+    }
+    push_free_page(run + ((run_size - 1) * M_4K));
+
+    TEST_SUCCEED();
+}
+
+static bool test_contiguous_pages_usable(void) {
+    enable_loss_check();
+
+    const uint32_t run_size = 8;
+    phys_addr_t run = pop_free_pages(run_size);
+    TEST_TRUE(run != NULL_PHYS_ADDR);
+
+    for (uint32_t i = 0; i < run_size; i++) {
+        phys_addr_t old = assign_free_page(0, run + (i * M_4K));
+        mem_set(free_kernel_pages[0], (uint8_t)i, M_4K);
+        assign_free_page(0, old);
+    }
+
+    for (uint32_t i = 0; i < run_size; i++) {
+        phys_addr_t old = assign_free_page(0, run + (i * M_4K));
+        TEST_TRUE(mem_chk(free_kernel_pages[0], (uint8_t)i, M_4K));
+        assign_free_page(0, old);
+    }
+
+    push_free_pages(run, run_size);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pop_large_page(void) {
+    enable_loss_check();
+
+    phys_addr_t lp = pop_free_large_page();
+    TEST_TRUE(lp != NULL_PHYS_ADDR);
+    TEST_TRUE(IS_ALIGNED(lp, M_4M));
+    TEST_TRUE(in_body(lp));
+    TEST_TRUE(in_body(lp + M_4M - M_4K));
+    TEST_EQUAL_UINT(initial_num_free_pages - 1024, get_num_free_pages());
+
+    // A second large page should never overlap the first.
+    phys_addr_t lp1 = pop_free_large_page();
+    TEST_TRUE(lp1 != NULL_PHYS_ADDR);
+    TEST_TRUE(IS_ALIGNED(lp1, M_4M));
+    TEST_TRUE(lp1 != lp);
+
+    // Every page of the run should be usable.
+    for (uint32_t i = 0; i < 1024; i += 97) {
+        phys_addr_t old = assign_free_page(0, lp + (i * M_4K));
+        mem_set(free_kernel_pages[0], (uint8_t)i, M_4K);
+        TEST_TRUE(mem_chk(free_kernel_pages[0], (uint8_t)i, M_4K));
+        assign_free_page(0, old);
+    }
+
+    push_free_pages(lp1, 1024);
+    push_free_pages(lp, 1024);
+
+    // Taking a single page out of the run should make the run unusable.
+    phys_addr_t p = pop_free_page();
+    TEST_TRUE(p != NULL_PHYS_ADDR);
+
+    phys_addr_t lp2 = pop_free_large_page();
+    TEST_TRUE(lp2 != NULL_PHYS_ADDR);
+    TEST_TRUE(p < lp2 || lp2 + M_4M <= p);
+
+    push_free_pages(lp2, 1024);
+    push_free_page(p);
+
+    TEST_SUCCEED();
+}
+
+bool test_page_frames(void) {
+    BEGIN_SUITE("Page Frames");
+
+    RUN_TEST(test_pop_and_push_single);
+    RUN_TEST(test_push_invalid);
+    RUN_TEST(test_pop_many_distinct);
+    RUN_TEST(test_pop_batch);
+    RUN_TEST(test_pop_contiguous);
+    RUN_TEST(test_pop_contiguous_fragmented);
+    RUN_TEST(test_contiguous_pages_usable);
+    RUN_TEST(test_pop_large_page);
+
+    return END_SUITE();
+}
@@ -428,6 +428,300 @@ static bool test_pd_copy_range_values(void) {
     TEST_SUCCEED();
 }
 
+/**
+ * Get the page directory entry which covers index `pi` in `pd`.
+ */
+static pt_entry_t get_pd_pde(phys_addr_t pd, uint32_t pi) {
+    phys_addr_t old0 = assign_free_page(0, pd);
+    pt_entry_t pde = ((pt_entry_t *)(free_kernel_pages[0]))[pi / 1024];
+    assign_free_page(0, old0);
+
+    return pde;
+}
+
+/**
+ * Get the page table entry at index `pi` in `pd`. (Not present if the page table doesn't exist)
+ */
+static pt_entry_t get_pd_pte(phys_addr_t pd, uint32_t pi) {
+    pt_entry_t pte = not_present_pt_entry();
+
+    phys_addr_t old0 = assign_free_page(0, pd);
+    pt_entry_t pde = ((pt_entry_t *)(free_kernel_pages[0]))[pi / 1024];
+    if (pte_get_present(pde)) {
+        assign_free_page(0, pte_get_base(pde));
+        pte = ((pt_entry_t *)(free_kernel_pages[0]))[pi % 1024];
+    }
+    assign_free_page(0, old0);
+
+    return pte;
+}
+
+static bool test_pt_cow_range(void) {
+    enable_loss_check();
+
+    phys_addr_t src_pt = new_page_table();
+    TEST_TRUE(src_pt != NULL_PHYS_ADDR);
+
+    TEST_SUCCESS(pt_alloc_range(src_pt, true, false, 0, 5, NULL));
+    TEST_SUCCESS(pt_alloc_range(src_pt, true, true, 10, 12, NULL));
+
+    phys_addr_t dest_pt = new_page_table();
+    TEST_TRUE(dest_pt != NULL_PHYS_ADDR);
+
+    // No pages should be needed for a COW copy.
+    const uint32_t free_before_cow = get_num_free_pages();
+    TEST_SUCCESS(pt_cow_range(dest_pt, src_pt, 0, 20));
+    TEST_EQUAL_UINT(free_before_cow, get_num_free_pages());
+
+    phys_addr_t old0 = assign_free_page(0, src_pt);
+    phys_addr_t old1 = assign_free_page(1, dest_pt);
+    const pt_entry_t *src_ptv = (pt_entry_t *)(free_kernel_pages[0]);
+    const pt_entry_t *dest_ptv = (pt_entry_t *)(free_kernel_pages[1]);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_EQUAL_HEX(src_ptv[i], dest_ptv[i]);
+        TEST_EQUAL_UINT(COW_ENTRY, pte_get_avail(src_ptv[i]));
+        TEST_FALSE(pte_get_writable(src_ptv[i]));
+        TEST_TRUE(pte_get_user(src_ptv[i]));
+        TEST_EQUAL_UINT(2, page_get_refs(pte_get_base(src_ptv[i])));
+    }
+
+    for (uint32_t i = 10; i < 12; i++) {
+        TEST_EQUAL_HEX(src_ptv[i], dest_ptv[i]);
+        TEST_EQUAL_UINT(SHARED_ENTRY, pte_get_avail(src_ptv[i]));
+        TEST_EQUAL_UINT(0, page_get_refs(pte_get_base(src_ptv[i])));
+    }
+
+    const phys_addr_t first_page = pte_get_base(src_ptv[0]);
+
+    assign_free_page(1, old1);
+    assign_free_page(0, old0);
+
+    // Sharing an existing COW page only bumps its count.
+    phys_addr_t dest_pt2 = new_page_table();
+    TEST_TRUE(dest_pt2 != NULL_PHYS_ADDR);
+    TEST_SUCCESS(pt_cow_range(dest_pt2, src_pt, 0, 5));
+    TEST_EQUAL_UINT(3, page_get_refs(first_page));
+
+    // Pages should only return to the free list after the final reference is deleted.
+    delete_page_table(dest_pt2);
+    TEST_EQUAL_UINT(2, page_get_refs(first_page));
+
+    const uint32_t free_before_delete = get_num_free_pages();
+    delete_page_table(dest_pt);
+    TEST_EQUAL_UINT(free_before_delete + 1, get_num_free_pages()); // Just the table.
+    TEST_EQUAL_UINT(1, page_get_refs(first_page));
+
+    delete_page_table_force(src_pt, true);
+    TEST_EQUAL_UINT(0, page_get_refs(first_page));
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_resolve_cow(void) {
+    enable_loss_check();
+
+    const uint32_t pi_s = 1;
+    const uint32_t pi_e = 4;
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+    TEST_SUCCESS(pd_alloc_pages_p(pd, true, false, pi_s, pi_e, NULL));
+
+    for (uint32_t pi = pi_s; pi < pi_e; pi++) {
+        phys_addr_t old0 = assign_free_page(0, pd_get_underlying_p(pd, pi));
+        mem_set(free_kernel_pages[0], (uint8_t)pi, M_4K);
+        assign_free_page(0, old0);
+    }
+
+    phys_addr_t child = cow_page_directory(pd);
+    TEST_TRUE(child != NULL_PHYS_ADDR);
+    TEST_TRUE(check_equiv_pd(child, pd, 0, 1024 * 1024, false));
+
+    const phys_addr_t shared_page = pd_get_underlying_p(pd, pi_s);
+    TEST_EQUAL_HEX(shared_page, pd_get_underlying_p(child, pi_s));
+
+    // Child writes first, it should get a copy.
+    TEST_SUCCESS(pd_resolve_cow_p(child, pi_s));
+
+    pt_entry_t pte = get_pd_pte(child, pi_s);
+    TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(pte));
+    TEST_TRUE(pte_get_writable(pte));
+    TEST_TRUE(pte_get_base(pte) != shared_page);
+    TEST_TRUE(check_equal_page(pte_get_base(pte), shared_page));
+    TEST_EQUAL_UINT(1, page_get_refs(shared_page));
+
+    // Now the parent holds the only reference, it should just reclaim the page.
+    const uint32_t free_before_reclaim = get_num_free_pages();
+    TEST_SUCCESS(pd_resolve_cow_p(pd, pi_s));
+    TEST_EQUAL_UINT(free_before_reclaim, get_num_free_pages());
+
+    pte = get_pd_pte(pd, pi_s);
+    TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(pte));
+    TEST_TRUE(pte_get_writable(pte));
+    TEST_EQUAL_HEX(shared_page, pte_get_base(pte));
+    TEST_EQUAL_UINT(0, page_get_refs(shared_page));
+
+    // Non-COW or unmapped pages can't be resolved.
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, pd_resolve_cow_p(pd, pi_s));
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, pd_resolve_cow_p(pd, 5000));
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, pd_resolve_cow_p(pd, 1024 * 1024));
+
+    // Kernel writes into a COW page must not leak into the other memory space.
+    const uint8_t *dest = (uint8_t *)(M_4K * (pi_s + 1));
+    const char msg[] = "Hello";
+    TEST_SUCCESS(mem_cpy_to_user(child, (void *)dest, msg, sizeof(msg), NULL));
+    TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(get_pd_pte(child, pi_s + 1)));
+
+    char buf[sizeof(msg)];
+    TEST_SUCCESS(mem_cpy_from_user(buf, pd, dest, sizeof(buf), NULL));
+    TEST_TRUE(mem_chk(buf, (uint8_t)(pi_s + 1), sizeof(buf)));
+
+    TEST_SUCCESS(mem_cpy_from_user(buf, child, dest, sizeof(buf), NULL));
+    TEST_TRUE(mem_cmp(buf, msg, sizeof(msg)));
+
+    delete_page_directory(child);
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_copy_large(void) {
+    enable_loss_check();
+
+    const uint32_t pi_s = 1024 * 3;
+    const uint32_t pi_e = 1024 * 4;
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+    TEST_SUCCESS(pd_alloc_large_pages_p(pd, true, pi_s, pi_e, NULL));
+
+    TEST_TRUE(fos_pde_is_large(get_pd_pde(pd, pi_s)));
+
+    for (uint32_t pi = pi_s; pi < pi_e; pi += 101) {
+        phys_addr_t old0 = assign_free_page(0, pd_get_underlying_p(pd, pi));
+        mem_set(free_kernel_pages[0], (uint8_t)pi, M_4K);
+        assign_free_page(0, old0);
+    }
+
+    // A deep copy should get its own large entry with the same contents.
+    phys_addr_t copy = copy_page_directory(pd);
+    TEST_TRUE(copy != NULL_PHYS_ADDR);
+
+    const pt_entry_t copy_pde = get_pd_pde(copy, pi_s);
+    TEST_TRUE(fos_pde_is_large(copy_pde));
+    TEST_TRUE(pte_get_base(copy_pde) != pte_get_base(get_pd_pde(pd, pi_s)));
+
+    for (uint32_t pi = pi_s; pi < pi_e; pi += 101) {
+        TEST_TRUE(check_equal_page(pd_get_underlying_p(copy, pi), pd_get_underlying_p(pd, pi)));
+    }
+
+    delete_page_directory(copy);
+
+    // A COW copy splits the source, after which both sides share every page.
+    phys_addr_t child = cow_page_directory(pd);
+    TEST_TRUE(child != NULL_PHYS_ADDR);
+
+    TEST_FALSE(fos_pde_is_large(get_pd_pde(pd, pi_s)));
+    TEST_EQUAL_UINT(COW_ENTRY, pte_get_avail(get_pd_pte(pd, pi_s + 7)));
+    TEST_EQUAL_HEX(pd_get_underlying_p(pd, pi_s + 7), pd_get_underlying_p(child, pi_s + 7));
+
+    TEST_SUCCESS(pd_resolve_cow_p(child, pi_s + 7));
+    TEST_TRUE(check_equal_page(pd_get_underlying_p(pd, pi_s + 7), pd_get_underlying_p(child, pi_s + 7)));
+
+    delete_page_directory(child);
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_resolve_lazy(void) {
+    enable_loss_check();
+
+    const uint32_t pi_s = 1020;  // Cross a page table boundary.
+    const uint32_t pi_e = 1030;
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    // Reserving should only cost page tables.
+    const uint32_t free_before = get_num_free_pages();
+
+    uint32_t true_e;
+    TEST_SUCCESS(pd_reserve_pages_p(pd, true, pi_s, pi_e, &true_e));
+    TEST_EQUAL_UINT(pi_e, true_e);
+    TEST_EQUAL_UINT(free_before - 2, get_num_free_pages());
+
+    for (uint32_t pi = pi_s; pi < pi_e; pi++) {
+        TEST_TRUE(fos_pte_is_lazy(get_pd_pte(pd, pi)));
+        TEST_EQUAL_HEX(NULL_PHYS_ADDR, pd_get_underlying_p(pd, pi));
+    }
+
+    // Lazy pages count as allocated.
+    TEST_EQUAL_HEX(FOS_E_ALREADY_ALLOCATED, pd_alloc_pages_p(pd, true, false, pi_s - 2, pi_e, &true_e));
+    TEST_EQUAL_UINT(pi_s, true_e);
+    TEST_EQUAL_HEX(FOS_E_ALREADY_ALLOCATED, pd_reserve_pages_p(pd, true, pi_e - 1, pi_e + 1, &true_e));
+    TEST_EQUAL_UINT(pi_e - 1, true_e);
+
+    // Dirty a free page, then make sure materialization gives back zeros.
+    phys_addr_t dirty = pop_free_page();
+    TEST_TRUE(dirty != NULL_PHYS_ADDR);
+    phys_addr_t old0 = assign_free_page(0, dirty);
+    mem_set(free_kernel_pages[0], 0xAB, M_4K);
+    assign_free_page(0, old0);
+    push_free_page(dirty);
+
+    TEST_SUCCESS(pd_resolve_lazy_p(pd, pi_s));
+
+    pt_entry_t pte = get_pd_pte(pd, pi_s);
+    TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(pte));
+    TEST_TRUE(pte_get_present(pte));
+    TEST_TRUE(pte_get_writable(pte));
+    TEST_TRUE(pte_get_user(pte));
+
+    old0 = assign_free_page(0, pte_get_base(pte));
+    TEST_TRUE(mem_chk(free_kernel_pages[0], 0, M_4K));
+    assign_free_page(0, old0);
+
+    // Only lazy pages can be resolved.
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, pd_resolve_lazy_p(pd, pi_s));
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, pd_resolve_lazy_p(pd, pi_e));
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, pd_resolve_lazy_p(pd, 5000));
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, pd_resolve_lazy_p(pd, 1024 * 1024));
+
+    // Kernel reads and writes materialize lazy pages too. (Reads only need the zero page)
+    uint8_t buf[16];
+    mem_set(buf, 0xFF, sizeof(buf));
+    TEST_SUCCESS(mem_cpy_from_user(buf, pd, (void *)(M_4K * (pi_s + 1)), sizeof(buf), NULL));
+    TEST_TRUE(mem_chk(buf, 0, sizeof(buf)));
+    TEST_EQUAL_UINT(COW_ENTRY, pte_get_avail(get_pd_pte(pd, pi_s + 1)));
+    TEST_EQUAL_HEX(get_zero_page(), pte_get_base(get_pd_pte(pd, pi_s + 1)));
+
+    TEST_SUCCESS(mem_set_to_user(pd, (void *)(M_4K * (pi_s + 2)), 0x12, M_4K, NULL));
+    TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(get_pd_pte(pd, pi_s + 2)));
+
+    // Copies carry over reservations, but don't materialize them.
+    phys_addr_t child = cow_page_directory(pd);
+    TEST_TRUE(child != NULL_PHYS_ADDR);
+    TEST_TRUE(fos_pte_is_lazy(get_pd_pte(child, pi_e - 1)));
+    TEST_TRUE(fos_pte_is_lazy(get_pd_pte(pd, pi_e - 1)));
+
+    TEST_SUCCESS(pd_resolve_lazy_p(child, pi_e - 1));
+    TEST_TRUE(fos_pte_is_lazy(get_pd_pte(pd, pi_e - 1)));
+
+    delete_page_directory(child);
+
+    // Freeing clears lazy entries.
+    pd_free_pages_p(pd, false, pi_s, pi_e);
+    for (uint32_t pi = pi_s; pi < pi_e; pi++) {
+        TEST_FALSE(fos_pte_in_use(get_pd_pte(pd, pi)));
+    }
+
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
 /*
  * NOTE: VERY IMPORTANT: in some of the below tests I switch into a copied memory space for
  * convenience. I have learned this is extra dicey. Calling any of the paging functions from the
@@ -438,6 +732,275 @@ static bool test_pd_copy_range_values(void) {
 /**
  * NOTE: This test copies the current page directory!
  */
+/**
+ * Fills every byte of page `pi` with `pi`. Fails for page indeces which are multiples of 8.
+ */
+static fernos_error_t pattern_page_filler(void *ctx, phys_addr_t pd, uint32_t pi, void *dest) {
+    (void)pd;
+
+    uint32_t *calls = (uint32_t *)ctx;
+    (*calls)++;
+
+    if (pi % 8 == 0) {
+        return FOS_E_UNKNWON_ERROR;
+    }
+
+    mem_set(dest, (uint8_t)pi, M_4K);
+
+    return FOS_E_SUCCESS;
+}
+
+static bool test_pd_resolve_lazy_read(void) {
+    enable_loss_check();
+
+    const uint32_t pi_s = 1020;
+    const uint32_t pi_e = 1030;
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    proc_mem_stats_t stats;
+    stats.quota = 0;
+    TEST_SUCCESS(pd_acct_attach(pd, &stats));
+
+    uint32_t true_e;
+    TEST_SUCCESS(pd_reserve_pages_p(pd, true, pi_s, pi_e, &true_e));
+
+    // Reading costs nothing at all.
+    const uint32_t free_before = get_num_free_pages();
+
+    const phys_addr_t zp = get_zero_page();
+    TEST_TRUE(zp != NULL_PHYS_ADDR);
+
+    for (uint32_t pi = pi_s; pi < pi_e; pi++) {
+        TEST_SUCCESS(pd_resolve_lazy_read_p(pd, pi));
+
+        const pt_entry_t pte = get_pd_pte(pd, pi);
+        TEST_EQUAL_UINT(COW_ENTRY, pte_get_avail(pte));
+        TEST_EQUAL_HEX(zp, pte_get_base(pte));
+        TEST_FALSE(pte_get_writable(pte));
+        TEST_TRUE(pte_get_user(pte));
+    }
+
+    TEST_EQUAL_UINT(free_before, get_num_free_pages());
+    TEST_EQUAL_UINT(0, stats.resident);
+
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, pd_resolve_lazy_read_p(pd, pi_s));
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, pd_resolve_lazy_read_p(pd, pi_e));
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, pd_resolve_lazy_read_p(pd, 1024 * 1024));
+
+    // Even deep copies just share the zero page.
+    phys_addr_t child = copy_page_directory(pd);
+    TEST_TRUE(child != NULL_PHYS_ADDR);
+    TEST_EQUAL_HEX(zp, pte_get_base(get_pd_pte(child, pi_s)));
+    delete_page_directory(child);
+
+    // A write gets a page of its own, which is zeroed and charged.
+    TEST_SUCCESS(pd_resolve_cow_p(pd, pi_s));
+
+    const pt_entry_t pte = get_pd_pte(pd, pi_s);
+    TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(pte));
+    TEST_TRUE(pte_get_writable(pte));
+    TEST_TRUE(pte_get_base(pte) != zp);
+    TEST_EQUAL_UINT(1, stats.resident);
+
+    phys_addr_t old0 = assign_free_page(0, pte_get_base(pte));
+    TEST_TRUE(mem_chk(free_kernel_pages[0], 0, M_4K));
+    assign_free_page(0, old0);
+
+    // The zero page itself is untouched, and never freed.
+    old0 = assign_free_page(0, zp);
+    TEST_TRUE(mem_chk(free_kernel_pages[0], 0, M_4K));
+    assign_free_page(0, old0);
+
+    pd_free_pages_p(pd, false, pi_s, pi_e);
+    TEST_EQUAL_UINT(0, stats.resident);
+    TEST_EQUAL_UINT(UINT32_MAX, page_get_refs(zp));
+
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_resolve_backed_lazy(void) {
+    enable_loss_check();
+
+    const uint32_t pi_s = 1020;
+    const uint32_t pi_e = 1030;
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    uint32_t true_e;
+    TEST_SUCCESS(pd_reserve_backed_pages_p(pd, true, false, pi_s, pi_e, &true_e));
+    TEST_EQUAL_UINT(pi_e, true_e);
+
+    for (uint32_t pi = pi_s; pi < pi_e; pi++) {
+        TEST_TRUE(fos_pte_is_backed_lazy(get_pd_pte(pd, pi)));
+        TEST_TRUE(fos_pte_in_use(get_pd_pte(pd, pi)));
+    }
+
+    // Without a filler, backed pages are just zeroed.
+    TEST_SUCCESS(pd_resolve_lazy_p(pd, pi_s + 1));
+    uint8_t buf[16];
+    TEST_SUCCESS(mem_cpy_from_user(buf, pd, (void *)(M_4K * (pi_s + 1)), sizeof(buf), NULL));
+    TEST_TRUE(mem_chk(buf, 0, sizeof(buf)));
+
+    uint32_t calls = 0;
+    set_lazy_page_filler(pattern_page_filler, &calls);
+
+    TEST_SUCCESS(pd_resolve_lazy_p(pd, pi_s + 2));
+    TEST_EQUAL_UINT(1, calls);
+
+    // The writeable bit is kept.
+    pt_entry_t pte = get_pd_pte(pd, pi_s + 2);
+    TEST_EQUAL_UINT(UNIQUE_ENTRY, pte_get_avail(pte));
+    TEST_TRUE(pte_get_present(pte));
+    TEST_FALSE(pte_get_writable(pte));
+
+    TEST_SUCCESS(mem_cpy_from_user(buf, pd, (void *)(M_4K * (pi_s + 2)), sizeof(buf), NULL));
+    TEST_TRUE(mem_chk(buf, (uint8_t)(pi_s + 2), sizeof(buf)));
+
+    // Kernel reads go through the filler too.
+    TEST_SUCCESS(mem_cpy_from_user(buf, pd, (void *)(M_4K * (pi_s + 3)), sizeof(buf), NULL));
+    TEST_TRUE(mem_chk(buf, (uint8_t)(pi_s + 3), sizeof(buf)));
+    TEST_EQUAL_UINT(2, calls);
+
+    // A filler error leaves the entry lazy, and gives the page back.
+    const uint32_t free_before = get_num_free_pages();
+    TEST_EQUAL_HEX(FOS_E_UNKNWON_ERROR, pd_resolve_lazy_p(pd, 1024));
+    TEST_TRUE(fos_pte_is_backed_lazy(get_pd_pte(pd, 1024)));
+    TEST_EQUAL_UINT(free_before, get_num_free_pages());
+
+    // Plain lazy pages never reach the filler.
+    TEST_SUCCESS(pd_reserve_pages_p(pd, true, pi_e, pi_e + 1, &true_e));
+    TEST_FALSE(fos_pte_is_backed_lazy(get_pd_pte(pd, pi_e)));
+    TEST_SUCCESS(pd_resolve_lazy_p(pd, pi_e));
+    TEST_EQUAL_UINT(3, calls);
+
+    set_lazy_page_filler(NULL, NULL);
+
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_get_underlying_run(void) {
+    enable_loss_check();
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    TEST_SUCCESS(pd_alloc_pages_p(pd, true, false, 10, 20, NULL));
+    TEST_SUCCESS(pd_reserve_pages_p(pd, true, 20, 22, NULL));
+    TEST_SUCCESS(pd_alloc_pages_p(pd, true, false, 1020, 1030, NULL));
+
+    phys_addr_t run[16];
+
+    // Every page should match what `pd_get_underlying_p` gives.
+    TEST_EQUAL_UINT(10, pd_get_underlying_run_p(pd, 10, 10, false, run));
+    for (uint32_t i = 0; i < 10; i++) {
+        TEST_EQUAL_HEX(pd_get_underlying_p(pd, 10 + i), run[i]);
+    }
+
+    // Runs stop at lazy pages and unmapped pages.
+    TEST_EQUAL_UINT(5, pd_get_underlying_run_p(pd, 15, 10, false, run));
+    TEST_EQUAL_UINT(0, pd_get_underlying_run_p(pd, 20, 10, false, run));
+    TEST_EQUAL_UINT(0, pd_get_underlying_run_p(pd, 5000, 10, false, run));
+
+    // Runs can cross page tables.
+    TEST_EQUAL_UINT(10, pd_get_underlying_run_p(pd, 1020, 16, false, run));
+    for (uint32_t i = 0; i < 10; i++) {
+        TEST_EQUAL_HEX(pd_get_underlying_p(pd, 1020 + i), run[i]);
+    }
+
+    // COW pages can be read as is, but not written.
+    phys_addr_t child = cow_page_directory(pd);
+    TEST_TRUE(child != NULL_PHYS_ADDR);
+
+    TEST_EQUAL_UINT(10, pd_get_underlying_run_p(child, 10, 10, false, run));
+    TEST_EQUAL_UINT(0, pd_get_underlying_run_p(child, 10, 10, true, run));
+
+    delete_page_directory(child);
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_find_free_run(void) {
+    enable_loss_check();
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    uint32_t pi;
+
+    // An empty range is found from the top.
+    TEST_SUCCESS(pd_find_free_run_p(pd, 0, 4096, 10, &pi));
+    TEST_EQUAL_UINT(4086, pi);
+
+    TEST_SUCCESS(pd_alloc_pages_p(pd, true, false, 4090, 4096, NULL));
+    TEST_SUCCESS(pd_reserve_pages_p(pd, true, 4070, 4080, NULL));
+
+    // Both present and lazy pages are in use, runs can cross page tables.
+    TEST_SUCCESS(pd_find_free_run_p(pd, 0, 4096, 10, &pi));
+    TEST_EQUAL_UINT(4080, pi);
+
+    TEST_SUCCESS(pd_find_free_run_p(pd, 0, 4096, 11, &pi));
+    TEST_EQUAL_UINT(4059, pi);
+
+    TEST_SUCCESS(pd_find_free_run_p(pd, 0, 4096, 3000, &pi));
+    TEST_EQUAL_UINT(1070, pi);
+
+    TEST_EQUAL_HEX(FOS_E_NO_SPACE, pd_find_free_run_p(pd, 4060, 4096, 11, &pi));
+    TEST_EQUAL_HEX(FOS_E_NO_SPACE, pd_find_free_run_p(pd, 0, 4096, 4071, &pi));
+
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, pd_find_free_run_p(pd, 0, 4096, 0, &pi));
+    TEST_EQUAL_HEX(FOS_E_INVALID_RANGE, pd_find_free_run_p(pd, 10, 5, 1, &pi));
+
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
+static bool test_pd_clean_page(void) {
+    enable_loss_check();
+
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    TEST_SUCCESS(pd_alloc_pages_p(pd, true, false, 10, 12, NULL));
+    TEST_SUCCESS(pd_reserve_pages_p(pd, true, 12, 13, NULL));
+
+    // Fresh and lazy pages are clean.
+    TEST_EQUAL_HEX(NULL_PHYS_ADDR, pd_clean_page_p(pd, 10));
+    TEST_EQUAL_HEX(NULL_PHYS_ADDR, pd_clean_page_p(pd, 12));
+    TEST_EQUAL_HEX(NULL_PHYS_ADDR, pd_clean_page_p(pd, 5000));
+
+    // A kernel write marks the page dirty.
+    uint32_t val = 5;
+    TEST_SUCCESS(mem_cpy_to_user(pd, (void *)(11 * M_4K), &val, sizeof(val), NULL));
+
+    TEST_EQUAL_HEX(NULL_PHYS_ADDR, pd_clean_page_p(pd, 10));
+    TEST_EQUAL_HEX(pd_get_underlying_p(pd, 11), pd_clean_page_p(pd, 11));
+    TEST_EQUAL_HEX(NULL_PHYS_ADDR, pd_clean_page_p(pd, 11));
+
+    // The dirty bit survives being made COW and back.
+    TEST_SUCCESS(mem_cpy_to_user(pd, (void *)(11 * M_4K), &val, sizeof(val), NULL));
+
+    phys_addr_t child = cow_page_directory(pd);
+    TEST_TRUE(child != NULL_PHYS_ADDR);
+
+    TEST_SUCCESS(pd_resolve_cow_p(child, 11));
+    TEST_TRUE(pd_clean_page_p(child, 11) != NULL_PHYS_ADDR);
+    TEST_TRUE(pd_clean_page_p(pd, 11) != NULL_PHYS_ADDR);
+
+    delete_page_directory(child);
+    delete_page_directory(pd);
+
+    TEST_SUCCEED();
+}
+
 #define MEM_TEST_AREA_SIZE  (4 * M_4K)
 #define MEM_TEST_AREA_START ((uint8_t *)FC_CORE_VMEM_FREE_START)
 #define MEM_TEST_AREA_END   (MEM_TEST_AREA_START + MEM_TEST_AREA_SIZE)
@@ -892,6 +1455,180 @@ static bool test_new_user_app_pd(void) {
     TEST_SUCCEED();
 }
 
+static bool test_new_user_app_pd_shared(void) {
+    enable_loss_check();
+
+    // Two pages of "text" which we hold a reference to, just like the image cache would.
+    phys_addr_t text_pages[2];
+    for (uint32_t i = 0; i < 2; i++) {
+        text_pages[i] = pop_free_page();
+        TEST_TRUE(text_pages[i] != NULL_PHYS_ADDR);
+        page_inc_refs(text_pages[i]);
+
+        phys_addr_t old0 = assign_free_page(0, text_pages[i]);
+        mem_set(free_kernel_pages[0], (uint8_t)(0xA0 + i), M_4K);
+        assign_free_page(0, old0);
+    }
+
+    user_app_t ua = {
+        .al = NULL,
+        .entry = (const void *)FC_CORE_VMEM_APP_START,
+        .areas = {
+            (user_app_area_entry_t) {
+                .occupied = true,
+                .load_position = (void *)FC_CORE_VMEM_APP_START,
+                .area_size = M_4K + 100,
+                .given = NULL, // Ignored, the pages are given.
+                .given_size = 0,
+                .writeable = false
+            },
+            (user_app_area_entry_t) {
+                .occupied = true,
+                .load_position = (void *)(FC_CORE_VMEM_APP_START + (4 * M_4K)),
+                .area_size = 16,
+                .given = "data",
+                .given_size = 5,
+                .writeable = true
+            }
+        }
+    };
+
+    phys_addr_t * const area_pages[FOS_MAX_APP_AREAS] = {
+        text_pages
+    };
+
+    phys_addr_t upd0;
+    TEST_SUCCESS(new_user_app_pd_shared(&ua, area_pages, 0, NULL, NULL, NULL, 0, &upd0));
+
+    phys_addr_t upd1;
+    TEST_SUCCESS(new_user_app_pd_shared(&ua, area_pages, 0, NULL, NULL, NULL, 0, &upd1));
+
+    const uint32_t text_pi = FC_CORE_VMEM_APP_START / M_4K;
+
+    for (uint32_t i = 0; i < 2; i++) {
+        pt_entry_t pte = get_pd_pte(upd0, text_pi + i);
+        TEST_EQUAL_UINT(COW_ENTRY, pte_get_avail(pte));
+        TEST_FALSE(pte_get_writable(pte));
+        TEST_EQUAL_HEX(text_pages[i], pte_get_base(pte));
+        TEST_EQUAL_HEX(text_pages[i], pd_get_underlying_p(upd1, text_pi + i));
+
+        // Us + both page directories.
+        TEST_EQUAL_UINT(3, page_get_refs(text_pages[i]));
+    }
+
+    // The writeable area is still private.
+    char buf[5];
+    TEST_SUCCESS(mem_cpy_from_user(buf, upd0, ua.areas[1].load_position, sizeof(buf), NULL));
+    TEST_TRUE(mem_cmp(buf, "data", sizeof(buf)));
+    TEST_TRUE(pd_get_underlying(upd0, ua.areas[1].load_position) !=
+            pd_get_underlying(upd1, ua.areas[1].load_position));
+
+    // A write to the shared area must only be seen by the writer.
+    TEST_SUCCESS(mem_cpy_to_user(upd0, (void *)FC_CORE_VMEM_APP_START, "hi", 3, NULL));
+    TEST_EQUAL_UINT(2, page_get_refs(text_pages[0]));
+
+    TEST_SUCCESS(mem_cpy_from_user(buf, upd1, (const void *)FC_CORE_VMEM_APP_START, 3, NULL));
+    TEST_TRUE(mem_chk(buf, 0xA0, 3));
+
+    delete_page_directory(upd0);
+    delete_page_directory(upd1);
+
+    // Only our references should remain, the pages must still be around.
+    for (uint32_t i = 0; i < 2; i++) {
+        TEST_EQUAL_UINT(1, page_get_refs(text_pages[i]));
+        TEST_EQUAL_UINT(0, page_dec_refs(text_pages[i]));
+        push_free_page(text_pages[i]);
+    }
+
+    TEST_SUCCEED();
+}
+
+/**
+ * Every given byte is its offset within the area plus the area index.
+ */
+static fernos_error_t pattern_area_reader(void *ctx, size_t area_ind, size_t offset, void *dest, size_t len) {
+    uint32_t *calls = (uint32_t *)ctx;
+    (*calls)++;
+
+    for (size_t i = 0; i < len; i++) {
+        ((uint8_t *)dest)[i] = (uint8_t)(offset + i + area_ind);
+    }
+
+    return FOS_E_SUCCESS;
+}
+
+static fernos_error_t failing_area_reader(void *ctx, size_t area_ind, size_t offset, void *dest, size_t len) {
+    (void)ctx;
+    (void)area_ind;
+    (void)offset;
+    (void)dest;
+    (void)len;
+
+    return FOS_E_UNKNWON_ERROR;
+}
+
+static bool test_new_user_app_pd_reader(void) {
+    enable_loss_check();
+
+    user_app_t ua = {
+        .al = NULL,
+        .entry = (const void *)FC_CORE_VMEM_APP_START,
+        .areas = {
+            (user_app_area_entry_t) {
+                .occupied = true,
+                .load_position = (void *)FC_CORE_VMEM_APP_START,
+                .area_size = (2 * M_4K) + 50,
+                .given = NULL, // Never read when a reader is given.
+                .given_size = M_4K + 20,
+                .writeable = false
+            },
+            (user_app_area_entry_t) {
+                .occupied = true,
+                .load_position = (void *)(FC_CORE_VMEM_APP_START + (4 * M_4K)),
+                .area_size = 100,
+                .given = NULL,
+                .given_size = 0,
+                .writeable = true
+            }
+        }
+    };
+
+    uint32_t calls = 0;
+
+    phys_addr_t upd;
+    TEST_SUCCESS(new_user_app_pd_shared(&ua, NULL, 0, pattern_area_reader, &calls, NULL, 0, &upd));
+
+    // One call per page which has given bytes.
+    TEST_EQUAL_UINT(2, calls);
+
+    uint8_t buf[M_4K];
+
+    // First page is entirely given.
+    TEST_SUCCESS(mem_cpy_from_user(buf, upd, ua.areas[0].load_position, M_4K, NULL));
+    for (size_t i = 0; i < M_4K; i++) {
+        TEST_EQUAL_UINT((uint8_t)i, buf[i]);
+    }
+
+    // Second page is partially given, the rest is zero.
+    TEST_SUCCESS(mem_cpy_from_user(buf, upd, (uint8_t *)(ua.areas[0].load_position) + M_4K,
+                M_4K, NULL));
+    for (size_t i = 0; i < 20; i++) {
+        TEST_EQUAL_UINT((uint8_t)(M_4K + i), buf[i]);
+    }
+    TEST_TRUE(mem_chk(buf + 20, 0, M_4K - 20));
+
+    // The bss like area is all zeros.
+    TEST_SUCCESS(mem_cpy_from_user(buf, upd, ua.areas[1].load_position, M_4K, NULL));
+    TEST_TRUE(mem_chk(buf, 0, M_4K));
+
+    delete_page_directory(upd);
+
+    // A reader failure fails the whole thing.
+    TEST_FAILURE(new_user_app_pd_shared(&ua, NULL, 0, failing_area_reader, NULL, NULL, 0, &upd));
+
+    TEST_SUCCEED();
+}
+
 static bool test_ua_copy_from_user(void) {
     enable_loss_check();
 
@@ -1005,12 +1742,68 @@ bool test_page_helpers(void) {
     RUN_TEST(test_pt_copy_range_values);
     RUN_TEST(test_pd_copy_range_p);
     RUN_TEST(test_pd_copy_range_values);
+    RUN_TEST(test_pt_cow_range);
+    RUN_TEST(test_pd_resolve_cow);
+    RUN_TEST(test_pd_copy_large);
+    RUN_TEST(test_pd_resolve_lazy);
+    RUN_TEST(test_pd_resolve_lazy_read);
+    RUN_TEST(test_pd_resolve_backed_lazy);
+    RUN_TEST(test_pd_get_underlying_run);
+    RUN_TEST(test_pd_find_free_run);
+    RUN_TEST(test_pd_clean_page);
     RUN_TEST(test_mem_cpy_user);
     RUN_TEST(test_bad_mem_cpy);
     RUN_TEST(test_mem_set_user);
     RUN_TEST(test_bad_mem_set);
     RUN_TEST(test_new_user_app_pd);
+    RUN_TEST(test_new_user_app_pd_shared);
+    RUN_TEST(test_new_user_app_pd_reader);
     RUN_TEST(test_ua_copy_from_user);
 
     return END_SUITE();
 }
+
+#define BENCH_CPY_ROUNDS  (16U)
+#define BENCH_CPY_MAX     (M_1M)
+
+/**
+ * Where the user buffer is placed in the benchmark page directory. (Page index)
+ */
+#define BENCH_CPY_PI      (FC_CORE_VMEM_FREE_START / M_4K)
+
+void bench_mem_cpy_user(void) {
+    static uint8_t kbuf[BENCH_CPY_MAX];
+    static const uint32_t sizes[] = { M_4K, M_64K, M_1M };
+
+    LOGF_METHOD("mem_cpy_user Benchmark (%u rounds, KCycles per copy)\n", BENCH_CPY_ROUNDS);
+
+    phys_addr_t pd = new_page_directory();
+    if (pd == NULL_PHYS_ADDR) {
+        return;
+    }
+
+    if (pd_alloc_pages_p(pd, true, false, BENCH_CPY_PI, BENCH_CPY_PI + (BENCH_CPY_MAX / M_4K), NULL) == FOS_E_SUCCESS) {
+        // Start a little into the first page so that every copy crosses page boundaries.
+        void *ubuf = (void *)((BENCH_CPY_PI * M_4K) + 64);
+
+        for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            const uint32_t bytes = sizes[i] - 64;
+
+            uint64_t start = read_tsc();
+            for (uint32_t r = 0; r < BENCH_CPY_ROUNDS; r++) {
+                mem_cpy_to_user(pd, ubuf, kbuf, bytes, NULL);
+            }
+            const uint32_t to_kc = (uint32_t)(((read_tsc() - start) / BENCH_CPY_ROUNDS) >> 10);
+
+            start = read_tsc();
+            for (uint32_t r = 0; r < BENCH_CPY_ROUNDS; r++) {
+                mem_cpy_from_user(kbuf, pd, ubuf, bytes, NULL);
+            }
+            const uint32_t from_kc = (uint32_t)(((read_tsc() - start) / BENCH_CPY_ROUNDS) >> 10);
+
+            LOGF_METHOD("%u bytes: to %u, from %u\n", sizes[i], to_kc, from_kc);
+        }
+    }
+
+    delete_page_directory(pd);
+}
@@ -120,6 +120,192 @@ static bool test_many_threads(void) {
     TEST_SUCCEED();
 }
 
+static bool test_schedule_prios(void) {
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    process_t *proc = new_da_process(0, pd, NULL);
+    TEST_TRUE(proc != NULL);
+
+    thread_t *thr0 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    thread_t *thr1 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    thread_t *thr2 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    TEST_TRUE(thr0 && thr1 && thr2);
+
+    TEST_EQUAL_UINT(THREAD_PRIO_DEFAULT, thr0->prio);
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, thread_set_prio(thr0, THREAD_PRIO_LEVELS));
+    TEST_SUCCESS(thread_set_prio(thr1, 2));
+
+    schedule_t s;
+    init_schedule(&s);
+
+    // Scheduling never preempts the current thread.
+    thread_schedule(thr0, &s);
+    thread_schedule(thr1, &s);
+    thread_schedule(thr2, &s);
+    TEST_EQUAL_HEX(thr0, s.head);
+    TEST_EQUAL_HEX((1UL << 2) | (1UL << THREAD_PRIO_DEFAULT), s.level_map);
+
+    // The more urgent thread runs until it leaves the schedule.
+    schedule_advance(&s);
+    TEST_EQUAL_HEX(thr1, s.head);
+    schedule_advance(&s);
+    TEST_EQUAL_HEX(thr1, s.head);
+
+    thread_detach(thr1);
+    TEST_EQUAL_HEX(NULL, thr1->schedule);
+    TEST_EQUAL_HEX(1UL << THREAD_PRIO_DEFAULT, s.level_map);
+
+    // Threads of equal priority take turns.
+    TEST_EQUAL_HEX(thr2, s.head);
+    schedule_advance(&s);
+    TEST_EQUAL_HEX(thr0, s.head);
+    schedule_advance(&s);
+    TEST_EQUAL_HEX(thr2, s.head);
+
+    // A woken thread keeps its boost until it uses up a full time slice.
+    thread_wake(thr1, &s);
+    TEST_EQUAL_UINT(FC_CORE_SCHED_WAKE_BOOST, thr1->boost);
+    TEST_EQUAL_HEX(thr2, s.head);
+    schedule_advance(&s);
+    TEST_EQUAL_HEX(thr1, s.head);
+    schedule_advance(&s);
+    TEST_EQUAL_UINT(0, thr1->boost);
+    TEST_EQUAL_HEX(thr1, s.head);
+
+    // Lowering the current thread's priority takes effect on the next advance.
+    TEST_SUCCESS(thread_set_prio(thr1, 6));
+    TEST_EQUAL_HEX(thr1, s.head);
+    schedule_advance(&s);
+    TEST_EQUAL_HEX(thr0, s.head);
+    TEST_EQUAL_HEX((1UL << 6) | (1UL << THREAD_PRIO_DEFAULT), s.level_map);
+
+    TEST_SUCCESS(delete_process(proc));
+
+    TEST_EQUAL_HEX(NULL, s.head);
+    TEST_EQUAL_HEX(0, s.level_map);
+
+    TEST_SUCCEED();
+}
+
+static bool test_schedule_quantum(void) {
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    process_t *proc = new_da_process(0, pd, NULL);
+    TEST_TRUE(proc != NULL);
+
+    thread_t *thr0 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    thread_t *thr1 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    thread_t *thr2 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    TEST_TRUE(thr0 && thr1 && thr2);
+
+    schedule_t s;
+    init_schedule(&s);
+
+    thread_schedule(thr0, &s);
+    thread_schedule(thr1, &s);
+
+    // The current thread runs for its full slice.
+    for (uint32_t i = 0; i < FC_CORE_SCHED_QUANTUM - 1; i++) {
+        schedule_tick(&s);
+        TEST_EQUAL_HEX(thr0, s.head);
+    }
+
+    schedule_tick(&s);
+    TEST_EQUAL_HEX(thr1, s.head);
+    TEST_EQUAL_UINT(FC_CORE_SCHED_QUANTUM, thr0->slice);
+
+    // Unless a more urgent thread shows up. 
+    TEST_SUCCESS(thread_set_prio(thr2, THREAD_PRIO_DEFAULT - 1));
+    thread_schedule(thr2, &s);
+    TEST_EQUAL_HEX(thr1, s.head);
+
+    schedule_tick(&s);
+    if (FC_CORE_SCHED_QUANTUM > 1) {
+        // `thr1` keeps its place and the rest of its slice.
+        TEST_EQUAL_HEX(thr2, s.head);
+        TEST_EQUAL_UINT(FC_CORE_SCHED_QUANTUM - 1, thr1->slice);
+
+        thread_detach(thr2);
+        TEST_EQUAL_HEX(thr1, s.head);
+    }
+
+    TEST_SUCCESS(delete_process(proc));
+
+    TEST_SUCCEED();
+}
+
+static bool test_schedule_stats(void) {
+    phys_addr_t pd = new_page_directory();
+    TEST_TRUE(pd != NULL_PHYS_ADDR);
+
+    process_t *proc = new_da_process(0, pd, NULL);
+    TEST_TRUE(proc != NULL);
+
+    thread_t *thr0 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    thread_t *thr1 = proc_new_thread(proc, (uintptr_t)fake_entry, 0, 0, 0);
+    TEST_TRUE(thr0 && thr1);
+
+    basic_wait_queue_t *bwq = new_da_basic_wait_queue();
+    TEST_TRUE(bwq != NULL);
+
+    schedule_t s;
+    init_schedule(&s);
+
+    thread_schedule(thr0, &s);
+    thread_schedule(thr1, &s);
+
+    // Using up a slice is involuntary.
+    for (uint32_t i = 0; i < FC_CORE_SCHED_QUANTUM; i++) {
+        schedule_tick(&s);
+    }
+    TEST_EQUAL_HEX(thr1, s.head);
+    TEST_EQUAL_UINT(1, thr0->stats.invol_switches);
+    TEST_EQUAL_UINT(0, thr1->stats.invol_switches);
+
+    // Leaving the schedule is voluntary.
+    thread_detach(thr1);
+    TEST_EQUAL_UINT(1, thr1->stats.vol_switches);
+
+    TEST_SUCCESS(bwq_enqueue(bwq, thr0));
+    thread_wait(thr0, (wait_queue_t *)bwq, WAIT_KIND_IO);
+    TEST_EQUAL_UINT(1, thr0->stats.vol_switches);
+    TEST_EQUAL_UINT(WAIT_KIND_IO, thr0->wait_kind);
+
+    TEST_SUCCESS(bwq_wake_all_threads(bwq, &s, FOS_E_SUCCESS));
+    TEST_EQUAL_HEX(thr0, s.head);
+    TEST_EQUAL_UINT(WAIT_KINDS, thr0->wait_kind);
+    TEST_TRUE(thr0->stats.wait_ns[WAIT_KIND_IO] > 0);
+    TEST_EQUAL_UINT(0, thr0->stats.wait_ns[WAIT_KIND_SLEEP]);
+
+    thread_dispatch(thr0);
+    TEST_EQUAL_UINT(1, thr0->stats.wakeups);
+    TEST_TRUE(thr0->stats.runq_latency_ns <= thr0->stats.max_runq_latency_ns);
+
+    thread_charge(thr0);
+    const uint64_t cpu_ns = thr0->stats.cpu_ns;
+    TEST_TRUE(cpu_ns > 0);
+
+    // Not dispatched, nothing to charge.
+    thread_charge(thr0);
+    TEST_TRUE(cpu_ns == thr0->stats.cpu_ns);
+
+    // Deleted threads still count towards their process.
+    proc_delete_thread(proc, thr1, false);
+
+    sched_stats_t stats;
+    proc_sched_stats(proc, &stats);
+    TEST_EQUAL_UINT(2, stats.vol_switches);
+    TEST_EQUAL_UINT(1, stats.invol_switches);
+    TEST_TRUE(cpu_ns == stats.cpu_ns);
+
+    delete_wait_queue((wait_queue_t *)bwq);
+    TEST_SUCCESS(delete_process(proc));
+
+    TEST_SUCCEED();
+}
+
 static bool test_fork_process(void) {
     phys_addr_t pd = new_page_directory();
     TEST_TRUE(pd != NULL_PHYS_ADDR);
@@ -372,6 +558,9 @@ bool test_process(void) {
     RUN_TEST(test_new_and_delete);
     RUN_TEST(test_new_thread);
     RUN_TEST(test_many_threads);
+    RUN_TEST(test_schedule_prios);
+    RUN_TEST(test_schedule_quantum);
+    RUN_TEST(test_schedule_stats);
     RUN_TEST(test_fork_process);
     RUN_TEST(test_complex_process);
     RUN_TEST(test_fork_with_handles);
@@ -72,6 +72,11 @@ void _nop_slave_irq15_handler(void);
 // PIT Stuff... These all assume operation in kernel space where interrupts
 // are disabled!
 
+/**
+ * The rate at which all PIT channels count down.
+ */
+#define PIT_BASE_FREQ_HZ (1193182U)
+
 /**
  * Initilize the Programmable interval timer.
  *
@@ -93,3 +98,27 @@ void pit_set_reload_val(uint16_t reload_val);
  * Gets the current count value on channel 0.
  */
 uint16_t pit_get_count(void);
+
+/**
+ * Switch channel 0 into one-shot mode. Channel 0 counts down from `count` and triggers IRQ0 
+ * once when it reaches 0. No more interrupts occur after that.
+ *
+ * Call `init_pit` to go back to periodic interrupts.
+ */
+void pit_one_shot(uint16_t count);
+
+/**
+ * Returns true if the countdown started by `pit_one_shot` has reached 0.
+ *
+ * (After reaching 0 the count wraps around, so `pit_get_count` can't be trusted)
+ */
+bool pit_one_shot_done(void);
+
+/**
+ * Count down `count` PIT cycles on channel 2 (The speaker channel, so IRQ0 is left alone) and
+ * return how many TSC cycles passed during the countdown.
+ *
+ * This busy waits! It is meant to be used once at startup to find the TSC frequency.
+ * (`count` PIT cycles take `count / PIT_BASE_FREQ_HZ` seconds)
+ */
+uint64_t pit_measure_tsc(uint16_t count);
@@ -41,6 +41,29 @@ typedef uint32_t pt_entry_t;
 #define PTE_PCD_WID_MASK TO_MASK64(PTE_PCD_WID)
 #define PTE_PCD_MASK (PTE_PCD_WID_MASK << PTE_PCD_OFF)       
 
+/*
+ * The dirty bit is set by the CPU whenever a page is written to through a page table entry.
+ * (It is never cleared by the CPU)
+ */
+
+#define PTE_DIRTY_OFF (6)      
+#define PTE_DIRTY_WID (1)  
+#define PTE_DIRTY_WID_MASK TO_MASK64(PTE_DIRTY_WID)
+#define PTE_DIRTY_MASK (PTE_DIRTY_WID_MASK << PTE_DIRTY_OFF)       
+
+/*
+ * The page size bit only has meaning in page directory entries, and only once PSE is enabled.
+ * (See `enable_pse`)
+ *
+ * When set, the entry maps a single 4MB page directly, rather than pointing to a page table.
+ * The base of such an entry must be 4MB aligned.
+ */
+
+#define PTE_PS_OFF (7)      
+#define PTE_PS_WID (1)  
+#define PTE_PS_WID_MASK TO_MASK64(PTE_PS_WID)
+#define PTE_PS_MASK (PTE_PS_WID_MASK << PTE_PS_OFF)       
+
 #define PTE_AVAIL_OFF (9)      
 #define PTE_AVAIL_WID (3)  
 #define PTE_AVAIL_WID_MASK TO_MASK64(PTE_AVAIL_WID)
@@ -120,6 +143,32 @@ static inline uint8_t pte_get_pcd(pt_entry_t pte) {
     return (pte & PTE_PCD_MASK) >> PTE_PCD_OFF;
 }
 
+static inline void pte_set_dirty(pt_entry_t *pte, uint8_t d) {
+    pt_entry_t te = *pte;
+
+    te &= ~(PTE_DIRTY_MASK);
+    te |= (d & PTE_DIRTY_WID_MASK) << PTE_DIRTY_OFF;
+
+    *pte = te;
+}
+
+static inline uint8_t pte_get_dirty(pt_entry_t pte) {
+    return (pte & PTE_DIRTY_MASK) >> PTE_DIRTY_OFF;
+}
+
+static inline void pte_set_ps(pt_entry_t *pte, uint8_t ps) {
+    pt_entry_t te = *pte;
+
+    te &= ~(PTE_PS_MASK);
+    te |= (ps & PTE_PS_WID_MASK) << PTE_PS_OFF;
+
+    *pte = te;
+}
+
+static inline uint8_t pte_get_ps(pt_entry_t pte) {
+    return (pte & PTE_PS_MASK) >> PTE_PS_OFF;
+}
+
 static inline void pte_set_avail(pt_entry_t *pte, uint8_t av) {
     pt_entry_t te = *pte;
 
@@ -148,6 +197,13 @@ static inline phys_addr_t pte_get_base(pt_entry_t pte) {
 
 void enable_paging(void);
 
+/**
+ * Set the PSE bit in CR4, this allows 4MB pages in page directories.
+ *
+ * Should be called before paging is enabled.
+ */
+void enable_pse(void);
+
 static inline uint32_t is_paging_enabled(void) {
     return read_cr0() & (1 << 31);
 }
@@ -1,5 +1,6 @@
 
 #include "k_sys/intr.h"
+#include "s_util/misc.h"
 
 // Ok, now some PIC stuff..... (Much of this taken from OSdev Wiki
 
@@ -193,7 +194,34 @@ void _nop_slave_irq15_handler(void) {
  * PIT CMD bits [1:3] = Operating mode
  */
 
-#define PIT_CMD_SQUARE_WAVE_MODE (0x3U << 1)
+#define PIT_CMD_TERMINAL_COUNT_MODE (0x0U << 1)
+#define PIT_CMD_SQUARE_WAVE_MODE    (0x3U << 1)
+
+/*
+ * Read back command bits. (Used with PIT_CMD_READ_BACK)
+ *
+ * NOTE: The latch bits are active low!
+ */
+
+#define PIT_RB_NO_LATCH_COUNT  (0x1U << 5)
+#define PIT_RB_NO_LATCH_STATUS (0x1U << 4)
+#define PIT_RB_CHNL_0          (0x1U << 1)
+
+/*
+ * Status byte bit 7 = The state of the channel's OUT pin.
+ */
+
+#define PIT_STATUS_OUT (0x1U << 7)
+
+/*
+ * Channel 2's gate is controlled through the keyboard controller's port B. Its OUT pin can be 
+ * read back from the same port.
+ */
+
+#define PIT_CHNL_2_CTRL_PORT (0x61U)
+#define PIT_CHNL_2_GATE      (0x1U << 0)
+#define PIT_CHNL_2_SPEAKER   (0x1U << 1)
+#define PIT_CHNL_2_OUT       (0x1U << 5)
 
 void init_pit(uint16_t init_reload_val) {
     outb(PIT_CMD_REG_PORT, 
@@ -221,3 +249,51 @@ uint16_t pit_get_count(void) {
 
    return count;
 }
+
+/*
+ * In terminal count mode, OUT goes low as soon as the mode is set, and goes high (triggering IRQ0)
+ * once the count reaches 0. The count is started as soon as the reload value is written.
+ */
+
+void pit_one_shot(uint16_t count) {
+    outb(PIT_CMD_REG_PORT, 
+            PIT_CMD_CHNL_0 |
+            PIT_CMD_LO_HI |
+            PIT_CMD_TERMINAL_COUNT_MODE);
+
+    pit_set_reload_val(count);
+}
+
+bool pit_one_shot_done(void) {
+    outb(PIT_CMD_REG_PORT, 
+            PIT_CMD_READ_BACK | PIT_RB_NO_LATCH_COUNT | PIT_RB_CHNL_0);
+
+    return (inb(PIT_CHNL_0_DATA_PORT) & PIT_STATUS_OUT) != 0;
+}
+
+uint64_t pit_measure_tsc(uint16_t count) {
+    const uint8_t ctrl = inb(PIT_CHNL_2_CTRL_PORT);
+
+    // Gate low, so the count doesn't start when it's written. Keep the speaker off too.
+    outb(PIT_CHNL_2_CTRL_PORT, ctrl & ~(PIT_CHNL_2_GATE | PIT_CHNL_2_SPEAKER));
+
+    outb(PIT_CMD_REG_PORT, 
+            PIT_CMD_CHNL_2 |
+            PIT_CMD_LO_HI |
+            PIT_CMD_TERMINAL_COUNT_MODE);
+
+    outb(PIT_CHNL_2_DATA_PORT, count & 0xFF);
+    outb(PIT_CHNL_2_DATA_PORT, (count & 0xFF00) >> 8);
+
+    // Raising the gate starts the countdown.
+    outb(PIT_CHNL_2_CTRL_PORT, (ctrl & ~PIT_CHNL_2_SPEAKER) | PIT_CHNL_2_GATE);
+    const uint64_t start = read_tsc();
+
+    while (!(inb(PIT_CHNL_2_CTRL_PORT) & PIT_CHNL_2_OUT));
+
+    const uint64_t end = read_tsc();
+
+    outb(PIT_CHNL_2_CTRL_PORT, ctrl);
+
+    return end - start;
+}
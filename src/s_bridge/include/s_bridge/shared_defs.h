@@ -103,6 +103,22 @@ typedef struct _thread_join_ret_t {
     void *retval;
 } thread_join_ret_t;
 
+/**
+ * A thread's scheduling priority. Scheduled threads with a lower priority value always run
+ * before those with a higher value. (Threads of equal priority take turns)
+ */
+typedef uint32_t thread_prio_t;
+
+/**
+ * Number of priority levels. Valid priorities are [0, THREAD_PRIO_LEVELS).
+ */
+#define THREAD_PRIO_LEVELS (8U)
+
+/**
+ * Priority given to newly created threads.
+ */
+#define THREAD_PRIO_DEFAULT (4U)
+
 /**
  * Exit statuses of a process.
  */
@@ -115,6 +131,183 @@ typedef uint32_t proc_exit_status_t;
 #define PROC_ES_GPF (0x3U) // Exit due to a general protection fault.
 #define PROC_ES_PF  (0x4U) // Exit due to a page fault.
 #define PROC_ES_SIGNAL  (0x5U) // An unallowed signal was received.
+#define PROC_ES_OOM     (0x6U) // Killed to free up memory, or ran past its page quota.
+
+/**
+ * How many physical pages a process's memory space uses.
+ *
+ * Only pages mapped into userspace are counted. Lazy pages are only counted once written.
+ * (Page tables and kernel structures are not counted)
+ */
+typedef struct _proc_mem_stats_t {
+    /**
+     * Every page mapped into the process's userspace.
+     */
+    uint32_t resident;
+
+    /**
+     * Resident pages which may also be mapped by other processes. (Shared memory and COW pages)
+     */
+    uint32_t shared;
+
+    /**
+     * Resident pages in the thread stack area.
+     */
+    uint32_t stack;
+
+    /**
+     * Resident pages in the free area. (i.e. the heap, and file mappings)
+     */
+    uint32_t heap;
+
+    /**
+     * The process may not grow past this many resident pages. 0 means no quota.
+     *
+     * NOTE: A process can end up above its quota, for example right after a fork. It just won't
+     * be given any new pages until it drops back below.
+     */
+    uint32_t quota;
+} proc_mem_stats_t;
+
+/**
+ * Number of malloc size classes counted in `heap_stats_t`.
+ *
+ * Class 0 counts requests of 1-8 bytes, class 1 counts 9-16 bytes, class 2 counts 17-32 bytes,
+ * and so on. The last class counts everything which doesn't fit in an earlier class.
+ */
+#define HEAP_STATS_NUM_CLASSES (16U)
+
+/**
+ * Statistics of the kernel heap, as seen from userspace.
+ *
+ * This mirrors `allocator_stats_t`. It is kept separate so that changes to the allocators don't
+ * silently change what userspace is handed. (See `allocator_stats_t` for what each field means)
+ */
+typedef struct _heap_stats_t {
+    uint32_t bytes_in_use;
+    uint32_t peak_bytes_in_use;
+    uint32_t bytes_mapped;
+
+    uint32_t num_user_blocks;
+    uint32_t num_free_blocks;
+    uint32_t bytes_free;
+
+    uint32_t num_mallocs;
+    uint32_t num_failed_mallocs;
+    uint32_t num_reallocs;
+    uint32_t num_frees;
+
+    uint32_t num_blocks_searched;
+
+    uint32_t mallocs_per_class[HEAP_STATS_NUM_CLASSES];
+} heap_stats_t;
+
+/**
+ * How to turn a reading of the CPU's timestamp counter (See `read_tsc`) into the monotonic clock.
+ *
+ * The clock counts nanoseconds since the TSC read `tsc_start`, which is some time during boot.
+ * These values are measured once at startup and never change after that. So, it is safe for
+ * userspace to keep a copy and read the clock without entering the kernel.
+ */
+typedef struct _clock_info_t {
+    uint64_t tsc_start;
+
+    /**
+     * One TSC cycle is `mult / 2^shift` nanoseconds. (`shift` is at most 32)
+     */
+    uint32_t mult;
+    uint32_t shift;
+} clock_info_t;
+
+/**
+ * Convert the TSC reading `tsc` into nanoseconds of the monotonic clock.
+ *
+ * The 64-bit cycle count is split in two so the multiply never overflows.
+ */
+static inline uint64_t clock_info_ns(const clock_info_t *ci, uint64_t tsc) {
+    const uint64_t delta = tsc - ci->tsc_start;
+
+    return (((delta & 0xFFFFFFFFULL) * ci->mult) >> ci->shift) +
+        (((delta >> 32) * ci->mult) << (32 - ci->shift));
+}
+
+/**
+ * What a thread can wait on. (Used to break down waiting time in `sched_stats_t`)
+ */
+typedef uint32_t wait_kind_t;
+
+#define WAIT_KIND_SLEEP  (0U) // Sleeping
+#define WAIT_KIND_JOIN   (1U) // Joining other threads
+#define WAIT_KIND_SIGNAL (2U) // Waiting for signals
+#define WAIT_KIND_SYNC   (3U) // Futexes and semaphores
+#define WAIT_KIND_IO     (4U) // Files, pipes, the keyboard and windows
+
+#define WAIT_KINDS (5U)
+
+/**
+ * Scheduler statistics of a thread. (Or of all threads of a process)
+ *
+ * All times are in nanoseconds of the monotonic clock. (See `clock_info_t`)
+ */
+typedef struct _sched_stats_t {
+    /**
+     * Time spent running in userspace.
+     */
+    uint64_t cpu_ns;
+
+    /**
+     * Timer ticks which arrived while running.
+     */
+    uint32_t cpu_ticks;
+
+    /**
+     * Times the thread gave up the CPU by waiting or exiting.
+     */
+    uint32_t vol_switches;
+
+    /**
+     * Times the thread was switched out by the scheduler while it could have kept running.
+     */
+    uint32_t invol_switches;
+
+    /**
+     * Time spent waiting, by what was waited on. (Indexed by `wait_kind_t`)
+     */
+    uint64_t wait_ns[WAIT_KINDS];
+
+    /**
+     * Times the thread got to run after being woken up from waiting.
+     */
+    uint32_t wakeups;
+
+    /**
+     * Run queue latency. The time between being woken up and actually running, summed over all 
+     * `wakeups`, and the longest single one.
+     */
+    uint64_t runq_latency_ns;
+    uint64_t max_runq_latency_ns;
+} sched_stats_t;
+
+/**
+ * Add the statistics in `src` to `dest`.
+ */
+static inline void sched_stats_add(sched_stats_t *dest, const sched_stats_t *src) {
+    dest->cpu_ns += src->cpu_ns;
+    dest->cpu_ticks += src->cpu_ticks;
+    dest->vol_switches += src->vol_switches;
+    dest->invol_switches += src->invol_switches;
+
+    for (wait_kind_t i = 0; i < WAIT_KINDS; i++) {
+        dest->wait_ns[i] += src->wait_ns[i];
+    }
+
+    dest->wakeups += src->wakeups;
+    dest->runq_latency_ns += src->runq_latency_ns;
+
+    if (src->max_runq_latency_ns > dest->max_runq_latency_ns) {
+        dest->max_runq_latency_ns = src->max_runq_latency_ns;
+    }
+}
 
 /*
  * Syscall IDs.
@@ -145,6 +338,7 @@ static inline bool scid_is_vanilla(syscall_id_t scid) {
 #define SCID_PROC_EXIT (0x81U)
 #define SCID_PROC_REAP (0x82U)
 #define SCID_PROC_EXEC (0x83U)
+#define SCID_PROC_SPAWN (0x84U)
 
 /* Signal Syscalls (process adjacent) */
 #define SCID_SIGNAL       (0x90U)
@@ -155,12 +349,22 @@ static inline bool scid_is_vanilla(syscall_id_t scid) {
 /* Process Memory Management */
 #define SCID_MEM_REQUEST  (0xA0U)
 #define SCID_MEM_RETURN   (0xA1U)
+#define SCID_MEM_RESERVE  (0xA2U)
+#define SCID_MEM_KERNEL_STATS (0xA3U)
+#define SCID_MEM_PROC_STATS   (0xA4U)
+#define SCID_MEM_PROC_SET_QUOTA (0xA5U)
+
+/* Time Syscalls */
+#define SCID_CLOCK_INFO (0xB0U)
+#define SCID_SCHED_STATS (0xB1U)
 
 /* Thread Syscalls */
 #define SCID_THREAD_EXIT  (0x100U)
 #define SCID_THREAD_SLEEP (0x101U)
 #define SCID_THREAD_SPAWN (0x102U)
 #define SCID_THREAD_JOIN  (0x103U)
+#define SCID_THREAD_SET_PRIO (0x104U)
+#define SCID_THREAD_SLEEP_UNTIL (0x105U)
 
 /* Default IO Syscalls (See Handle Syscalls) */
 #define SCID_SET_IN_HANDLE  (0x300U)
@@ -318,8 +522,10 @@ typedef int32_t futex_t;
 #define PLG_FS_PCID_GET_CHILD_NAME (5U)
 #define PLG_FS_PCID_FLUSH          (6U)
 #define PLG_FS_PCID_OPEN           (7U)
+#define PLG_FS_PCID_EXEC           (8U)
+#define PLG_FS_PCID_MUNMAP         (9U)
 
-#define PLG_FILE_SYS_NUM_CMDS      (PLG_FS_PCID_OPEN + 1)
+#define PLG_FILE_SYS_NUM_CMDS      (PLG_FS_PCID_MUNMAP + 1)
 
 /*
  * File system plugin handle commands
@@ -327,6 +533,18 @@ typedef int32_t futex_t;
 
 #define PLG_FS_HCID_SEEK           (NUM_DEFAULT_HCIDS + 0U)
 #define PLG_FS_HCID_FLUSH          (NUM_DEFAULT_HCIDS + 1U)
+#define PLG_FS_HCID_EXEC           (NUM_DEFAULT_HCIDS + 2U)
+#define PLG_FS_HCID_MMAP           (NUM_DEFAULT_HCIDS + 3U)
+
+/*
+ * File system mmap flags.
+ *
+ * WRITE: The mapping is writeable, and dirty pages are written back to the file.
+ * PRIVATE: Writes to the mapping are never written back to the file.
+ */
+
+#define PLG_FS_MMAP_FLAG_WRITE     (1U << 0)
+#define PLG_FS_MMAP_FLAG_PRIVATE   (1U << 1)
 
 /*
  * ***** Keyboard Plugin ******
@@ -59,6 +59,28 @@ static inline bool hp_is_empty(heap_t *hp) {
     return hp->tree_len == 0;
 }
 
+/**
+ * Get a pointer to the maximum value in the heap. (Without removing it)
+ *
+ * Returns NULL if the heap is empty.
+ *
+ * NOTE: The returned pointer is only valid until the heap is next modified.
+ */
+static inline void *hp_peek_max(heap_t *hp) {
+    return hp->tree_len > 0 ? hp->buf : NULL;
+}
+
+/**
+ * Get a pointer to the cell at position `pos` in the heap buffer. (See `buf` above)
+ *
+ * Returns NULL if `pos` is out of bounds.
+ *
+ * NOTE: The returned pointer is only valid until the heap is next modified.
+ */
+static inline void *hp_get(heap_t *hp, size_t pos) {
+    return pos < hp->tree_len ? hp->buf + (hp->cell_size * pos) : NULL;
+}
+
 /**
  * Pop the maximum value off the heap.
  *
@@ -70,6 +92,20 @@ static inline bool hp_is_empty(heap_t *hp) {
  */
 bool hp_pop_max(heap_t *hp, void *out);
 
+/**
+ * Remove the value at position `pos` in the heap buffer. (Not necessarily the max)
+ *
+ * This is for when you need to remove a specific value. Positions can be found by searching
+ * through the heap with `hp_get`. NOTE: Removing a value moves other values around, so positions
+ * found before the removal may no longer be correct.
+ *
+ * Returns `true` if a value was removed.
+ * Returns `false` if `pos` is out of bounds.
+ *
+ * `out` is optional, if given, the removed value is written to `out`.
+ */
+bool hp_remove(heap_t *hp, size_t pos, void *out);
+
 /**
  * Push a value onto the heap.
  *
@@ -8,3 +8,9 @@ bool test_basic_wait_queue(void);
 bool test_vector_wait_queue(void);
 
 bool test_timed_wait_queue(void);
+
+/**
+ * Time a timed wait queue holding many sleepers, which are woken and put back to sleep over
+ * many ticks. (Like the kernel's sleep queue) Results are printed with `gfx_direct_put_fmt_s_rr`.
+ */
+void bench_timed_wait_queue(void);
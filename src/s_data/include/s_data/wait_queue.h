@@ -6,6 +6,7 @@
 #include "s_mem/allocator.h"
 #include "s_util/err.h"
 #include "s_data/list.h"
+#include "s_data/heap.h"
 
 /**
  * A wait queue is intended to be used for managing asleep threads in the kernel, but should not
@@ -282,13 +283,26 @@ fernos_error_t vwq_pop(vector_wait_queue_t *vwq, void **item, uint8_t *ready_id)
 typedef struct _twq_wait_pair_t {
     void *item;
 
-    uint32_t wake_time;
+    /**
+     * When `item` becomes ready. This is measured from when the queue was created, so unlike the
+     * times given to the queue, this never wraps.
+     */
+    uint64_t wake_time;
+
+    /**
+     * Items with equal wake times become ready in the order they were enqueued. 
+     * (This is that order)
+     */
+    uint32_t seq;
 } twq_wait_pair_t;
 
 /**
- * A "timed" wait queue is really just a sorted list of items which all
- * hold a wake up time. Items are notified by providing a current time to the queue.
- * The queue then will move items to the ready queue if their wake up times have passed.
+ * A "timed" wait queue holds items which all have a wake up time. Items are notified by providing
+ * a current time to the queue. Items whose wake up times have passed are then ready to be popped.
+ *
+ * Items are kept in a min heap ordered by wake up time. So, enqueuing is O(log n), notifying is 
+ * O(1), and popping is O(log n). Items live directly in the heap buffer, so no allocation is done
+ * per item. (The buffer only grows when the queue holds more items than ever before)
  */
 typedef struct _timed_wait_queue_t {
     wait_queue_t super;
@@ -306,18 +320,22 @@ typedef struct _timed_wait_queue_t {
     uint32_t time;
 
     /**
-     * Sorted list of waiting items.
-     *
-     * List<twq_wait_pair_t *>
+     * How much time has passed since this queue was created. Unlike `time` this doesn't wrap.
+     * 
+     * Items with a `wake_time` <= `elapsed` are ready.
      */
-    list_t *wait_q;
+    uint64_t elapsed;
 
     /**
-     * Items ready to be popped.
-     *
-     * List<void *>
+     * The `seq` given to the next enqueued item.
      */
-    list_t *ready_q;
+    uint32_t next_seq;
+
+    /**
+     * Heap<twq_wait_pair_t> ordered so that the max is the earliest waking item. 
+     * (Both waiting and ready items live here)
+     */
+    heap_t *hp;
 } timed_wait_queue_t;
 
 timed_wait_queue_t *new_timed_wait_queue(allocator_t *al);
@@ -341,9 +359,9 @@ fernos_error_t twq_enqueue(timed_wait_queue_t *twq, void *item, uint32_t wt);
  *
  * curr_time represents the current time.
  *
- * Items will be moved to the ready queue in order of their wake up times.
+ * Items will be ready to pop in order of their wake up times.
  *
- * Returns on error if insufficient resources.
+ * This always succeeds.
  */
 fernos_error_t twq_notify(timed_wait_queue_t *twq, uint32_t curr_time);
 
@@ -358,3 +376,12 @@ fernos_error_t twq_notify(timed_wait_queue_t *twq, uint32_t curr_time);
  * No other errors are returned from this function.
  */
 fernos_error_t twq_pop(timed_wait_queue_t *twq, void **item);
+
+/**
+ * Get how much time must pass before the next waiting item is ready.
+ *
+ * Returns FOS_E_EMPTY if there are no waiting or ready items. (Nothing is written to `time`)
+ *
+ * Returns FOS_E_SUCCESS otherwise. If there already is a ready item, 0 is written to `time`.
+ */
+fernos_error_t twq_time_until_next(timed_wait_queue_t *twq, uint32_t *time);
@@ -33,27 +33,24 @@ void delete_heap(heap_t *hp) {
     al_free(hp->al, hp);
 }
 
-bool hp_pop_max(heap_t *hp, void *out) {
-    if (hp->tree_len == 0) {
-        return false;
-    }
-
-    if (out) {
-        mem_cpy(out, hp->buf + (hp->cell_size * 0), hp->cell_size);
-    }
-
-    if (hp->tree_len > 1) {
-        // If there is more than one element, we must do a shift down!
-        // Essentially swap the last node with the root, then push the last node down. 
+/**
+ * Fill the hole at `curr_pos` with the last cell of the heap, pushing it down as far as needed.
+ * Afterwards the heap has one less cell.
+ *
+ * `curr_pos` must be in bounds, and the last cell must be <= the parent of `curr_pos`.
+ * (i.e. Pushing down is the only direction the last cell may need to move)
+ */
+static void hp_fill_down(heap_t *hp, size_t curr_pos) {
+    if (curr_pos < hp->tree_len - 1) {
+        // Essentially swap the last node into the hole, then push it down. 
      
         uint8_t * const sub = hp->buf + (hp->cell_size * (hp->tree_len - 1));
 
-        size_t curr_pos = 0;
         uint8_t *curr = hp->buf + (hp->cell_size * curr_pos);
 
         // NOTE: During this loop, we consider the cell at position `tree_len - 1` as
         // invalid! (Conceptually, this is the last cell of the heap, which we are now pushing
-        // into the root position)
+        // into the hole)
         while (true) {
             const size_t left_pos = (curr_pos * 2) + 1;
             uint8_t * const left = left_pos < hp->tree_len - 1 
@@ -102,6 +99,60 @@ bool hp_pop_max(heap_t *hp, void *out) {
     }
 
     hp->tree_len--;
+}
+
+bool hp_pop_max(heap_t *hp, void *out) {
+    if (hp->tree_len == 0) {
+        return false;
+    }
+
+    if (out) {
+        mem_cpy(out, hp->buf + (hp->cell_size * 0), hp->cell_size);
+    }
+
+    hp_fill_down(hp, 0);
+
+    return true;
+}
+
+bool hp_remove(heap_t *hp, size_t pos, void *out) {
+    if (pos >= hp->tree_len) {
+        return false;
+    }
+
+    uint8_t *curr = hp->buf + (hp->cell_size * pos);
+
+    if (out) {
+        mem_cpy(out, curr, hp->cell_size);
+    }
+
+    uint8_t * const sub = hp->buf + (hp->cell_size * (hp->tree_len - 1));
+
+    // If the last cell is greater than the parent of the hole, it must move up instead of down.
+    // (The last cell is never an ancestor of the hole, so it is safe to shift parents down)
+    if (pos > 0 && hp->cmp(sub, hp->buf + (hp->cell_size * ((pos - 1) / 2))) > 0) {
+        while (pos > 0) {
+            const size_t parent_pos = (pos - 1) / 2;
+            uint8_t * const parent = hp->buf + (hp->cell_size * parent_pos);
+
+            if (hp->cmp(parent, sub) >= 0) {
+                break;
+            }
+
+            mem_cpy(curr, parent, hp->cell_size);
+
+            pos = parent_pos;
+            curr = parent;
+        }
+
+        mem_cpy(curr, sub, hp->cell_size);
+        hp->tree_len--;
+
+        return true;
+    }
+
+    hp_fill_down(hp, pos);
+
     return true;
 }
 
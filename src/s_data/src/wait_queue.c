@@ -320,16 +320,32 @@ static const wait_queue_impl_t TWQ_IMPL = {
     .wq_dump = NULL // Maybe implement one day.
 };
 
+/**
+ * The heap is a max heap, so earlier wake times compare as greater.
+ */
+static int32_t twq_pair_cmp(const void *k0, const void *k1) {
+    const twq_wait_pair_t *p0 = (const twq_wait_pair_t *)k0;
+    const twq_wait_pair_t *p1 = (const twq_wait_pair_t *)k1;
+
+    if (p0->wake_time != p1->wake_time) {
+        return p0->wake_time < p1->wake_time ? 1 : -1;
+    }
+
+    // Sequence numbers can wrap, but not while two items are both in the queue.
+    const int32_t seq_diff = (int32_t)(p1->seq - p0->seq);
+
+    return seq_diff > 0 ? 1 : (seq_diff < 0 ? -1 : 0);
+}
+
 timed_wait_queue_t *new_timed_wait_queue(allocator_t *al) {
     timed_wait_queue_t *twq = al_malloc(al, sizeof(timed_wait_queue_t));
+    heap_t *hp = new_heap(al, sizeof(twq_wait_pair_t), twq_pair_cmp);
 
-    list_t *wait_q = new_linked_list(al, sizeof(twq_wait_pair_t));
-    list_t *ready_q = new_linked_list(al, sizeof(void *));
-
-    if (!twq || !wait_q || !ready_q) {
+    if (!twq || !hp) {
         al_free(al, twq);
-        delete_list(wait_q);
-        delete_list(ready_q);
+        if (hp) {
+            delete_heap(hp);
+        }
 
         return NULL;
     }
@@ -338,8 +354,9 @@ timed_wait_queue_t *new_timed_wait_queue(allocator_t *al) {
 
     twq->al = al;
     twq->time = 0;
-    twq->wait_q = wait_q;
-    twq->ready_q = ready_q;
+    twq->elapsed = 0;
+    twq->next_seq = 0;
+    twq->hp = hp;
 
     return twq;
 }
@@ -347,8 +364,7 @@ timed_wait_queue_t *new_timed_wait_queue(allocator_t *al) {
 static void delete_timed_wait_queue(wait_queue_t *wq) {
     timed_wait_queue_t *twq = (timed_wait_queue_t *)wq;
 
-    delete_list(twq->wait_q);
-    delete_list(twq->ready_q);
+    delete_heap(twq->hp);
     al_free(twq->al, twq);
 }
 
@@ -368,111 +384,74 @@ static uint32_t abs_wait_time(uint32_t curr_time, uint32_t wake_time) {
 }
 
 fernos_error_t twq_enqueue(timed_wait_queue_t *twq, void *item, uint32_t wt) {
-    // If wake time is current time, move to the ready queue immediately.
-    if (wt == twq->time) {
-        return l_push_back(twq->ready_q, &item);
-    }
-
-    fernos_error_t err;
-
+    // NOTE: If wake time is current time, the item is ready immediately.
     twq_wait_pair_t new_pair = {
         .item = item,
-        .wake_time = wt
+        .wake_time = twq->elapsed + abs_wait_time(twq->time, wt),
+        .seq = twq->next_seq
     };
 
-    // Number of ticks until our new pair wakes up!
-    uint32_t np_abs_wait = abs_wait_time(twq->time, new_pair.wake_time);
-
-    l_reset_iter(twq->wait_q);
-    twq_wait_pair_t *iter;
-    for (iter = (twq_wait_pair_t *)l_get_iter(twq->wait_q); iter; 
-            iter = (twq_wait_pair_t *)l_next_iter(twq->wait_q)) {
-        uint32_t iter_abs_wait = abs_wait_time(twq->time, iter->wake_time);
-
-        if (np_abs_wait < iter_abs_wait) {
-            err = l_push_before_iter(twq->wait_q, &new_pair);
-            break;
-        }
-    }
-
-    if (!iter) { 
-        err = l_push_back(twq->wait_q, &new_pair);
+    fernos_error_t err = hp_push(twq->hp, &new_pair);
+    if (err == FOS_E_SUCCESS) {
+        twq->next_seq++;
     }
 
     return err;
 }
 
 fernos_error_t twq_notify(timed_wait_queue_t *twq, uint32_t curr_time) {
-    fernos_error_t err = FOS_E_SUCCESS;
+    twq->elapsed += abs_wait_time(twq->time, curr_time);
+    twq->time = curr_time;
 
-    uint32_t ticks_passed = abs_wait_time(twq->time, curr_time);
+    return FOS_E_SUCCESS;
+}
 
-    while (l_get_len(twq->wait_q) > 0) {
-        twq_wait_pair_t *head = (twq_wait_pair_t *)l_get_ptr(twq->wait_q, 0);
-        
-        uint32_t ticks_needed = abs_wait_time(twq->time, head->wake_time);
+fernos_error_t twq_pop(timed_wait_queue_t *twq, void **item) {
+    twq_wait_pair_t *head = hp_peek_max(twq->hp);
 
-        // If we've waited long enough, we can move our item to the ready queue!
-        if (ticks_needed <= ticks_passed) {
-            err = l_push_back(twq->ready_q, &(head->item));
+    if (!head || head->wake_time > twq->elapsed) {
+        if (item) {
+            *item = NULL;
+        }
 
-            // If the push fails, just error out where we are.
-            if (err != FOS_E_SUCCESS) {
-                break;
-            }
+        return FOS_E_EMPTY;
+    }
 
-            // If our push succeeded, then do the pop. (Which will always succeed.)
-            l_pop_front(twq->wait_q, NULL);
-        } else {
-            // If we've reached an item which must still sleep, we know all remaining 
-            // items must also still sleep. We can exit the loop early.
-            break;
-        }
+    if (item) {
+        *item = head->item;
     }
 
-    // Right now, we always set the time, even in case of error.
-    // So, just know that when a memory error occurs, the state of the queue could be slightly
-    // funky. In this case, you should really just dispose of the queue.
-    twq->time = curr_time;
+    hp_pop_max(twq->hp, NULL);
 
-    return err;
+    return FOS_E_SUCCESS;
 }
 
-fernos_error_t twq_pop(timed_wait_queue_t *twq, void **item) {
-    if (l_get_len(twq->ready_q) == 0) {
+fernos_error_t twq_time_until_next(timed_wait_queue_t *twq, uint32_t *time) {
+    twq_wait_pair_t *head = hp_peek_max(twq->hp);
+
+    if (!head) {
         return FOS_E_EMPTY;
     }
 
-    l_pop_front(twq->ready_q, item);                
+    // Wake times are always less than 2^32 ahead of `elapsed`.
+    *time = head->wake_time > twq->elapsed ? (uint32_t)(head->wake_time - twq->elapsed) : 0;
+
     return FOS_E_SUCCESS;
 }
 
 static void twq_remove(wait_queue_t *wq, void *item) {
     timed_wait_queue_t *twq = (timed_wait_queue_t *)wq;
 
+    size_t pos = 0;
     twq_wait_pair_t *p;
 
-    l_reset_iter(twq->wait_q);
-    p = (twq_wait_pair_t *)l_get_iter(twq->wait_q);
-    while (p) {
+    while ((p = hp_get(twq->hp, pos))) {
         if (p->item == item) {
-            l_pop_iter(twq->wait_q, NULL);
-            p = (twq_wait_pair_t *)l_get_iter(twq->wait_q);
-        } else {
-            p = (twq_wait_pair_t *)l_next_iter(twq->wait_q);
-        }
-    }
-
-    void **i;
-
-    l_reset_iter(twq->ready_q);
-    i = (void **)l_get_iter(twq->ready_q);
-    while (i) {
-        if (*i == item) {
-            l_pop_iter(twq->ready_q, NULL);
-            i = (void **)l_get_iter(twq->ready_q);
+            // Removal can move pairs to earlier positions, so just start over.
+            hp_remove(twq->hp, pos, NULL);
+            pos = 0;
         } else {
-            i = (void **)l_next_iter(twq->ready_q);
+            pos++;
         }
     }
 }
@@ -133,6 +133,62 @@ static bool test_heap_misc(void) {
     TEST_SUCCEED();
 }
 
+/**
+ * Confirm every cell in the heap is <= its parent.
+ */
+static bool check_heap_order(heap_t *hp) {
+    for (size_t pos = 1; pos < hp->tree_len; pos++) {
+        TEST_TRUE(hp->cmp(hp_get(hp, (pos - 1) / 2), hp_get(hp, pos)) >= 0);
+    }
+
+    TEST_SUCCEED();
+}
+
+static bool test_heap_remove(void) {
+    heap_t *hp = new_da_heap(sizeof(int32_t), int_cmp);
+    TEST_TRUE(hp != NULL);
+
+    TEST_EQUAL_HEX(NULL, hp_peek_max(hp));
+    TEST_FALSE(hp_remove(hp, 0, NULL));
+
+    for (int32_t i = 0; i < 64; i++) {
+        const int32_t val = (i * 37) % 64;
+        TEST_SUCCESS(hp_push(hp, &val));
+    }
+
+    TEST_EQUAL_INT(63, *(int32_t *)hp_peek_max(hp));
+    TEST_EQUAL_HEX(NULL, hp_get(hp, 64));
+    TEST_FALSE(hp_remove(hp, 64, NULL));
+
+    // Remove all multiples of 3 from wherever they are in the heap.
+    for (int32_t val = 0; val < 64; val += 3) {
+        size_t pos = 0;
+        while (*(int32_t *)hp_get(hp, pos) != val) {
+            pos++;
+        }
+
+        int32_t removed;
+        TEST_TRUE(hp_remove(hp, pos, &removed));
+        TEST_EQUAL_INT(val, removed);
+
+        TEST_TRUE(check_heap_order(hp));
+    }
+
+    for (int32_t val = 63; val >= 0; val--) {
+        if (val % 3 != 0) {
+            int32_t popped;
+            TEST_TRUE(hp_pop_max(hp, &popped));
+            TEST_EQUAL_INT(val, popped);
+        }
+    }
+
+    TEST_TRUE(hp_is_empty(hp));
+
+    delete_heap(hp);
+
+    TEST_SUCCEED();
+}
+
 typedef struct _test_range_t {
     int32_t s;
     int32_t e;
@@ -209,6 +265,7 @@ bool test_heap(void) {
     RUN_TEST(test_int_heap0);
     RUN_TEST(test_int_heap1);
     RUN_TEST(test_heap_misc);
+    RUN_TEST(test_heap_remove);
     RUN_TEST(test_big_heap);
     return END_SUITE();
 }
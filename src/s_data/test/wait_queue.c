@@ -4,6 +4,8 @@
 
 #include "k_startup/gfx.h"
 #include "s_util/err.h"
+#include "s_util/misc.h"
+#include "s_util/rand.h"
 #include <stdint.h>
 
 
@@ -691,6 +693,35 @@ static bool test_twq_wrap(void) {
     TEST_SUCCEED();
 }
 
+static bool test_twq_time_until_next(void) {
+    timed_wait_queue_t *twq = new_da_timed_wait_queue();
+    TEST_TRUE(twq != NULL);
+
+    uint32_t time;
+
+    TEST_EQUAL_HEX(FOS_E_EMPTY, twq_time_until_next(twq, &time));
+
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_notify(twq, UINT32_MAX - 1));
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_enqueue(twq, (void *)1, 5));
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_enqueue(twq, (void *)2, 2));
+
+    // Wake times wrap around.
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_time_until_next(twq, &time));
+    TEST_EQUAL_UINT(4, time);
+
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_notify(twq, 2));
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_time_until_next(twq, &time));
+    TEST_EQUAL_UINT(0, time);
+
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_pop(twq, NULL));
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, twq_time_until_next(twq, &time));
+    TEST_EQUAL_UINT(3, time);
+
+    delete_wait_queue((wait_queue_t *)twq);
+
+    TEST_SUCCEED();
+}
+
 static bool test_twq_complex0(void) {
     timed_wait_queue_t *twq = new_da_timed_wait_queue();
     TEST_TRUE(twq != NULL);
@@ -789,9 +820,57 @@ bool test_timed_wait_queue(void) {
     RUN_TEST(test_twq_simple0);
     RUN_TEST(test_twq_simple1);
     RUN_TEST(test_twq_wrap);
+    RUN_TEST(test_twq_time_until_next);
     RUN_TEST(test_twq_complex0);
     RUN_TEST(test_twq_remove);
 
     return END_SUITE();
 }
 
+#define BENCH_TWQ_SLEEPERS  (512U)
+#define BENCH_TWQ_TICKS     (1024U)
+#define BENCH_TWQ_MAX_SLEEP (64U)
+
+void bench_timed_wait_queue(void) {
+    LOGF_METHOD("Timed Wait Queue Benchmark (%u sleepers, %u ticks, KCycles)\n", 
+            BENCH_TWQ_SLEEPERS, BENCH_TWQ_TICKS);
+
+    timed_wait_queue_t *twq = new_da_timed_wait_queue();
+    if (!twq) {
+        return;
+    }
+
+    rand_t r = rand(0);
+
+    uint64_t start = read_tsc();
+    for (uint32_t i = 0; i < BENCH_TWQ_SLEEPERS; i++) {
+        if (twq_enqueue(twq, (void *)i, 1 + (next_rand_u32(&r) % BENCH_TWQ_MAX_SLEEP)) != FOS_E_SUCCESS) {
+            delete_wait_queue((wait_queue_t *)twq);
+            return;
+        }
+    }
+    const uint32_t enqueue_kc = (uint32_t)((read_tsc() - start) >> 10);
+
+    // Every tick, wake up whoever is due, and put them right back to sleep.
+    uint32_t wakes = 0;
+
+    start = read_tsc();
+    for (uint32_t t = 1; t <= BENCH_TWQ_TICKS; t++) {
+        twq_notify(twq, t);
+
+        void *item;
+        while (twq_pop(twq, &item) == FOS_E_SUCCESS) {
+            wakes++;
+            if (twq_enqueue(twq, item, t + 1 + (next_rand_u32(&r) % BENCH_TWQ_MAX_SLEEP)) != FOS_E_SUCCESS) {
+                delete_wait_queue((wait_queue_t *)twq);
+                return;
+            }
+        }
+    }
+    const uint32_t ticks_kc = (uint32_t)((read_tsc() - start) >> 10);
+
+    LOGF_METHOD("Enqueue: %u\n", enqueue_kc);
+    LOGF_METHOD("Ticks:   %u (%u wake ups)\n", ticks_kc, wakes);
+
+    delete_wait_queue((wait_queue_t *)twq);
+}
@@ -122,6 +122,99 @@ static inline size_t validate_mb_size(size_t mb_size) {
     return mbs;
 }
 
+/**
+ * Number of size classes used for allocation statistics.
+ *
+ * Class 0 counts requests of 1-8 bytes, class 1 counts 9-16 bytes, class 2 counts 17-32 bytes,
+ * and so on. The last class counts everything which doesn't fit in an earlier class.
+ */
+#define AL_STATS_NUM_CLASSES (16U)
+
+/**
+ * Get the statistics size class of a request of `bytes` bytes.
+ */
+static inline uint32_t al_stats_class(size_t bytes) {
+    if (bytes <= 8) {
+        return 0;
+    }
+
+    const uint32_t c = (32 - __builtin_clz(bytes - 1)) - 3;
+    return c < AL_STATS_NUM_CLASSES ? c : AL_STATS_NUM_CLASSES - 1;
+}
+
+/**
+ * Live counters describing an allocator.
+ *
+ * NOTE: The kernel hands these out to userspace as a `heap_stats_t` (See s_bridge), keep the two
+ * in sync when adding fields.
+ */
+typedef struct _allocator_stats_t {
+    /**
+     * Bytes currently held by user blocks. (Includes rounding done by the allocator, but not
+     * the allocator's own bookkeeping)
+     */
+    uint32_t bytes_in_use;
+
+    /**
+     * The largest `bytes_in_use` has ever been.
+     */
+    uint32_t peak_bytes_in_use;
+
+    /**
+     * Bytes currently requested from the memory manager.
+     */
+    uint32_t bytes_mapped;
+
+    /**
+     * Same as `al_num_user_blocks`.
+     */
+    uint32_t num_user_blocks;
+
+    /**
+     * Free blocks currently available to the allocator. (i.e. the total length of its free lists)
+     */
+    uint32_t num_free_blocks;
+    uint32_t bytes_free;
+
+    /**
+     * Every call to malloc, including those which fail.
+     */
+    uint32_t num_mallocs;
+    uint32_t num_failed_mallocs;
+    uint32_t num_reallocs;
+    uint32_t num_frees;
+
+    /**
+     * Total number of free blocks looked at while searching for a block to allocate.
+     *
+     * `num_blocks_searched / num_mallocs` is the average search length.
+     */
+    uint32_t num_blocks_searched;
+
+    /**
+     * Number of malloc calls in each size class. (See `al_stats_class`)
+     */
+    uint32_t mallocs_per_class[AL_STATS_NUM_CLASSES];
+} allocator_stats_t;
+
+/**
+ * Count a single malloc request in `stats`.
+ */
+static inline void al_stats_count_malloc(allocator_stats_t *stats, size_t bytes) {
+    stats->num_mallocs++;
+    stats->mallocs_per_class[al_stats_class(bytes)]++;
+}
+
+/**
+ * Add `bytes` to the in use count of `stats`, bumping the peak if needed.
+ */
+static inline void al_stats_add_in_use(allocator_stats_t *stats, size_t bytes) {
+    stats->bytes_in_use += bytes;
+    if (stats->bytes_in_use > stats->peak_bytes_in_use) {
+        stats->peak_bytes_in_use = stats->bytes_in_use;
+    }
+}
+
 /**
  * An allocator is something used to request dynamic memory.
  *
@@ -140,6 +233,12 @@ typedef struct _allocator_impl_t {
     // OPTIONAL
     void (*al_dump)(allocator_t *al, void (*pf)(const char *fmt, ...));
 
+    // OPTIONAL
+    size_t (*al_trim)(allocator_t *al);
+
+    // OPTIONAL
+    void (*al_stats)(allocator_t *al, allocator_stats_t *stats);
+
     void (*delete_allocator)(allocator_t *al);
 } allocator_impl_t;
 
@@ -216,6 +315,42 @@ static inline void al_dump(allocator_t *al, void (*pf)(const char *fmt, ...)) {
     al->impl->al_dump(al, pf);
 }
 
+/**
+ * Give as much unused memory as possible back to whoever provided it. (For example, the
+ * `return_mem` function of a memory manager pair)
+ *
+ * This is completely optional, allocators which don't support trimming do nothing.
+ *
+ * Returns the number of bytes returned.
+ */
+static inline size_t al_trim(allocator_t *al) {
+    if (!(al->impl->al_trim)) {
+        return 0;
+    }
+
+    return al->impl->al_trim(al);
+}
+
+/**
+ * Write the allocator's current statistics to `*stats`.
+ *
+ * This is also optional. FOS_E_NOT_IMPLEMENTED is returned if the allocator doesn't keep
+ * statistics. (In which case `*stats` is left untouched)
+ */
+static inline fernos_error_t al_stats(allocator_t *al, allocator_stats_t *stats) {
+    if (!stats) {
+        return FOS_E_BAD_ARGS;
+    }
+
+    if (!(al->impl->al_stats)) {
+        return FOS_E_NOT_IMPLEMENTED;
+    }
+
+    al->impl->al_stats(al, stats);
+
+    return FOS_E_SUCCESS;
+}
+
 /**
  * Delete the allocator.
  */
@@ -259,3 +394,11 @@ static inline void da_free(void *ptr) {
 static inline void da_dump(void (*pf)(const char *fmt, ...)) {
     al_dump(get_default_allocator(), pf);
 }
+
+static inline size_t da_trim(void) {
+    return al_trim(get_default_allocator());
+}
+
+static inline fernos_error_t da_stats(allocator_stats_t *stats) {
+    return al_stats(get_default_allocator(), stats);
+}
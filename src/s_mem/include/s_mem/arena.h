@@ -0,0 +1,57 @@
+
+#pragma once
+
+#include "s_mem/allocator.h"
+#include "s_util/err.h"
+
+/*
+ * An arena allocator hands out memory by just bumping a pointer.
+ *
+ * Freeing a block gives no memory back, EXCEPT in two cases:
+ * 1) The block freed was the most recently allocated block. (The bump pointer is moved back)
+ * 2) The block freed was the last live block in the arena. (The whole arena is reset)
+ *
+ * This is meant for scratch memory which is allocated and then freed shortly after. (For example
+ * within a single system call)
+ *
+ * Pages are requested as the bump pointer advances, and are only returned when the arena is
+ * trimmed or deleted. So, after the first few uses, allocation never touches the memory manager.
+ */
+
+typedef struct _arena_attrs_t {
+    /**
+     * Start of the arena region. (4K Aligned)
+     *
+     * The arena's bookkeeping lives at the start of this region.
+     */
+    void *start;
+
+    /**
+     * Exclusive end of the arena region. (4K Aligned)
+     */
+    const void *end;
+
+    /**
+     * Functions used for requesting and returning memory.
+     */
+    mem_manage_pair_t mmp;
+} arena_attrs_t;
+
+/**
+ * Create a new arena allocator.
+ *
+ * It is expected that the entire region is unallocated when this function is called.
+ *
+ * Returns NULL on error.
+ */
+allocator_t *new_arena_allocator(arena_attrs_t attrs);
+
+/**
+ * Free every block in the arena at once. This is O(1).
+ *
+ * All pointers previously returned by the arena become invalid!
+ * Mapped pages are kept for future allocations.
+ *
+ * `al` MUST be an arena allocator.
+ */
+void arena_reset(allocator_t *al);
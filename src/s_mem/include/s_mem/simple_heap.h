@@ -50,6 +50,28 @@ typedef struct _simple_heap_attrs_t {
      */
     size_t large_fl_search_amt;
 
+    /**
+     * When true, the two free lists above are replaced by segregated power-of-two bins.
+     * (`small_fl_cutoff`, `small_fl_search_amt` and `large_fl_search_amt` are then ignored)
+     *
+     * Bin `i` holds all free blocks with sizes in [2^i, 2^(i+1)). A bitmap tracks which bins
+     * are non-empty. An allocation of `n` bytes takes the first block of the smallest non-empty
+     * bin whose blocks are all at least `n` bytes. If no such bin exists, the bin which `n` 
+     * falls into is searched before growing the heap. This avoids long free list scans once the
+     * heap fragments.
+     */
+    bool segregated;
+
+    /**
+     * When a free leaves a free block at the very top of the heap which is at least this many
+     * bytes, the heap is trimmed automatically. (i.e. the pages under the top free block are
+     * returned with `mmp.return_mem` and the break pointer moves down)
+     *
+     * 0 means the heap is never trimmed automatically. (`al_trim` can always be used to trim
+     * explicitly)
+     */
+    size_t trim_threshold;
+
     /*
      * When the request mem call fails (Meaning we have occupied the entire region)....
      *
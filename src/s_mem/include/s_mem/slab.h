@@ -0,0 +1,68 @@
+
+#pragma once
+
+#include "s_mem/allocator.h"
+#include "s_mem/simple_heap.h"
+#include "s_util/err.h"
+
+/*
+ * A slab allocator serves small allocations out of fixed size "size classes".
+ *
+ * Every size class has its own set of 4K slab pages. Each slab page is cut into equally sized
+ * objects, which are handed out from a per page free list. This means no boundary tags and no
+ * free list searching for small objects. (Which the kernel allocates A LOT of)
+ *
+ * Allocations larger than the largest size class are handed off to a simple heap which the
+ * slab allocator owns.
+ */
+
+/**
+ * The object sizes of each size class, in ascending order.
+ *
+ * All sizes are multiples of 8.
+ */
+#define SLAB_CLASS_SIZES { \
+    8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512 \
+}
+
+#define SLAB_NUM_CLASSES (12U)
+#define SLAB_MAX_OBJ_SIZE (512U)
+
+/**
+ * All attributes are required to be specified!
+ */
+typedef struct _slab_attrs_t {
+    /**
+     * Start of the slab region. (4K Aligned)
+     *
+     * The first page of this region holds the allocator itself.
+     */
+    void *start;
+
+    /**
+     * Exclusive end of the slab region. (4K Aligned)
+     */
+    const void *end;
+
+    /**
+     * Functions used for requesting and returning slab pages.
+     */
+    mem_manage_pair_t mmp;
+
+    /**
+     * Attributes of the simple heap used for allocations larger than `SLAB_MAX_OBJ_SIZE`.
+     *
+     * The region of this simple heap must NOT overlap with the slab region!
+     */
+    simple_heap_attrs_t large_attrs;
+} slab_attrs_t;
+
+/**
+ * Create a new slab allocator.
+ *
+ * It is expected that the entire slab region and the entire large region are unallocated when
+ * this function is called.
+ *
+ * Returns NULL if the attributes are invalid, or if the initial memory requests fail.
+ */
+allocator_t *new_slab_allocator(slab_attrs_t attrs);
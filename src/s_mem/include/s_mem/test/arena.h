@@ -0,0 +1,11 @@
+
+#pragma once
+
+#include "s_mem/allocator.h"
+
+/**
+ * Run arena allocator tests with a memory manager pair.
+ *
+ * This runs the generic allocator suite, followed by arena specific tests.
+ */
+void test_arena(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...));
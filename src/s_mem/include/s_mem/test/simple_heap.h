@@ -7,3 +7,11 @@
  * Run simple heap tests which a memory manager pair.
  */
 void test_shal(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...));
+
+/**
+ * Run a fragmentation heavy trace against a few simple heap configurations. (Including the
+ * segregated configuration)
+ *
+ * The time taken and the amount of memory requested by each heap are printed with `logf`.
+ */
+void bench_shal(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...));
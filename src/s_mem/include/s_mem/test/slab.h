@@ -0,0 +1,15 @@
+
+#pragma once
+
+#include "s_mem/allocator.h"
+
+/**
+ * Run slab allocator tests with a memory manager pair.
+ */
+void test_slab(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...));
+
+/**
+ * Compare the throughput of the slab allocator against the simple heap allocator for
+ * small object allocations. Results are printed with `logf`.
+ */
+void bench_slab(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...));
@@ -0,0 +1,280 @@
+
+#include "s_mem/arena.h"
+#include "s_mem/allocator.h"
+#include "s_util/err.h"
+#include "s_util/misc.h"
+#include "s_util/str.h"
+
+static void *arena_malloc(allocator_t *al, size_t bytes);
+static void *arena_realloc(allocator_t *al, void *ptr, size_t bytes);
+static void arena_free(allocator_t *al, void *ptr);
+static size_t arena_num_user_blocks(allocator_t *al);
+static void arena_dump(allocator_t *al, void (*pf)(const char *fmt, ...));
+static size_t arena_trim(allocator_t *al);
+static void delete_arena_allocator(allocator_t *al);
+
+static const allocator_impl_t ARENA_ALLOCATOR_IMPL = {
+    .al_malloc = arena_malloc,
+    .al_realloc = arena_realloc,
+    .al_free = arena_free,
+    .al_num_user_blocks = arena_num_user_blocks,
+    .al_dump = arena_dump,
+    .al_trim = arena_trim,
+    .delete_allocator = delete_arena_allocator
+};
+
+/**
+ * Every block is preceded by one of these. (Padded to keep blocks 8 byte aligned)
+ *
+ * The size is needed for `realloc`.
+ */
+typedef struct _arena_block_hdr_t {
+    uint32_t size;
+    uint32_t pad;
+} arena_block_hdr_t;
+
+typedef struct _arena_allocator_t {
+    allocator_t super;
+    const arena_attrs_t attrs;
+
+    /**
+     * Where the first block goes.
+     */
+    uint8_t * const arena_start;
+
+    /**
+     * Exclusive end of the used part of the arena.
+     */
+    uint8_t *bump_ptr;
+
+    /**
+     * Exclusive end of the mapped part of the arena. (4K aligned)
+     */
+    const void *brk_ptr;
+
+    /**
+     * The most recently allocated block which is still live, NULL if unknown.
+     */
+    void *last_block;
+
+    size_t num_user_blocks;
+} arena_allocator_t;
+
+allocator_t *new_arena_allocator(arena_attrs_t attrs) {
+    if (!IS_ALIGNED(attrs.start, M_4K) || !IS_ALIGNED(attrs.end, M_4K)) {
+        return NULL;
+    }
+
+    if (attrs.end <= attrs.start) {
+        return NULL;
+    }
+
+    if (!attrs.mmp.request_mem || !attrs.mmp.return_mem) {
+        return NULL;
+    }
+
+    fernos_error_t err;
+
+    const void *true_e;
+    err = attrs.mmp.request_mem(attrs.start, (uint8_t *)(attrs.start) + M_4K, &true_e);
+    if (err != FOS_E_SUCCESS) {
+        return NULL;
+    }
+
+    arena_allocator_t *arena = (arena_allocator_t *)(attrs.start);
+
+    *(const allocator_impl_t **)&(arena->super.impl) = &ARENA_ALLOCATOR_IMPL;
+    *(arena_attrs_t *)&(arena->attrs) = attrs;
+    *(uint8_t **)&(arena->arena_start) = (uint8_t *)ALIGN_UP((uint32_t)(arena + 1), 8);
+
+    arena->bump_ptr = arena->arena_start;
+    arena->brk_ptr = true_e;
+    arena->last_block = NULL;
+    arena->num_user_blocks = 0;
+
+    return (allocator_t *)arena;
+}
+
+void arena_reset(allocator_t *al) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+
+    arena->bump_ptr = arena->arena_start;
+    arena->last_block = NULL;
+    arena->num_user_blocks = 0;
+}
+
+/**
+ * Make sure everything below `new_bump` is mapped.
+ *
+ * Returns true if this succeeds.
+ */
+static bool arena_ensure_mapped(arena_allocator_t *arena, const uint8_t *new_bump) {
+    if ((const void *)new_bump <= arena->brk_ptr) {
+        return true;
+    }
+
+    if ((const void *)new_bump > arena->attrs.end) {
+        return false;
+    }
+
+    const void *new_brk = (const void *)ALIGN_UP((uint32_t)new_bump, M_4K);
+
+    const void *true_e;
+    arena->attrs.mmp.request_mem((void *)(arena->brk_ptr), new_brk, &true_e);
+
+    // Keep whatever we got, even on failure.
+    if (arena->brk_ptr < true_e) {
+        arena->brk_ptr = true_e;
+    }
+
+    return (const void *)new_bump <= arena->brk_ptr;
+}
+
+static inline arena_block_hdr_t *arena_block_get_hdr(void *block) {
+    return (arena_block_hdr_t *)block - 1;
+}
+
+static void *arena_malloc(allocator_t *al, size_t bytes) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+
+    if (bytes == 0) {
+        return NULL;
+    }
+
+    // Also guards against `bytes` being so large that it wraps around.
+    if (bytes > (uint32_t)(arena->attrs.end) - (uint32_t)(arena->bump_ptr)) {
+        return NULL;
+    }
+
+    const size_t size = ALIGN_UP(bytes, 8);
+    uint8_t *new_bump = arena->bump_ptr + sizeof(arena_block_hdr_t) + size;
+
+    if (!arena_ensure_mapped(arena, new_bump)) {
+        return NULL;
+    }
+
+    arena_block_hdr_t *hdr = (arena_block_hdr_t *)(arena->bump_ptr);
+    hdr->size = size;
+
+    arena->bump_ptr = new_bump;
+    arena->last_block = hdr + 1;
+    arena->num_user_blocks++;
+
+    return hdr + 1;
+}
+
+static void arena_free(allocator_t *al, void *ptr) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+
+    if (!ptr) {
+        return;
+    }
+
+    if ((uint8_t *)ptr < arena->arena_start || arena->bump_ptr <= (uint8_t *)ptr) {
+        return; // Not in the arena!
+    }
+
+    if (arena->num_user_blocks == 0) {
+        return;
+    }
+
+    arena->num_user_blocks--;
+
+    if (arena->num_user_blocks == 0) {
+        arena_reset(al);
+    } else if (ptr == arena->last_block) {
+        // We don't know what the block before this one is.
+        arena->bump_ptr = (uint8_t *)arena_block_get_hdr(ptr);
+        arena->last_block = NULL;
+    }
+}
+
+static void *arena_realloc(allocator_t *al, void *ptr, size_t bytes) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+
+    if (!ptr) {
+        return arena_malloc(al, bytes);
+    }
+
+    if (bytes == 0) {
+        arena_free(al, ptr);
+        return NULL;
+    }
+
+    if ((uint8_t *)ptr < arena->arena_start || arena->bump_ptr <= (uint8_t *)ptr) {
+        return NULL; // Not in the arena!
+    }
+
+    arena_block_hdr_t *hdr = arena_block_get_hdr(ptr);
+
+    if (bytes <= hdr->size) {
+        return ptr; // Nothing to do for a shrink.
+    }
+
+    // The most recent block can just be stretched.
+    if (ptr == arena->last_block &&
+            bytes <= (uint32_t)(arena->attrs.end) - (uint32_t)ptr) {
+        const size_t size = ALIGN_UP(bytes, 8);
+        uint8_t *new_bump = (uint8_t *)ptr + size;
+
+        if (arena_ensure_mapped(arena, new_bump)) {
+            hdr->size = size;
+            arena->bump_ptr = new_bump;
+
+            return ptr;
+        }
+
+        return NULL;
+    }
+
+    void *new_ptr = arena_malloc(al, bytes);
+    if (!new_ptr) {
+        return NULL;
+    }
+
+    mem_cpy(new_ptr, ptr, hdr->size);
+    arena_free(al, ptr);
+
+    return new_ptr;
+}
+
+static size_t arena_num_user_blocks(allocator_t *al) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+    return arena->num_user_blocks;
+}
+
+static void arena_dump(allocator_t *al, void (*pf)(const char *fmt, ...)) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+
+    pf("Arena Allocator\n");
+    dump_hex_pairs(pf,
+        "Ar", arena->arena_start,
+        "Bp", arena->bump_ptr,
+        "Br", arena->brk_ptr,
+        "End", arena->attrs.end
+    );
+    pf("\n");
+    pf("User blocks: %u\n", arena->num_user_blocks);
+}
+
+static size_t arena_trim(allocator_t *al) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+
+    const void *new_brk = (const void *)ALIGN_UP((uint32_t)(arena->bump_ptr), M_4K);
+    if (new_brk >= arena->brk_ptr) {
+        return 0;
+    }
+
+    const size_t trimmed = (uint32_t)(arena->brk_ptr) - (uint32_t)new_brk;
+
+    arena->attrs.mmp.return_mem((void *)new_brk, arena->brk_ptr);
+    arena->brk_ptr = new_brk;
+
+    return trimmed;
+}
+
+static void delete_arena_allocator(allocator_t *al) {
+    arena_allocator_t *arena = (arena_allocator_t *)al;
+
+    arena->attrs.mmp.return_mem(arena->attrs.start, arena->brk_ptr);
+}
@@ -14,6 +14,8 @@ static void *shal_realloc(allocator_t *al, void *ptr, size_t bytes);
 static void shal_free(allocator_t *al, void *ptr);
 static size_t shal_num_user_blocks(allocator_t *al);
 static void shal_dump(allocator_t *al, void (*pf)(const char *fmt, ...));
+static size_t shal_trim(allocator_t *al);
+static void shal_stats(allocator_t *al, allocator_stats_t *stats);
 static void delete_simple_heap_allocator(allocator_t *al);
 
 static const allocator_impl_t SHAL_ALLOCATOR_IMPL = {
@@ -22,9 +24,20 @@ static const allocator_impl_t SHAL_ALLOCATOR_IMPL = {
     .al_free = shal_free,
     .al_num_user_blocks = shal_num_user_blocks,
     .al_dump = shal_dump,
+    .al_trim = shal_trim,
+    .al_stats = shal_stats,
     .delete_allocator = delete_simple_heap_allocator
 };
 
+/**
+ * One bin for every possible power of two.
+ */
+#define SHAL_NUM_BINS (32U)
+
+static inline uint32_t shal_bin_index(size_t size) {
+    return 31 - __builtin_clz(size);
+}
+
 typedef struct _simple_heap_allocator_t {
     allocator_t super;
     const simple_heap_attrs_t attrs;
@@ -74,8 +87,24 @@ typedef struct _simple_heap_allocator_t {
      */
     free_block_t *small_fl_head;
     free_block_t *large_fl_head;
+
+    /**
+     * Only used when `attrs.segregated` is true. (See `simple_heap_attrs_t`)
+     *
+     * Bit `i` of `bin_bitmap` is set if and only if `bins[i]` is non-empty.
+     */
+    uint32_t bin_bitmap;
+    free_block_t *bins[SHAL_NUM_BINS];
+
+    /**
+     * Running counters. `bytes_mapped` and `num_user_blocks` are filled in when the stats are
+     * requested.
+     */
+    allocator_stats_t stats;
 } simple_heap_allocator_t;
 
+static void shal_add_fb(simple_heap_allocator_t *shal, mem_block_t *mb);
+
 allocator_t *new_simple_heap_allocator(simple_heap_attrs_t attrs) {
     if (!IS_ALIGNED(attrs.start, M_4K) || !IS_ALIGNED(attrs.end, M_4K)) {
         return NULL;
@@ -142,14 +171,17 @@ allocator_t *new_simple_heap_allocator(simple_heap_attrs_t attrs) {
     };
     mbb_set(mb_get_footer(first_fb), first_fb_size, false);
 
-    if (first_fb_size < shal->attrs.small_fl_cutoff) {
-        shal->small_fl_head = (free_block_t *)first_fb;
-        shal->large_fl_head = NULL;
-    } else {
-        shal->small_fl_head = NULL;
-        shal->large_fl_head = (free_block_t *)first_fb;
+    shal->small_fl_head = NULL;
+    shal->large_fl_head = NULL;
+    shal->bin_bitmap = 0;
+    for (uint32_t i = 0; i < SHAL_NUM_BINS; i++) {
+        shal->bins[i] = NULL;
     }
 
+    mem_set(&(shal->stats), 0, sizeof(allocator_stats_t));
+
+    shal_add_fb(shal, first_fb);
+
     return (allocator_t *)shal;
 }
 
@@ -165,6 +197,13 @@ static void shal_remove_fb(simple_heap_allocator_t *shal, mem_block_t *mb) {
 
     if (fb->prev) {
         fb->prev->next = fb->next;
+    } else if (shal->attrs.segregated) {
+        const uint32_t bin = shal_bin_index(fb_size);
+
+        shal->bins[bin] = fb->next;
+        if (!(fb->next)) {
+            shal->bin_bitmap &= ~(1UL << bin);
+        }
     } else {
         // If there is no previous, we are working with the head of a free list.
         // We must make sure to update the correct free list.
@@ -182,6 +221,9 @@ static void shal_remove_fb(simple_heap_allocator_t *shal, mem_block_t *mb) {
 
     fb->prev = NULL;
     fb->next = NULL;
+
+    shal->stats.num_free_blocks--;
+    shal->stats.bytes_free -= fb_size;
 }
 
 static mem_block_t *shal_mb_next(simple_heap_allocator_t *shal, mem_block_t *mb) {
@@ -249,7 +291,17 @@ static void shal_add_fb(simple_heap_allocator_t *shal, mem_block_t *mb) {
     free_block_t *fb = (free_block_t *)mb;
     fb->prev = NULL;
 
-    if (fb_size < shal->attrs.small_fl_cutoff) {
+    if (shal->attrs.segregated) {
+        const uint32_t bin = shal_bin_index(fb_size);
+
+        fb->next = shal->bins[bin];
+        if (shal->bins[bin]) {
+            shal->bins[bin]->prev = fb;
+        }
+
+        shal->bins[bin] = fb;
+        shal->bin_bitmap |= (1UL << bin);
+    } else if (fb_size < shal->attrs.small_fl_cutoff) {
         fb->next = shal->small_fl_head;
         if (shal->small_fl_head) {
             shal->small_fl_head->prev = fb;
@@ -264,6 +316,9 @@ static void shal_add_fb(simple_heap_allocator_t *shal, mem_block_t *mb) {
 
         shal->large_fl_head = fb;
     }
+
+    shal->stats.num_free_blocks++;
+    shal->stats.bytes_free += fb_size;
 }
 
 /**
@@ -315,6 +370,72 @@ static mem_block_t *shal_request_mem(simple_heap_allocator_t *shal, const void *
     return new_fb;
 }
 
+/**
+ * If the top of the heap is a free block, shrink it as much as possible and return the pages
+ * it no longer covers. The break pointer is moved down accordingly.
+ *
+ * Returns the number of bytes returned.
+ */
+static size_t shal_trim_top(simple_heap_allocator_t *shal) {
+    mem_block_border_t *top_ftr = (mem_block_border_t *)(shal->brk_ptr) - 1;
+
+    if (mbb_get_allocated(*top_ftr)) {
+        return 0;
+    }
+
+    mem_block_t *top = footer_get_mb(top_ftr);
+    mem_block_border_t *top_hdr = mb_get_header(top);
+
+    // If the top block starts on a page boundary, it can be removed entirely.
+    // Otherwise, it must be left with enough room to still be a valid free block.
+    // (The very first block never starts on a page boundary, so the heap is never empty)
+    const void *new_brk = IS_ALIGNED(top_hdr, M_4K) 
+        ? (const void *)top_hdr
+        : (const void *)ALIGN_UP((uint32_t)top_hdr + (2 * sizeof(mem_block_border_t)) 
+                + sizeof(free_block_t), M_4K);
+
+    if (new_brk >= shal->brk_ptr) {
+        return 0;
+    }
+
+    // Remember, the block must leave its free list BEFORE its size changes.
+    shal_remove_fb(shal, top);
+
+    const size_t trimmed = (uint32_t)(shal->brk_ptr) - (uint32_t)new_brk;
+
+    shal->attrs.mmp.return_mem((void *)new_brk, shal->brk_ptr);
+    shal->brk_ptr = new_brk;
+
+    // There is room to grow again.
+    shal->exhausted = false;
+
+    if ((const void *)top_hdr != new_brk) {
+        size_t new_size = (uint32_t)new_brk - (uint32_t)top - sizeof(mem_block_border_t);
+
+        mbb_set(top_hdr, new_size, false);
+        mbb_set(mb_get_footer(top), new_size, false);
+
+        shal_add_fb(shal, top);
+    }
+
+    return trimmed;
+}
+
+/**
+ * Trim the heap if the top free block has reached the trim threshold.
+ */
+static void shal_auto_trim(simple_heap_allocator_t *shal) {
+    if (shal->attrs.trim_threshold == 0) {
+        return;
+    }
+
+    mem_block_border_t *top_ftr = (mem_block_border_t *)(shal->brk_ptr) - 1;
+
+    if (!mbb_get_allocated(*top_ftr) && mbb_get_size(*top_ftr) >= shal->attrs.trim_threshold) {
+        shal_trim_top(shal);
+    }
+}
+
 /**
  * Search either free list for a block of at least bytes size.
  * 
@@ -348,6 +469,8 @@ static mem_block_t *shal_search_free_list(simple_heap_allocator_t *shal,
         iter = iter->next;
     }
 
+    shal->stats.num_blocks_searched += i;
+
     if (searched) {
         *searched = i;
     }
@@ -355,6 +478,47 @@ static mem_block_t *shal_search_free_list(simple_heap_allocator_t *shal,
     return fb;
 }
 
+/**
+ * Find a free block of at least `bytes` size in the segregated bins.
+ *
+ * The returned free block will be removed from its bin before being returned!
+ * NULL is returned if there is no such block.
+ */
+static mem_block_t *shal_search_bins(simple_heap_allocator_t *shal, size_t bytes) {
+    const uint32_t bin = shal_bin_index(bytes);
+
+    // Every block in a bin above `bin` is large enough. If `bytes` is a power of two, so is
+    // every block in `bin` itself.
+    const uint32_t fit_bin = (bytes & (bytes - 1)) == 0 ? bin : bin + 1;
+
+    const uint32_t fit_bins = fit_bin < SHAL_NUM_BINS 
+        ? shal->bin_bitmap & ~((1UL << fit_bin) - 1)
+        : 0;
+
+    mem_block_t *fb = NULL;
+
+    if (fit_bins) {
+        fb = (mem_block_t *)(shal->bins[__builtin_ctz(fit_bins)]);
+        shal->stats.num_blocks_searched++;
+    } else {
+        // Last resort, some blocks in `bin` may still be large enough.
+        for (free_block_t *iter = shal->bins[bin]; iter; iter = iter->next) {
+            shal->stats.num_blocks_searched++;
+
+            if (mb_get_size((mem_block_t *)iter) >= bytes) {
+                fb = (mem_block_t *)iter;
+                break;
+            }
+        }
+    }
+
+    if (fb) {
+        shal_remove_fb(shal, fb);
+    }
+
+    return fb;
+}
+
 /**
  * Take a block which does not belong to a free list.
  *
@@ -409,6 +573,8 @@ static void *shal_malloc(allocator_t *al, size_t bytes) {
         return NULL;
     }
 
+    al_stats_count_malloc(&(shal->stats), bytes);
+
     bytes = validate_mb_size(bytes);
 
     // We need to look for a free block which is at least bytes size.
@@ -418,14 +584,20 @@ static void *shal_malloc(allocator_t *al, size_t bytes) {
     size_t small_fl_searched = 0;
     size_t large_fl_searched = 0;
 
-    // Only search small list if we are requesting a small number of bytes.
-    if (/* !fb && */ bytes < shal->attrs.small_fl_cutoff) {
-        fb = shal_search_free_list(shal, false, true, bytes, &small_fl_searched);
-    }
+    if (shal->attrs.segregated) {
+        // The bins are never searched with a cutoff, so there is no need to search again
+        // below.
+        fb = shal_search_bins(shal, bytes);
+    } else {
+        // Only search small list if we are requesting a small number of bytes.
+        if (/* !fb && */ bytes < shal->attrs.small_fl_cutoff) {
+            fb = shal_search_free_list(shal, false, true, bytes, &small_fl_searched);
+        }
 
-    // If we are yet to find a free block, let's search the large list.
-    if (!fb) {
-        fb = shal_search_free_list(shal, true, true, bytes, &large_fl_searched);
+        // If we are yet to find a free block, let's search the large list.
+        if (!fb) {
+            fb = shal_search_free_list(shal, true, true, bytes, &large_fl_searched);
+        }
     }
 
     // After doing an initial search of both lists, are we still yet to find a large enough free 
@@ -460,13 +632,13 @@ static void *shal_malloc(allocator_t *al, size_t bytes) {
     // search amt. So, we shouldn't try again. (We already looked at everything)
     //
     // The slight inefficiency here is that we will search over the inital free blocks again.
-    if (!fb && bytes < shal->attrs.small_fl_cutoff && 
+    if (!fb && !(shal->attrs.segregated) && bytes < shal->attrs.small_fl_cutoff && 
             small_fl_searched == shal->attrs.small_fl_search_amt) {
         fb = shal_search_free_list(shal, false, false, bytes, NULL);
     }
 
     // Still no match? Exhaust the large free list.
-    if (!fb && large_fl_searched == shal->attrs.large_fl_search_amt) {
+    if (!fb && !(shal->attrs.segregated) && large_fl_searched == shal->attrs.large_fl_search_amt) {
         fb = shal_search_free_list(shal, true, false, bytes, NULL);
     }
 
@@ -480,6 +652,10 @@ static void *shal_malloc(allocator_t *al, size_t bytes) {
         // (Remember, this call also marks the free block as allocated!)
         shal_shrink_left(shal, fb, bytes);
         shal->num_user_blocks++;
+
+        al_stats_add_in_use(&(shal->stats), mb_get_size(fb));
+    } else {
+        shal->stats.num_failed_mallocs++;
     }
 
     return fb;
@@ -507,6 +683,8 @@ static void *shal_realloc(allocator_t *al, void *ptr, size_t bytes) {
         return NULL;  // Can't realloc a free block.
     }
 
+    shal->stats.num_reallocs++;
+
     // Ok now for real logic.
 
     bytes = validate_mb_size(bytes);
@@ -519,6 +697,10 @@ static void *shal_realloc(allocator_t *al, void *ptr, size_t bytes) {
 
     if (bytes < mb_size) { // A shrink.
         shal_shrink_left(shal, mb, bytes);
+        shal->stats.bytes_in_use -= mb_size - mb_get_size(mb);
+
+        shal_auto_trim(shal);
+
         return mb;
     }
 
@@ -574,6 +756,8 @@ static void *shal_realloc(allocator_t *al, void *ptr, size_t bytes) {
     mbb_set(stretch_hdr, stretch_size, true);
     mbb_set(stretch_ftr, stretch_size, true);
 
+    al_stats_add_in_use(&(shal->stats), stretch_size - mb_size);
+
     return mb;
 }
 
@@ -595,10 +779,15 @@ static void shal_free(allocator_t *al, void *ptr) {
         return; // Can't free a block which isn't allocated!
     }
 
+    shal->stats.num_frees++;
+    shal->stats.bytes_in_use -= mb_get_size(mb);
+
     mem_block_t *new_fb = shal_coalesce(shal, mb);
     shal_add_fb(shal, new_fb);
 
     shal->num_user_blocks--;
+
+    shal_auto_trim(shal);
 }
 
 static size_t shal_num_user_blocks(allocator_t *al) {
@@ -617,10 +806,14 @@ static void shal_dump(allocator_t *al, void (*pf)(const char *fmt, ...)) {
         "End", shal->attrs.end
     );
     pf("\n");
-    dump_hex_pairs(pf,
-        "SFL Head", shal->small_fl_head,
-        "LFL Head", shal->large_fl_head
-    );
+    if (shal->attrs.segregated) {
+        dump_hex_pairs(pf, "Bins", shal->bin_bitmap);
+    } else {
+        dump_hex_pairs(pf,
+            "SFL Head", shal->small_fl_head,
+            "LFL Head", shal->large_fl_head
+        );
+    }
     pf("\n");
 
     pf("------ Heap ------\n");
@@ -652,6 +845,20 @@ static void shal_dump(allocator_t *al, void (*pf)(const char *fmt, ...)) {
     pf("------------------\n");
 }
 
+static size_t shal_trim(allocator_t *al) {
+    simple_heap_allocator_t *shal = (simple_heap_allocator_t *)al;
+    return shal_trim_top(shal);
+}
+
+static void shal_stats(allocator_t *al, allocator_stats_t *stats) {
+    simple_heap_allocator_t *shal = (simple_heap_allocator_t *)al;
+
+    *stats = shal->stats;
+
+    stats->bytes_mapped = (uint32_t)(shal->brk_ptr) - (uint32_t)(shal->attrs.start);
+    stats->num_user_blocks = shal->num_user_blocks;
+}
+
 static void delete_simple_heap_allocator(allocator_t *al) {
     simple_heap_allocator_t *shal = (simple_heap_allocator_t *)al;
 
@@ -659,6 +866,11 @@ static void delete_simple_heap_allocator(allocator_t *al) {
     shal->attrs.mmp.return_mem(shal->attrs.start, shal->brk_ptr);
 }
 
+/**
+ * The default heap gives memory back once 256K sit unused at its top.
+ */
+#define SHAL_DEFAULT_TRIM_THRESHOLD (64 * M_4K)
+
 fernos_error_t setup_default_simple_heap(mem_manage_pair_t mmp) {
     allocator_t *al = new_simple_heap_allocator(
         (simple_heap_attrs_t) {
@@ -669,7 +881,10 @@ fernos_error_t setup_default_simple_heap(mem_manage_pair_t mmp) {
 
             .small_fl_cutoff = 0x100,
             .small_fl_search_amt = 0x20,
-            .large_fl_search_amt = 0x200
+            .large_fl_search_amt = 0x200,
+
+            .segregated = true,
+            .trim_threshold = SHAL_DEFAULT_TRIM_THRESHOLD
         }
     );
 
@@ -0,0 +1,500 @@
+
+#include "s_mem/slab.h"
+#include "s_mem/simple_heap.h"
+#include "s_mem/allocator.h"
+#include "s_util/err.h"
+#include "s_util/misc.h"
+#include "s_util/str.h"
+
+static void *slab_malloc(allocator_t *al, size_t bytes);
+static void *slab_realloc(allocator_t *al, void *ptr, size_t bytes);
+static void slab_free(allocator_t *al, void *ptr);
+static size_t slab_num_user_blocks(allocator_t *al);
+static void slab_dump(allocator_t *al, void (*pf)(const char *fmt, ...));
+static size_t slab_trim(allocator_t *al);
+static void slab_stats(allocator_t *al, allocator_stats_t *stats);
+static void delete_slab_allocator(allocator_t *al);
+
+static const allocator_impl_t SLAB_ALLOCATOR_IMPL = {
+    .al_malloc = slab_malloc,
+    .al_realloc = slab_realloc,
+    .al_free = slab_free,
+    .al_num_user_blocks = slab_num_user_blocks,
+    .al_dump = slab_dump,
+    .al_trim = slab_trim,
+    .al_stats = slab_stats,
+    .delete_allocator = delete_slab_allocator
+};
+
+static const uint16_t SLAB_CLASS_SIZE_TABLE[SLAB_NUM_CLASSES] = SLAB_CLASS_SIZES;
+
+/**
+ * Free objects within a slab page point to the next free object in the same page.
+ */
+typedef struct _slab_obj_t {
+    struct _slab_obj_t *next;
+} slab_obj_t;
+
+/**
+ * Every slab page starts with one of these.
+ *
+ * Objects are carved out of the page lazily. Objects in [0, num_carved) have been handed out
+ * at least once, those which are free live in `free_head`. Objects in [num_carved, capacity) have
+ * never been used.
+ */
+typedef struct _slab_page_t {
+    /**
+     * Links in the partial list of this page's size class, or in the empty page list.
+     * (A full page belongs to no list)
+     */
+    struct _slab_page_t *prev;
+    struct _slab_page_t *next;
+
+    slab_obj_t *free_head;
+
+    uint16_t num_used;
+    uint16_t num_carved;
+
+    uint32_t class_ind;
+} slab_page_t;
+
+/**
+ * Objects start at this offset from the beginning of their slab page.
+ */
+#define SLAB_PAGE_HDR_SIZE (ALIGN_UP(sizeof(slab_page_t), 8))
+
+typedef struct _slab_class_t {
+    uint32_t obj_size;
+
+    /**
+     * How many objects fit in one slab page.
+     */
+    uint32_t capacity;
+
+    /**
+     * Pages with at least one free object. NULL when empty.
+     */
+    slab_page_t *partial_head;
+
+    /**
+     * Number of pages currently owned by this class.
+     */
+    uint32_t num_pages;
+
+    /**
+     * Number of objects currently allocated in this class.
+     */
+    uint32_t num_used;
+} slab_class_t;
+
+typedef struct _slab_allocator_t {
+    allocator_t super;
+    const slab_attrs_t attrs;
+
+    /**
+     * Slab pages are taken from [attrs.start + 4K, brk_ptr). (The first page holds this struct)
+     *
+     * Pages after the brk_ptr are expected to be unmapped.
+     */
+    const void *brk_ptr;
+
+    /**
+     * Set when we can no longer request pages. (Same semantics as in the simple heap)
+     */
+    bool exhausted;
+
+    /**
+     * Slab pages which hold no objects. These are still mapped and reused by any class
+     * before new pages are requested.
+     */
+    slab_page_t *empty_head;
+    uint32_t num_empty_pages;
+
+    /**
+     * Allocator used for objects larger than SLAB_MAX_OBJ_SIZE.
+     */
+    allocator_t *large_al;
+
+    slab_class_t classes[SLAB_NUM_CLASSES];
+
+    /**
+     * Maps (bytes - 1) / 8 to the smallest class which can hold `bytes`.
+     */
+    uint8_t class_lookup[SLAB_MAX_OBJ_SIZE / 8];
+
+    /**
+     * Running counters for slab objects only. Large allocations are counted by `large_al`.
+     */
+    allocator_stats_t stats;
+} slab_allocator_t;
+
+allocator_t *new_slab_allocator(slab_attrs_t attrs) {
+    if (!IS_ALIGNED(attrs.start, M_4K) || !IS_ALIGNED(attrs.end, M_4K)) {
+        return NULL;
+    }
+
+    // We need at least the prologue page and one slab page.
+    if ((uint8_t *)(attrs.end) < (uint8_t *)(attrs.start) + (2 * M_4K)) {
+        return NULL;
+    }
+
+    if (!attrs.mmp.request_mem || !attrs.mmp.return_mem) {
+        return NULL;
+    }
+
+    // The two regions must be disjoint.
+    if ((const void *)(attrs.large_attrs.start) < attrs.end &&
+            (const void *)(attrs.start) < attrs.large_attrs.end) {
+        return NULL;
+    }
+
+    fernos_error_t err;
+
+    const void *true_e;
+    err = attrs.mmp.request_mem(attrs.start, (uint8_t *)(attrs.start) + M_4K, &true_e);
+    if (err != FOS_E_SUCCESS) {
+        return NULL;
+    }
+
+    allocator_t *large_al = new_simple_heap_allocator(attrs.large_attrs);
+    if (!large_al) {
+        attrs.mmp.return_mem(attrs.start, true_e);
+        return NULL;
+    }
+
+    slab_allocator_t *slab = (slab_allocator_t *)(attrs.start);
+
+    *(const allocator_impl_t **)&(slab->super.impl) = &SLAB_ALLOCATOR_IMPL;
+    *(slab_attrs_t *)&(slab->attrs) = attrs;
+
+    slab->brk_ptr = true_e;
+    slab->exhausted = false;
+    slab->empty_head = NULL;
+    slab->num_empty_pages = 0;
+    slab->large_al = large_al;
+    mem_set(&(slab->stats), 0, sizeof(allocator_stats_t));
+
+    uint32_t lookup_i = 0;
+    for (uint32_t ci = 0; ci < SLAB_NUM_CLASSES; ci++) {
+        const uint32_t obj_size = SLAB_CLASS_SIZE_TABLE[ci];
+
+        slab->classes[ci] = (slab_class_t) {
+            .obj_size = obj_size,
+            .capacity = (M_4K - SLAB_PAGE_HDR_SIZE) / obj_size,
+            .partial_head = NULL,
+            .num_pages = 0,
+            .num_used = 0
+        };
+
+        for (; lookup_i < obj_size / 8; lookup_i++) {
+            slab->class_lookup[lookup_i] = (uint8_t)ci;
+        }
+    }
+
+    return (allocator_t *)slab;
+}
+
+static inline slab_page_t *slab_obj_page(void *obj) {
+    return (slab_page_t *)ALIGN(obj, M_4K);
+}
+
+static inline bool slab_owns(slab_allocator_t *slab, void *ptr) {
+    return (uint8_t *)(slab->attrs.start) + M_4K <= (uint8_t *)ptr && ptr < slab->brk_ptr;
+}
+
+static void slab_list_push(slab_page_t **head, slab_page_t *page) {
+    page->prev = NULL;
+    page->next = *head;
+
+    if (*head) {
+        (*head)->prev = page;
+    }
+
+    *head = page;
+}
+
+static void slab_list_remove(slab_page_t **head, slab_page_t *page) {
+    if (page->prev) {
+        page->prev->next = page->next;
+    } else {
+        *head = page->next;
+    }
+
+    if (page->next) {
+        page->next->prev = page->prev;
+    }
+
+    page->prev = NULL;
+    page->next = NULL;
+}
+
+/**
+ * Get a fresh page for the given class. The page is NOT added to any list.
+ *
+ * Empty pages are reused first, otherwise a new page is requested.
+ * Returns NULL if no page could be found.
+ */
+static slab_page_t *slab_new_page(slab_allocator_t *slab, uint32_t class_ind) {
+    slab_page_t *page = slab->empty_head;
+
+    if (page) {
+        slab_list_remove(&(slab->empty_head), page);
+        slab->num_empty_pages--;
+    } else {
+        if (slab->exhausted || slab->brk_ptr >= slab->attrs.end) {
+            return NULL;
+        }
+
+        const void *true_e;
+        fernos_error_t err = slab->attrs.mmp.request_mem((void *)(slab->brk_ptr),
+                (const uint8_t *)(slab->brk_ptr) + M_4K, &true_e);
+
+        if (err != FOS_E_SUCCESS) {
+            slab->exhausted = true;
+            return NULL;
+        }
+
+        page = (slab_page_t *)(slab->brk_ptr);
+        slab->brk_ptr = true_e;
+    }
+
+    *page = (slab_page_t) {
+        .prev = NULL,
+        .next = NULL,
+        .free_head = NULL,
+        .num_used = 0,
+        .num_carved = 0,
+        .class_ind = class_ind
+    };
+
+    slab->classes[class_ind].num_pages++;
+
+    return page;
+}
+
+static void *slab_malloc(allocator_t *al, size_t bytes) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    if (bytes == 0) {
+        return NULL;
+    }
+
+    if (bytes > SLAB_MAX_OBJ_SIZE) {
+        return al_malloc(slab->large_al, bytes);
+    }
+
+    al_stats_count_malloc(&(slab->stats), bytes);
+
+    const uint32_t class_ind = slab->class_lookup[(bytes - 1) / 8];
+    slab_class_t *cls = &(slab->classes[class_ind]);
+
+    slab_page_t *page = cls->partial_head;
+    if (!page) {
+        page = slab_new_page(slab, class_ind);
+        if (!page) {
+            slab->stats.num_failed_mallocs++;
+            return NULL;
+        }
+
+        slab_list_push(&(cls->partial_head), page);
+    }
+
+    void *obj;
+
+    if (page->free_head) {
+        obj = page->free_head;
+        page->free_head = page->free_head->next;
+    } else {
+        obj = (uint8_t *)page + SLAB_PAGE_HDR_SIZE + (page->num_carved * cls->obj_size);
+        page->num_carved++;
+    }
+
+    page->num_used++;
+    cls->num_used++;
+    al_stats_add_in_use(&(slab->stats), cls->obj_size);
+
+    // Full pages leave the partial list.
+    if (page->num_used == cls->capacity) {
+        slab_list_remove(&(cls->partial_head), page);
+    }
+
+    return obj;
+}
+
+static void slab_free(allocator_t *al, void *ptr) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    if (!ptr) {
+        return;
+    }
+
+    if (!slab_owns(slab, ptr)) {
+        al_free(slab->large_al, ptr);
+        return;
+    }
+
+    slab_page_t *page = slab_obj_page(ptr);
+
+    if (page->num_used == 0) {
+        return; // Can't free from an empty page!
+    }
+
+    slab_class_t *cls = &(slab->classes[page->class_ind]);
+
+    const uint32_t offset = (uint32_t)ptr - (uint32_t)page;
+    if (offset < SLAB_PAGE_HDR_SIZE || (offset - SLAB_PAGE_HDR_SIZE) % cls->obj_size != 0) {
+        return; // Not the start of an object!
+    }
+
+    if (page->num_used == cls->capacity) {
+        slab_list_push(&(cls->partial_head), page); // Full -> Partial.
+    }
+
+    slab_obj_t *obj = (slab_obj_t *)ptr;
+    obj->next = page->free_head;
+    page->free_head = obj;
+
+    page->num_used--;
+    cls->num_used--;
+
+    slab->stats.num_frees++;
+    slab->stats.bytes_in_use -= cls->obj_size;
+
+    if (page->num_used == 0) {
+        slab_list_remove(&(cls->partial_head), page);
+        cls->num_pages--;
+
+        slab_list_push(&(slab->empty_head), page);
+        slab->num_empty_pages++;
+    }
+}
+
+static void *slab_realloc(allocator_t *al, void *ptr, size_t bytes) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    if (!ptr) {
+        return slab_malloc(al, bytes);
+    }
+
+    if (bytes == 0) {
+        slab_free(al, ptr);
+        return NULL;
+    }
+
+    if (!slab_owns(slab, ptr)) {
+        if (bytes > SLAB_MAX_OBJ_SIZE) {
+            return al_realloc(slab->large_al, ptr, bytes);
+        }
+
+        // Large blocks are always larger than SLAB_MAX_OBJ_SIZE, so all `bytes` can be copied.
+        void *new_ptr = slab_malloc(al, bytes);
+        if (!new_ptr) {
+            return NULL;
+        }
+
+        mem_cpy(new_ptr, ptr, bytes);
+        al_free(slab->large_al, ptr);
+
+        return new_ptr;
+    }
+
+    slab->stats.num_reallocs++;
+
+    const uint32_t obj_size = slab->classes[slab_obj_page(ptr)->class_ind].obj_size;
+
+    if (bytes <= obj_size) {
+        return ptr; // Fits where it is.
+    }
+
+    void *new_ptr = slab_malloc(al, bytes);
+    if (!new_ptr) {
+        return NULL;
+    }
+
+    mem_cpy(new_ptr, ptr, obj_size);
+    slab_free(al, ptr);
+
+    return new_ptr;
+}
+
+static size_t slab_num_user_blocks(allocator_t *al) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    size_t num_blocks = al_num_user_blocks(slab->large_al);
+
+    for (uint32_t ci = 0; ci < SLAB_NUM_CLASSES; ci++) {
+        num_blocks += slab->classes[ci].num_used;
+    }
+
+    return num_blocks;
+}
+
+static void slab_dump(allocator_t *al, void (*pf)(const char *fmt, ...)) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    pf("Slab Allocator\n");
+    dump_hex_pairs(pf,
+        "Pr", slab->attrs.start,
+        "Br", slab->brk_ptr,
+        "End", slab->attrs.end
+    );
+    pf("\n");
+    pf("Empty pages: %u\n", slab->num_empty_pages);
+
+    for (uint32_t ci = 0; ci < SLAB_NUM_CLASSES; ci++) {
+        const slab_class_t *cls = &(slab->classes[ci]);
+        pf("[%u] Size: %u Pages: %u Used: %u\n", ci, cls->obj_size, cls->num_pages, cls->num_used);
+    }
+
+    al_dump(slab->large_al, pf);
+}
+
+static size_t slab_trim(allocator_t *al) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    // Empty slab pages are kept for reuse, only the large heap is trimmed.
+    return al_trim(slab->large_al);
+}
+
+static void slab_stats(allocator_t *al, allocator_stats_t *stats) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    mem_set(stats, 0, sizeof(allocator_stats_t));
+    al_stats(slab->large_al, stats);
+
+    // NOTE: The slab and large heap peaks may not have happened at the same time, so the
+    // combined peak is an upper bound.
+    stats->bytes_in_use += slab->stats.bytes_in_use;
+    stats->peak_bytes_in_use += slab->stats.peak_bytes_in_use;
+    stats->bytes_mapped += (uint32_t)(slab->brk_ptr) - (uint32_t)(slab->attrs.start);
+
+    stats->num_mallocs += slab->stats.num_mallocs;
+    stats->num_failed_mallocs += slab->stats.num_failed_mallocs;
+    stats->num_reallocs += slab->stats.num_reallocs;
+    stats->num_frees += slab->stats.num_frees;
+
+    for (uint32_t i = 0; i < AL_STATS_NUM_CLASSES; i++) {
+        stats->mallocs_per_class[i] += slab->stats.mallocs_per_class[i];
+    }
+
+    // Every free object in a slab page counts as a free block.
+    for (uint32_t ci = 0; ci < SLAB_NUM_CLASSES; ci++) {
+        const slab_class_t *cls = &(slab->classes[ci]);
+        const uint32_t free_objs = (cls->num_pages * cls->capacity) - cls->num_used;
+
+        stats->num_user_blocks += cls->num_used;
+        stats->num_free_blocks += free_objs;
+        stats->bytes_free += free_objs * cls->obj_size;
+    }
+
+    stats->bytes_free += slab->num_empty_pages * (M_4K - SLAB_PAGE_HDR_SIZE);
+}
+
+static void delete_slab_allocator(allocator_t *al) {
+    slab_allocator_t *slab = (slab_allocator_t *)al;
+
+    delete_allocator(slab->large_al);
+
+    // Like the simple heap, we only return up to the break pointer.
+    slab->attrs.mmp.return_mem(slab->attrs.start, slab->brk_ptr);
+}
@@ -0,0 +1,182 @@
+#include "s_mem/allocator.h"
+#include "s_mem/arena.h"
+#include "s_mem/test/allocator.h"
+#include "s_mem/test/arena.h"
+#include "s_util/misc.h"
+#include "s_util/str.h"
+
+static bool pretest(void);
+static bool posttest(void);
+
+#define PRETEST() pretest()
+#define POSTTEST() posttest()
+
+static void (*logf)(const char *fmt, ...) = NULL;
+
+#define LOGF_METHOD(...) logf(__VA_ARGS__)
+
+#include "s_util/test.h"
+
+/**
+ * NOTE: Like in the simple heap tests, this must not be const!
+ */
+static mem_manage_pair_t test_mmp;
+
+/*
+ * NOTE: To run these tests in Userspace, you may want to change `start` and `end` to be in
+ * the free area!
+ */
+
+static allocator_t *gen_arena(void) {
+    arena_attrs_t attrs = {
+        .start = (void *)(2 * M_4M),
+        .end = (const void *)(3 * M_4M),
+
+        .mmp = test_mmp
+    };
+
+    return new_arena_allocator(attrs);
+}
+
+static allocator_t *al = NULL;
+
+static bool pretest(void) {
+    al = gen_arena();
+    TEST_TRUE(al != NULL);
+
+    TEST_SUCCEED();
+}
+
+static bool posttest(void) {
+    delete_allocator(al);
+    al = NULL;
+
+    TEST_SUCCEED();
+}
+
+static bool test_arena_reset(void) {
+    uint8_t *first = al_malloc(al, 24);
+    TEST_TRUE(first != NULL);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        uint8_t *block = al_malloc(al, 100 + i);
+        TEST_TRUE(block != NULL);
+        TEST_TRUE(IS_ALIGNED(block, 8));
+        mem_set(block, i, 100 + i);
+    }
+
+    TEST_EQUAL_UINT(101, al_num_user_blocks(al));
+
+    arena_reset(al);
+    TEST_EQUAL_UINT(0, al_num_user_blocks(al));
+
+    // After a reset, the arena should start from the beginning again.
+    TEST_EQUAL_HEX(first, al_malloc(al, 24));
+
+    TEST_SUCCEED();
+}
+
+static bool test_arena_lifo(void) {
+    uint8_t *a = al_malloc(al, 16);
+    uint8_t *b = al_malloc(al, 16);
+    TEST_TRUE(a != NULL && b != NULL);
+
+    // Freeing the latest block gives its space right back.
+    al_free(al, b);
+    TEST_EQUAL_HEX(b, al_malloc(al, 16));
+
+    // Freeing any other block gives nothing back.
+    al_free(al, a);
+    uint8_t *c = al_malloc(al, 16);
+    TEST_TRUE(c != a && c != b);
+
+    // Freeing everything resets the arena.
+    al_free(al, b);
+    al_free(al, c);
+    TEST_EQUAL_UINT(0, al_num_user_blocks(al));
+    TEST_EQUAL_HEX(a, al_malloc(al, 16));
+
+    TEST_SUCCEED();
+}
+
+static bool test_arena_realloc_in_place(void) {
+    uint8_t *a = al_malloc(al, 16);
+    TEST_TRUE(a != NULL);
+    mem_set(a, 1, 16);
+
+    // The most recent block can grow in place, even across pages.
+    uint8_t *a_re = al_realloc(al, a, 3 * M_4K);
+    TEST_EQUAL_HEX(a, a_re);
+    TEST_TRUE(mem_chk(a, 1, 16));
+    mem_set(a, 1, 3 * M_4K);
+
+    uint8_t *b = al_malloc(al, 16);
+    TEST_TRUE(b != NULL);
+
+    // Now `a` must move.
+    a_re = al_realloc(al, a, 4 * M_4K);
+    TEST_TRUE(a_re != NULL && a_re != a);
+    TEST_TRUE(mem_chk(a_re, 1, 3 * M_4K));
+
+    TEST_SUCCEED();
+}
+
+static bool test_arena_exhaust(void) {
+    uint32_t num_blocks = 0;
+    while (al_malloc(al, M_64K)) {
+        num_blocks++;
+    }
+
+    TEST_TRUE(num_blocks > 0);
+    TEST_TRUE(num_blocks < M_4M / M_64K);
+
+    arena_reset(al);
+
+    // Every page should still be usable after the reset.
+    for (uint32_t i = 0; i < num_blocks; i++) {
+        uint8_t *block = al_malloc(al, M_64K);
+        TEST_TRUE(block != NULL);
+        mem_set(block, i, M_64K);
+    }
+
+    TEST_SUCCEED();
+}
+
+static bool test_arena_trim(void) {
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_TRUE(al_malloc(al, M_64K) != NULL);
+    }
+
+    // Nothing above the bump pointer yet.
+    TEST_EQUAL_UINT(0, al_trim(al));
+
+    arena_reset(al);
+
+    // Everything but the first page can go.
+    TEST_TRUE(al_trim(al) >= 4 * M_64K);
+    TEST_EQUAL_UINT(0, al_trim(al));
+
+    // The arena should be able to map its pages again.
+    for (uint32_t i = 0; i < 4; i++) {
+        uint8_t *block = al_malloc(al, M_64K);
+        TEST_TRUE(block != NULL);
+        mem_set(block, i, M_64K);
+    }
+
+    TEST_SUCCEED();
+}
+
+void test_arena(mem_manage_pair_t mmp, void (*lf)(const char *fmt, ...)) {
+    test_mmp = mmp;
+    logf = lf;
+
+    test_allocator("Arena (Allocator Suite)", gen_arena, lf);
+
+    BEGIN_SUITE("Arena");
+    RUN_TEST(test_arena_reset);
+    RUN_TEST(test_arena_lifo);
+    RUN_TEST(test_arena_realloc_in_place);
+    RUN_TEST(test_arena_exhaust);
+    RUN_TEST(test_arena_trim);
+    END_SUITE();
+}
@@ -5,6 +5,20 @@
 #include "s_mem/test/allocator.h"
 #include "s_mem/test/simple_heap.h"
 #include "s_util/misc.h"
+#include "s_util/rand.h"
+#include "s_util/str.h"
+
+static bool pretest(void);
+static bool posttest(void);
+
+#define PRETEST() pretest()
+#define POSTTEST() posttest()
+
+static void (*logf)(const char *fmt, ...) = NULL;
+
+#define LOGF_METHOD(...) logf(__VA_ARGS__)
+
+#include "s_util/test.h"
 
 /**
  * CRAZY BUG FIND: When this is marked const, it's literally placed in program text section.
@@ -62,11 +76,232 @@ static allocator_t *gen_no_search_limit_shal(void) {
     return new_simple_heap_allocator(attrs);
 }
 
-void test_shal(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...)) {
+static allocator_t *gen_segregated_shal(void) {
+    simple_heap_attrs_t attrs = {
+        .start = (void *)(2 * M_4M),
+        .end = (const void *)((3 * M_4M)),
+
+        .mmp = test_mmp,
+
+        .segregated = true
+    };
+
+    return new_simple_heap_allocator(attrs);
+}
+
+static allocator_t *gen_trim_shal(size_t trim_threshold) {
+    simple_heap_attrs_t attrs = {
+        .start = (void *)(2 * M_4M),
+        .end = (const void *)((3 * M_4M)),
+
+        .mmp = test_mmp,
+
+        .segregated = true,
+        .trim_threshold = trim_threshold
+    };
+
+    return new_simple_heap_allocator(attrs);
+}
+
+/**
+ * Trims whenever it can, good for shaking out trimming bugs.
+ */
+static allocator_t *gen_eager_trim_shal(void) {
+    return gen_trim_shal(M_4K);
+}
+
+/*
+ * Trimming and statistics tests.
+ */
+
+static allocator_t *al = NULL;
+
+static bool pretest(void) {
+    TEST_SUCCEED();
+}
+
+static bool posttest(void) {
+    delete_allocator(al);
+    al = NULL;
+
+    TEST_SUCCEED();
+}
+
+static bool test_shal_trim(void) {
+    al = gen_trim_shal(0);
+    TEST_TRUE(al != NULL);
+
+    uint8_t *small = al_malloc(al, 16);
+    uint8_t *big = al_malloc(al, 64 * M_4K);
+    TEST_TRUE(small != NULL && big != NULL);
+
+    // Only the slack left over after growing the heap can be given back.
+    TEST_TRUE(al_trim(al) <= M_4K);
+    TEST_EQUAL_UINT(0, al_trim(al));
+
+    al_free(al, big);
+
+    // No threshold, so nothing should have been returned automatically.
+    TEST_TRUE(al_trim(al) >= 63 * M_4K);
+    TEST_EQUAL_UINT(0, al_trim(al));
+
+    mem_set(small, 0xAB, 16);
+
+    // The heap should grow back just fine.
+    big = al_malloc(al, 64 * M_4K);
+    TEST_TRUE(big != NULL);
+    mem_set(big, 0xCD, 64 * M_4K);
+
+    TEST_TRUE(mem_chk(small, 0xAB, 16));
+    TEST_EQUAL_UINT(2, al_num_user_blocks(al));
+
+    al_free(al, big);
+    al_free(al, small);
+    TEST_EQUAL_UINT(0, al_num_user_blocks(al));
+
+    TEST_SUCCEED();
+}
+
+static bool test_shal_trim_allocated_top(void) {
+    al = gen_trim_shal(0);
+    TEST_TRUE(al != NULL);
+
+    uint8_t *big = al_malloc(al, 64 * M_4K);
+    uint8_t *small = al_malloc(al, 16);
+    TEST_TRUE(small != NULL && big != NULL);
+
+    al_free(al, big);
+
+    // The big free block is stuck under `small`, at most some slack above `small` can go.
+    TEST_TRUE(al_trim(al) <= M_4K);
+
+    // It should still be reusable though.
+    TEST_EQUAL_HEX(big, al_malloc(al, 64 * M_4K));
+
+    TEST_SUCCEED();
+}
+
+static bool test_shal_auto_trim(void) {
+    al = gen_trim_shal(16 * M_4K);
+    TEST_TRUE(al != NULL);
+
+    uint8_t *small = al_malloc(al, 16);
+    TEST_TRUE(small != NULL);
+
+    // Below the threshold, memory is kept.
+    uint8_t *mid = al_malloc(al, 4 * M_4K);
+    TEST_TRUE(mid != NULL);
+    al_free(al, mid);
+    TEST_TRUE(al_trim(al) > 0);
+
+    // Above the threshold, memory is given back right away.
+    uint8_t *big = al_malloc(al, 64 * M_4K);
+    TEST_TRUE(big != NULL);
+    al_free(al, big);
+    TEST_EQUAL_UINT(0, al_trim(al));
+
+    // Shrinking with realloc also trims.
+    big = al_malloc(al, 64 * M_4K);
+    TEST_TRUE(big != NULL);
+    mem_set(big, 0x12, 64 * M_4K);
+    TEST_EQUAL_HEX(big, al_realloc(al, big, 16));
+    TEST_TRUE(mem_chk(big, 0x12, 16));
+    TEST_EQUAL_UINT(0, al_trim(al));
+
+    TEST_EQUAL_UINT(2, al_num_user_blocks(al));
+
+    TEST_SUCCEED();
+}
+
+static bool test_shal_stats(void) {
+    al = gen_trim_shal(0);
+    TEST_TRUE(al != NULL);
+
+    allocator_stats_t stats;
+    TEST_SUCCESS(al_stats(al, &stats));
+
+    TEST_EQUAL_UINT(0, stats.bytes_in_use);
+    TEST_EQUAL_UINT(0, stats.num_mallocs);
+    TEST_EQUAL_UINT(1, stats.num_free_blocks);
+    TEST_EQUAL_UINT(M_4K, stats.bytes_mapped);
+
+    void *blocks[8];
+    for (uint32_t i = 0; i < 8; i++) {
+        blocks[i] = al_malloc(al, 8 << i);
+        TEST_TRUE(blocks[i] != NULL);
+    }
+
+    TEST_SUCCESS(al_stats(al, &stats));
+
+    TEST_EQUAL_UINT(8, stats.num_mallocs);
+    TEST_EQUAL_UINT(8, stats.num_user_blocks);
+    TEST_EQUAL_UINT(0, stats.num_failed_mallocs);
+    TEST_TRUE(stats.bytes_in_use >= (8 << 8) - 8);
+    TEST_EQUAL_UINT(stats.bytes_in_use, stats.peak_bytes_in_use);
+    TEST_TRUE(stats.bytes_in_use + stats.bytes_free <= stats.bytes_mapped);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_EQUAL_UINT(1, stats.mallocs_per_class[i]);
+    }
+
+    const uint32_t peak = stats.peak_bytes_in_use;
+
+    // Free every other block, this should leave a few free blocks around.
+    for (uint32_t i = 0; i < 8; i += 2) {
+        al_free(al, blocks[i]);
+    }
+
+    TEST_SUCCESS(al_stats(al, &stats));
+
+    TEST_EQUAL_UINT(4, stats.num_frees);
+    TEST_EQUAL_UINT(4, stats.num_user_blocks);
+    TEST_TRUE(stats.bytes_in_use < peak);
+    TEST_EQUAL_UINT(peak, stats.peak_bytes_in_use);
+    TEST_TRUE(stats.num_free_blocks >= 4);
+
+    // A failed malloc is still counted.
+    TEST_TRUE(al_malloc(al, 2 * M_4M) == NULL);
+    TEST_SUCCESS(al_stats(al, &stats));
+    TEST_EQUAL_UINT(9, stats.num_mallocs);
+    TEST_EQUAL_UINT(1, stats.num_failed_mallocs);
+    TEST_EQUAL_UINT(1, stats.mallocs_per_class[AL_STATS_NUM_CLASSES - 1]);
+
+    // Stretching in place should be reflected in the in use count.
+    const uint32_t in_use = stats.bytes_in_use;
+    TEST_EQUAL_HEX(blocks[7], al_realloc(al, blocks[7], 4 * M_4K));
+    TEST_SUCCESS(al_stats(al, &stats));
+    TEST_EQUAL_UINT(1, stats.num_reallocs);
+    TEST_TRUE(stats.bytes_in_use >= in_use + (4 * M_4K) - (8 << 7));
+
+    for (uint32_t i = 1; i < 8; i += 2) {
+        al_free(al, blocks[i]);
+    }
+
+    TEST_SUCCESS(al_stats(al, &stats));
+    TEST_EQUAL_UINT(0, stats.bytes_in_use);
+    TEST_EQUAL_UINT(0, stats.num_user_blocks);
+
+    // Everything should be coalesced back into one block.
+    TEST_EQUAL_UINT(1, stats.num_free_blocks);
+
+    TEST_SUCCEED();
+}
+
+void test_shal(mem_manage_pair_t mmp, void (*lf)(const char *fmt, ...)) {
     test_mmp = mmp;
+    logf = lf;
 
     //(void)gen_basic_shal;
-    test_allocator("Basic SHAL", gen_basic_shal, logf);
+    test_allocator("Basic SHAL", gen_basic_shal, lf);
+    test_allocator("Segregated SHAL", gen_segregated_shal, lf);
+    test_allocator("Eager Trim SHAL", gen_eager_trim_shal, lf);
+
+    BEGIN_SUITE("SHAL");
+    RUN_TEST(test_shal_trim);
+    RUN_TEST(test_shal_trim_allocated_top);
+    RUN_TEST(test_shal_auto_trim);
+    RUN_TEST(test_shal_stats);
+    END_SUITE();
 
     (void)gen_big_cutoff_shal;
     //test_allocator("Big Cutoff SHAL", gen_big_cutoff_shal);
@@ -74,3 +309,101 @@ void test_shal(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...)) {
     (void)gen_no_search_limit_shal;
     //test_allocator("No Search Limit SHAL", gen_no_search_limit_shal);
 }
+
+/*
+ * Benchmarking.
+ *
+ * The memory manager pair is wrapped so we can see how much memory each heap requests.
+ */
+
+static mem_manage_pair_t bench_real_mmp;
+static size_t bench_bytes_requested;
+
+static fernos_error_t bench_request_mem(void *s, const void *e, const void **true_e) {
+    fernos_error_t err = bench_real_mmp.request_mem(s, e, true_e);
+    bench_bytes_requested += (uint8_t *)(*true_e) - (uint8_t *)s;
+    return err;
+}
+
+#define BENCH_NUM_BLOCKS (1024U)
+#define BENCH_ROUNDS     (16U)
+
+/**
+ * A fragmentation heavy trace. Blocks of very different sizes are allocated, then a random half
+ * are freed and replaced with blocks of new sizes, over and over.
+ *
+ * Returns the number of KCycles this took. (0 if an allocation failed)
+ */
+static uint32_t bench_trace(allocator_t *al) {
+    static void *blocks[BENCH_NUM_BLOCKS];
+
+    rand_t r = rand(0);
+
+    uint64_t start = read_tsc();
+
+    for (uint32_t i = 0; i < BENCH_NUM_BLOCKS; i++) {
+        blocks[i] = al_malloc(al, 8 + (next_rand_u32(&r) % 0x400));
+        if (!blocks[i]) {
+            return 0;
+        }
+    }
+
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        for (uint32_t i = 0; i < BENCH_NUM_BLOCKS; i++) {
+            if (next_rand_u1(&r)) {
+                al_free(al, blocks[i]);
+                blocks[i] = NULL;
+            }
+        }
+
+        for (uint32_t i = 0; i < BENCH_NUM_BLOCKS; i++) {
+            if (!blocks[i]) {
+                // Mostly small blocks, with the occasional large one.
+                const size_t size = (next_rand_u8(&r) < 0x10) 
+                    ? M_4K + (next_rand_u32(&r) % (2 * M_4K))
+                    : 8 + (next_rand_u32(&r) % 0x400);
+
+                blocks[i] = al_malloc(al, size);
+                if (!blocks[i]) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    uint32_t kcycles = (uint32_t)((read_tsc() - start) >> 10);
+
+    for (uint32_t i = 0; i < BENCH_NUM_BLOCKS; i++) {
+        al_free(al, blocks[i]);
+    }
+
+    return kcycles;
+}
+
+static void bench_shal_gen(const char *name, allocator_t *(*gen)(void), 
+        void (*lf)(const char *fmt, ...)) {
+    bench_bytes_requested = 0;
+
+    allocator_t *al = gen();
+    if (!al) {
+        lf("%s: Failed to create allocator\n", name);
+        return;
+    }
+
+    const uint32_t kcycles = bench_trace(al);
+    lf("%s: %u KCycles, %u KB requested\n", name, kcycles, bench_bytes_requested >> 10);
+
+    delete_allocator(al);
+}
+
+void bench_shal(mem_manage_pair_t mmp, void (*lf)(const char *fmt, ...)) {
+    // The generators all use `test_mmp`, so that's where the wrapper goes.
+    bench_real_mmp = mmp;
+    test_mmp = mmp;
+    test_mmp.request_mem = bench_request_mem;
+
+    bench_shal_gen("Basic SHAL", gen_basic_shal, lf);
+    bench_shal_gen("No Search Limit SHAL", gen_no_search_limit_shal, lf);
+    bench_shal_gen("Segregated SHAL", gen_segregated_shal, lf);
+}
+
@@ -0,0 +1,116 @@
+#include "s_mem/allocator.h"
+#include "s_mem/simple_heap.h"
+#include "s_mem/slab.h"
+#include "s_mem/test/allocator.h"
+#include "s_mem/test/slab.h"
+#include "s_util/misc.h"
+
+/**
+ * NOTE: Like in the simple heap tests, this must not be const!
+ */
+static mem_manage_pair_t test_mmp;
+
+/*
+ * NOTE: To run these tests in Userspace, you may want to change the regions below to be in
+ * the free area!
+ */
+
+static simple_heap_attrs_t large_attrs(void) {
+    return (simple_heap_attrs_t) {
+        .start = (void *)((2 * M_4M) + M_1M),
+        .end = (const void *)(3 * M_4M),
+
+        .mmp = test_mmp,
+
+        .small_fl_cutoff = 0x100,
+        .small_fl_search_amt = 0x10,
+        .large_fl_search_amt = 0x10,
+    };
+}
+
+static allocator_t *gen_slab(void) {
+    slab_attrs_t attrs = {
+        .start = (void *)(2 * M_4M),
+        .end = (const void *)((2 * M_4M) + M_1M),
+
+        .mmp = test_mmp,
+
+        .large_attrs = large_attrs()
+    };
+
+    return new_slab_allocator(attrs);
+}
+
+static allocator_t *gen_shal(void) {
+    return new_simple_heap_allocator(large_attrs());
+}
+
+void test_slab(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...)) {
+    test_mmp = mmp;
+
+    test_allocator("Slab", gen_slab, logf);
+}
+
+#define BENCH_NUM_OBJS (2048U)
+#define BENCH_ROUNDS   (8U)
+
+/**
+ * Allocate `BENCH_NUM_OBJS` small objects, free every other one, allocate those again, then
+ * free everything. This is repeated `BENCH_ROUNDS` times.
+ *
+ * The sizes used are meant to resemble the kernel's list nodes, map nodes, and such.
+ *
+ * Returns the number of KCycles this took, 0 if an allocation failed.
+ */
+static uint32_t bench_allocator(allocator_t *al) {
+    static void *objs[BENCH_NUM_OBJS];
+    static const size_t sizes[] = { 12, 16, 24, 40, 64, 20, 32, 8 };
+
+    const uint32_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    uint64_t start = read_tsc();
+
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++) {
+        for (uint32_t i = 0; i < BENCH_NUM_OBJS; i++) {
+            objs[i] = al_malloc(al, sizes[i % num_sizes]);
+            if (!objs[i]) {
+                return 0;
+            }
+        }
+
+        for (uint32_t i = 0; i < BENCH_NUM_OBJS; i += 2) {
+            al_free(al, objs[i]);
+        }
+
+        for (uint32_t i = 0; i < BENCH_NUM_OBJS; i += 2) {
+            objs[i] = al_malloc(al, sizes[(i + 3) % num_sizes]);
+            if (!objs[i]) {
+                return 0;
+            }
+        }
+
+        for (uint32_t i = 0; i < BENCH_NUM_OBJS; i++) {
+            al_free(al, objs[i]);
+        }
+    }
+
+    return (uint32_t)((read_tsc() - start) >> 10);
+}
+
+void bench_slab(mem_manage_pair_t mmp, void (*logf)(const char *fmt, ...)) {
+    test_mmp = mmp;
+
+    logf("Slab Benchmark (%u rounds of %u objects, KCycles)\n", BENCH_ROUNDS, BENCH_NUM_OBJS);
+
+    allocator_t *al = gen_shal();
+    if (al) {
+        logf("Simple Heap: %u\n", bench_allocator(al));
+        delete_allocator(al);
+    }
+
+    al = gen_slab();
+    if (al) {
+        logf("Slab:        %u\n", bench_allocator(al));
+        delete_allocator(al);
+    }
+}
@@ -92,6 +92,14 @@ void _dump_hex_pairs(void (*pf)(const char *fmt, ...), ...);
  */
 bool intervals_overlap(int32_t *pos, int32_t *len, int32_t window_len);
 
+/**
+ * Read the CPU's timestamp counter.
+ *
+ * This counts cycles at some constant rate which is NOT known here. It is only really useful
+ * for comparing durations measured on the same machine. (i.e. benchmarking)
+ */
+uint64_t read_tsc(void);
+
 /** 
  * True if and only if `c` has a corresponding ascii printable character!
  */
@@ -125,6 +125,24 @@ fernos_error_t sc_proc_reap_single(proc_id_t cpid, proc_id_t *rcpid, proc_exit_s
  */
 fernos_error_t sc_proc_exec(user_app_t *ua, const void *args_block, size_t args_block_size);
 
+/**
+ * Create a new child process which runs the given user application.
+ *
+ * This is like calling `sc_proc_fork` and then `sc_proc_exec` in the child, except this
+ * process's memory is never copied. So, the cost of this call doesn't depend on the size of
+ * the calling process.
+ *
+ * Just like after an exec, the child only keeps the default IO handles. (And the working
+ * directory) 
+ *
+ * NOTE: `args_block` is expected to be absolute from FC_CORE_VMEM_APP_ARGS_START.
+ *
+ * On success, the child's pid is written to *cpid. On error, FC_CORE_MAX_PROCS is written to
+ * *cpid. The cpid argument is optional.
+ */
+fernos_error_t sc_proc_spawn(user_app_t *ua, const void *args_block, size_t args_block_size,
+        proc_id_t *cpid);
+
 /**
  * Send a signal to a process with pid `pid`.
  *
@@ -199,6 +217,8 @@ fernos_error_t sc_mem_request(void *s, const void *e, const void **true_e);
  *
  * Does nothing if `s` or `e` aren't 4K aligned, `e` < `s`, or `s` or `e` are outside
  * the process free area.
+ *
+ * File mappings which overlap the range are unmapped in full, as if by `sc_fs_munmap`.
  */
 void sc_mem_return(void *s, const void *e);
 
@@ -209,6 +229,62 @@ void sc_mem_return(void *s, const void *e);
  */
 extern const mem_manage_pair_t USER_MMP;
 
+/**
+ * Reserve memory in this process's free area.
+ *
+ * Exact same arguments and return values as `sc_mem_request`. The difference is that no
+ * memory is actually given to the reserved pages until they are first touched. 
+ * (At which point they will be zeroed)
+ *
+ * This is useful for large areas which may only ever be partially used.
+ *
+ * NOTE: If the system runs out of memory when a reserved page is first touched, the process
+ * will exit with PROC_ES_PF. 
+ *
+ * Memory reserved with this call is returned with `sc_mem_return`.
+ */
+fernos_error_t sc_mem_reserve(void *s, const void *e, const void **true_e);
+
+/**
+ * Like `USER_MMP`, but with `sc_mem_reserve` instead of `sc_mem_request`.
+ */
+extern const mem_manage_pair_t USER_LAZY_MMP;
+
+/**
+ * Get the current statistics of the kernel heap.
+ *
+ * Returns FOS_E_BAD_ARGS if `stats` is NULL.
+ * Returns FOS_E_NOT_IMPLEMENTED if the kernel heap doesn't keep statistics.
+ */
+fernos_error_t sc_mem_kernel_heap_stats(heap_stats_t *stats);
+
+/**
+ * Get how many physical pages process `pid` uses. (See `proc_mem_stats_t`)
+ *
+ * If `pid` is FC_CORE_MAX_PROCS, the stats of this process are given.
+ *
+ * Returns FOS_E_BAD_ARGS if `stats` is NULL.
+ * Returns FOS_E_INVALID_INDEX if there is no process with id `pid`.
+ */
+fernos_error_t sc_mem_proc_stats(proc_id_t pid, proc_mem_stats_t *stats);
+
+/**
+ * Limit how many resident pages process `pid` may use. 0 means no limit. 
+ *
+ * If `pid` is FC_CORE_MAX_PROCS, the quota of this process is set. Otherwise, `pid` must be a 
+ * living child of this process.
+ *
+ * If this process has a quota itself, `quota` must be non-zero and no larger. (i.e. a process can
+ * only ever lower its own quota)
+ *
+ * Once a process hits its quota, memory requests fail with FOS_E_NO_MEM, and page faults which
+ * need a fresh page end the process with PROC_ES_OOM.
+ *
+ * Returns FOS_E_INVALID_INDEX if there is no process with id `pid`.
+ * Returns FOS_E_NOT_PERMITTED if `pid` is not a living child, or `quota` is too large.
+ */
+fernos_error_t sc_mem_proc_set_quota(proc_id_t pid, uint32_t quota);
+
 /**
  * Exit the current thread.
  *
@@ -225,11 +301,60 @@ void sc_thread_exit(void *retval);
 /**
  * Have the current thread sleep for at least `ticks` timer interrupts.
  *
+ * The thread always gives up the CPU, even when `ticks` is 0. (In that case, it sleeps until the
+ * next timer interrupt, which is a way to yield)
+ *
  * Remember, this only sleeps the calling thread. Other threads in the parent process will be 
  * left untouched.
  */
 void sc_thread_sleep(uint32_t ticks);
 
+/**
+ * Have the current thread sleep until the monotonic clock reaches `deadline` nanoseconds.
+ * (See `sc_clock_ns`)
+ *
+ * Deadlines don't need to line up with timer interrupts. If nothing else is running, the thread
+ * is woken up right at its deadline. Otherwise, it is woken up by the first timer interrupt after
+ * its deadline.
+ *
+ * Returns immediately if `deadline` has already passed. Sleeps are cut short after ~36 minutes.
+ */
+void sc_thread_sleep_until(uint64_t deadline);
+
+/**
+ * Have the current thread sleep for at least `ns` nanoseconds. (See `sc_thread_sleep_until`)
+ */
+void sc_thread_sleep_ns(uint64_t ns);
+
+/**
+ * Get how the monotonic clock is read. (See `clock_info_t`)
+ *
+ * Returns FOS_E_BAD_ARGS if `info` is NULL.
+ */
+fernos_error_t sc_clock_info(clock_info_t *info);
+
+/**
+ * Nanoseconds since boot on the monotonic clock.
+ *
+ * Only the first call in a process enters the kernel. (To get the clock info) After that, reading 
+ * the clock is just a TSC read and a multiply.
+ *
+ * Returns 0 if the clock info couldn't be retrieved.
+ */
+uint64_t sc_clock_ns(void);
+
+/**
+ * Get the scheduler statistics of thread `tid` in process `pid`. (See `sched_stats_t`)
+ *
+ * Pass FC_CORE_MAX_PROCS as `pid` for the calling process. Pass the null thread id 
+ * (FC_CORE_MAX_THREADS_PER_PROC) as `tid` for the whole process, this includes threads which
+ * have already exited.
+ *
+ * Returns FOS_E_BAD_ARGS if `stats` is NULL.
+ * Returns FOS_E_INVALID_INDEX if there is no such process or thread.
+ */
+fernos_error_t sc_sched_stats(proc_id_t pid, thread_id_t tid, sched_stats_t *stats);
+
 /**
  * Spawn a thread with the given entry point and argument!
  *
@@ -261,6 +386,26 @@ fernos_error_t sc_thread_spawn(thread_id_t *tid, void *(*entry)(void *arg), void
  */
 fernos_error_t sc_thread_join(join_vector_t jv, thread_id_t *joined, void **retval);
 
+/**
+ * Set the priority of thread `tid` in the calling process. Pass the null thread id 
+ * (FC_CORE_MAX_THREADS_PER_PROC) to set the priority of the calling thread.
+ *
+ * Scheduled threads with a lower priority value always run before those with a higher value.
+ * New threads start with priority THREAD_PRIO_DEFAULT. (Forked threads keep their priority)
+ *
+ * Threads woken up from waiting (on input, pipes, sleep, etc.) are temporarily boosted to a more 
+ * urgent priority until they use up a full time slice. (See FC_CORE_SCHED_WAKE_BOOST)
+ *
+ * Only the root process may raise a thread above THREAD_PRIO_DEFAULT. Other processes can only
+ * move a thread down, or back to THREAD_PRIO_DEFAULT.
+ *
+ * Returns FOS_E_BAD_ARGS if `prio` is not less than THREAD_PRIO_LEVELS.
+ * Returns FOS_E_INVALID_INDEX if there is no living thread with id `tid`.
+ * Returns FOS_E_NOT_PERMITTED if a non-root process tries to raise a thread above 
+ * THREAD_PRIO_DEFAULT.
+ */
+fernos_error_t sc_thread_set_prio(thread_id_t tid, thread_prio_t prio);
+
 /*
  * Now for handle and plugin system calls!
  *
@@ -102,9 +102,76 @@ fernos_error_t sc_fs_seek(handle_t h, size_t pos);
 
 /**
  * Call the flush command on a given handle.
+ *
+ * Dirty pages of this process's writeable mappings of the file are written back first.
+ * (See `sc_fs_mmap`)
  */
 fernos_error_t sc_fs_flush(handle_t h);
 
+/**
+ * Map `len` bytes of the file behind `h`, starting at `offset`, into this process's free area.
+ * The address of the mapping is written to `*addr`.
+ *
+ * Pages are only read from the file when first touched, so mapping a large file is cheap.
+ * Mapped bytes past the end of the file read as zero.
+ *
+ * `flags` is a combination of `PLG_FS_MMAP_FLAG_*`. Without `PLG_FS_MMAP_FLAG_WRITE`, the
+ * mapping is read-only. With it, written pages are written back to the file on `sc_fs_flush`,
+ * `sc_fs_flush_all`, `sc_fs_munmap`, exec, and once this process is reaped. Add
+ * `PLG_FS_MMAP_FLAG_PRIVATE` to keep writes private to this process instead.
+ * (Write back never grows the file)
+ *
+ * Mappings are placed at the top of the free area, and are removed with `sc_fs_munmap`.
+ * Returning any page of a mapping with `sc_mem_return` also removes the whole mapping.
+ * Closing `h` does not remove its mappings.
+ *
+ * NOTE: A forked child gets its own private copy of every mapping, written back independently.
+ *
+ * FOS_E_BAD_ARGS if `addr` is NULL or `len` is 0.
+ * FOS_E_ALIGN_ERROR if `offset` isn't 4K aligned.
+ * FOS_E_INVALID_RANGE if `offset` is past the end of the file.
+ * FOS_E_NO_SPACE if there is no room in the free area for the mapping.
+ */
+fernos_error_t sc_fs_mmap(handle_t h, size_t offset, size_t len, uint32_t flags, void **addr);
+
+/**
+ * Remove the mapping at `addr` created by `sc_fs_mmap`.
+ *
+ * Dirty pages of a write back mapping are written back first. The mapping is always removed,
+ * if the write back fails, its error is returned.
+ *
+ * FOS_E_INVALID_INDEX if there is no mapping at `addr`.
+ */
+fernos_error_t sc_fs_munmap(void *addr);
+
+/**
+ * Execute the file behind file handle `h`.
+ *
+ * This is exactly `sc_proc_exec`, `ua` should have been parsed from the file behind `h`.
+ * Since `ua` comes from userspace, its read-only areas are never shared with other processes.
+ * (Use `sc_fs_exec_path` for that)
+ *
+ * On success, this call never returns. (And `h` is closed like every other non-default handle)
+ */
+fernos_error_t sc_fs_exec(handle_t h, user_app_t *ua, const void *args_block, size_t args_block_size);
+
+/**
+ * Execute the ELF file at `path`.
+ *
+ * Unlike `sc_fs_exec`, the file is parsed and loaded entirely by the kernel. Each loadable
+ * segment is read from the file system straight into the new process. (No user app structure
+ * or heap buffers are needed) Large segments are paged in from the file as they are touched,
+ * so startup cost doesn't grow with the size of the file.
+ *
+ * `args_block` must be an absolute args block. (See `args_block_make_absolute`)
+ *
+ * FOS_E_INVALID_INDEX if `path` doesn't exist.
+ * FOS_E_STATE_MISMATCH if `path` is a directory or not a 32-bit x86 ELF file.
+ *
+ * On success, this call never returns.
+ */
+fernos_error_t sc_fs_exec_path(const char *path, const void *args_block, size_t args_block_size);
+
 /**
  * Given a path to an ELF file, parse its contents into a new user app structure.
  *
@@ -126,7 +193,7 @@ fernos_error_t sc_fs_parse_elf32(allocator_t *al, const char *path, user_app_t *
 fernos_error_t sc_fs_parse_da_elf32(const char *path, user_app_t **ua);
 
 /**
- * Wrapper around `sc_fs_parse_da_elf32` and `sc_proc_exec`.
+ * Wrapper around `new_da_args_block` and `sc_fs_exec_path`.
  *
  * `num_args` must be greater than 1.
  *
@@ -7,3 +7,9 @@
  * This suite tests system calls from the userspace root process!
  */
 bool test_syscall(void);
+
+/**
+ * Prints out how long forking takes with various amounts of allocated memory in the calling
+ * process.
+ */
+void bench_syscall_fork(void);
@@ -9,3 +9,9 @@
  * file system plugin and the test app.
  */
 bool test_syscall_exec(void);
+
+/**
+ * Prints out how long it takes to start (and reap) the test app using fork + exec vs. spawn,
+ * with various amounts of allocated memory in the calling process.
+ */
+void bench_syscall_spawn(void);
@@ -2,6 +2,7 @@
 #include "u_startup/syscall.h"
 #include "s_bridge/shared_defs.h"
 #include "s_util/str.h"
+#include "s_util/misc.h"
 #include "c_config.h"
 
 
@@ -47,6 +48,12 @@ fernos_error_t sc_proc_exec(user_app_t *ua, const void *args_block, size_t args_
             (uint32_t)args_block_size, 0);
 }
 
+fernos_error_t sc_proc_spawn(user_app_t *ua, const void *args_block, size_t args_block_size,
+        proc_id_t *cpid) {
+    return (fernos_error_t)trigger_syscall(SCID_PROC_SPAWN, (uint32_t)ua, (uint32_t)args_block, 
+            (uint32_t)args_block_size, (uint32_t)cpid);
+}
+
 fernos_error_t sc_signal(proc_id_t pid, sig_id_t sid) {
     return (fernos_error_t)trigger_syscall(SCID_SIGNAL, (uint32_t)pid, (uint32_t)sid, 0, 0);
 }
@@ -71,11 +78,32 @@ void sc_mem_return(void *s, const void *e) {
     (void)trigger_syscall(SCID_MEM_RETURN, (uint32_t)s, (uint32_t)e, 0, 0);
 }
 
+fernos_error_t sc_mem_reserve(void *s, const void *e, const void **true_e) {
+    return (fernos_error_t)trigger_syscall(SCID_MEM_RESERVE, (uint32_t)s, (uint32_t)e, (uint32_t)true_e, 0);
+}
+
 const mem_manage_pair_t USER_MMP = {
     .request_mem = sc_mem_request,
     .return_mem = sc_mem_return
 };
 
+const mem_manage_pair_t USER_LAZY_MMP = {
+    .request_mem = sc_mem_reserve,
+    .return_mem = sc_mem_return
+};
+
+fernos_error_t sc_mem_kernel_heap_stats(heap_stats_t *stats) {
+    return (fernos_error_t)trigger_syscall(SCID_MEM_KERNEL_STATS, (uint32_t)stats, 0, 0, 0);
+}
+
+fernos_error_t sc_mem_proc_stats(proc_id_t pid, proc_mem_stats_t *stats) {
+    return (fernos_error_t)trigger_syscall(SCID_MEM_PROC_STATS, pid, (uint32_t)stats, 0, 0);
+}
+
+fernos_error_t sc_mem_proc_set_quota(proc_id_t pid, uint32_t quota) {
+    return (fernos_error_t)trigger_syscall(SCID_MEM_PROC_SET_QUOTA, pid, quota, 0, 0);
+}
+
 void sc_thread_exit(void *retval) {
     (void)trigger_syscall(SCID_THREAD_EXIT, (uint32_t)retval, 0, 0, 0);
 
@@ -86,6 +114,42 @@ void sc_thread_sleep(uint32_t ticks) {
     (void)trigger_syscall(SCID_THREAD_SLEEP, ticks, 0, 0, 0);
 }
 
+void sc_thread_sleep_until(uint64_t deadline) {
+    (void)trigger_syscall(SCID_THREAD_SLEEP_UNTIL, (uint32_t)deadline, (uint32_t)(deadline >> 32), 
+            0, 0);
+}
+
+void sc_thread_sleep_ns(uint64_t ns) {
+    sc_thread_sleep_until(sc_clock_ns() + ns);
+}
+
+fernos_error_t sc_clock_info(clock_info_t *info) {
+    return (fernos_error_t)trigger_syscall(SCID_CLOCK_INFO, (uint32_t)info, 0, 0, 0);
+}
+
+/**
+ * The clock info never changes, so it is only retrieved once per process. (It is still valid 
+ * in forked children)
+ */
+static clock_info_t clock_info;
+static bool clock_info_set = false;
+
+uint64_t sc_clock_ns(void) {
+    if (!clock_info_set) {
+        if (sc_clock_info(&clock_info) != FOS_E_SUCCESS) {
+            return 0;
+        }
+
+        clock_info_set = true;
+    }
+
+    return clock_info_ns(&clock_info, read_tsc());
+}
+
+fernos_error_t sc_sched_stats(proc_id_t pid, thread_id_t tid, sched_stats_t *stats) {
+    return (fernos_error_t)trigger_syscall(SCID_SCHED_STATS, pid, tid, (uint32_t)stats, 0);
+}
+
 fernos_error_t sc_thread_spawn(thread_id_t *tid, void *(*entry)(void *arg), void *arg) {
     return (fernos_error_t)trigger_syscall(SCID_THREAD_SPAWN, (uint32_t)tid, (uint32_t)entry, (uint32_t)arg, 0);
 }
@@ -106,6 +170,10 @@ fernos_error_t sc_thread_join(join_vector_t jv, thread_id_t *joined, void **retv
     return err;
 }
 
+fernos_error_t sc_thread_set_prio(thread_id_t tid, thread_prio_t prio) {
+    return (fernos_error_t)trigger_syscall(SCID_THREAD_SET_PRIO, tid, prio, 0, 0);
+}
+
 void sc_set_in_handle(handle_t in) {
     (void)trigger_syscall(SCID_SET_IN_HANDLE, (uint32_t)in, 0, 0, 0);
 }
@@ -47,7 +47,23 @@ fernos_error_t sc_fs_seek(handle_t h, size_t pos) {
 }
 
 fernos_error_t sc_fs_flush(handle_t h) {
-    return sc_handle_cmd(h, PLG_FS_PCID_FLUSH, 0, 0, 0, 0);
+    return sc_handle_cmd(h, PLG_FS_HCID_FLUSH, 0, 0, 0, 0);
+}
+
+fernos_error_t sc_fs_mmap(handle_t h, size_t offset, size_t len, uint32_t flags, void **addr) {
+    return sc_handle_cmd(h, PLG_FS_HCID_MMAP, offset, len, flags, (uint32_t)addr);
+}
+
+fernos_error_t sc_fs_munmap(void *addr) {
+    return sc_plg_cmd(PLG_FILE_SYS_ID, PLG_FS_PCID_MUNMAP, (uint32_t)addr, 0, 0, 0);
+}
+
+fernos_error_t sc_fs_exec(handle_t h, user_app_t *ua, const void *args_block, size_t args_block_size) {
+    return sc_handle_cmd(h, PLG_FS_HCID_EXEC, (uint32_t)ua, (uint32_t)args_block, args_block_size, 0);
+}
+
+fernos_error_t sc_fs_exec_path(const char *path, const void *args_block, size_t args_block_size) {
+    return sc_plg_cmd(PLG_FILE_SYS_ID, PLG_FS_PCID_EXEC, (uint32_t)path, str_len(path), (uint32_t)args_block, args_block_size);
 }
 
 /**
@@ -204,37 +220,29 @@ fernos_error_t sc_fs_exec_da_elf32(const char * const * args, size_t num_args) {
 
     fernos_error_t err;
 
-    // 1) let's get the user app loaded.
-    user_app_t *ua;
-    err = sc_fs_parse_da_elf32(args[0], &ua);
-    if (err != FOS_E_SUCCESS) {
-        return err;
-    }
-
-    // 2) Next, let's get the args block created.
+    // 1) Let's get the args block created.
+    // (The ELF file itself is loaded by the kernel, nothing is read into our heap)
     const void *args_block;
     size_t args_block_len;
 
     err = new_da_args_block(args + 1, num_args - 1, &args_block, &args_block_len);
     if (err != FOS_E_SUCCESS) {
-        delete_user_app(ua);
         return err;
     }
 
     // Make absolute!
     args_block_make_absolute((void *)args_block, FC_CORE_VMEM_APP_ARGS_START);
 
-    // Finally, attempt to execute!
-    err = sc_proc_exec(ua, args_block, args_block_len);
+    // 2) Finally, attempt to execute!
+    err = sc_fs_exec_path(args[0], args_block, args_block_len);
 
     if (err != FOS_E_SUCCESS) {
         da_free((void *)args_block); // works when args_block is NULL.
-        delete_user_app(ua);
 
         return err;
     } 
 
-    // This should never run, on SUCCESS `sc_proc_exec` should never return.
+    // This should never run, on SUCCESS `sc_fs_exec_path` should never return.
     return FOS_E_ABORT_SYSTEM;
 }
 
@@ -1,6 +1,7 @@
 
 #include "u_startup/syscall.h"
 #include "c_config.h"
+#include "s_util/misc.h"
 
 #define LOGF_METHOD(...) sc_out_write_fmt_s(__VA_ARGS__)
 #define FAILURE_ACTION() while (1)
@@ -527,6 +528,298 @@ static bool test_memory_forks(void) {
     TEST_SUCCEED();
 }
 
+static bool test_cow_forks(void) {
+    // Forked address spaces are copy-on-write under the hood. Writes from either side after the
+    // fork should never be visible to the other side.
+
+    const uint32_t num_pages = 4;
+    uint32_t *area = (uint32_t *)FC_CORE_VMEM_FREE_START;
+    const uint32_t area_len = (num_pages * M_4K) / sizeof(uint32_t);
+
+    const void *true_e;
+    TEST_SUCCESS(sc_mem_request(area, (uint8_t *)area + (num_pages * M_4K), &true_e));
+
+    for (uint32_t i = 0; i < area_len; i++) {
+        area[i] = i;
+    }
+
+    // Signal 3 is sent from child to parent, 4 from parent to child.
+    sc_signal_allow((1 << FSIG_CHLD) | (1 << 3));
+
+    proc_id_t cpid;
+    proc_exit_status_t rces;
+
+    TEST_SUCCESS(sc_proc_fork(&cpid));
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        sc_signal_allow(1 << 4);
+        sc_signal(FC_CORE_MAX_PROCS, 3);
+
+        // Wait for the parent to scribble over its copy.
+        sc_signal_wait(1 << 4, NULL);
+
+        for (uint32_t i = 0; i < area_len; i++) {
+            if (area[i] != i) {
+                sc_proc_exit(PROC_ES_FAILURE);
+            }
+        }
+
+        // Now scribble over ours.
+        for (uint32_t i = 0; i < area_len; i++) {
+            area[i] = 0xFFFFFFFF;
+        }
+
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    TEST_SUCCESS(sc_signal_wait(1 << 3, NULL));
+
+    for (uint32_t i = 0; i < area_len; i += 2) {
+        area[i] = 0;
+    }
+
+    TEST_SUCCESS(sc_signal(cpid, 4));
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, &rces));
+    TEST_EQUAL_HEX(PROC_ES_SUCCESS, rces);
+
+    for (uint32_t i = 0; i < area_len; i++) {
+        TEST_EQUAL_UINT(i % 2 == 0 ? 0 : i, area[i]);
+    }
+
+    sc_mem_return(area, (uint8_t *)area + (num_pages * M_4K));
+
+    TEST_SUCCEED();
+}
+
+static bool test_lazy_memory(void) {
+    const uint32_t num_pages = 64;
+
+    uint8_t *s = (uint8_t *)FC_CORE_VMEM_FREE_START;
+    uint8_t *e = s + (num_pages * M_4K);
+
+    // Place `true_e` itself in the reserved area, the kernel should materialize it when
+    // writing.
+    const void **true_e_ptr = (const void **)(s + M_4K);
+
+    TEST_SUCCESS(sc_mem_reserve(s, e, (const void **)true_e_ptr));
+    TEST_EQUAL_HEX(e, *true_e_ptr);
+
+    // Reserved pages count as allocated.
+    const void *true_e;
+    TEST_EQUAL_HEX(FOS_E_ALREADY_ALLOCATED, sc_mem_request(e - M_4K, e + M_4K, &true_e));
+    TEST_EQUAL_HEX(e - M_4K, true_e);
+    TEST_EQUAL_HEX(FOS_E_ALREADY_ALLOCATED, sc_mem_reserve(s, e, &true_e));
+    TEST_EQUAL_HEX(s, true_e);
+
+    // Untouched pages read as zero.
+    for (uint8_t *p = s; p < e; p += 3 * M_4K) {
+        TEST_EQUAL_UINT(0, *(uint32_t *)p);
+        *(uint32_t *)p = (uint32_t)p;
+    }
+
+    // A child should see the same values, and its own fresh reserved pages.
+    proc_id_t cpid;
+    proc_exit_status_t rces;
+
+    TEST_SUCCESS(sc_proc_fork(&cpid));
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        for (uint8_t *p = s; p < e; p += M_4K) {
+            const uint32_t expected = ((uint32_t)(p - s) / M_4K) % 3 == 0 ? (uint32_t)p : 0;
+            if (*(uint32_t *)p != expected) {
+                sc_proc_exit(PROC_ES_FAILURE);
+            }
+
+            *(uint32_t *)p = 0;
+        }
+
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, &rces));
+    TEST_EQUAL_HEX(PROC_ES_SUCCESS, rces);
+
+    for (uint8_t *p = s; p < e; p += 3 * M_4K) {
+        TEST_EQUAL_UINT((uint32_t)p, *(uint32_t *)p);
+    }
+
+    sc_mem_return(s, e);
+
+    // After returning, the area should fault again.
+    TEST_SUCCESS(sc_proc_fork(&cpid));
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        *(uint32_t *)s = 4;
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, &rces));
+    TEST_EQUAL_HEX(PROC_ES_PF, rces);
+
+    TEST_SUCCEED();
+}
+
+static bool test_kernel_heap_stats(void) {
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, sc_mem_kernel_heap_stats(NULL));
+
+    heap_stats_t stats;
+    TEST_SUCCESS(sc_mem_kernel_heap_stats(&stats));
+
+    // The kernel has definitely allocated something by now.
+    TEST_TRUE(stats.num_mallocs > 0);
+    TEST_TRUE(stats.num_user_blocks > 0);
+    TEST_TRUE(stats.bytes_in_use > 0);
+    TEST_TRUE(stats.bytes_in_use <= stats.peak_bytes_in_use);
+    TEST_TRUE(stats.bytes_in_use + stats.bytes_free <= stats.bytes_mapped);
+
+    uint32_t class_total = 0;
+    for (uint32_t i = 0; i < HEAP_STATS_NUM_CLASSES; i++) {
+        class_total += stats.mallocs_per_class[i];
+    }
+    TEST_EQUAL_UINT(stats.num_mallocs, class_total);
+
+    // Forking allocates kernel structures, which should show up in the counters.
+    proc_id_t cpid;
+    TEST_SUCCESS(sc_proc_fork(&cpid));
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, NULL));
+
+    heap_stats_t new_stats;
+    TEST_SUCCESS(sc_mem_kernel_heap_stats(&new_stats));
+
+    TEST_TRUE(new_stats.num_mallocs > stats.num_mallocs);
+    TEST_TRUE(new_stats.num_frees > stats.num_frees);
+    TEST_TRUE(new_stats.peak_bytes_in_use >= stats.peak_bytes_in_use);
+
+    TEST_SUCCEED();
+}
+
+static bool test_proc_mem_stats(void) {
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, sc_mem_proc_stats(FC_CORE_MAX_PROCS, NULL));
+
+    proc_mem_stats_t stats;
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, sc_mem_proc_stats(FC_CORE_MAX_PROCS - 1, &stats));
+
+    TEST_SUCCESS(sc_mem_proc_stats(FC_CORE_MAX_PROCS, &stats));
+
+    // We are running, so we must have some code and a stack.
+    TEST_TRUE(stats.resident > 0);
+    TEST_TRUE(stats.stack > 0);
+    TEST_TRUE(stats.stack + stats.heap <= stats.resident);
+    TEST_TRUE(stats.shared <= stats.resident);
+
+    const uint32_t num_pages = 16;
+
+    uint8_t *s = (uint8_t *)FC_CORE_VMEM_FREE_START;
+    uint8_t *e = s + (num_pages * M_4K);
+
+    const void *true_e;
+    TEST_SUCCESS(sc_mem_request(s, e, &true_e));
+
+    proc_mem_stats_t new_stats;
+    TEST_SUCCESS(sc_mem_proc_stats(FC_CORE_MAX_PROCS, &new_stats));
+    TEST_EQUAL_UINT(stats.resident + num_pages, new_stats.resident);
+    TEST_EQUAL_UINT(stats.heap + num_pages, new_stats.heap);
+
+    // After a fork, everything we had becomes copy-on-write.
+    proc_id_t cpid;
+    TEST_SUCCESS(sc_proc_fork(&cpid));
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, NULL));
+
+    TEST_SUCCESS(sc_mem_proc_stats(FC_CORE_MAX_PROCS, &new_stats));
+    TEST_TRUE(new_stats.shared >= stats.shared + num_pages);
+
+    sc_mem_return(s, e);
+
+    TEST_SUCCESS(sc_mem_proc_stats(FC_CORE_MAX_PROCS, &new_stats));
+    TEST_EQUAL_UINT(stats.heap, new_stats.heap);
+
+    // Reserved pages are only counted once they are touched.
+    TEST_SUCCESS(sc_mem_reserve(s, e, &true_e));
+
+    TEST_SUCCESS(sc_mem_proc_stats(FC_CORE_MAX_PROCS, &new_stats));
+    TEST_EQUAL_UINT(stats.heap, new_stats.heap);
+
+    *(uint32_t *)s = 4;
+    *(uint32_t *)(s + (2 * M_4K)) = 4;
+
+    TEST_SUCCESS(sc_mem_proc_stats(FC_CORE_MAX_PROCS, &new_stats));
+    TEST_EQUAL_UINT(stats.heap + 2, new_stats.heap);
+
+    sc_mem_return(s, e);
+
+    TEST_SUCCESS(sc_mem_proc_stats(FC_CORE_MAX_PROCS, &new_stats));
+    TEST_EQUAL_UINT(stats.heap, new_stats.heap);
+
+    TEST_SUCCEED();
+}
+
+static bool test_proc_mem_quota(void) {
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, sc_mem_proc_set_quota(FC_CORE_MAX_PROCS - 1, 16));
+
+    proc_id_t cpid;
+    proc_exit_status_t rces;
+
+    // A process can't raise its own quota, so the quota is only ever set in a child.
+
+    TEST_SUCCESS(sc_proc_fork(&cpid));
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        proc_mem_stats_t stats;
+        if (sc_mem_proc_stats(FC_CORE_MAX_PROCS, &stats) != FOS_E_SUCCESS) {
+            sc_proc_exit(PROC_ES_FAILURE);
+        }
+
+        // Leave a little room for the stack to grow.
+        const uint32_t quota = stats.resident + 16;
+
+        if (sc_mem_proc_set_quota(FC_CORE_MAX_PROCS, quota) != FOS_E_SUCCESS ||
+                sc_mem_proc_set_quota(FC_CORE_MAX_PROCS, quota + 1) != FOS_E_NOT_PERMITTED ||
+                sc_mem_proc_set_quota(FC_CORE_MAX_PROCS, 0) != FOS_E_NOT_PERMITTED) {
+            sc_proc_exit(PROC_ES_FAILURE);
+        }
+
+        uint8_t *s = (uint8_t *)FC_CORE_VMEM_FREE_START;
+        uint8_t *e = s + (32 * M_4K);
+
+        const void *true_e;
+        if (sc_mem_request(s, e, &true_e) != FOS_E_NO_MEM || 
+                (const uint8_t *)true_e <= s || e <= (const uint8_t *)true_e) {
+            sc_proc_exit(PROC_ES_FAILURE);
+        }
+
+        // We are now at our quota, materializing a reserved page should end us.
+        if (sc_mem_reserve(e, e + M_4K, &true_e) != FOS_E_SUCCESS) {
+            sc_proc_exit(PROC_ES_FAILURE);
+        }
+
+        *(uint32_t *)e = 4;
+
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, &rces));
+    TEST_EQUAL_HEX(PROC_ES_OOM, rces);
+
+    TEST_SUCCEED();
+}
+
 /* Multithreading Tests */
 
 /**
@@ -665,6 +958,167 @@ static bool test_thread_join1(void) {
     TEST_SUCCEED();
 }
 
+static volatile uint32_t prio_worker_runs;
+
+static void *test_thread_prio_worker(void *arg) {
+    (void)arg;
+    prio_worker_runs++;
+    return NULL;
+}
+
+static bool test_thread_prio(void) {
+    const thread_id_t NULL_TID = FC_CORE_MAX_THREADS_PER_PROC;
+
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, sc_thread_set_prio(NULL_TID, THREAD_PRIO_LEVELS));
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, sc_thread_set_prio(NULL_TID - 1, THREAD_PRIO_DEFAULT));
+
+    // While we are more urgent than our worker, it should never get to run.
+    TEST_SUCCESS(sc_thread_set_prio(NULL_TID, THREAD_PRIO_DEFAULT - 1));
+
+    prio_worker_runs = 0;
+
+    thread_id_t tid;
+    TEST_SUCCESS(sc_thread_spawn(&tid, test_thread_prio_worker, NULL));
+    TEST_SUCCESS(sc_thread_set_prio(tid, THREAD_PRIO_LEVELS - 1));
+
+    for (volatile uint32_t i = 0; i < (1UL << 22); i++);
+    TEST_EQUAL_UINT(0, prio_worker_runs);
+
+    TEST_SUCCESS(sc_thread_join(1 << tid, NULL, NULL));
+    TEST_EQUAL_UINT(1, prio_worker_runs);
+
+    TEST_SUCCESS(sc_thread_set_prio(NULL_TID, THREAD_PRIO_DEFAULT));
+
+    // Outside the root process, threads can't be raised above the default level.
+    proc_id_t cpid;
+    TEST_SUCCESS(sc_proc_fork(&cpid));
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        if (sc_thread_set_prio(NULL_TID, THREAD_PRIO_DEFAULT - 1) != FOS_E_NOT_PERMITTED) {
+            sc_proc_exit(PROC_ES_FAILURE);
+        }
+
+        if (sc_thread_set_prio(NULL_TID, THREAD_PRIO_LEVELS - 1) != FOS_E_SUCCESS) {
+            sc_proc_exit(PROC_ES_FAILURE);
+        }
+
+        if (sc_thread_set_prio(NULL_TID, THREAD_PRIO_DEFAULT) != FOS_E_SUCCESS) {
+            sc_proc_exit(PROC_ES_FAILURE);
+        }
+
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    proc_exit_status_t rces;
+    TEST_SUCCESS(sc_proc_reap_single(cpid, NULL, &rces));
+    TEST_EQUAL_HEX(PROC_ES_SUCCESS, rces);
+
+    TEST_SUCCEED();
+}
+
+static bool test_clock(void) {
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, sc_clock_info(NULL));
+
+    clock_info_t info;
+    TEST_SUCCESS(sc_clock_info(&info));
+    TEST_TRUE(info.mult > 0);
+    TEST_TRUE(info.shift <= 32);
+
+    uint64_t prev = sc_clock_ns();
+    for (uint32_t i = 0; i < 1000; i++) {
+        const uint64_t curr = sc_clock_ns();
+        TEST_TRUE(prev <= curr);
+        prev = curr;
+    }
+
+    // A sub-tick sleep. (One tick is ~838us)
+    uint64_t start = sc_clock_ns();
+    sc_thread_sleep_ns(200000);
+    TEST_TRUE(sc_clock_ns() - start >= 200000);
+
+    start = sc_clock_ns();
+    sc_thread_sleep_until(start + 1500000);
+    TEST_TRUE(sc_clock_ns() >= start + 1500000);
+
+    // Deadlines in the past shouldn't sleep at all.
+    sc_thread_sleep_until(0);
+
+    // Tick based sleeps should still line up with the clock.
+    start = sc_clock_ns();
+    sc_thread_sleep(4);
+    TEST_TRUE(sc_clock_ns() - start >= 3000000);
+
+    TEST_SUCCEED();
+}
+
+static volatile uint32_t yield_worker_runs;
+
+static void *test_sleep_yield_worker(void *arg) {
+    (void)arg;
+    yield_worker_runs++;
+    return NULL;
+}
+
+static bool test_sleep_yield(void) {
+    const thread_id_t NULL_TID = FC_CORE_MAX_THREADS_PER_PROC;
+
+    // The worker only ever runs if we actually leave the schedule.
+    TEST_SUCCESS(sc_thread_set_prio(NULL_TID, THREAD_PRIO_DEFAULT - 1));
+
+    yield_worker_runs = 0;
+
+    thread_id_t tid;
+    TEST_SUCCESS(sc_thread_spawn(&tid, test_sleep_yield_worker, NULL));
+    TEST_SUCCESS(sc_thread_set_prio(tid, THREAD_PRIO_LEVELS - 1));
+
+    sc_thread_sleep(0);
+    TEST_EQUAL_UINT(1, yield_worker_runs);
+
+    TEST_SUCCESS(sc_thread_join(1 << tid, NULL, NULL));
+    TEST_SUCCESS(sc_thread_set_prio(NULL_TID, THREAD_PRIO_DEFAULT));
+
+    TEST_SUCCEED();
+}
+
+static void *test_sched_stats_worker(void *arg) {
+    (void)arg;
+    sc_thread_sleep(2);
+    return NULL;
+}
+
+static bool test_sched_stats(void) {
+    const thread_id_t NULL_TID = FC_CORE_MAX_THREADS_PER_PROC;
+
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, sc_sched_stats(FC_CORE_MAX_PROCS, NULL_TID, NULL));
+
+    sched_stats_t before;
+    TEST_SUCCESS(sc_sched_stats(FC_CORE_MAX_PROCS, NULL_TID, &before));
+
+    thread_id_t tid;
+    TEST_SUCCESS(sc_thread_spawn(&tid, test_sched_stats_worker, NULL));
+
+    sched_stats_t worker;
+    TEST_SUCCESS(sc_sched_stats(FC_CORE_MAX_PROCS, tid, &worker));
+    TEST_EQUAL_UINT(0, worker.wakeups);
+
+    for (volatile uint32_t i = 0; i < (1UL << 20); i++);
+
+    TEST_SUCCESS(sc_thread_join(1 << tid, NULL, NULL));
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, sc_sched_stats(FC_CORE_MAX_PROCS, tid, &worker));
+
+    // The worker is gone, but its sleep should still show up in the process's statistics.
+    sched_stats_t after;
+    TEST_SUCCESS(sc_sched_stats(FC_CORE_MAX_PROCS, NULL_TID, &after));
+
+    TEST_TRUE(after.cpu_ns > before.cpu_ns);
+    TEST_TRUE(after.vol_switches >= before.vol_switches + 2);
+    TEST_TRUE(after.wakeups > before.wakeups);
+    TEST_TRUE(after.wait_ns[WAIT_KIND_SLEEP] >= before.wait_ns[WAIT_KIND_SLEEP] + 1000000);
+    TEST_TRUE(after.max_runq_latency_ns <= after.runq_latency_ns);
+
+    TEST_SUCCEED();
+}
+
 static uint32_t number;
 
 #define TEST_FORK_AND_THREAD_WORKER_ITERS (5)
@@ -803,11 +1257,20 @@ bool test_syscall(void) {
 
     RUN_TEST(test_simple_memory);
     RUN_TEST(test_memory_forks);
+    RUN_TEST(test_cow_forks);
+    RUN_TEST(test_lazy_memory);
+    RUN_TEST(test_kernel_heap_stats);
+    RUN_TEST(test_proc_mem_stats);
+    RUN_TEST(test_proc_mem_quota);
 
     // Threading tests
 
     RUN_TEST(test_thread_join0);
     RUN_TEST(test_thread_join1);
+    RUN_TEST(test_thread_prio);
+    RUN_TEST(test_clock);
+    RUN_TEST(test_sleep_yield);
+    RUN_TEST(test_sched_stats);
     RUN_TEST(test_fork_and_thread);
 
     // Stack pressure tests
@@ -819,3 +1282,79 @@ bool test_syscall(void) {
 }
 
 
+/**
+ * Fork the calling process, have the child write to the first word of every page in `[s, e)`,
+ * then reap the child. Returns the number of KCycles this took.
+ *
+ * If `dirty` is false, the child exits immediately.
+ */
+static uint32_t time_fork(uint8_t *s, uint8_t *e, bool dirty) {
+    proc_id_t cpid;
+
+    uint64_t start = read_tsc();
+
+    if (sc_proc_fork(&cpid) != FOS_E_SUCCESS) {
+        return 0;
+    }
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        if (dirty) {
+            for (uint8_t *p = s; p < e; p += M_4K) {
+                *(uint32_t *)p = 1;
+            }
+        }
+
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    sc_signal_wait(1 << FSIG_CHLD, NULL);
+    sc_proc_reap(cpid, NULL, NULL);
+
+    return (uint32_t)((read_tsc() - start) >> 10);
+}
+
+void bench_syscall_fork(void) {
+    const uint32_t heap_sizes[] = {
+        0, M_64K * 4, M_1M, M_4M
+    };
+    const uint32_t num_heap_sizes = sizeof(heap_sizes) / sizeof(heap_sizes[0]);
+    const uint32_t trials = 8;
+
+    sig_vector_t sv = sc_signal_allow(1 << FSIG_CHLD);
+
+    sc_out_write_fmt_s("Fork Benchmark (KCycles per fork + reap)\n");
+
+    for (uint32_t i = 0; i < num_heap_sizes; i++) {
+        uint8_t *s = (uint8_t *)FC_CORE_VMEM_FREE_START;
+        uint8_t *e = s + heap_sizes[i];
+
+        const void *true_e;
+        if (sc_mem_request(s, e, &true_e) != FOS_E_SUCCESS) {
+            sc_out_write_fmt_s("Unable to allocate %u bytes\n", heap_sizes[i]);
+            sc_mem_return(s, true_e);
+            break;
+        }
+
+        // Make sure every page is actually populated in the parent.
+        for (uint8_t *p = s; p < e; p += M_4K) {
+            *(uint32_t *)p = 0;
+        }
+
+        uint32_t clean = 0;
+        uint32_t dirty = 0;
+
+        for (uint32_t t = 0; t < trials; t++) {
+            clean += time_fork(s, e, false);
+            dirty += time_fork(s, e, true);
+        }
+
+        // The "dirty" column has the child touch every page, which forces every page to be
+        // copied. This is roughly what every fork cost before copy-on-write.
+        sc_out_write_fmt_s("Heap %u KB: Fork %u, Fork + Dirty %u\n", heap_sizes[i] >> 10,
+                clean / trials, dirty / trials);
+
+        sc_mem_return(s, e);
+    }
+
+    sc_signal_allow(sv);
+}
@@ -4,6 +4,7 @@
 #include "u_startup/syscall_fs.h"
 #include "u_startup/syscall_fut.h"
 #include "c_config.h"
+#include "s_util/misc.h"
 
 /*
  * NOTE: These tests kinda cover the behavior of a few different files/plugins.
@@ -409,6 +410,151 @@ static bool test_too_big_args(void) {
     TEST_SUCCEED();
 }
 
+/**
+ * Spawn `args[0]` with arguments `args[1...]`. The ELF file is parsed in userspace.
+ */
+static fernos_error_t spawn_da_elf32(const char * const *args, size_t num_args, proc_id_t *cpid) {
+    fernos_error_t err;
+
+    user_app_t *ua;
+    err = sc_fs_parse_da_elf32(args[0], &ua);
+    if (err != FOS_E_SUCCESS) {
+        return err;
+    }
+
+    const void *args_block;
+    size_t args_block_len;
+    err = new_da_args_block(args + 1, num_args - 1, &args_block, &args_block_len);
+
+    if (err == FOS_E_SUCCESS) {
+        if (args_block) {
+            args_block_make_absolute((void *)args_block, FC_CORE_VMEM_APP_ARGS_START);
+        }
+
+        err = sc_proc_spawn(ua, args_block, args_block_len, cpid);
+        da_free((void *)args_block);
+    }
+
+    delete_user_app(ua);
+
+    return err;
+}
+
+static bool test_spawn_exit_status(void) {
+    const char *args[] = {TEST_APP};
+
+    proc_id_t cpid;
+    TEST_SUCCESS(spawn_da_elf32(args, 1, &cpid));
+    TEST_TRUE(cpid != FC_CORE_MAX_PROCS);
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+
+    proc_exit_status_t es;
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, &es));
+    TEST_EQUAL_UINT(100, es);
+
+    TEST_SUCCEED();
+}
+
+static bool test_spawn_args(void) {
+    const char *args[] = {TEST_APP, "c", "hello", "world"};
+    const size_t num_args = sizeof(args) / sizeof(args[0]);
+
+    proc_exit_status_t exp_es = 0;
+    for (size_t i = 2; i < num_args; i++) {
+        for (size_t j = 0; args[i][j]; j++) {
+            exp_es += (uint8_t)(args[i][j]);
+        }
+    }
+
+    proc_id_t cpid;
+    TEST_SUCCESS(spawn_da_elf32(args, num_args, &cpid));
+
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+
+    proc_exit_status_t act_es;
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, &act_es));
+    TEST_EQUAL_UINT(exp_es, act_es);
+
+    TEST_SUCCEED();
+}
+
+static bool test_spawn_default_io(void) {
+    // The spawned process should write to our default handles, but none of our other handles
+    // should be inherited.
+
+    TEST_SUCCESS(sc_fs_touch("h2c"));
+    TEST_SUCCESS(sc_fs_touch("c2h"));
+
+    handle_t old_in = sc_get_in_handle();
+    handle_t old_out = sc_get_out_handle();
+
+    handle_t d_in;
+    TEST_SUCCESS(sc_fs_open("h2c", &d_in));
+
+    handle_t d_out;
+    TEST_SUCCESS(sc_fs_open("c2h", &d_out));
+
+    sc_set_in_handle(d_in);
+    sc_set_out_handle(d_out);
+
+    const char *args[] = {TEST_APP, "b"};
+
+    proc_id_t cpid;
+    fernos_error_t spawn_err = spawn_da_elf32(args, 2, &cpid);
+
+    // Restore our IO before testing anything, so failures are still visible.
+    sc_set_in_handle(old_in);
+    sc_set_out_handle(old_out);
+
+    TEST_SUCCESS(spawn_err);
+
+    char buf[10];
+
+    TEST_SUCCESS(sc_handle_write_full(d_in, "abc", 3));
+    TEST_SUCCESS(sc_handle_read_full(d_out, buf, 3));
+    TEST_TRUE(mem_cmp("bcd", buf, 3));
+
+    sc_handle_close(d_out);
+    sc_handle_close(d_in);
+
+    TEST_SUCCESS(sc_signal(cpid, 1));
+    TEST_SUCCESS(sc_signal_wait(1 << FSIG_CHLD, NULL));
+
+    proc_exit_status_t es;
+    TEST_SUCCESS(sc_proc_reap(cpid, NULL, &es));
+    TEST_EQUAL_HEX(PROC_ES_SIGNAL, es);
+
+    TEST_SUCCESS(sc_fs_remove("c2h"));
+    TEST_SUCCESS(sc_fs_remove("h2c"));
+
+    TEST_SUCCEED();
+}
+
+static bool test_spawn_bad_args(void) {
+    proc_id_t cpid = 0;
+    TEST_FAILURE(sc_proc_spawn(NULL, NULL, 0, &cpid));
+    TEST_EQUAL_UINT(FC_CORE_MAX_PROCS, cpid);
+
+    // Too large of an args block should fail just like with exec.
+    const size_t num_args = 5000;
+    const char **args = da_malloc(sizeof(const char *) * num_args);  
+    TEST_TRUE(args != NULL);
+
+    args[0] = TEST_APP;
+    for (size_t i = 1; i < num_args; i++) {
+        args[i] = "HereIsSomBigArgWooooooh!";
+    }
+
+    cpid = 0;
+    TEST_FAILURE(spawn_da_elf32(args, num_args, &cpid));
+    TEST_EQUAL_UINT(FC_CORE_MAX_PROCS, cpid);
+
+    da_free((void *)args);
+
+    TEST_SUCCEED();
+}
+
 bool test_syscall_exec(void) {
     BEGIN_SUITE("Syscall Exec");
     RUN_TEST(test_exit_status);
@@ -418,5 +564,92 @@ bool test_syscall_exec(void) {
     RUN_TEST(test_default_io);
     RUN_TEST(test_big_args);
     RUN_TEST(test_too_big_args);
+    RUN_TEST(test_spawn_exit_status);
+    RUN_TEST(test_spawn_args);
+    RUN_TEST(test_spawn_default_io);
+    RUN_TEST(test_spawn_bad_args);
     return END_SUITE();
 }
+
+/**
+ * Start the test app (with no args) in a new child process, then reap it. 
+ * Returns the number of KCycles this took.
+ *
+ * If `spawn` is true, `sc_proc_spawn` is used, otherwise `sc_proc_fork` + `sc_proc_exec`.
+ */
+static uint32_t time_start_app(user_app_t *ua, bool spawn) {
+    proc_id_t cpid;
+
+    uint64_t start = read_tsc();
+
+    if (spawn) {
+        if (sc_proc_spawn(ua, NULL, 0, &cpid) != FOS_E_SUCCESS) {
+            return 0;
+        }
+    } else {
+        if (sc_proc_fork(&cpid) != FOS_E_SUCCESS) {
+            return 0;
+        }
+
+        if (cpid == FC_CORE_MAX_PROCS) {
+            sc_proc_exec(ua, NULL, 0);
+            sc_proc_exit(PROC_ES_FAILURE); // Only if the exec failed.
+        }
+    }
+
+    sc_signal_wait(1 << FSIG_CHLD, NULL);
+    sc_proc_reap(cpid, NULL, NULL);
+
+    return (uint32_t)((read_tsc() - start) >> 10);
+}
+
+void bench_syscall_spawn(void) {
+    const uint32_t heap_sizes[] = {
+        0, M_64K * 4, M_1M, M_4M
+    };
+    const uint32_t num_heap_sizes = sizeof(heap_sizes) / sizeof(heap_sizes[0]);
+    const uint32_t trials = 8;
+
+    user_app_t *ua;
+    if (sc_fs_parse_da_elf32(TEST_APP, &ua) != FOS_E_SUCCESS) {
+        sc_out_write_fmt_s("Unable to parse %s\n", TEST_APP);
+        return;
+    }
+
+    sig_vector_t sv = sc_signal_allow(1 << FSIG_CHLD);
+
+    sc_out_write_fmt_s("Spawn Benchmark (KCycles per start + reap)\n");
+
+    for (uint32_t i = 0; i < num_heap_sizes; i++) {
+        uint8_t *s = (uint8_t *)FC_CORE_VMEM_FREE_START;
+        uint8_t *e = s + heap_sizes[i];
+
+        const void *true_e;
+        if (sc_mem_request(s, e, &true_e) != FOS_E_SUCCESS) {
+            sc_out_write_fmt_s("Unable to allocate %u bytes\n", heap_sizes[i]);
+            sc_mem_return(s, true_e);
+            break;
+        }
+
+        // Make sure every page is actually populated in the parent.
+        for (uint8_t *p = s; p < e; p += M_4K) {
+            *(uint32_t *)p = 0;
+        }
+
+        uint32_t fork_exec = 0;
+        uint32_t spawn = 0;
+
+        for (uint32_t t = 0; t < trials; t++) {
+            fork_exec += time_start_app(ua, false);
+            spawn += time_start_app(ua, true);
+        }
+
+        sc_out_write_fmt_s("Heap %u KB: Fork + Exec %u, Spawn %u\n", heap_sizes[i] >> 10,
+                fork_exec / trials, spawn / trials);
+
+        sc_mem_return(s, e);
+    }
+
+    sc_signal_allow(sv);
+    delete_user_app(ua);
+}
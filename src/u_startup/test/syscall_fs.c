@@ -777,6 +777,297 @@ static bool test_big_file(void) {
     TEST_SUCCEED();
 }
 
+/**
+ * Write `len` bytes of `val` to a new file at `path`, then open it.
+ */
+static bool make_mmap_test_file(const char *path, uint8_t val, size_t len, handle_t *fh) {
+    fernos_error_t err;
+
+    err = sc_fs_touch(path);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_open(path, fh);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    uint8_t buf[512];
+    mem_set(buf, val, sizeof(buf));
+
+    for (size_t written = 0; written < len; written += sizeof(buf)) {
+        err = sc_handle_write_full(*fh, buf, MIN(sizeof(buf), len - written));
+        TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    }
+
+    TEST_SUCCEED();
+}
+
+static bool test_mmap_rw(void) {
+    fernos_error_t err;
+
+    // Not a multiple of 4K on purpose.
+    const size_t file_len = (3 * M_4K) + 100;
+
+    handle_t fh;
+    TEST_TRUE(make_mmap_test_file("./a.bin", 7, file_len, &fh));
+
+    // Read-only first, with a mapping which overshoots the end of the file.
+
+    uint8_t *ro;
+    err = sc_fs_mmap(fh, 0, file_len + M_4K, 0, (void **)&ro);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    TEST_TRUE(IS_ALIGNED(ro, M_4K));
+
+    for (size_t i = 0; i < file_len + M_4K; i++) {
+        TEST_EQUAL_UINT(i < file_len ? 7 : 0, ro[i]);
+    }
+
+    // Now a writeable mapping starting from the second page.
+
+    uint8_t *rw;
+    err = sc_fs_mmap(fh, M_4K, file_len - M_4K, PLG_FS_MMAP_FLAG_WRITE, (void **)&rw);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    TEST_TRUE(rw != ro);
+
+    uint8_t buf[100];
+
+    mem_set(rw, 9, M_4K);           // The second page of the file.
+    mem_set(rw + (2 * M_4K), 9, 100); // The last 100 bytes of the file.
+    rw[(2 * M_4K) + 100] = 9;        // Past the end of the file, never written back.
+
+    // The kernel writing into the mapping should also count as a write.
+    mem_set(buf, 8, 10);
+
+    err = sc_fs_seek(fh, 0);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    err = sc_handle_write_full(fh, buf, 10);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_seek(fh, 0);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    err = sc_handle_read_full(fh, rw + M_4K, 10);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_flush(fh);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    fs_node_info_t info;
+    err = sc_fs_get_info("./a.bin", &info);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    TEST_EQUAL_UINT(file_len, info.len);
+
+    err = sc_fs_seek(fh, 0);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    for (size_t off = 0; off < file_len; off += sizeof(buf)) {
+        const size_t to_read = MIN(sizeof(buf), file_len - off);
+
+        err = sc_handle_read_full(fh, buf, to_read);
+        TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+        for (size_t i = 0; i < to_read; i++) {
+            const size_t pos = off + i;
+
+            uint8_t expected = 7;
+            if ((M_4K <= pos && pos < 2 * M_4K) || (3 * M_4K) <= pos) {
+                expected = 9;
+            }
+
+            if (pos < 10 || (2 * M_4K <= pos && pos < (2 * M_4K) + 10)) {
+                expected = 8;
+            }
+
+            TEST_EQUAL_UINT(expected, buf[i]);
+        }
+    }
+
+    err = sc_fs_munmap(rw);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_munmap(ro);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_munmap(ro);
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, err);
+
+    // A private mapping is writeable, but never changes the file.
+
+    uint8_t *priv;
+    err = sc_fs_mmap(fh, 0, M_4K, PLG_FS_MMAP_FLAG_WRITE | PLG_FS_MMAP_FLAG_PRIVATE, 
+            (void **)&priv);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    priv[0] = 1;
+
+    err = sc_fs_munmap(priv);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_seek(fh, 0);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_handle_read_full(fh, buf, 1);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    TEST_EQUAL_UINT(8, buf[0]);
+
+    sc_handle_close(fh);
+
+    err = sc_fs_remove("./a.bin");
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    TEST_SUCCEED();
+}
+
+static bool test_mmap_multiprocess(void) {
+    fernos_error_t err;
+
+    handle_t fh;
+    TEST_TRUE(make_mmap_test_file("./a.bin", 3, 2 * M_4K, &fh));
+
+    uint8_t *rw;
+    err = sc_fs_mmap(fh, 0, 2 * M_4K, PLG_FS_MMAP_FLAG_WRITE, (void **)&rw);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    rw[0] = 4; // Dirty before the fork.
+    TEST_EQUAL_UINT(3, rw[M_4K]); // Loaded, but clean before the fork.
+
+    proc_id_t cpid;
+    err = sc_proc_fork(&cpid);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    if (cpid == FC_CORE_MAX_PROCS) {
+        // The child writes the second page and exits without unmapping or flushing.
+        // Its mapping is written back when it is reaped.
+        TEST_EQUAL_UINT(4, rw[0]);
+        rw[M_4K] = 5;
+
+        sc_proc_exit(PROC_ES_SUCCESS);
+    }
+
+    err = sc_signal_wait(1 << FSIG_CHLD, NULL);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_proc_reap(cpid, NULL, NULL);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    // Mappings are private copies after a fork, so ours doesn't see the child's write.
+    TEST_EQUAL_UINT(3, rw[M_4K]);
+
+    uint8_t buf[1];
+
+    err = sc_fs_seek(fh, M_4K);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    err = sc_handle_read_full(fh, buf, 1);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    TEST_EQUAL_UINT(5, buf[0]);
+
+    // The child also wrote back our pre-fork write.
+    err = sc_fs_seek(fh, 0);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    err = sc_handle_read_full(fh, buf, 1);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    TEST_EQUAL_UINT(4, buf[0]);
+
+    // Only our dirty page is written back on unmap, the child's write survives.
+    err = sc_fs_munmap(rw);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_seek(fh, M_4K);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    err = sc_handle_read_full(fh, buf, 1);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+    TEST_EQUAL_UINT(5, buf[0]);
+
+    sc_handle_close(fh);
+
+    err = sc_fs_remove("./a.bin");
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    TEST_SUCCEED();
+}
+
+static bool test_mmap_return_mem(void) {
+    fernos_error_t err;
+
+    handle_t fh;
+    TEST_TRUE(make_mmap_test_file("./a.bin", 3, 2 * M_4K, &fh));
+
+    uint8_t *rw;
+    err = sc_fs_mmap(fh, 0, 2 * M_4K, PLG_FS_MMAP_FLAG_WRITE, (void **)&rw);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    rw[0] = 4;
+
+    // Returning part of a mapping writes it back and removes all of it.
+    sc_mem_return(rw + M_4K, rw + (2 * M_4K));
+
+    err = sc_fs_munmap(rw);
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, err);
+
+    // Whatever ends up at the same addresses has nothing to do with the file.
+    const void *true_e;
+    err = sc_mem_request(rw, rw + (2 * M_4K), &true_e);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    mem_set(rw, 6, 2 * M_4K);
+
+    err = sc_fs_flush(fh);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    err = sc_fs_seek(fh, 0);
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    uint8_t buf[512];
+    for (size_t off = 0; off < 2 * M_4K; off += sizeof(buf)) {
+        err = sc_handle_read_full(fh, buf, sizeof(buf));
+        TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+        for (size_t i = 0; i < sizeof(buf); i++) {
+            TEST_EQUAL_UINT(off + i == 0 ? 4 : 3, buf[i]);
+        }
+    }
+
+    sc_mem_return(rw, rw + (2 * M_4K));
+
+    sc_handle_close(fh);
+
+    err = sc_fs_remove("./a.bin");
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    TEST_SUCCEED();
+}
+
+static bool test_mmap_bad_args(void) {
+    fernos_error_t err;
+
+    handle_t fh;
+    TEST_TRUE(make_mmap_test_file("./a.bin", 1, 100, &fh));
+
+    void *addr;
+
+    err = sc_fs_mmap(fh, 0, 0, 0, &addr);
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, err);
+
+    err = sc_fs_mmap(fh, 0, M_4K, 0, NULL);
+    TEST_EQUAL_HEX(FOS_E_BAD_ARGS, err);
+
+    err = sc_fs_mmap(fh, 1, M_4K, 0, &addr);
+    TEST_EQUAL_HEX(FOS_E_ALIGN_ERROR, err);
+
+    err = sc_fs_mmap(fh, M_4K, M_4K, 0, &addr);
+    TEST_EQUAL_HEX(FOS_E_INVALID_RANGE, err);
+
+    err = sc_fs_mmap(fh, 0, FC_CORE_VMEM_FREE_SIZE + 1, 0, &addr);
+    TEST_EQUAL_HEX(FOS_E_NO_SPACE, err);
+
+    err = sc_fs_munmap(NULL);
+    TEST_EQUAL_HEX(FOS_E_INVALID_INDEX, err);
+
+    sc_handle_close(fh);
+
+    err = sc_fs_remove("./a.bin");
+    TEST_EQUAL_HEX(FOS_E_SUCCESS, err);
+
+    TEST_SUCCEED();
+}
+
 static bool test_bad_fs_calls(void) {
     fernos_error_t err;
 
@@ -1077,6 +1368,10 @@ bool test_syscall_fs(void) {
     RUN_TEST(test_many_handles);
     RUN_TEST(test_dir_functions);
     RUN_TEST(test_big_file);
+    RUN_TEST(test_mmap_rw);
+    RUN_TEST(test_mmap_multiprocess);
+    RUN_TEST(test_mmap_return_mem);
+    RUN_TEST(test_mmap_bad_args);
     RUN_TEST(test_bad_fs_calls);
     RUN_TEST(test_elf32_parsing);
     return END_SUITE();